@@ -172,8 +172,10 @@ void bgp_adj_in_set(struct bgp_dest *dest, struct peer *peer, struct attr *attr,
 	for (adj = dest->adj_in; adj; adj = adj->next) {
 		if (adj->peer == peer && adj->addpath_rx_id == addpath_id) {
 			if (!attrhash_cmp(adj->attr, attr)) {
+				peer->stat_attr_bytes -= bgp_attr_mem_size(adj->attr);
 				bgp_attr_unintern(&adj->attr);
 				adj->attr = bgp_attr_intern(attr);
+				peer->stat_attr_bytes += bgp_attr_mem_size(adj->attr);
 			}
 			if (!bgp_labels_cmp(adj->labels, labels)) {
 				bgp_labels_unintern(&adj->labels);
@@ -190,15 +192,55 @@ void bgp_adj_in_set(struct bgp_dest *dest, struct peer *peer, struct attr *attr,
 	adj->labels = bgp_labels_intern(labels);
 	BGP_ADJ_IN_ADD(dest, adj);
 	peer->stat_pfx_adj_rib_in++;
+	peer->stat_attr_bytes += bgp_attr_mem_size(adj->attr);
+	peer->stat_adj_rib_in_bytes += sizeof(*adj);
 	bgp_dest_lock_node(dest);
 }
 
+static void bgp_adj_in_filtered_count(struct bgp_dest *dest,
+				      struct bgp_adj_in *bai, bool filtered)
+{
+	struct bgp_table *table = bgp_dest_table(dest);
+
+	if (bai->filtered == filtered)
+		return;
+
+	bai->filtered = filtered;
+	if (!bai->peer)
+		return;
+
+	if (filtered)
+		bai->peer->pcount_filtered[table->afi][table->safi]++;
+	else if (bai->peer->pcount_filtered[table->afi][table->safi])
+		bai->peer->pcount_filtered[table->afi][table->safi]--;
+}
+
+/* Record whether the Adj-RIB-In entry of (peer, addpath_id) was denied
+ * by inbound policy the last time it went through bgp_update().
+ */
+void bgp_adj_in_filtered_set(struct bgp_dest *dest, struct peer *peer,
+			     uint32_t addpath_id, bool filtered)
+{
+	struct bgp_adj_in *adj;
+
+	for (adj = dest->adj_in; adj; adj = adj->next) {
+		if (adj->peer == peer && adj->addpath_rx_id == addpath_id) {
+			bgp_adj_in_filtered_count(dest, adj, filtered);
+			return;
+		}
+	}
+}
+
 void bgp_adj_in_remove(struct bgp_dest **dest, struct bgp_adj_in *bai)
 {
+	bgp_adj_in_filtered_count(*dest, bai, false);
+	if (bai->peer) {
+		bai->peer->stat_pfx_adj_rib_in--;
+		bai->peer->stat_attr_bytes -= bgp_attr_mem_size(bai->attr);
+		bai->peer->stat_adj_rib_in_bytes -= sizeof(*bai);
+	}
 	bgp_attr_unintern(&bai->attr);
 	bgp_labels_unintern(&bai->labels);
-	if (bai->peer)
-		bai->peer->stat_pfx_adj_rib_in--;
 	BGP_ADJ_IN_DEL(*dest, bai);
 	*dest = bgp_dest_unlock_node(*dest);
 	peer_unlock(bai->peer); /* adj_in peer reference */
@@ -103,6 +103,9 @@ struct bgp_adj_in {
 
 	/* Addpath identifier */
 	uint32_t addpath_rx_id;
+
+	/* Denied by inbound policy, counted in peer->pcount_filtered */
+	bool filtered;
 };
 
 /* BGP advertisement list.  */
@@ -143,6 +146,8 @@ extern void bgp_adj_in_set(struct bgp_dest *dest, struct peer *peer,
 extern bool bgp_adj_in_unset(struct bgp_dest **dest, struct peer *peer,
 			     uint32_t addpath_id);
 extern void bgp_adj_in_remove(struct bgp_dest **dest, struct bgp_adj_in *bai);
+extern void bgp_adj_in_filtered_set(struct bgp_dest *dest, struct peer *peer,
+				    uint32_t addpath_id, bool filtered);
 
 extern unsigned int bgp_advertise_attr_hash_key(const void *p);
 extern bool bgp_advertise_attr_hash_cmp(const void *p1, const void *p2);
@@ -2412,19 +2412,30 @@ void bgp_aggr_aspath_remove(void *arg)
 void bgp_compute_aggregate_aspath(struct bgp_aggregate *aggregate,
 				  struct aspath *aspath)
 {
-	bgp_compute_aggregate_aspath_hash(aggregate, aspath);
+	struct aspath *merged;
 
-	bgp_compute_aggregate_aspath_val(aggregate);
+	if (!bgp_compute_aggregate_aspath_hash(aggregate, aspath))
+		return;
 
+	if (!aggregate->aspath) {
+		bgp_compute_aggregate_aspath_val(aggregate);
+		return;
+	}
+
+	/* Fold just the new as-path in, as bgp_aggr_aspath_prepare() does */
+	merged = aspath_aggregate(aggregate->aspath, aspath);
+	aspath_free(aggregate->aspath);
+	aggregate->aspath = merged;
 }
 
-void bgp_compute_aggregate_aspath_hash(struct bgp_aggregate *aggregate,
+/* Returns true if the as-path was not part of the aggregate yet. */
+bool bgp_compute_aggregate_aspath_hash(struct bgp_aggregate *aggregate,
 				       struct aspath *aspath)
 {
 	struct aspath *aggr_aspath = NULL;
 
 	if ((aggregate == NULL) || (aspath == NULL))
-		return;
+		return false;
 
 	/* Create hash if not already created.
 	 */
@@ -2444,6 +2455,8 @@ void bgp_compute_aggregate_aspath_hash(struct bgp_aggregate *aggregate,
 	/* Increment reference counter.
 	 */
 	aggr_aspath->refcnt++;
+
+	return aggr_aspath->refcnt == 1;
 }
 
 void bgp_compute_aggregate_aspath_val(struct bgp_aggregate *aggregate)
@@ -2464,40 +2477,8 @@ void bgp_compute_aggregate_aspath_val(struct bgp_aggregate *aggregate)
 	}
 }
 
-void bgp_remove_aspath_from_aggregate(struct bgp_aggregate *aggregate,
-				      struct aspath *aspath)
-{
-	struct aspath *aggr_aspath = NULL;
-	struct aspath *ret_aspath = NULL;
-
-	if ((!aggregate)
-	    || (!aggregate->aspath_hash)
-	    || (!aspath))
-		return;
-
-	/* Look-up the aspath in the hash.
-	 */
-	aggr_aspath = bgp_aggr_aspath_lookup(aggregate, aspath);
-	if (aggr_aspath) {
-		aggr_aspath->refcnt--;
-
-		if (aggr_aspath->refcnt == 0) {
-			ret_aspath = hash_release(aggregate->aspath_hash,
-						  aggr_aspath);
-			aspath_free(ret_aspath);
-			ret_aspath = NULL;
-
-			/* Remove aggregate's old as-path.
-			 */
-			aspath_free(aggregate->aspath);
-			aggregate->aspath = NULL;
-
-			bgp_compute_aggregate_aspath_val(aggregate);
-		}
-	}
-}
-
-void bgp_remove_aspath_from_aggregate_hash(struct bgp_aggregate *aggregate,
+/* Returns true if the last reference to the as-path went away. */
+bool bgp_remove_aspath_from_aggregate_hash(struct bgp_aggregate *aggregate,
 					   struct aspath *aspath)
 {
 	struct aspath *aggr_aspath = NULL;
@@ -2506,7 +2487,7 @@ void bgp_remove_aspath_from_aggregate_hash(struct bgp_aggregate *aggregate,
 	if ((!aggregate)
 	    || (!aggregate->aspath_hash)
 	    || (!aspath))
-		return;
+		return false;
 
 	/* Look-up the aspath in the hash.
 	 */
@@ -2519,8 +2500,10 @@ void bgp_remove_aspath_from_aggregate_hash(struct bgp_aggregate *aggregate,
 						  aggr_aspath);
 			aspath_free(ret_aspath);
 			ret_aspath = NULL;
+			return true;
 		}
 	}
+	return false;
 }
 
 struct aspath *aspath_delete_as_set_seq(struct aspath *aspath)
@@ -158,12 +158,10 @@ extern uint8_t *aspath_snmp_pathseg(struct aspath *aspath, size_t *varlen);
 extern void bgp_compute_aggregate_aspath(struct bgp_aggregate *aggregate,
 					 struct aspath *aspath);
 
-extern void bgp_compute_aggregate_aspath_hash(struct bgp_aggregate *aggregate,
+extern bool bgp_compute_aggregate_aspath_hash(struct bgp_aggregate *aggregate,
 					      struct aspath *aspath);
 extern void bgp_compute_aggregate_aspath_val(struct bgp_aggregate *aggregate);
-extern void bgp_remove_aspath_from_aggregate(struct bgp_aggregate *aggregate,
-					     struct aspath *aspath);
-extern void bgp_remove_aspath_from_aggregate_hash(
+extern bool bgp_remove_aspath_from_aggregate_hash(
 						struct bgp_aggregate *aggregate,
 						struct aspath *aspath);
 
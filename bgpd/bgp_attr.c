@@ -1000,6 +1000,38 @@ unsigned long int attr_unknown_count(void)
 	return transit_hash->count;
 }
 
+/* Approximate memory held by an attribute, for per-peer accounting */
+size_t bgp_attr_mem_size(const struct attr *attr)
+{
+	struct community *comm;
+	struct ecommunity *ecomm;
+	struct lcommunity *lcomm;
+	struct cluster_list *cluster;
+	size_t size;
+
+	if (!attr)
+		return 0;
+
+	size = sizeof(struct attr);
+	if (attr->aspath)
+		size += sizeof(struct aspath) + aspath_size(attr->aspath);
+
+	comm = bgp_attr_get_community(attr);
+	if (comm)
+		size += sizeof(*comm) + comm->size * COMMUNITY_SIZE;
+	ecomm = bgp_attr_get_ecommunity(attr);
+	if (ecomm)
+		size += sizeof(*ecomm) + ecomm->size * ecomm->unit_size;
+	lcomm = bgp_attr_get_lcommunity(attr);
+	if (lcomm)
+		size += sizeof(*lcomm) + lcomm->size * LCOMMUNITY_SIZE;
+	cluster = bgp_attr_get_cluster(attr);
+	if (cluster)
+		size += sizeof(*cluster) + cluster->length;
+
+	return size;
+}
+
 unsigned int attrhash_key_make(const void *p)
 {
 	const struct attr *attr = (struct attr *)p;
@@ -929,18 +929,31 @@ void bgp_aggr_community_remove(void *arg)
 void bgp_compute_aggregate_community(struct bgp_aggregate *aggregate,
 				     struct community *community)
 {
-	bgp_compute_aggregate_community_hash(aggregate, community);
-	bgp_compute_aggregate_community_val(aggregate);
+	struct community *merged;
+
+	if (!bgp_compute_aggregate_community_hash(aggregate, community))
+		return;
+
+	if (!aggregate->community) {
+		bgp_compute_aggregate_community_val(aggregate);
+		return;
+	}
+
+	/* Merge just the new value instead of walking the whole hash */
+	merged = community_merge(aggregate->community, community);
+	aggregate->community = community_uniq_sort(merged);
+	community_free(&merged);
 }
 
 
-void bgp_compute_aggregate_community_hash(struct bgp_aggregate *aggregate,
+/* Returns true if the value was not part of the aggregate yet. */
+bool bgp_compute_aggregate_community_hash(struct bgp_aggregate *aggregate,
 					  struct community *community)
 {
 	struct community *aggr_community = NULL;
 
 	if ((aggregate == NULL) || (community == NULL))
-		return;
+		return false;
 
 	/* Create hash if not already created.
 	 */
@@ -961,6 +974,8 @@ void bgp_compute_aggregate_community_hash(struct bgp_aggregate *aggregate,
 	/* Increment reference counter.
 	 */
 	aggr_community->refcnt++;
+
+	return aggr_community->refcnt == 1;
 }
 
 void bgp_compute_aggregate_community_val(struct bgp_aggregate *aggregate)
@@ -988,34 +1003,8 @@ void bgp_compute_aggregate_community_val(struct bgp_aggregate *aggregate)
 
 
 
-void bgp_remove_community_from_aggregate(struct bgp_aggregate *aggregate,
-					 struct community *community)
-{
-	struct community *aggr_community = NULL;
-	struct community *ret_comm = NULL;
-
-	if ((!aggregate)
-	    || (!aggregate->community_hash)
-	    || (!community))
-		return;
-
-	/* Look-up the community in the hash.
-	 */
-	aggr_community = bgp_aggr_community_lookup(aggregate, community);
-	if (aggr_community) {
-		aggr_community->refcnt--;
-
-		if (aggr_community->refcnt == 0) {
-			ret_comm = hash_release(aggregate->community_hash,
-						aggr_community);
-			community_free(&ret_comm);
-
-			bgp_compute_aggregate_community_val(aggregate);
-		}
-	}
-}
-
-void bgp_remove_comm_from_aggregate_hash(struct bgp_aggregate *aggregate,
+/* Returns true if the last reference to the value went away. */
+bool bgp_remove_comm_from_aggregate_hash(struct bgp_aggregate *aggregate,
 		struct community *community)
 {
 
@@ -1025,7 +1014,7 @@ void bgp_remove_comm_from_aggregate_hash(struct bgp_aggregate *aggregate,
 	if ((!aggregate)
 	    || (!aggregate->community_hash)
 	    || (!community))
-		return;
+		return false;
 
 	/* Look-up the community in the hash.
 	 */
@@ -1037,6 +1026,8 @@ void bgp_remove_comm_from_aggregate_hash(struct bgp_aggregate *aggregate,
 			ret_comm = hash_release(aggregate->community_hash,
 						aggr_community);
 			community_free(&ret_comm);
+			return true;
 		}
 	}
+	return false;
 }
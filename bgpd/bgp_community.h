@@ -85,12 +85,10 @@ extern void bgp_compute_aggregate_community(struct bgp_aggregate *aggregate,
 
 extern void bgp_compute_aggregate_community_val(
 					       struct bgp_aggregate *aggregate);
-extern void bgp_compute_aggregate_community_hash(
+extern bool bgp_compute_aggregate_community_hash(
 						struct bgp_aggregate *aggregate,
 						struct community *community);
-extern void bgp_remove_community_from_aggregate(struct bgp_aggregate *aggregate,
-						struct community *community);
-extern void bgp_remove_comm_from_aggregate_hash(struct bgp_aggregate *aggregate,
+extern bool bgp_remove_comm_from_aggregate_hash(struct bgp_aggregate *aggregate,
 						struct community *community);
 extern void bgp_aggr_community_remove(void *arg);
 
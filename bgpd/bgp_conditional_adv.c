@@ -7,52 +7,248 @@
 
 #include <zebra.h>
 
+#include "jhash.h"
+
 #include "bgpd/bgp_conditional_adv.h"
 #include "bgpd/bgp_vty.h"
 
-static route_map_result_t
-bgp_check_rmap_prefixes_in_bgp_table(struct bgp_table *table,
-				     struct route_map *rmap)
+DEFINE_MTYPE_STATIC(BGPD, BGP_COND_WATCH, "BGP conditional adv watcher");
+DEFINE_MTYPE_STATIC(BGPD, BGP_COND_MATCH, "BGP conditional adv match");
+
+/*
+ * Condition-map watchers.
+ *
+ * Instead of walking the whole BGP table on every scanner run, each
+ * condition-map in use keeps the set of destinations that currently match
+ * it.  The set is built once with a table walk when the watcher is created
+ * and is then kept up to date from bgp_process() as destinations change.
+ * Whether a condition holds is just whether its set is empty, and a set
+ * becoming (non-)empty schedules the scanner right away.
+ */
+PREDECL_HASH(bgp_cond_match);
+
+struct bgp_cond_match {
+	struct bgp_cond_match_item itm;
+	struct bgp_dest *dest;
+};
+
+static int bgp_cond_match_cmp(const struct bgp_cond_match *a,
+			      const struct bgp_cond_match *b)
+{
+	return numcmp((uintptr_t)a->dest, (uintptr_t)b->dest);
+}
+
+static uint32_t bgp_cond_match_hash(const struct bgp_cond_match *m)
+{
+	return jhash(&m->dest, sizeof(m->dest), 0x6b3a9d21);
+}
+
+DECLARE_HASH(bgp_cond_match, struct bgp_cond_match, itm, bgp_cond_match_cmp,
+	     bgp_cond_match_hash);
+
+struct bgp_cond_watch {
+	afi_t afi;
+	safi_t safi;
+	struct route_map *cmap;
+
+	struct bgp_cond_match_head matches;
+
+	/* Still referenced by a peer, for garbage collection */
+	bool used;
+	/* Set went from empty to non-empty or back since the last run */
+	bool changed;
+};
+
+static void bgp_conditional_adv_timer(struct event *t);
+
+static bool bgp_cond_dest_match(struct bgp_dest *dest, struct route_map *rmap)
 {
 	struct attr dummy_attr = {0};
-	struct bgp_dest *dest;
 	struct bgp_path_info *pi;
 	struct bgp_path_info path = {0};
 	struct bgp_path_info_extra path_extra;
 	const struct prefix *dest_p;
-	route_map_result_t ret = RMAP_DENYMATCH;
+	route_map_result_t ret;
 
-	for (dest = bgp_table_top(table); dest; dest = bgp_route_next(dest)) {
-		dest_p = bgp_dest_get_prefix(dest);
-		assert(dest_p);
+	dest_p = bgp_dest_get_prefix(dest);
+	assert(dest_p);
 
-		for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = pi->next) {
-			dummy_attr = *pi->attr;
+	for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = pi->next) {
+		if (CHECK_FLAG(pi->flags, BGP_PATH_REMOVED))
+			continue;
 
-			/* Fill temp path_info */
-			prep_for_rmap_apply(&path, &path_extra, dest, pi, pi->peer, NULL,
-					    &dummy_attr);
+		dummy_attr = *pi->attr;
 
-			RESET_FLAG(dummy_attr.rmap_change_flags);
+		/* Fill temp path_info */
+		prep_for_rmap_apply(&path, &path_extra, dest, pi, pi->peer, NULL,
+				    &dummy_attr);
 
-			ret = route_map_apply(rmap, dest_p, &path);
-			bgp_attr_flush(&dummy_attr);
+		RESET_FLAG(dummy_attr.rmap_change_flags);
 
-			if (ret == RMAP_PERMITMATCH) {
-				bgp_dest_unlock_node(dest);
-				bgp_cond_adv_debug(
-					"%s: Condition map routes present in BGP table",
-					__func__);
+		ret = route_map_apply(rmap, dest_p, &path);
+		bgp_attr_flush(&dummy_attr);
 
-				return ret;
-			}
+		if (ret == RMAP_PERMITMATCH)
+			return true;
+	}
+
+	return false;
+}
+
+static void bgp_cond_watch_flush(struct bgp_cond_watch *watch)
+{
+	struct bgp_cond_match *m;
+
+	while ((m = bgp_cond_match_pop(&watch->matches))) {
+		bgp_dest_unlock_node(m->dest);
+		XFREE(MTYPE_BGP_COND_MATCH, m);
+	}
+}
+
+static void bgp_cond_watch_free(struct bgp_cond_watch *watch)
+{
+	bgp_cond_watch_flush(watch);
+	bgp_cond_match_fini(&watch->matches);
+	XFREE(MTYPE_BGP_COND_WATCH, watch);
+}
+
+/* Returns true if the set went from empty to non-empty or vice versa. */
+static bool bgp_cond_watch_update(struct bgp_cond_watch *watch,
+				  struct bgp_dest *dest)
+{
+	struct bgp_cond_match ref = { .dest = dest }, *m;
+	bool match;
+
+	match = bgp_cond_dest_match(dest, watch->cmap);
+	m = bgp_cond_match_find(&watch->matches, &ref);
+
+	if (match == !!m)
+		return false;
+
+	if (match) {
+		m = XCALLOC(MTYPE_BGP_COND_MATCH, sizeof(*m));
+		m->dest = bgp_dest_lock_node(dest);
+		bgp_cond_match_add(&watch->matches, m);
+		return bgp_cond_match_count(&watch->matches) == 1;
+	}
+
+	bgp_cond_match_del(&watch->matches, m);
+	bgp_dest_unlock_node(m->dest);
+	XFREE(MTYPE_BGP_COND_MATCH, m);
+	return bgp_cond_match_count(&watch->matches) == 0;
+}
+
+static struct bgp_cond_watch *bgp_cond_watch_get(struct bgp *bgp, afi_t afi,
+						 safi_t safi,
+						 struct route_map *cmap)
+{
+	struct bgp_cond_watch *watch;
+	struct listnode *node;
+	struct bgp_dest *dest;
+
+	if (!bgp->cond_watch)
+		bgp->cond_watch = list_new();
+
+	for (ALL_LIST_ELEMENTS_RO(bgp->cond_watch, node, watch))
+		if (watch->afi == afi && watch->safi == safi &&
+		    watch->cmap == cmap)
+			return watch;
+
+	watch = XCALLOC(MTYPE_BGP_COND_WATCH, sizeof(*watch));
+	watch->afi = afi;
+	watch->safi = safi;
+	watch->cmap = cmap;
+	bgp_cond_match_init(&watch->matches);
+	listnode_add(bgp->cond_watch, watch);
+
+	for (dest = bgp_table_top(bgp->rib[afi][safi]); dest;
+	     dest = bgp_route_next(dest))
+		bgp_cond_watch_update(watch, dest);
+
+	bgp_cond_adv_debug("%s: %s watching %s, %zu matching routes", __func__,
+			   bgp->name_pretty, cmap->name,
+			   bgp_cond_match_count(&watch->matches));
+
+	return watch;
+}
+
+static void bgp_conditional_adv_kick(struct bgp *bgp)
+{
+	event_cancel(&bgp->t_condition_check);
+	event_add_event(bm->master, bgp_conditional_adv_timer, bgp, 0,
+			&bgp->t_condition_check);
+}
+
+/* Called after best path selection for a destination has completed. */
+void bgp_conditional_adv_dest_changed(struct bgp_dest *dest)
+{
+	struct bgp_table *table = bgp_dest_table(dest);
+	struct bgp *bgp = table->bgp;
+	struct bgp_cond_watch *watch;
+	struct listnode *node;
+	bool kick = false;
+
+	if (!bgp->cond_watch || !listcount(bgp->cond_watch))
+		return;
+
+	/* Only routes in the top level table are subject to conditions */
+	if (bgp->rib[table->afi][table->safi] != table)
+		return;
+
+	for (ALL_LIST_ELEMENTS_RO(bgp->cond_watch, node, watch)) {
+		if (watch->afi != table->afi || watch->safi != table->safi)
+			continue;
+
+		if (bgp_cond_watch_update(watch, dest)) {
+			watch->changed = true;
+			kick = true;
 		}
 	}
 
-	bgp_cond_adv_debug("%s: Condition map routes not present in BGP table",
-			   __func__);
+	if (kick)
+		bgp_conditional_adv_kick(bgp);
+}
+
+/* Drop all watchers, e.g. because a condition-map has been changed. */
+void bgp_conditional_adv_watch_reset(struct bgp *bgp)
+{
+	struct bgp_cond_watch *watch;
+
+	if (!bgp->cond_watch)
+		return;
+
+	while ((watch = listnode_head(bgp->cond_watch))) {
+		listnode_delete(bgp->cond_watch, watch);
+		bgp_cond_watch_free(watch);
+	}
+
+	if (bgp->condition_filter_count)
+		bgp_conditional_adv_kick(bgp);
+}
+
+void bgp_conditional_adv_fini(struct bgp *bgp)
+{
+	bgp_conditional_adv_watch_reset(bgp);
+	event_cancel(&bgp->t_condition_check);
+	if (bgp->cond_watch)
+		list_delete(&bgp->cond_watch);
+}
+
+static void bgp_cond_watch_gc(struct bgp *bgp)
+{
+	struct bgp_cond_watch *watch;
+	struct listnode *node, *nnode;
+
+	for (ALL_LIST_ELEMENTS(bgp->cond_watch, node, nnode, watch)) {
+		watch->changed = false;
+		if (watch->used) {
+			watch->used = false;
+			continue;
+		}
 
-	return ret;
+		list_delete_node(bgp->cond_watch, node);
+		bgp_cond_watch_free(watch);
+	}
 }
 
 static void bgp_conditional_adv_routes(struct peer *peer, afi_t afi,
@@ -164,6 +360,7 @@ static void bgp_conditional_adv_timer(struct event *t)
 	struct bgp_filter *filter = NULL;
 	struct listnode *node, *nnode = NULL;
 	struct update_subgroup *subgrp = NULL;
+	struct bgp_cond_watch *watch;
 	route_map_result_t ret;
 	bool advmap_table_changed = false;
 
@@ -223,8 +420,12 @@ static void bgp_conditional_adv_timer(struct event *t)
 
 			SET_FLAG(peer->sflags, PEER_STATUS_COND_ADV_PENDING);
 
+			watch = bgp_cond_watch_get(bgp, afi, pfx_rcd_safi,
+						   filter->advmap.cmap);
+			watch->used = true;
+
 			if (!peer->advmap_config_change[afi][safi] &&
-			    !advmap_table_changed)
+			    !advmap_table_changed && !watch->changed)
 				continue;
 
 			if (BGP_DEBUG(cond_adv, COND_ADV)) {
@@ -243,8 +444,15 @@ static void bgp_conditional_adv_timer(struct event *t)
 			/* cmap (route-map attached to exist-map or
 			 * non-exist-map) map validation
 			 */
-			ret = bgp_check_rmap_prefixes_in_bgp_table(
-				table, filter->advmap.cmap);
+			if (bgp_cond_match_count(&watch->matches)) {
+				bgp_cond_adv_debug("%s: Condition map routes present in BGP table",
+						   __func__);
+				ret = RMAP_PERMITMATCH;
+			} else {
+				bgp_cond_adv_debug("%s: Condition map routes not present in BGP table",
+						   __func__);
+				ret = RMAP_DENYMATCH;
+			}
 
 			/* Derive conditional advertisement status from
 			 * condition and return value of condition-map
@@ -307,6 +515,8 @@ static void bgp_conditional_adv_timer(struct event *t)
 		}
 		peer->advmap_table_change = false;
 	}
+
+	bgp_cond_watch_gc(bgp);
 }
 
 void bgp_conditional_adv_enable(struct peer *peer, afi_t afi, safi_t safi)
@@ -356,6 +566,7 @@ void bgp_conditional_adv_disable(struct peer *peer, afi_t afi, safi_t safi)
 
 	/* Last filter removed. So cancel conditional routes polling thread. */
 	event_cancel(&bgp->t_condition_check);
+	bgp_conditional_adv_watch_reset(bgp);
 }
 
 static void peer_advertise_map_filter_update(struct peer *peer, afi_t afi,
@@ -1890,18 +1890,31 @@ void bgp_aggr_ecommunity_remove(void *arg)
 void bgp_compute_aggregate_ecommunity(struct bgp_aggregate *aggregate,
 				      struct ecommunity *ecommunity)
 {
-	bgp_compute_aggregate_ecommunity_hash(aggregate, ecommunity);
-	bgp_compute_aggregate_ecommunity_val(aggregate);
+	struct ecommunity *merged;
+
+	if (!bgp_compute_aggregate_ecommunity_hash(aggregate, ecommunity))
+		return;
+
+	if (!aggregate->ecommunity) {
+		bgp_compute_aggregate_ecommunity_val(aggregate);
+		return;
+	}
+
+	/* Merge just the new value instead of walking the whole hash */
+	merged = ecommunity_merge(aggregate->ecommunity, ecommunity);
+	aggregate->ecommunity = ecommunity_uniq_sort(merged);
+	ecommunity_free(&merged);
 }
 
 
-void bgp_compute_aggregate_ecommunity_hash(struct bgp_aggregate *aggregate,
+/* Returns true if the value was not part of the aggregate yet. */
+bool bgp_compute_aggregate_ecommunity_hash(struct bgp_aggregate *aggregate,
 					   struct ecommunity *ecommunity)
 {
 	struct ecommunity *aggr_ecommunity = NULL;
 
 	if ((aggregate == NULL) || (ecommunity == NULL))
-		return;
+		return false;
 
 	/* Create hash if not already created.
 	 */
@@ -1922,6 +1935,8 @@ void bgp_compute_aggregate_ecommunity_hash(struct bgp_aggregate *aggregate,
 	/* Increment reference counter.
 	 */
 	aggr_ecommunity->refcnt++;
+
+	return aggr_ecommunity->refcnt == 1;
 }
 
 void bgp_compute_aggregate_ecommunity_val(struct bgp_aggregate *aggregate)
@@ -1947,33 +1962,8 @@ void bgp_compute_aggregate_ecommunity_val(struct bgp_aggregate *aggregate)
 	}
 }
 
-void bgp_remove_ecommunity_from_aggregate(struct bgp_aggregate *aggregate,
-					  struct ecommunity *ecommunity)
-{
-	struct ecommunity *aggr_ecommunity = NULL;
-	struct ecommunity *ret_ecomm = NULL;
-
-	if ((!aggregate)
-	    || (!aggregate->ecommunity_hash)
-	    || (!ecommunity))
-		return;
-
-	/* Look-up the ecommunity in the hash.
-	 */
-	aggr_ecommunity = bgp_aggr_ecommunity_lookup(aggregate, ecommunity);
-	if (aggr_ecommunity) {
-		aggr_ecommunity->refcnt--;
-
-		if (aggr_ecommunity->refcnt == 0) {
-			ret_ecomm = hash_release(aggregate->ecommunity_hash,
-						 aggr_ecommunity);
-			ecommunity_free(&ret_ecomm);
-			bgp_compute_aggregate_ecommunity_val(aggregate);
-		}
-	}
-}
-
-void bgp_remove_ecomm_from_aggregate_hash(struct bgp_aggregate *aggregate,
+/* Returns true if the last reference to the value went away. */
+bool bgp_remove_ecomm_from_aggregate_hash(struct bgp_aggregate *aggregate,
 					  struct ecommunity *ecommunity)
 {
 
@@ -1983,7 +1973,7 @@ void bgp_remove_ecomm_from_aggregate_hash(struct bgp_aggregate *aggregate,
 	if ((!aggregate)
 	    || (!aggregate->ecommunity_hash)
 	    || (!ecommunity))
-		return;
+		return false;
 
 	/* Look-up the ecommunity in the hash.
 	 */
@@ -1995,8 +1985,10 @@ void bgp_remove_ecomm_from_aggregate_hash(struct bgp_aggregate *aggregate,
 			ret_ecomm = hash_release(aggregate->ecommunity_hash,
 						 aggr_ecommunity);
 			ecommunity_free(&ret_ecomm);
+			return true;
 		}
 	}
+	return false;
 }
 
 struct ecommunity *
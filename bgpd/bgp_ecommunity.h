@@ -417,15 +417,12 @@ extern void bgp_compute_aggregate_ecommunity(
 					struct bgp_aggregate *aggregate,
 					struct ecommunity *ecommunity);
 
-extern void bgp_compute_aggregate_ecommunity_hash(
+extern bool bgp_compute_aggregate_ecommunity_hash(
 					struct bgp_aggregate *aggregate,
 					struct ecommunity *ecommunity);
 extern void bgp_compute_aggregate_ecommunity_val(
 					struct bgp_aggregate *aggregate);
-extern void bgp_remove_ecommunity_from_aggregate(
-					struct bgp_aggregate *aggregate,
-					struct ecommunity *ecommunity);
-extern void bgp_remove_ecomm_from_aggregate_hash(
+extern bool bgp_remove_ecomm_from_aggregate_hash(
 					struct bgp_aggregate *aggregate,
 					struct ecommunity *ecommunity);
 extern void bgp_aggr_ecommunity_remove(void *arg);
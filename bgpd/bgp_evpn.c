@@ -912,6 +912,161 @@ struct bgp_dest *bgp_evpn_vni_node_lookup(const struct bgpevpn *vpn,
 	return bgp_evpn_vni_ip_node_lookup(vpn->ip_table, p, parent_pi);
 }
 
+/* VNI, MAC, IP length and IPv6, VTEP (family and IPv6), flags, seq, ESI */
+#define EVPN_MACIP_ENTRY_MAX                                                   \
+	(4 + ETH_ALEN + 2 + IPV6_MAX_BYTELEN + 2 + IPV6_MAX_BYTELEN + 1 + 4 +  \
+	 sizeof(esi_t))
+
+void bgp_evpn_macip_batch_init(struct bgp_evpn_macip_batch *batch,
+			       enum zclient_send_status (*send)(struct stream *s,
+								uint32_t entries))
+{
+	memset(batch, 0, sizeof(*batch));
+	batch->s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+	batch->send = send;
+}
+
+void bgp_evpn_macip_batch_fini(struct bgp_evpn_macip_batch *batch)
+{
+	stream_free(batch->s);
+	memset(batch, 0, sizeof(*batch));
+}
+
+/*
+ * Hand the pending message to the transport.  Zebra processes every entry
+ * in a ZEBRA_REMOTE_MACIP_ADD/DEL message, so one message carries as many
+ * MAC/IPs as fit into a ZAPI packet.
+ */
+enum zclient_send_status
+bgp_evpn_macip_batch_flush(struct bgp_evpn_macip_batch *batch)
+{
+	enum zclient_send_status ret;
+	uint32_t entries = batch->entries;
+
+	if (!entries)
+		return ZCLIENT_SEND_SUCCESS;
+
+	stream_putw_at(batch->s, 0, stream_get_endp(batch->s));
+	batch->entries = 0;
+
+	ret = batch->send(batch->s, entries);
+	stream_reset(batch->s);
+	return ret;
+}
+
+/*
+ * Append one MAC/IP to the batch.  A change of command (add vs. delete) or
+ * VRF, or running out of room, sends out what is pending first so ordering
+ * is preserved; the return value is the status of that send, if any.
+ */
+enum zclient_send_status
+bgp_evpn_macip_batch_add(struct bgp_evpn_macip_batch *batch, bool add,
+			 vrf_id_t vrf_id, vni_t vni, const struct ethaddr *mac,
+			 const struct ipaddr *ip, const struct ipaddr *vtep_ip,
+			 uint8_t flags, uint32_t seq, const esi_t *esi)
+{
+	enum zclient_send_status ret = ZCLIENT_SEND_SUCCESS;
+	uint16_t cmd = add ? ZEBRA_REMOTE_MACIP_ADD : ZEBRA_REMOTE_MACIP_DEL;
+	struct stream *s = batch->s;
+	uint16_t ipa_len;
+
+	if (batch->entries &&
+	    (batch->cmd != cmd || batch->vrf_id != vrf_id ||
+	     STREAM_WRITEABLE(s) < EVPN_MACIP_ENTRY_MAX))
+		ret = bgp_evpn_macip_batch_flush(batch);
+
+	if (!batch->entries) {
+		stream_reset(s);
+		zclient_create_header(s, cmd, vrf_id);
+		batch->cmd = cmd;
+		batch->vrf_id = vrf_id;
+	}
+
+	stream_putl(s, vni);
+	stream_put(s, &mac->octet, ETH_ALEN);
+
+	/* IP address length and IP address, if any. */
+	if (IS_IPADDR_NONE(ip))
+		stream_putw(s, 0);
+	else {
+		ipa_len = IS_IPADDR_V4(ip) ? IPV4_MAX_BYTELEN
+					   : IPV6_MAX_BYTELEN;
+		stream_putw(s, ipa_len);
+		stream_put(s, &ip->ip.addr, ipa_len);
+	}
+	stream_put_ipaddr(s, vtep_ip);
+
+	/* TX flags - MAC sticky status and/or gateway mac */
+	/* Also TX the sequence number of the best route. */
+	if (add) {
+		stream_putc(s, flags);
+		stream_putl(s, seq);
+		stream_put(s, esi, sizeof(esi_t));
+	}
+
+	batch->entries++;
+	return ret;
+}
+
+static enum zclient_send_status bgp_evpn_macip_zsend(struct stream *s,
+						     uint32_t entries)
+{
+	enum zclient_send_status ret;
+
+	if (!bgp_zclient || bgp_zclient->sock < 0)
+		return ZCLIENT_SEND_SUCCESS;
+
+	if (entries > 1 && bgp_debug_zebra(NULL))
+		zlog_debug("Tx %u MACIP entries in one message", entries);
+
+	stream_copy(bgp_zclient->obuf, s);
+	ret = zclient_send_message(bgp_zclient);
+
+	if (ret == ZCLIENT_SEND_FAILURE && entries > 1)
+		flog_err(EC_BGP_EVPN_FAIL,
+			 "Failed to send %u EVPN MACIP entries to zebra",
+			 entries);
+	return ret;
+}
+
+static struct bgp_evpn_macip_batch evpn_zebra_batch;
+static bool evpn_zebra_batching;
+
+/*
+ * While a batch is open (between bgp_evpn_zebra_batch_begin() and
+ * bgp_evpn_zebra_batch_end()), remote MAC/IPs are accumulated instead of
+ * being sent one message each.  Any other message that has to stay ordered
+ * with them must be preceded by bgp_evpn_zebra_batch_flush().
+ */
+void bgp_evpn_zebra_batch_begin(void)
+{
+	if (!evpn_zebra_batch.s)
+		bgp_evpn_macip_batch_init(&evpn_zebra_batch,
+					  bgp_evpn_macip_zsend);
+	evpn_zebra_batching = true;
+}
+
+enum zclient_send_status bgp_evpn_zebra_batch_flush(void)
+{
+	if (!evpn_zebra_batch.s)
+		return ZCLIENT_SEND_SUCCESS;
+
+	return bgp_evpn_macip_batch_flush(&evpn_zebra_batch);
+}
+
+enum zclient_send_status bgp_evpn_zebra_batch_end(void)
+{
+	evpn_zebra_batching = false;
+	return bgp_evpn_zebra_batch_flush();
+}
+
+void bgp_evpn_zebra_batch_finish(void)
+{
+	if (evpn_zebra_batch.s)
+		bgp_evpn_macip_batch_fini(&evpn_zebra_batch);
+	evpn_zebra_batching = false;
+}
+
 /*
  * Add (update) or delete MACIP from zebra.
  */
@@ -920,8 +1075,7 @@ static enum zclient_send_status bgp_zebra_send_remote_macip(
 	const struct ethaddr *mac, struct ipaddr *remote_vtep_ip, int add,
 	uint8_t flags, uint32_t seq, esi_t *esi)
 {
-	struct stream *s;
-	uint16_t ipa_len;
+	enum zclient_send_status ret;
 	static struct ipaddr zero_remote_vtep_ip = { .ipa_type = IPADDR_V4, .ipaddr_v4 = { INADDR_ANY } };
 	bool esi_valid;
 
@@ -944,48 +1098,23 @@ static enum zclient_send_status bgp_zebra_send_remote_macip(
 
 	if (!esi)
 		esi = zero_esi;
-	s = bgp_zclient->obuf;
-	stream_reset(s);
-
-	zclient_create_header(
-		s, add ? ZEBRA_REMOTE_MACIP_ADD : ZEBRA_REMOTE_MACIP_DEL,
-		bgp->vrf_id);
-	stream_putl(s, vpn ? vpn->vni : 0);
-
-	if (mac) /* Mac Addr */
-		stream_put(s, &mac->octet, ETH_ALEN);
-	else
-		stream_put(s, &p->prefix.macip_addr.mac.octet, ETH_ALEN);
+	if (!mac)
+		mac = &p->prefix.macip_addr.mac;
 
-	/* IP address length and IP address, if any. */
-	if (is_evpn_prefix_ipaddr_none(p))
-		stream_putw(s, 0);
-	else {
-		ipa_len = is_evpn_prefix_ipaddr_v4(p) ? IPV4_MAX_BYTELEN
-						      : IPV6_MAX_BYTELEN;
-		stream_putw(s, ipa_len);
-		stream_put(s, &p->prefix.macip_addr.ip.ip.addr, ipa_len);
-	}
 	/* If the ESI is valid that becomes the nexthop; tape out the
 	 * VTEP-IP for that case
 	 */
-	if (bgp_evpn_is_esi_valid(esi)) {
-		esi_valid = true;
-		stream_put_ipaddr(s, &zero_remote_vtep_ip);
-	} else {
-		esi_valid = false;
-		stream_put_ipaddr(s, remote_vtep_ip);
-	}
-
-	/* TX flags - MAC sticky status and/or gateway mac */
-	/* Also TX the sequence number of the best route. */
-	if (add) {
-		stream_putc(s, flags);
-		stream_putl(s, seq);
-		stream_put(s, esi, sizeof(esi_t));
-	}
-
-	stream_putw_at(s, 0, stream_get_endp(s));
+	esi_valid = bgp_evpn_is_esi_valid(esi);
+
+	if (!evpn_zebra_batch.s)
+		bgp_evpn_macip_batch_init(&evpn_zebra_batch,
+					  bgp_evpn_macip_zsend);
+	ret = bgp_evpn_macip_batch_add(&evpn_zebra_batch, !!add, bgp->vrf_id,
+				       vpn ? vpn->vni : 0, mac,
+				       &p->prefix.macip_addr.ip,
+				       esi_valid ? &zero_remote_vtep_ip
+						 : remote_vtep_ip,
+				       flags, seq, esi);
 
 	if (bgp_debug_zebra(NULL)) {
 		char esi_buf[ESI_STR_LEN];
@@ -996,8 +1125,7 @@ static enum zclient_send_status bgp_zebra_send_remote_macip(
 			snprintf(esi_buf, sizeof(esi_buf), "-");
 		zlog_debug(
 			"Tx %s MACIP, VNI %u MAC %pEA IP %pIA flags 0x%x seq %u remote VTEP %pIA esi %s",
-			add ? "ADD" : "DEL", (vpn ? vpn->vni : 0),
-			(mac ? mac : &p->prefix.macip_addr.mac),
+			add ? "ADD" : "DEL", (vpn ? vpn->vni : 0), mac,
 			&p->prefix.macip_addr.ip, flags, seq, remote_vtep_ip,
 			esi_buf);
 	}
@@ -1005,7 +1133,10 @@ static enum zclient_send_status bgp_zebra_send_remote_macip(
 	frrtrace(5, frr_bgp, evpn_mac_ip_zsend, add, vpn, p, remote_vtep_ip,
 		 esi);
 
-	return zclient_send_message(bgp_zclient);
+	if (evpn_zebra_batching)
+		return ret;
+
+	return bgp_evpn_macip_batch_flush(&evpn_zebra_batch);
 }
 
 /*
@@ -1764,6 +1895,7 @@ static int update_evpn_type5_route_entry(struct bgp *bgp_evpn, struct bgp *bgp_v
 				bgp_path_info_restore(dest, tmp_pi);
 
 			/* Unintern existing, set to new. */
+			bgp_path_info_attr_account(tmp_pi, attr_new);
 			bgp_attr_unintern(&tmp_pi->attr);
 			tmp_pi->attr = attr_new;
 			tmp_pi->uptime = monotime(NULL);
@@ -2191,6 +2323,7 @@ static int update_evpn_route_entry(struct bgp *bgp, struct bgpevpn *vpn,
 				bgp_path_info_restore(dest, tmp_pi);
 
 			/* Unintern existing, set to new. */
+			bgp_path_info_attr_account(tmp_pi, attr_new);
 			bgp_attr_unintern(&tmp_pi->attr);
 			tmp_pi->attr = attr_new;
 			tmp_pi->uptime = monotime(NULL);
@@ -3285,6 +3418,7 @@ static int install_evpn_route_entry_in_vrf(struct bgp *bgp_vrf,
 
 		bgp_path_info_set_flag(dest, pi, BGP_PATH_ATTR_CHANGED);
 		/* Unintern existing, set to new. */
+		bgp_path_info_attr_account(pi, attr_new);
 		bgp_attr_unintern(&pi->attr);
 		pi->attr = attr_new;
 		pi->uptime = monotime(NULL);
@@ -3442,6 +3576,7 @@ static int install_evpn_route_entry_in_vni_common(
 		}
 
 		/* Unintern existing, set to new. */
+		bgp_path_info_attr_account(pi, attr_new);
 		bgp_attr_unintern(&pi->attr);
 		pi->attr = attr_new;
 		pi->uptime = monotime(NULL);
@@ -212,6 +212,40 @@ extern enum zclient_send_status
 evpn_zebra_uninstall(struct bgp *bgp, struct bgpevpn *vpn,
 		     const struct prefix_evpn *p, struct bgp_path_info *pi,
 		     bool is_sync);
+
+/*
+ * Remote MAC/IP installs and withdrawals packed into bulk
+ * ZEBRA_REMOTE_MACIP_ADD/DEL messages.
+ */
+struct bgp_evpn_macip_batch {
+	/* message being built, ZAPI header included */
+	struct stream *s;
+	uint16_t cmd;
+	vrf_id_t vrf_id;
+	uint32_t entries;
+
+	/* hands a finished message to the transport */
+	enum zclient_send_status (*send)(struct stream *s, uint32_t entries);
+};
+
+extern void
+bgp_evpn_macip_batch_init(struct bgp_evpn_macip_batch *batch,
+			  enum zclient_send_status (*send)(struct stream *s,
+							   uint32_t entries));
+extern void bgp_evpn_macip_batch_fini(struct bgp_evpn_macip_batch *batch);
+extern enum zclient_send_status
+bgp_evpn_macip_batch_add(struct bgp_evpn_macip_batch *batch, bool add,
+			 vrf_id_t vrf_id, vni_t vni, const struct ethaddr *mac,
+			 const struct ipaddr *ip, const struct ipaddr *vtep_ip,
+			 uint8_t flags, uint32_t seq, const esi_t *esi);
+extern enum zclient_send_status
+bgp_evpn_macip_batch_flush(struct bgp_evpn_macip_batch *batch);
+
+extern void bgp_evpn_zebra_batch_begin(void);
+extern enum zclient_send_status bgp_evpn_zebra_batch_flush(void);
+extern enum zclient_send_status bgp_evpn_zebra_batch_end(void);
+extern void bgp_evpn_zebra_batch_finish(void);
+
 bool bgp_evpn_skip_vrf_import_of_local_es(struct bgp *bgp_vrf, const struct prefix_evpn *evp,
 					  struct bgp_path_info *pi, int install);
 int uninstall_evpn_route_entry_in_vrf(struct bgp *bgp_vrf, const struct prefix_evpn *evp,
@@ -319,6 +319,7 @@ static int bgp_evpn_es_route_install(struct bgp *bgp,
 			SET_FLAG(pi->flags, BGP_PATH_IGP_CHANGED);
 
 		/* Unintern existing, set to new. */
+		bgp_path_info_attr_account(pi, attr_new);
 		bgp_attr_unintern(&pi->attr);
 		pi->attr = attr_new;
 		pi->uptime = monotime(NULL);
@@ -525,6 +526,7 @@ int bgp_evpn_mh_route_update(struct bgp *bgp, struct bgp_evpn_es *es,
 				bgp_path_info_restore(dest, tmp_pi);
 
 			/* Unintern existing, set to new. */
+			bgp_path_info_attr_account(tmp_pi, attr_new);
 			bgp_attr_unintern(&tmp_pi->attr);
 			tmp_pi->attr = attr_new;
 			tmp_pi->uptime = monotime(NULL);
@@ -2311,6 +2313,7 @@ static void bgp_evpn_mac_update_on_es_local_chg(struct bgp_evpn_es *es,
 		else
 			UNSET_FLAG(attr_tmp.es_flags, ATTR_ES_IS_LOCAL);
 		attr_new = bgp_attr_intern(&attr_tmp);
+		bgp_path_info_attr_account(pi, attr_new);
 		bgp_attr_unintern(&pi->attr);
 		pi->attr = attr_new;
 		bgp_evpn_import_type2_route(pi, 1);
@@ -705,7 +705,7 @@ static void bgp_set_llgr_stale(struct peer *peer, afi_t afi, safi_t safi)
 	struct bgp_dest *dest;
 	struct bgp_path_info *pi, *next;
 	struct bgp_table *table;
-	struct attr attr;
+	struct attr attr, *attr_new;
 
 	if (safi == SAFI_MPLS_VPN || safi == SAFI_ENCAP || safi == SAFI_EVPN) {
 		for (dest = bgp_table_top(bgp->rib[afi][safi]); dest; dest = bgp_route_next(dest)) {
@@ -741,7 +741,9 @@ static void bgp_set_llgr_stale(struct peer *peer, afi_t afi, safi_t safi)
 
 					attr = *pi->attr;
 					bgp_attr_add_llgr_community(&attr);
-					pi->attr = bgp_attr_intern(&attr);
+					attr_new = bgp_attr_intern(&attr);
+					bgp_path_info_attr_account(pi, attr_new);
+					pi->attr = attr_new;
 					bgp_process(bgp, rm, pi, afi, safi);
 				}
 		}
@@ -770,7 +772,9 @@ static void bgp_set_llgr_stale(struct peer *peer, afi_t afi, safi_t safi)
 
 				attr = *pi->attr;
 				bgp_attr_add_llgr_community(&attr);
-				pi->attr = bgp_attr_intern(&attr);
+				attr_new = bgp_attr_intern(&attr);
+				bgp_path_info_attr_account(pi, attr_new);
+				pi->attr = attr_new;
 				bgp_process(bgp, dest, pi, afi, safi);
 			}
 	}
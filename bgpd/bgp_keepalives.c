@@ -13,7 +13,8 @@
 #include "hash.h"		// for hash, hash_clean, hash_create_size...
 #include "log.h"		// for zlog_debug
 #include "memory.h"		// for MTYPE_TMP, XFREE, XCALLOC, XMALLOC
-#include "monotime.h"		// for monotime, monotime_since
+#include "monotime.h"		// for monotime
+#include "typesafe.h"		// for PREDECL_DLIST, DECLARE_DLIST
 
 #include "bgpd/bgpd.h"          // for peer, PEER_EVENT_KEEPALIVES_ON, peer...
 #include "bgpd/bgp_debug.h"	// for bgp_debug_neighbor_events
@@ -25,98 +26,179 @@ DEFINE_MTYPE_STATIC(BGPD, BGP_PKAT, "Peer KeepAlive Timer");
 DEFINE_MTYPE_STATIC(BGPD, BGP_COND, "BGP Peer pthread Conditional");
 DEFINE_MTYPE_STATIC(BGPD, BGP_MUTEX, "BGP Peer pthread Mutex");
 
+/*
+ * Keepalive timer wheel.
+ *
+ * Peers are hashed into slots by the tick their next keepalive is due in, so
+ * that scheduling a peer and finding the peers due on a wakeup does not
+ * depend on the total number of peers. Peers due within the same tick are
+ * sent their keepalives together on one wakeup, which is what the former
+ * 100ms "send early" tolerance achieved with a walk over every peer.
+ *
+ * The wheel spans KA_WHEEL_SLOTS ticks; peers due further out than that
+ * simply stay in their slot for more than one rotation.
+ */
+#define KA_WHEEL_TICK_US (100 * 1000)
+#define KA_WHEEL_SLOTS	 1024
+
+PREDECL_DLIST(pkat_wheel);
+
 /*
  * Peer KeepAlive Timer.
- * Associates a peer with the time of its last keepalive.
+ * Associates a peer with the tick its next keepalive is due in.
  */
 struct pkat {
 	/* the peer to send keepalives to */
 	struct peer *peer;
-	/* absolute time of last keepalive sent */
-	struct timeval last;
+	/* wheel tick the next keepalive is due in */
+	uint64_t due;
+	/* wheel slot linkage */
+	struct pkat_wheel_item witem;
 };
 
+DECLARE_DLIST(pkat_wheel, struct pkat, witem);
+
 /* List of peers we are sending keepalives for, and associated mutex. */
 static pthread_mutex_t *peerhash_mtx;
 static pthread_cond_t *peerhash_cond;
 static struct hash *peerhash;
 
+/* Timer wheel, protected by peerhash_mtx. */
+static struct pkat_wheel_head wheel[KA_WHEEL_SLOTS];
+/* first tick not yet processed */
+static uint64_t wheel_tick;
+
+/* Wakeup statistics, protected by peerhash_mtx. */
+static struct bgp_keepalives_stats ka_stats;
+
+static inline uint64_t ka_wheel_now(void)
+{
+	return (uint64_t)monotime(NULL) / KA_WHEEL_TICK_US;
+}
+
+static void pkat_schedule(struct pkat *pkat, uint64_t now)
+{
+	uint32_t v_ka = atomic_load_explicit(&pkat->peer->v_keepalive,
+					     memory_order_relaxed);
+
+	/*
+	 * 0 keepalive timer means no keepalives; park the peer a full
+	 * rotation out so a later timer change is still picked up.
+	 */
+	if (v_ka == 0)
+		pkat->due = now + KA_WHEEL_SLOTS;
+	else
+		pkat->due = now + (uint64_t)v_ka * 1000000 / KA_WHEEL_TICK_US;
+
+	pkat_wheel_add_tail(&wheel[pkat->due % KA_WHEEL_SLOTS], pkat);
+}
+
 static struct pkat *pkat_new(struct peer *peer)
 {
-	struct pkat *pkat = XMALLOC(MTYPE_BGP_PKAT, sizeof(struct pkat));
+	struct pkat *pkat = XCALLOC(MTYPE_BGP_PKAT, sizeof(struct pkat));
+	uint64_t now = ka_wheel_now();
+
 	pkat->peer = peer;
-	monotime(&pkat->last);
+
+	/* nothing scheduled, don't make the thread walk the idle period */
+	if (peerhash->count == 0)
+		wheel_tick = now;
+	pkat_schedule(pkat, now);
 	return pkat;
 }
 
-static void pkat_del(void *pkat)
+static void pkat_del(void *arg)
 {
+	struct pkat *pkat = arg;
+
+	pkat_wheel_del(&wheel[pkat->due % KA_WHEEL_SLOTS], pkat);
 	XFREE(MTYPE_BGP_PKAT, pkat);
 }
 
-
 /*
- * Callback for hash_iterate. Determines if a peer needs a keepalive and if so,
- * generates and sends it.
- *
- * For any given peer, if the elapsed time since its last keepalive exceeds its
- * configured keepalive timer, a keepalive is sent to the peer and its
- * last-sent time is reset. Additionally, If the elapsed time does not exceed
- * the configured keepalive timer, but the time until the next keepalive is due
- * is within a hardcoded tolerance, a keepalive is sent as if the configured
- * timer was exceeded. Doing this helps alleviate nanosecond sleeps between
- * ticks by grouping together peers who are due for keepalives at roughly the
- * same time. This tolerance value is arbitrarily chosen to be 100ms.
- *
- * In addition, this function calculates the maximum amount of time that the
- * keepalive thread can sleep before another tick needs to take place. This is
- * equivalent to shortest time until a keepalive is due for any one peer.
+ * Sends keepalives to all peers in one wheel slot that are due at or before
+ * tick now, and reschedules them.
  *
- * @return maximum time to wait until next update (0 if infinity)
+ * @return number of keepalives sent
  */
-static void peer_process(struct hash_bucket *hb, void *arg)
+static uint32_t ka_wheel_run_slot(struct pkat_wheel_head *slot, uint64_t now)
 {
-	struct pkat *pkat = hb->data;
+	struct pkat *pkat;
+	uint32_t sent = 0;
 
-	struct timeval *next_update = arg;
+	frr_each_safe (pkat_wheel, slot, pkat) {
+		/* due in a later rotation */
+		if (pkat->due > now)
+			continue;
 
-	static struct timeval elapsed;  // elapsed time since keepalive
-	static struct timeval ka = {0}; // peer->v_keepalive as a timeval
-	static struct timeval diff;     // ka - elapsed
+		pkat_wheel_del(slot, pkat);
 
-	static const struct timeval tolerance = {0, 100000};
+		if (atomic_load_explicit(&pkat->peer->v_keepalive,
+					 memory_order_relaxed)) {
+			if (bgp_debug_keepalive(pkat->peer))
+				zlog_debug("%s [FSM] Timer (keepalive timer expire)",
+					   pkat->peer->host);
 
-	uint32_t v_ka = atomic_load_explicit(&pkat->peer->v_keepalive,
-					     memory_order_relaxed);
+			bgp_keepalive_send(pkat->peer->connection);
+			sent++;
+		}
 
-	/* 0 keepalive timer means no keepalives */
-	if (v_ka == 0)
-		return;
+		pkat_schedule(pkat, now);
+	}
+
+	return sent;
+}
 
-	/* calculate elapsed time since last keepalive */
-	monotime_since(&pkat->last, &elapsed);
+/*
+ * Processes all ticks up to and including now.
+ *
+ * @return tick of the next non-empty slot, 0 if the wheel is empty
+ */
+static uint64_t ka_wheel_run(uint64_t now)
+{
+	uint64_t tick = wheel_tick;
+	uint32_t sent = 0;
 
-	/* calculate difference between elapsed time and configured time */
-	ka.tv_sec = v_ka;
-	timersub(&ka, &elapsed, &diff);
+	/* after a long stall every slot is visited once */
+	if (now >= tick + KA_WHEEL_SLOTS)
+		tick = now - KA_WHEEL_SLOTS + 1;
 
-	int send_keepalive =
-		elapsed.tv_sec >= ka.tv_sec || timercmp(&diff, &tolerance, <);
+	for (; tick <= now; tick++)
+		sent += ka_wheel_run_slot(&wheel[tick % KA_WHEEL_SLOTS], now);
+	wheel_tick = now + 1;
 
-	if (send_keepalive) {
-		if (bgp_debug_keepalive(pkat->peer))
-			zlog_debug("%s [FSM] Timer (keepalive timer expire)",
-				   pkat->peer->host);
+	ka_stats.sent += sent;
+	if (sent > ka_stats.batch_max)
+		ka_stats.batch_max = sent;
 
-		bgp_keepalive_send(pkat->peer->connection);
-		monotime(&pkat->last);
-		memset(&elapsed, 0, sizeof(elapsed));
-		diff = ka;
-	}
+	if (peerhash->count == 0)
+		return 0;
+
+	for (tick = wheel_tick; tick < wheel_tick + KA_WHEEL_SLOTS; tick++)
+		if (pkat_wheel_count(&wheel[tick % KA_WHEEL_SLOTS]))
+			return tick;
 
-	/* if calculated next update for this peer < current delay, use it */
-	if (next_update->tv_sec < 0 || timercmp(&diff, next_update, <))
-		*next_update = diff;
+	return 0;
+}
+
+/* Accounts for how late a timed wakeup came in, in microseconds. */
+static void ka_stats_wakeup(int64_t late)
+{
+	ka_stats.wakeups++;
+	ka_stats.late_total += late;
+	if (ka_stats.wakeups == 1 || late < ka_stats.late_min)
+		ka_stats.late_min = late;
+	if (late > ka_stats.late_max)
+		ka_stats.late_max = late;
+
+	if (late < 1000)
+		ka_stats.late_hist[0]++;
+	else if (late < 10000)
+		ka_stats.late_hist[1]++;
+	else if (late < 100000)
+		ka_stats.late_hist[2]++;
+	else
+		ka_stats.late_hist[3]++;
 }
 
 static bool peer_hash_cmp(const void *f, const void *s)
@@ -137,6 +219,8 @@ static unsigned int peer_hash_key(const void *arg)
 static void bgp_keepalives_finish(void *arg)
 {
 	hash_clean_and_free(&peerhash, pkat_del);
+	for (unsigned int i = 0; i < KA_WHEEL_SLOTS; i++)
+		pkat_wheel_fini(&wheel[i]);
 
 	pthread_mutex_unlock(peerhash_mtx);
 	pthread_mutex_destroy(peerhash_mtx);
@@ -154,9 +238,8 @@ void *bgp_keepalives_start(void *arg)
 	struct frr_pthread *fpt = arg;
 	frr_event_loop_set_pthread_owner(fpt->master, pthread_self());
 
-	struct timeval currtime = {0, 0};
-	struct timeval aftertime = {0, 0};
-	struct timeval next_update = {0, 0};
+	uint64_t next_tick = 0;
+	int64_t deadline = 0, now;
 	struct timespec next_update_ts = {0, 0};
 
 	/*
@@ -187,8 +270,10 @@ void *bgp_keepalives_start(void *arg)
 	 */
 	frr_pthread_set_name(fpt);
 
-	/* initialize peer hashtable */
+	/* initialize peer hashtable and timer wheel */
 	peerhash = hash_create_size(2048, peer_hash_key, peer_hash_cmp, NULL);
+	for (unsigned int i = 0; i < KA_WHEEL_SLOTS; i++)
+		pkat_wheel_init(&wheel[i]);
 	pthread_mutex_lock(peerhash_mtx);
 
 	/* register cleanup handler */
@@ -207,18 +292,17 @@ void *bgp_keepalives_start(void *arg)
 						       memory_order_relaxed))
 				pthread_cond_wait(peerhash_cond, peerhash_mtx);
 
-		monotime(&currtime);
+		now = monotime(NULL);
 
-		next_update.tv_sec = -1;
+		/* woken up by a timeout rather than by bgp_keepalives_on() */
+		if (next_tick && now >= deadline)
+			ka_stats_wakeup(now - deadline);
 
-		hash_iterate(peerhash, peer_process, &next_update);
-		if (next_update.tv_sec == -1)
-			memset(&next_update, 0, sizeof(next_update));
+		next_tick = ka_wheel_run(now / KA_WHEEL_TICK_US);
 
-		monotime_since(&currtime, &aftertime);
-
-		timeradd(&currtime, &next_update, &next_update);
-		TIMEVAL_TO_TIMESPEC(&next_update, &next_update_ts);
+		deadline = next_tick * KA_WHEEL_TICK_US;
+		next_update_ts.tv_sec = deadline / 1000000;
+		next_update_ts.tv_nsec = (deadline % 1000000) * 1000;
 	}
 
 	/* clean up */
@@ -302,3 +386,16 @@ int bgp_keepalives_stop(struct frr_pthread *fpt, void **result)
 	pthread_join(fpt->thread, result);
 	return 0;
 }
+
+void bgp_keepalives_stats_get(struct bgp_keepalives_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+
+	if (!peerhash_mtx)
+		return;
+
+	frr_with_mutex (peerhash_mtx) {
+		*stats = ka_stats;
+		stats->peers = peerhash->count;
+	}
+}
@@ -49,8 +49,8 @@ extern void bgp_keepalives_init(void);
 /**
  * Entry function for keepalives pthread.
  *
- * This function loops over an internal list of peers, generating keepalives at
- * regular intervals as determined by each peer's keepalive timer.
+ * This function runs a timer wheel of peers, generating keepalives at regular
+ * intervals as determined by each peer's keepalive timer.
  *
  * See bgp_keepalives_on() for additional details.
  *
@@ -63,4 +63,26 @@ extern void *bgp_keepalives_start(void *arg);
  */
 int bgp_keepalives_stop(struct frr_pthread *fpt, void **result);
 
+/**
+ * Keepalive thread statistics.
+ * Latencies are in microseconds and measure how late the thread woke up
+ * compared to the wheel tick it was waiting for.
+ */
+struct bgp_keepalives_stats {
+	uint32_t peers;
+	uint64_t wakeups;
+	uint64_t sent;
+	uint32_t batch_max;
+	int64_t late_min;
+	int64_t late_max;
+	int64_t late_total;
+	/* < 1ms, < 10ms, < 100ms, >= 100ms */
+	uint64_t late_hist[4];
+};
+
+/**
+ * Copies out the keepalive thread statistics.
+ */
+extern void bgp_keepalives_stats_get(struct bgp_keepalives_stats *stats);
+
 #endif /* _FRR_BGP_KEEPALIVES_H */
@@ -39,6 +39,7 @@ static void lptest_finish(void);
 
 static void bgp_sync_label_manager(struct event *e);
 static void lp_chunk_free(void *goner);
+static void lp_prefetch_check(void);
 static void bgp_lp_release(mpls_label_t label, void *labelid, int type, bool check_type,
 			   bool debug_enabled);
 
@@ -65,12 +66,12 @@ DEFINE_MTYPE_STATIC(BGPD, BGP_LABEL_CHUNK, "BGP Label Chunk");
 DEFINE_MTYPE_STATIC(BGPD, BGP_LABEL_FIFO, "BGP Label FIFO item");
 DEFINE_MTYPE_STATIC(BGPD, BGP_LABEL_CB, "BGP Dynamic Label Assignment");
 DEFINE_MTYPE_STATIC(BGPD, BGP_LABEL_CBQ, "BGP Dynamic Label Callback");
+DEFINE_MTYPE_STATIC(BGPD, BGP_LABEL_RING, "BGP Free Label Ring");
 
 struct lp_chunk {
 	uint32_t	first;
 	uint32_t	last;
 	uint32_t nfree;		     /* un-allocated count */
-	uint32_t idx_last_allocated; /* start looking here */
 	bitfield_t allocated_map;
 };
 
@@ -173,6 +174,103 @@ static void lp_chunk_free(void *goner)
 	XFREE(MTYPE_BGP_LABEL_CHUNK, goner);
 }
 
+/*
+ * Free label ring
+ *
+ * All unallocated labels of all chunks sit in one FIFO ring, so getting a
+ * label no longer scans chunk bitfields; releasing one only has to find its
+ * chunk in our (short) chunk list.  The ring is sized to the total number of
+ * labels in our chunks and therefore can never overflow.  Released labels go
+ * to the tail, which keeps them out of circulation for as long as possible
+ * (as the old round-robin bitfield scan did).
+ */
+static void lp_ring_resize(uint32_t size)
+{
+	mpls_label_t *ring;
+	uint32_t i;
+
+	assert(lp->ring_count <= size);
+
+	if (!size) {
+		XFREE(MTYPE_BGP_LABEL_RING, lp->ring);
+		lp->ring_size = 0;
+		lp->ring_head = 0;
+		return;
+	}
+
+	ring = XMALLOC(MTYPE_BGP_LABEL_RING, size * sizeof(*ring));
+	for (i = 0; i < lp->ring_count; i++)
+		ring[i] = lp->ring[(lp->ring_head + i) % lp->ring_size];
+
+	XFREE(MTYPE_BGP_LABEL_RING, lp->ring);
+	lp->ring = ring;
+	lp->ring_size = size;
+	lp->ring_head = 0;
+}
+
+static inline void lp_ring_put(mpls_label_t label)
+{
+	assert(lp->ring_count < lp->ring_size);
+
+	lp->ring[(lp->ring_head + lp->ring_count) % lp->ring_size] = label;
+	lp->ring_count++;
+}
+
+static inline mpls_label_t lp_ring_get(void)
+{
+	mpls_label_t label;
+
+	if (!lp->ring_count)
+		return MPLS_LABEL_NONE;
+
+	label = lp->ring[lp->ring_head];
+	lp->ring_head = (lp->ring_head + 1) % lp->ring_size;
+	lp->ring_count--;
+	return label;
+}
+
+/* Drop a chunk's labels from the ring before handing it back to zebra */
+static void lp_ring_remove_chunk(const struct lp_chunk *chunk)
+{
+	uint32_t i, n = 0;
+	mpls_label_t label;
+
+	for (i = 0; i < lp->ring_count; i++) {
+		label = lp->ring[(lp->ring_head + i) % lp->ring_size];
+		if (label >= chunk->first && label <= chunk->last)
+			continue;
+		lp->ring[(lp->ring_head + n) % lp->ring_size] = label;
+		n++;
+	}
+	lp->ring_count = n;
+
+	lp_ring_resize(lp->ring_size - (chunk->last - chunk->first + 1));
+}
+
+static void lp_ring_flush(void)
+{
+	XFREE(MTYPE_BGP_LABEL_RING, lp->ring);
+	lp->ring_size = 0;
+	lp->ring_head = 0;
+	lp->ring_count = 0;
+}
+
+static struct lp_chunk *lp_chunk_find(mpls_label_t label,
+				      struct listnode **nodep)
+{
+	struct listnode *node;
+	struct lp_chunk *chunk;
+
+	for (ALL_LIST_ELEMENTS_RO(lp->chunks, node, chunk)) {
+		if ((label < chunk->first) || (label > chunk->last))
+			continue;
+		if (nodep)
+			*nodep = node;
+		return chunk;
+	}
+	return NULL;
+}
+
 void bgp_lp_init(struct event_loop *master, struct labelpool *pool)
 {
 	if (BGP_DEBUG(labelpool, LABELPOOL))
@@ -192,6 +290,7 @@ void bgp_lp_init(struct event_loop *master, struct labelpool *pool)
 	lp->callback_q->spec.max_retries = 0;
 
 	lp->next_chunksize = LP_CHUNK_SIZE_MIN;
+	lp->lowat = LP_CHUNK_SIZE_MIN / 4;
 
 #if BGP_LABELPOOL_ENABLE_TESTS
 	lptest_init();
@@ -225,6 +324,8 @@ void bgp_lp_finish(void)
 	if (!lp)
 		return;
 
+	event_cancel(&lp->t_prefetch);
+
 	skiplist_free(lp->ledger);
 	lp->ledger = NULL;
 
@@ -235,6 +336,7 @@ void bgp_lp_finish(void)
 		bgp_zebra_release_label_range(chunk->first, chunk->last);
 
 	list_delete(&lp->chunks);
+	lp_ring_flush();
 
 	while ((lf = lp_fifo_pop(&lp->requests))) {
 		check_bgp_lu_cb_unlock(&lf->lcb);
@@ -258,61 +360,33 @@ void bgp_lp_finish(void)
 
 static mpls_label_t get_label_from_pool(void *labelid)
 {
-	struct listnode *node;
 	struct lp_chunk *chunk;
-	int debug = BGP_DEBUG(labelpool, LABELPOOL);
-
-	/*
-	 * Find a free label
-	 */
-	for (ALL_LIST_ELEMENTS_RO(lp->chunks, node, chunk)) {
-		uintptr_t lbl;
-		unsigned int index;
-
-		if (debug)
-			zlog_debug("%s: chunk first=%u last=%u",
-				__func__, chunk->first, chunk->last);
-
-		/*
-		 * don't look in chunks with no available labels
-		 */
-		if (!chunk->nfree)
-			continue;
+	uintptr_t lbl;
+	mpls_label_t label;
 
-		/*
-		 * roll through bitfield starting where we stopped
-		 * last time
-		 */
-		index = bf_find_next_clear_bit_wrap(
-			&chunk->allocated_map, chunk->idx_last_allocated + 1,
-			0);
+	label = lp_ring_get();
+	if (label == MPLS_LABEL_NONE)
+		return MPLS_LABEL_NONE;
+
+	lbl = label;
+	if (skiplist_insert(lp->inuse, (void *)lbl, labelid)) {
+		/* something is very wrong */
+		flog_err(EC_BGP_LABEL_POOL_INSERT_FAIL,
+			 "%s: unable to insert inuse label %u (id %p)", __func__,
+			 label, labelid);
+		lp_ring_put(label);
+		return MPLS_LABEL_NONE;
+	}
 
-		/*
-		 * since chunk->nfree is non-zero, we should always get
-		 * a valid index
-		 */
-		assert(index != WORD_MAX);
-
-		lbl = chunk->first + index;
-		if (skiplist_insert(lp->inuse, (void *)lbl, labelid)) {
-			/* something is very wrong */
-			flog_err(EC_BGP_LABEL_POOL_INSERT_FAIL,
-				 "%s: unable to insert inuse label %u (id %p)", __func__,
-				 (uint32_t)lbl, labelid);
-			return MPLS_LABEL_NONE;
-		}
+	/* keep per-chunk accounting for "show bgp labelpool chunks" */
+	chunk = lp_chunk_find(label, NULL);
+	assert(chunk);
+	bf_set_bit(chunk->allocated_map, label - chunk->first);
+	chunk->nfree -= 1;
 
-		/*
-		 * Success
-		 */
-		bf_set_bit(chunk->allocated_map, index);
-		chunk->idx_last_allocated = index;
-		chunk->nfree -= 1;
-
-		return lbl;
-	}
+	lp_prefetch_check();
 
-	return MPLS_LABEL_NONE;
+	return label;
 }
 
 /*
@@ -487,25 +561,22 @@ static void bgp_lp_release(mpls_label_t label, void *labelid, int type, bool che
 		skiplist_delete(lp->inuse, (void *)lbl, NULL);
 
 		/*
-		 * Find the chunk this label belongs to and
-		 * deallocate the label in the chunk's bitfield
+		 * Find the chunk this label belongs to, deallocate the label
+		 * in the chunk's bitfield and make it available again
 		 */
-		for (ALL_LIST_ELEMENTS_RO(lp->chunks, node, chunk)) {
-			uint32_t index;
-
-			if ((label < chunk->first) || (label > chunk->last))
-				continue;
+		chunk = lp_chunk_find(label, &node);
+		if (chunk) {
+			uint32_t index = label - chunk->first;
 
-			index = label - chunk->first;
 			if (bf_test_index(chunk->allocated_map, index)) {
 				bf_release_index(chunk->allocated_map, index);
 				chunk->nfree += 1;
+				lp_ring_put(label);
 				deallocated = true;
 				if (debug_enabled)
 					zlog_debug("%s: released label %u from chunk, nfree now %u",
 						   __func__, label, chunk->nfree);
 			}
-			break;
 		}
 
 		if (!deallocated && debug_enabled) {
@@ -519,6 +590,7 @@ static void bgp_lp_release(mpls_label_t label, void *labelid, int type, bool che
 		if (found && deallocated && check_type &&
 		    chunk->nfree == chunk->last - chunk->first + 1 &&
 		    lp_fifo_count(&lp->requests) == 0) {
+			lp_ring_remove_chunk(chunk);
 			bgp_zebra_release_label_range(chunk->first, chunk->last);
 			list_delete_node(lp->chunks, node);
 			lp_chunk_free(chunk);
@@ -642,10 +714,43 @@ finishedrequest:
 	}
 }
 
+/*
+ * Chunk requests to the label manager are synchronous round-trips to
+ * zebra.  Rather than doing them only once the ring has run dry (with label
+ * requests piling up behind them), fetch the next chunk from an event as
+ * soon as the number of free labels drops below the low-water mark.
+ */
+static void lp_prefetch(struct event *e)
+{
+	if (lp->ring_count >= lp->lowat || lp->pending_count)
+		return;
+
+	if (BGP_DEBUG(labelpool, LABELPOOL))
+		zlog_debug("%s: %u free labels left, prefetching %u", __func__,
+			   lp->ring_count, lp->next_chunksize);
+
+	if (!bgp_zebra_request_label_range(MPLS_LABEL_BASE_ANY,
+					   lp->next_chunksize, true))
+		return;
+
+	lp->pending_count += lp->next_chunksize;
+	if ((lp->next_chunksize << 1) <= LP_CHUNK_SIZE_MAX)
+		lp->next_chunksize <<= 1;
+}
+
+static void lp_prefetch_check(void)
+{
+	if (lp->ring_count >= lp->lowat || lp->pending_count)
+		return;
+
+	event_add_event(bm->master, lp_prefetch, NULL, 0, &lp->t_prefetch);
+}
+
 void bgp_lp_event_chunk(uint32_t first, uint32_t last)
 {
 	struct lp_chunk *chunk;
 	uint32_t labelcount;
+	uint32_t i;
 
 	if (last < first) {
 		flog_err(EC_BGP_LABEL,
@@ -664,9 +769,18 @@ void bgp_lp_event_chunk(uint32_t first, uint32_t last)
 	bf_init(chunk->allocated_map, labelcount);
 
 	/*
-	 * Optimize for allocation by adding the new (presumably larger)
-	 * chunk at the head of the list so it is examined first.
+	 * Queue the new labels in the order the bitfield scan used to hand
+	 * them out (it started at index 1 and wrapped around to 0), so label
+	 * values seen on a fresh start stay the same.
 	 */
+	lp_ring_resize(lp->ring_size + labelcount);
+	for (i = 1; i < labelcount; i++)
+		lp_ring_put(first + i);
+	lp_ring_put(first);
+
+	/* keep roughly a quarter of the latest chunk in reserve */
+	lp->lowat = MAX(labelcount / 4, LP_CHUNK_SIZE_MIN / 4);
+
 	listnode_add_head(lp->chunks, chunk);
 
 	lp->pending_count -= labelcount;
@@ -714,6 +828,7 @@ void bgp_lp_event_zebra_up(void)
 	 * Invalidate current list of chunks
 	 */
 	list_delete_all_node(lp->chunks);
+	lp_ring_flush();
 
 	if (labels_needed && !bgp_zebra_request_label_range(MPLS_LABEL_BASE_ANY,
 							    labels_needed, true))
@@ -792,6 +907,7 @@ DEFUN(show_bgp_labelpool_summary, show_bgp_labelpool_summary_cmd,
 		json_object_int_add(json, "requests",
 				    lp_fifo_count(&lp->requests));
 		json_object_int_add(json, "labelChunks", listcount(lp->chunks));
+		json_object_int_add(json, "free", lp->ring_count);
 		json_object_int_add(json, "pending", lp->pending_count);
 		json_object_int_add(json, "reconnects", lp->reconnect_count);
 		vty_json(vty, json);
@@ -805,6 +921,7 @@ DEFUN(show_bgp_labelpool_summary, show_bgp_labelpool_summary_cmd,
 			"Requests:", lp_fifo_count(&lp->requests));
 		vty_out(vty, "%-13s %d\n",
 			"LabelChunks:", listcount(lp->chunks));
+		vty_out(vty, "%-13s %u\n", "Free:", lp->ring_count);
 		vty_out(vty, "%-13s %d\n", "Pending:", lp->pending_count);
 		vty_out(vty, "%-13s %d\n", "Reconnects:", lp->reconnect_count);
 	}
@@ -1294,12 +1411,24 @@ struct lp_test {
 	struct skiplist *timestamps_dealloc;
 	struct event *event_thread;
 	unsigned int counter[LPT_STAT_MAX];
+
+	/* churn test: release and re-request half the labels per round */
+	unsigned int churn_rounds;
+	unsigned int churn_done;
+	unsigned int churn_labels;
+	struct timeval churn_start;
+	int64_t churn_usec;
 };
 
 /* test parameters */
 #define LPT_MAX_COUNT 500000  /* get this many labels in all */
 #define LPT_BLKSIZE 10000     /* this many at a time, then yield */
 #define LPT_TS_INTERVAL 10000 /* timestamp every this many labels */
+#define LPT_CHURN_COUNT 100000 /* labels held during a churn test */
+#define LPT_CHURN_ROUNDS 20
+#define LPT_CHURN_WAIT_MSEC 10
+
+static void labelpool_churn_event_handler(struct event *event);
 
 
 static int test_cb(mpls_label_t label, void *labelid, bool allocated)
@@ -1379,12 +1508,88 @@ static void labelpool_test_event_handler(struct event *event)
 		 */
 		id = ((uintptr_t)tcb->generation << 24) |
 		     (tcb->request_count & 0x00ffffff);
-		bgp_lp_get(LP_TYPE_VRF, (void *)id, test_cb);
+		bgp_lp_get(LP_TYPE_VRF, (void *)id, VRF_DEFAULT, test_cb);
 	}
 
 	if (tcb->request_count < tcb->request_maximum)
-		thread_add_event(bm->master, labelpool_test_event_handler, NULL,
-				 0, &tcb->event_thread);
+		event_add_event(bm->master, labelpool_test_event_handler, NULL,
+				0, &tcb->event_thread);
+	else if (tcb->churn_rounds)
+		event_add_event(bm->master, labelpool_churn_event_handler,
+				NULL, 0, &tcb->event_thread);
+}
+
+/*
+ * Churn: once all labels of the test have been handed out, release every
+ * other one and immediately ask for as many new labels, for churn_rounds
+ * rounds.  This keeps the free label ring cycling without ever emptying a
+ * chunk.
+ */
+static void labelpool_churn_event_handler(struct event *event)
+{
+	struct lp_test *tcb;
+	void *Key, *cKey;
+	void *Value, *cValue;
+	void *cursor;
+	unsigned int iteration, released;
+	int rc;
+
+	if (skiplist_search(lp_tests, (void *)(uintptr_t)(lpt_generation),
+			    (void **)&tcb)) {
+		++lpt_test_event_tcb_lookup_fails;
+		return;
+	}
+
+	/* wait for the callbacks of the previous round to come in */
+	if ((unsigned int)skiplist_count(tcb->labels) < tcb->request_maximum) {
+		event_add_timer_msec(bm->master, labelpool_churn_event_handler,
+				     NULL, LPT_CHURN_WAIT_MSEC,
+				     &tcb->event_thread);
+		return;
+	}
+
+	if (!tcb->churn_done)
+		monotime(&tcb->churn_start);
+
+	if (tcb->churn_done == tcb->churn_rounds) {
+		tcb->churn_usec = monotime_since(&tcb->churn_start, NULL);
+		lpt_inprogress = false;
+		return;
+	}
+
+	cursor = NULL;
+	iteration = 0;
+	released = 0;
+	rc = skiplist_next(tcb->labels, &Key, &Value, &cursor);
+	while (!rc) {
+		cKey = Key;
+		cValue = Value;
+
+		/* find next item before we delete this one */
+		rc = skiplist_next(tcb->labels, &Key, &Value, &cursor);
+
+		if (!(iteration++ % 2)) {
+			bgp_lp_release((mpls_label_t)(uintptr_t)cValue, cKey,
+				       tcb->label_type, true, false);
+			skiplist_delete(tcb->labels, cKey, NULL);
+			++tcb->counter[LPT_STAT_DEALLOCATED];
+			++released;
+		}
+	}
+
+	while (released--) {
+		uintptr_t id;
+
+		++tcb->request_count;
+		id = ((uintptr_t)tcb->generation << 24) |
+		     (tcb->request_count & 0x00ffffff);
+		bgp_lp_get(tcb->label_type, (void *)id, VRF_DEFAULT, test_cb);
+		++tcb->churn_labels;
+	}
+
+	++tcb->churn_done;
+	event_add_event(bm->master, labelpool_churn_event_handler, NULL, 0,
+			&tcb->event_thread);
 }
 
 static void lptest_stop(void)
@@ -1408,7 +1613,8 @@ static void lptest_stop(void)
 	lpt_inprogress = false;
 }
 
-static int lptest_start(struct vty *vty)
+static int lptest_start(struct vty *vty, unsigned int count,
+			unsigned int churn_rounds)
 {
 	struct lp_test *tcb;
 
@@ -1430,7 +1636,7 @@ static int lptest_start(struct vty *vty)
 	 * We pack the generation and request number into the labelid;
 	 * make sure they fit.
 	 */
-	unsigned int n1 = LPT_MAX_COUNT;
+	unsigned int n1 = count + churn_rounds * ((count + 1) / 2);
 	unsigned int sh = 0;
 	unsigned int label_bits;
 
@@ -1445,8 +1651,8 @@ static int lptest_start(struct vty *vty)
 
 	if (sh > label_bits) {
 		vty_out(vty,
-			"Sorry, test iteration count too big on this platform (LPT_MAX_COUNT %u, need %u bits, but label_bits is only %u)\n",
-			LPT_MAX_COUNT, sh, label_bits);
+			"Sorry, test iteration count too big on this platform (count %u, need %u bits, but label_bits is only %u)\n",
+			count, sh, label_bits);
 		return -1;
 	}
 
@@ -1457,13 +1663,14 @@ static int lptest_start(struct vty *vty)
 
 	tcb->generation = lpt_generation;
 	tcb->label_type = LP_TYPE_VRF;
-	tcb->request_maximum = LPT_MAX_COUNT;
+	tcb->request_maximum = count;
 	tcb->request_blocksize = LPT_BLKSIZE;
+	tcb->churn_rounds = churn_rounds;
 	tcb->labels = skiplist_new(0, NULL, NULL);
 	tcb->timestamps_alloc = skiplist_new(0, NULL, NULL);
 	tcb->timestamps_dealloc = skiplist_new(0, NULL, NULL);
-	thread_add_event(bm->master, labelpool_test_event_handler, NULL, 0,
-			 &tcb->event_thread);
+	event_add_event(bm->master, labelpool_test_event_handler, NULL, 0,
+			&tcb->event_thread);
 	monotime(&tcb->starttime);
 
 	skiplist_insert(lp_tests, (void *)(uintptr_t)tcb->generation, tcb);
@@ -1476,7 +1683,21 @@ DEFPY(start_labelpool_perf_test, start_labelpool_perf_test_cmd,
       "label pool test\n"
       "start\n")
 {
-	lptest_start(vty);
+	lptest_start(vty, LPT_MAX_COUNT, 0);
+	return CMD_SUCCESS;
+}
+
+DEFPY(churn_labelpool_perf_test, churn_labelpool_perf_test_cmd,
+      "debug bgp lptest churn [(1-1000000)$count [rounds (1-1000)$rounds]]",
+      DEBUG_STR BGP_STR
+      "label pool test\n"
+      "allocate labels, then repeatedly release and reallocate half of them\n"
+      "number of labels to hold (default 100000)\n"
+      "number of churn rounds\n"
+      "rounds (default 20)\n")
+{
+	lptest_start(vty, count ? count : LPT_CHURN_COUNT,
+		     rounds ? rounds : LPT_CHURN_ROUNDS);
 	return CMD_SUCCESS;
 }
 
@@ -1512,6 +1733,16 @@ static void lptest_print_stats(struct vty *vty, struct lp_test *tcb)
 	}
 	vty_out(vty, "\n");
 
+	if (tcb->churn_rounds) {
+		vty_out(vty, "Churn: %u/%u rounds, %u labels reallocated",
+			tcb->churn_done, tcb->churn_rounds, tcb->churn_labels);
+		if (tcb->churn_usec && tcb->churn_labels)
+			vty_out(vty, " in %.3f s (%.2f us/label)",
+				(double)tcb->churn_usec / 1000000,
+				(double)tcb->churn_usec / tcb->churn_labels);
+		vty_out(vty, "\n\n");
+	}
+
 	if (tcb->timestamps_alloc) {
 		void *Key;
 		void *Value;
@@ -1653,8 +1884,8 @@ DEFPY(release_labelpool_perf_test, release_labelpool_perf_test_cmd,
 		rc = skiplist_next(tcb->labels, &Key, &Value, &cursor);
 
 		if (!(iteration % every_nth)) {
-			bgp_lp_release(tcb->label_type, cKey,
-				       (mpls_label_t)(uintptr_t)cValue);
+			bgp_lp_release((mpls_label_t)(uintptr_t)cValue, cKey,
+				       tcb->label_type, true, false);
 			skiplist_delete(tcb->labels, cKey, NULL);
 			++tcb->counter[LPT_STAT_DEALLOCATED];
 		}
@@ -1674,8 +1905,8 @@ static void lptest_delete(void *val)
 	if (tcb->labels) {
 		cursor = NULL;
 		while (!skiplist_next(tcb->labels, &Key, &Value, &cursor))
-			bgp_lp_release(tcb->label_type, Key,
-				       (mpls_label_t)(uintptr_t)Value);
+			bgp_lp_release((mpls_label_t)(uintptr_t)Value, Key,
+				       tcb->label_type, true, false);
 		skiplist_free(tcb->labels);
 		tcb->labels = NULL;
 	}
@@ -1727,6 +1958,7 @@ void bgp_lp_vty_init(void)
 
 #if BGP_LABELPOOL_ENABLE_TESTS
 	install_element(ENABLE_NODE, &start_labelpool_perf_test_cmd);
+	install_element(ENABLE_NODE, &churn_labelpool_perf_test_cmd);
 	install_element(ENABLE_NODE, &show_labelpool_perf_test_cmd);
 	install_element(ENABLE_NODE, &stop_labelpool_perf_test_cmd);
 	install_element(ENABLE_NODE, &release_labelpool_perf_test_cmd);
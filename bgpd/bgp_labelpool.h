@@ -31,6 +31,14 @@ struct labelpool {
 	uint32_t		pending_count;	/* requested from zebra */
 	uint32_t reconnect_count;		/* zebra reconnections */
 	uint32_t next_chunksize;		/* request this many labels */
+
+	/* unallocated labels of all chunks, see lp_ring_*() */
+	mpls_label_t *ring;
+	uint32_t ring_size;
+	uint32_t ring_head;
+	uint32_t ring_count;
+	uint32_t lowat;				/* prefetch below this */
+	struct event *t_prefetch;
 };
 
 extern void bgp_lp_init(struct event_loop *master, struct labelpool *pool);
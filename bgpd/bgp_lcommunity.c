@@ -562,19 +562,31 @@ void bgp_aggr_lcommunity_remove(void *arg)
 void bgp_compute_aggregate_lcommunity(struct bgp_aggregate *aggregate,
 				      struct lcommunity *lcommunity)
 {
+	struct lcommunity *merged;
 
-	bgp_compute_aggregate_lcommunity_hash(aggregate, lcommunity);
-	bgp_compute_aggregate_lcommunity_val(aggregate);
+	if (!bgp_compute_aggregate_lcommunity_hash(aggregate, lcommunity))
+		return;
+
+	if (!aggregate->lcommunity) {
+		bgp_compute_aggregate_lcommunity_val(aggregate);
+		return;
+	}
+
+	/* Merge just the new value instead of walking the whole hash */
+	merged = lcommunity_merge(aggregate->lcommunity, lcommunity);
+	aggregate->lcommunity = lcommunity_uniq_sort(merged);
+	lcommunity_free(&merged);
 }
 
-void bgp_compute_aggregate_lcommunity_hash(struct bgp_aggregate *aggregate,
+/* Returns true if the value was not part of the aggregate yet. */
+bool bgp_compute_aggregate_lcommunity_hash(struct bgp_aggregate *aggregate,
 					   struct lcommunity *lcommunity)
 {
 
 	struct lcommunity *aggr_lcommunity = NULL;
 
 	if ((aggregate == NULL) || (lcommunity == NULL))
-		return;
+		return false;
 
 	/* Create hash if not already created.
 	 */
@@ -595,6 +607,8 @@ void bgp_compute_aggregate_lcommunity_hash(struct bgp_aggregate *aggregate,
 	/* Increment reference counter.
 	 */
 	aggr_lcommunity->refcnt++;
+
+	return aggr_lcommunity->refcnt == 1;
 }
 
 void bgp_compute_aggregate_lcommunity_val(struct bgp_aggregate *aggregate)
@@ -620,35 +634,8 @@ void bgp_compute_aggregate_lcommunity_val(struct bgp_aggregate *aggregate)
 	}
 }
 
-void bgp_remove_lcommunity_from_aggregate(struct bgp_aggregate *aggregate,
-					  struct lcommunity *lcommunity)
-{
-	struct lcommunity *aggr_lcommunity = NULL;
-	struct lcommunity *ret_lcomm = NULL;
-
-	if ((!aggregate)
-	    || (!aggregate->lcommunity_hash)
-	    || (!lcommunity))
-		return;
-
-	/* Look-up the lcommunity in the hash.
-	 */
-	aggr_lcommunity = bgp_aggr_lcommunity_lookup(aggregate, lcommunity);
-	if (aggr_lcommunity) {
-		aggr_lcommunity->refcnt--;
-
-		if (aggr_lcommunity->refcnt == 0) {
-			ret_lcomm = hash_release(aggregate->lcommunity_hash,
-						 aggr_lcommunity);
-			lcommunity_free(&ret_lcomm);
-
-			bgp_compute_aggregate_lcommunity_val(aggregate);
-
-		}
-	}
-}
-
-void bgp_remove_lcomm_from_aggregate_hash(struct bgp_aggregate *aggregate,
+/* Returns true if the last reference to the value went away. */
+bool bgp_remove_lcomm_from_aggregate_hash(struct bgp_aggregate *aggregate,
 					  struct lcommunity *lcommunity)
 {
 	struct lcommunity *aggr_lcommunity = NULL;
@@ -657,7 +644,7 @@ void bgp_remove_lcomm_from_aggregate_hash(struct bgp_aggregate *aggregate,
 	if ((!aggregate)
 	    || (!aggregate->lcommunity_hash)
 	    || (!lcommunity))
-		return;
+		return false;
 
 	/* Look-up the lcommunity in the hash.
 	 */
@@ -669,6 +656,8 @@ void bgp_remove_lcomm_from_aggregate_hash(struct bgp_aggregate *aggregate,
 			ret_lcomm = hash_release(aggregate->lcommunity_hash,
 						 aggr_lcommunity);
 			lcommunity_free(&ret_lcomm);
+			return true;
 		}
 	}
+	return false;
 }
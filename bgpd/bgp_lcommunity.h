@@ -63,16 +63,12 @@ extern void bgp_compute_aggregate_lcommunity(
 					struct bgp_aggregate *aggregate,
 					struct lcommunity *lcommunity);
 
-extern void bgp_compute_aggregate_lcommunity_hash(
+extern bool bgp_compute_aggregate_lcommunity_hash(
 					struct bgp_aggregate *aggregate,
 					struct lcommunity *lcommunity);
 extern void bgp_compute_aggregate_lcommunity_val(
 					struct bgp_aggregate *aggregate);
-
-extern void bgp_remove_lcommunity_from_aggregate(
-					struct bgp_aggregate *aggregate,
-					struct lcommunity *lcommunity);
-extern void bgp_remove_lcomm_from_aggregate_hash(
+extern bool bgp_remove_lcomm_from_aggregate_hash(
 					struct bgp_aggregate *aggregate,
 					struct lcommunity *lcommunity);
 extern void bgp_aggr_lcommunity_remove(void *arg);
@@ -515,6 +515,7 @@ int bgp_ls_update(struct bgp *bgp, struct bgp_ls_nlri *nlri, struct bgp_ls_attr
 			/* unset of previous already took care of pcount */
 			SET_FLAG(bpi->flags, BGP_PATH_VALID);
 
+			bgp_path_info_attr_account(bpi, attr_new);
 			bgp_attr_unintern(&bpi->attr);
 			bpi->attr = attr_new;
 			bpi->uptime = monotime(NULL);
@@ -653,7 +654,7 @@ int bgp_ls_withdraw(struct bgp *bgp, struct bgp_ls_nlri *nlri)
 int bgp_nlri_parse_ls(struct peer *peer, struct attr *attr, struct bgp_nlri *packet)
 {
 	struct stream *s;
-	struct bgp_ls_nlri *nlri;
+	struct bgp_ls_nlri nlri;
 	struct prefix p;
 	struct bgp_ls_nlri *ls_entry;
 	struct bgp_dest *dest;
@@ -667,22 +668,17 @@ int bgp_nlri_parse_ls(struct peer *peer, struct attr *attr, struct bgp_nlri *pac
 	stream_set_getp(s, 0);
 
 	while (STREAM_READABLE(s) > 0) {
-		nlri = bgp_ls_nlri_alloc();
-		if (!nlri) {
-			ret = BGP_NLRI_PARSE_ERROR;
-			goto done;
-		}
-
-		ret = bgp_ls_decode_nlri(s, nlri);
+		/* NLRIs are flat, decode on the stack and only copy when interning */
+		memset(&nlri, 0, sizeof(nlri));
+		ret = bgp_ls_decode_nlri(s, &nlri);
 		if (ret < 0) {
-			bgp_ls_nlri_free(nlri);
 			flog_warn(EC_BGP_LS_PACKET, "%s [Error] Failed to decode BGP-LS NLRI",
 				  peer->host);
 			ret = BGP_NLRI_PARSE_ERROR;
 			goto done;
 		}
 
-		ls_entry = bgp_ls_nlri_get(&peer->bgp->ls_info->nlri_hash, peer->bgp, nlri);
+		ls_entry = bgp_ls_nlri_get(&peer->bgp->ls_info->nlri_hash, peer->bgp, &nlri);
 
 		memset(&p, 0, sizeof(p));
 		p.family = AF_UNSPEC;
@@ -704,9 +700,7 @@ int bgp_nlri_parse_ls(struct peer *peer, struct attr *attr, struct bgp_nlri *pac
 
 		if (BGP_DEBUG(linkstate, LINKSTATE))
 			zlog_debug("%s processed BGP-LS %s NLRI type=%u", peer->host,
-				   attr ? "UPDATE" : "WITHDRAW", nlri->nlri_type);
-
-		bgp_ls_nlri_free(nlri);
+				   attr ? "UPDATE" : "WITHDRAW", nlri.nlri_type);
 	}
 
 done:
@@ -860,6 +854,7 @@ void bgp_ls_cleanup(struct bgp *bgp)
 	ls_ted_del_all(&bgp->ls_info->ted);
 
 	idalloc_destroy(bgp->ls_info->allocator);
+	bgp_ls_nlri_fini();
 
 	XFREE(MTYPE_BGP_LS, bgp->ls_info);
 
@@ -476,26 +476,6 @@ struct bgp_ls_nlri *bgp_ls_nlri_alloc(void)
 
 void bgp_ls_nlri_free(struct bgp_ls_nlri *nlri)
 {
-	if (!nlri)
-		return;
-
-	switch (nlri->nlri_type) {
-	case BGP_LS_NLRI_TYPE_NODE:
-		break;
-
-	case BGP_LS_NLRI_TYPE_LINK:
-		XFREE(MTYPE_BGP_LS_NLRI, nlri->nlri_data.link.link_desc.mt_id);
-		break;
-
-	case BGP_LS_NLRI_TYPE_IPV4_PREFIX:
-	case BGP_LS_NLRI_TYPE_IPV6_PREFIX:
-		XFREE(MTYPE_BGP_LS_NLRI, nlri->nlri_data.prefix.prefix_desc.mt_id);
-		break;
-
-	case BGP_LS_NLRI_TYPE_RESERVED:
-		break;
-	}
-
 	XFREE(MTYPE_BGP_LS_NLRI, nlri);
 }
 
@@ -527,56 +507,54 @@ void bgp_ls_attr_free(struct bgp_ls_attr *attr)
 	XFREE(MTYPE_BGP_LS_ATTR, attr);
 }
 
-/* Deep copy BGP-LS NLRI (including dynamic fields) */
+/* Scratch buffer the wire encoding of NLRIs being interned is built in */
+static struct stream *bgp_ls_nlri_scratch;
+
+/*
+ * Copy BGP-LS NLRI for interning
+ *
+ * The NLRI is flat, so this is a plain copy; the wire encoding is built once
+ * here and appended to the same allocation for bgp_ls_encode_nlri() to reuse.
+ */
 struct bgp_ls_nlri *bgp_ls_nlri_copy(const struct bgp_ls_nlri *nlri)
 {
 	struct bgp_ls_nlri *nlri_copy;
+	struct stream *s;
+	size_t wire_len = 0;
+	size_t max_len;
 
 	if (!nlri)
 		return NULL;
 
-	/* Allocate and copy NLRI */
-	nlri_copy = XCALLOC(MTYPE_BGP_LS_NLRI, sizeof(*nlri_copy));
-	memcpy(nlri_copy, nlri, sizeof(*nlri_copy));
-	nlri_copy->refcnt = 0;
+	max_len = BGP_LS_NLRI_TYPE_SIZE + BGP_LS_NLRI_LENGTH_SIZE + bgp_ls_nlri_size(nlri);
+	if (!bgp_ls_nlri_scratch)
+		bgp_ls_nlri_scratch = stream_new(MAX(max_len, 256U));
+	else if (STREAM_SIZE(bgp_ls_nlri_scratch) < max_len)
+		stream_resize_inplace(&bgp_ls_nlri_scratch, max_len);
 
-	/* Copy type-specific dynamically allocated fields */
-	switch (nlri->nlri_type) {
-	case BGP_LS_NLRI_TYPE_NODE:
-		break;
-
-	case BGP_LS_NLRI_TYPE_LINK:
-		/* Copy link descriptor mt_id */
-		if (nlri->nlri_data.link.link_desc.mt_id) {
-			size_t mt_size = nlri->nlri_data.link.link_desc.mt_id_count *
-					 sizeof(uint16_t);
-			nlri_copy->nlri_data.link.link_desc.mt_id = XCALLOC(MTYPE_BGP_LS_NLRI,
-									    mt_size);
-			memcpy(nlri_copy->nlri_data.link.link_desc.mt_id,
-			       nlri->nlri_data.link.link_desc.mt_id, mt_size);
-		}
-		break;
+	s = bgp_ls_nlri_scratch;
+	stream_reset(s);
+	if (bgp_ls_encode_nlri(s, nlri) > 0)
+		wire_len = stream_get_endp(s);
 
-	case BGP_LS_NLRI_TYPE_IPV4_PREFIX:
-	case BGP_LS_NLRI_TYPE_IPV6_PREFIX:
-		/* Copy prefix descriptor mt_id */
-		if (nlri->nlri_data.prefix.prefix_desc.mt_id) {
-			size_t mt_size = nlri->nlri_data.prefix.prefix_desc.mt_id_count *
-					 sizeof(uint16_t);
-			nlri_copy->nlri_data.prefix.prefix_desc.mt_id = XCALLOC(MTYPE_BGP_LS_NLRI,
-										mt_size);
-			memcpy(nlri_copy->nlri_data.prefix.prefix_desc.mt_id,
-			       nlri->nlri_data.prefix.prefix_desc.mt_id, mt_size);
-		}
-		break;
-
-	case BGP_LS_NLRI_TYPE_RESERVED:
-		break;
-	}
+	nlri_copy = XCALLOC(MTYPE_BGP_LS_NLRI, sizeof(*nlri_copy) + wire_len);
+	memcpy(nlri_copy, nlri, sizeof(*nlri_copy));
+	memset(&nlri_copy->hash_item, 0, sizeof(nlri_copy->hash_item));
+	nlri_copy->refcnt = 0;
+	nlri_copy->id = 0;
+	nlri_copy->wire_len = wire_len;
+	memcpy(nlri_copy->wire, STREAM_DATA(s), wire_len);
 
 	return nlri_copy;
 }
 
+/* Release the encoding scratch buffer */
+void bgp_ls_nlri_fini(void)
+{
+	stream_free(bgp_ls_nlri_scratch);
+	bgp_ls_nlri_scratch = NULL;
+}
+
 struct bgp_ls_attr *bgp_ls_attr_copy(const struct bgp_ls_attr *src)
 {
 	struct bgp_ls_attr *dst;
@@ -1324,16 +1302,11 @@ struct bgp_ls_nlri *bgp_ls_nlri_get(struct bgp_ls_nlri_hash_head *hash, struct b
 /* Lookup NLRI in BGP-LS NLRI hash table */
 struct bgp_ls_nlri *bgp_ls_nlri_lookup(struct bgp_ls_nlri_hash_head *hash, struct bgp_ls_nlri *nlri)
 {
-	struct bgp_ls_nlri lookup;
-
 	if (!hash)
 		return NULL;
 
-	memset(&lookup, 0, sizeof(lookup));
-	lookup.nlri_type = nlri->nlri_type;
-	lookup.nlri_data = nlri->nlri_data;
-
-	return bgp_ls_nlri_hash_find(hash, &lookup);
+	/* Only the type and descriptors are looked at, no need for a copy */
+	return bgp_ls_nlri_hash_find(hash, nlri);
 }
 
 /* Insert or lookup BGP-LS attribute in hash table */
@@ -2044,6 +2017,14 @@ int bgp_ls_encode_nlri(struct stream *s, const struct bgp_ls_nlri *nlri)
 	if (!s || !nlri)
 		return -1;
 
+	/* Interned NLRIs carry their encoding, it only needs copying */
+	if (nlri->wire_len) {
+		if (STREAM_WRITEABLE(s) < nlri->wire_len)
+			return -1;
+		stream_put(s, nlri->wire, nlri->wire_len);
+		return nlri->wire_len;
+	}
+
 	/* Validate NLRI */
 	if (!bgp_ls_nlri_validate(nlri))
 		return -1;
@@ -2780,7 +2761,6 @@ int bgp_ls_decode_link_descriptor(struct stream *s, struct bgp_ls_link_descripto
 				goto error;
 			}
 			desc->mt_id_count = tlv_len / 2;
-			desc->mt_id = XCALLOC(MTYPE_BGP_LS_NLRI, tlv_len);
 			for (uint16_t i = 0; i < desc->mt_id_count; i++)
 				desc->mt_id[i] = stream_getw(s);
 			BGP_LS_TLV_SET(desc->present_tlvs, BGP_LS_LINK_DESC_MT_ID_BIT);
@@ -2821,8 +2801,6 @@ int bgp_ls_decode_link_descriptor(struct stream *s, struct bgp_ls_link_descripto
 	return 0;
 
 error:
-	XFREE(MTYPE_BGP_LS_NLRI, desc->mt_id);
-	desc->mt_id = NULL;
 	desc->mt_id_count = 0;
 	return -1;
 }
@@ -2879,7 +2857,6 @@ int bgp_ls_decode_prefix_descriptor(struct stream *s, struct bgp_ls_prefix_descr
 				goto error;
 			}
 			desc->mt_id_count = tlv_len / 2;
-			desc->mt_id = XCALLOC(MTYPE_BGP_LS_NLRI, tlv_len);
 			for (uint16_t i = 0; i < desc->mt_id_count; i++)
 				desc->mt_id[i] = stream_getw(s);
 			BGP_LS_TLV_SET(desc->present_tlvs, BGP_LS_PREFIX_DESC_MT_ID_BIT);
@@ -2985,8 +2962,6 @@ int bgp_ls_decode_prefix_descriptor(struct stream *s, struct bgp_ls_prefix_descr
 	return 0;
 
 error:
-	XFREE(MTYPE_BGP_LS_NLRI, desc->mt_id);
-	desc->mt_id = NULL;
 	desc->mt_id_count = 0;
 	return -1;
 }
@@ -363,7 +363,7 @@ struct bgp_ls_link_descriptor {
 	struct in6_addr ipv6_neigh_addr; /* IPv6 Neighbor Address */
 	as_t remote_asn;		 /* Remote AS Number */
 	uint8_t mt_id_count;		 /* Number of Multi-Topology IDs */
-	uint16_t *mt_id;		 /* Multi-Topology IDs */
+	uint16_t mt_id[BGP_LS_MAX_MT_ID]; /* Multi-Topology IDs */
 };
 
 /*
@@ -373,7 +373,7 @@ struct bgp_ls_link_descriptor {
 struct bgp_ls_prefix_descriptor {
 	uint16_t present_tlvs;			     /* Bitmask of present TLVs */
 	uint8_t mt_id_count;			     /* Number of Multi-Topology IDs */
-	uint16_t *mt_id;			     /* Multi-Topology IDs */
+	uint16_t mt_id[BGP_LS_MAX_MT_ID];	     /* Multi-Topology IDs */
 	enum bgp_ls_ospf_route_type ospf_route_type; /* OSPF Route Type */
 	struct prefix prefix;			     /* IP prefix (IPv4 or IPv6) */
 };
@@ -503,6 +503,14 @@ struct bgp_ls_nlri {
 
 	/* Hash table linkage */
 	struct bgp_ls_nlri_hash_item hash_item;
+
+	/*
+	 * Wire encoding (Type, Length, Value) of an interned NLRI, stored in
+	 * the same allocation so it is only built once and then copied into
+	 * every UPDATE.  Always 0 on NLRIs that are not interned.
+	 */
+	uint16_t wire_len;
+	uint8_t wire[];
 };
 
 /* Forward declare the hash table */
@@ -645,6 +653,7 @@ extern void bgp_ls_nlri_free(struct bgp_ls_nlri *nlri);
 extern struct bgp_ls_attr *bgp_ls_attr_alloc(void);
 extern void bgp_ls_attr_free(struct bgp_ls_attr *attr);
 extern struct bgp_ls_nlri *bgp_ls_nlri_copy(const struct bgp_ls_nlri *nlri);
+extern void bgp_ls_nlri_fini(void);
 struct bgp_ls_attr *bgp_ls_attr_copy(const struct bgp_ls_attr *src);
 
 /* NLRI validation functions */
@@ -1117,6 +1117,49 @@ int bgp_ls_process_subnet(struct bgp *bgp, struct ls_subnet *subnet, uint8_t eve
  * ===========================================================================
  */
 
+/*
+ * Check whether an UPDATE carries exactly what the TED already holds
+ *
+ * IGPs re-flood unchanged LSPs/LSAs on every refresh.  Re-originating those
+ * rebuilds the BGP-LS attribute and interns it only to find the RIB entry
+ * unchanged, so only real deltas are exported.  SYNC and ADD are always
+ * exported, they are what (re)populates the TED.  Elements that could not be
+ * exported yet for lack of a destination or advertising vertex never count
+ * as unchanged.
+ */
+static bool bgp_ls_ted_unchanged(struct ls_ted *ted, struct ls_message *msg)
+{
+	struct ls_vertex *vertex;
+	struct ls_edge *edge;
+	struct ls_subnet *subnet;
+
+	if (msg->event != LS_MSG_EVENT_UPDATE)
+		return false;
+
+	switch (msg->type) {
+	case LS_MSG_TYPE_NODE:
+		if (!msg->data.node)
+			return false;
+		vertex = ls_find_vertex_by_id(ted, msg->data.node->adv);
+		return vertex && ls_node_same(vertex->node, msg->data.node);
+
+	case LS_MSG_TYPE_ATTRIBUTES:
+		if (!msg->data.attr)
+			return false;
+		edge = ls_find_edge_by_source(ted, msg->data.attr);
+		return edge && edge->destination &&
+		       ls_attributes_same(edge->attributes, msg->data.attr);
+
+	case LS_MSG_TYPE_PREFIX:
+		if (!msg->data.prefix)
+			return false;
+		subnet = ls_find_subnet(ted, &msg->data.prefix->pref);
+		return subnet && subnet->vertex && ls_prefix_same(subnet->ls_pref, msg->data.prefix);
+	}
+
+	return false;
+}
+
 /*
  * Process link-state message and update TED
  *
@@ -1130,10 +1173,14 @@ int bgp_ls_process_message(struct bgp *bgp, struct ls_message *msg)
 	struct ls_edge *reverse_edge = NULL;
 	bool reverse_edge_dst_updated = false;
 	struct ls_subnet *subnet;
+	bool unchanged;
 
 	if (!bgp || !bgp->ls_info || !bgp->ls_info->ted || !msg)
 		return -1;
 
+	/* Must be checked before the TED takes over the message data */
+	unchanged = bgp_ls_ted_unchanged(bgp->ls_info->ted, msg);
+
 	if (BGP_DEBUG(zebra, ZEBRA) || BGP_DEBUG(linkstate, LINKSTATE)) {
 		const char *type_str = msg->type == LS_MSG_TYPE_NODE	     ? "NODE"
 				       : msg->type == LS_MSG_TYPE_ATTRIBUTES ? "ATTR"
@@ -1153,9 +1200,11 @@ int bgp_ls_process_message(struct bgp *bgp, struct ls_message *msg)
 		}
 
 		if (BGP_DEBUG(zebra, ZEBRA) || BGP_DEBUG(linkstate, LINKSTATE))
-			zlog_debug("%s: Node vertex key=%" PRIu64, __func__, vertex->key);
+			zlog_debug("%s: Node vertex key=%" PRIu64 "%s", __func__, vertex->key,
+				   unchanged ? " unchanged" : "");
 
-		bgp_ls_process_vertex(bgp, vertex, msg->event);
+		if (!unchanged)
+			bgp_ls_process_vertex(bgp, vertex, msg->event);
 
 		if (msg->event == LS_MSG_EVENT_DELETE)
 			ls_vertex_del_all(bgp->ls_info->ted, vertex);
@@ -1208,7 +1257,18 @@ int bgp_ls_process_message(struct bgp *bgp, struct ls_message *msg)
 				break;
 			}
 
-			bgp_ls_process_edge(bgp, edge, msg->event);
+			/*
+			 * An unchanged edge was complete before this update, so it
+			 * and its reverse have been exported already.
+			 */
+			if (unchanged && !reverse_edge_dst_updated) {
+				if (BGP_DEBUG(zebra, ZEBRA) || BGP_DEBUG(linkstate, LINKSTATE))
+					zlog_debug("%s: Skip unchanged edge", __func__);
+				break;
+			}
+
+			if (!unchanged)
+				bgp_ls_process_edge(bgp, edge, msg->event);
 
 			/*
 			 * After we process edge A->B, check whether reverse edge B->A is
@@ -1252,10 +1312,11 @@ int bgp_ls_process_message(struct bgp *bgp, struct ls_message *msg)
 			char buf[PREFIX2STR_BUFFER];
 
 			prefix2str(&subnet->key, buf, sizeof(buf));
-			zlog_debug("%s: Prefix %s", __func__, buf);
+			zlog_debug("%s: Prefix %s%s", __func__, buf, unchanged ? " unchanged" : "");
 		}
 
-		bgp_ls_process_subnet(bgp, subnet, msg->event);
+		if (!unchanged)
+			bgp_ls_process_subnet(bgp, subnet, msg->event);
 
 		if (msg->event == LS_MSG_EVENT_DELETE)
 			ls_subnet_del_all(bgp->ls_info->ted, subnet);
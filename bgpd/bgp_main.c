@@ -47,6 +47,7 @@
 #include "bgpd/bgp_network.h"
 #include "bgpd/bgp_errors.h"
 #include "bgpd/bgp_script.h"
+#include "bgpd/bgp_evpn.h"
 #include "bgpd/bgp_evpn_mh.h"
 #include "bgpd/bgp_nhg.h"
 #include "bgpd/bgp_routemap_nb.h"
@@ -191,6 +192,7 @@ static FRR_NORETURN void bgp_exit(int status)
 		bgp_delete(bgp_default);
 
 	bgp_evpn_mh_finish();
+	bgp_evpn_zebra_batch_finish();
 	bgp_nhg_finish();
 
 	zebra_announce_fini(&bm->zebra_announce_head);
@@ -33,6 +33,7 @@ DECLARE_MTYPE(AS_STR);
 
 DECLARE_MTYPE(BGP_TABLE);
 DECLARE_MTYPE(BGP_NODE);
+DECLARE_MTYPE(BGP_TABLE_NODE);
 DECLARE_MTYPE(BGP_ROUTE);
 DECLARE_MTYPE(BGP_ROUTE_EXTRA);
 DECLARE_MTYPE(BGP_ROUTE_EXTRA_EVPN);
@@ -15,6 +15,7 @@
 #include "mpls.h"
 #include "json.h"
 #include "zclient.h"
+#include "jhash.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_debug.h"
@@ -42,6 +43,7 @@
 
 DEFINE_MTYPE_STATIC(BGPD, MPLSVPN_NH_LABEL_BIND_CACHE,
 		    "BGP MPLSVPN nexthop label bind cache");
+DEFINE_MTYPE_STATIC(BGPD, BGP_VPN_IMPORT_MAP, "BGP VPN RT import map");
 
 /*
  * Definitions and external declarations.
@@ -1351,6 +1353,7 @@ leak_update(struct bgp *to_bgp, struct bgp_dest *bn,
 			bgp_path_info_restore(bn, bpi);
 		else
 			bgp_aggregate_decrement(to_bgp, p, bpi, afi, safi);
+		bgp_path_info_attr_account(bpi, new_attr);
 		bgp_attr_unintern(&bpi->attr);
 		bpi->attr = new_attr;
 		bpi->uptime = monotime(NULL);
@@ -2701,11 +2704,249 @@ bool vpn_leak_to_vrf_no_retain_filter_check(struct bgp *from_bgp,
 	return true;
 }
 
+/*
+ * Route-target import map
+ *
+ * For every route-target some VRF imports from VPN ("rt vpn import"), keep
+ * the list of VRFs doing so.  A VPN route then only visits the VRFs that
+ * can import it rather than every BGP instance, which keeps per-route leak
+ * cost flat as the number of VRFs grows.
+ *
+ * VRFs whose import RT list uses a non-standard unit size (IPv6 extended
+ * communities) can't be keyed this way and are kept on a separate list
+ * that is always visited.  The map only narrows down the candidates;
+ * vpn_leak_to_vrf_update_onevrf() still does the real RT intersection.
+ *
+ * The map is thrown away whenever an import RT list may have changed and
+ * rebuilt on next use.
+ */
+struct vpn_import_vrf {
+	struct bgp *bgp;
+	/* last lookup this VRF was returned for, to suppress duplicates */
+	uint32_t mark;
+};
+
+PREDECL_HASH(vpn_import_rts);
+
+struct vpn_import_rt {
+	struct vpn_import_rts_item itm;
+
+	uint8_t val[ECOMMUNITY_SIZE];
+
+	/* indexes into vpn_import_map.vrfs[afi] */
+	uint32_t *vrfs;
+	uint32_t n_vrfs;
+	uint32_t n_alloc;
+};
+
+static int vpn_import_rt_cmp(const struct vpn_import_rt *a,
+			     const struct vpn_import_rt *b)
+{
+	return memcmp(a->val, b->val, ECOMMUNITY_SIZE);
+}
+
+static uint32_t vpn_import_rt_hash(const struct vpn_import_rt *rt)
+{
+	return jhash(rt->val, ECOMMUNITY_SIZE, 0x2f8e1b55);
+}
+
+DECLARE_HASH(vpn_import_rts, struct vpn_import_rt, itm, vpn_import_rt_cmp,
+	     vpn_import_rt_hash);
+
+static struct vpn_import_map {
+	bool valid;
+	uint32_t mark;
+
+	struct vpn_import_rts_head rts[AFI_MAX];
+
+	struct vpn_import_vrf *vrfs[AFI_MAX];
+	uint32_t n_vrfs[AFI_MAX];
+
+	/* VRFs that can't be indexed by RT and are always candidates */
+	uint32_t *any[AFI_MAX];
+	uint32_t n_any[AFI_MAX];
+} vpn_import_map;
+
+void vpn_leak_import_map_invalidate(void)
+{
+	struct vpn_import_rt *rt;
+	afi_t afi;
+
+	if (!vpn_import_map.valid)
+		return;
+
+	for (afi = AFI_IP; afi < AFI_MAX; afi++) {
+		while ((rt = vpn_import_rts_pop(&vpn_import_map.rts[afi]))) {
+			XFREE(MTYPE_BGP_VPN_IMPORT_MAP, rt->vrfs);
+			XFREE(MTYPE_BGP_VPN_IMPORT_MAP, rt);
+		}
+		vpn_import_rts_fini(&vpn_import_map.rts[afi]);
+
+		XFREE(MTYPE_BGP_VPN_IMPORT_MAP, vpn_import_map.vrfs[afi]);
+		XFREE(MTYPE_BGP_VPN_IMPORT_MAP, vpn_import_map.any[afi]);
+		vpn_import_map.n_vrfs[afi] = 0;
+		vpn_import_map.n_any[afi] = 0;
+	}
+	vpn_import_map.valid = false;
+}
+
+static void vpn_import_map_add(afi_t afi, const uint8_t *val, uint32_t idx)
+{
+	struct vpn_import_rt ref, *rt;
+
+	memcpy(ref.val, val, ECOMMUNITY_SIZE);
+	rt = vpn_import_rts_find(&vpn_import_map.rts[afi], &ref);
+	if (!rt) {
+		rt = XCALLOC(MTYPE_BGP_VPN_IMPORT_MAP, sizeof(*rt));
+		memcpy(rt->val, val, ECOMMUNITY_SIZE);
+		vpn_import_rts_add(&vpn_import_map.rts[afi], rt);
+	}
+
+	/* the same RT listed twice in one VRF */
+	if (rt->n_vrfs && rt->vrfs[rt->n_vrfs - 1] == idx)
+		return;
+
+	if (rt->n_vrfs == rt->n_alloc) {
+		rt->n_alloc = rt->n_alloc ? rt->n_alloc * 2 : 4;
+		rt->vrfs = XREALLOC(MTYPE_BGP_VPN_IMPORT_MAP, rt->vrfs,
+				    rt->n_alloc * sizeof(rt->vrfs[0]));
+	}
+	rt->vrfs[rt->n_vrfs++] = idx;
+}
+
+static void vpn_import_map_build(void)
+{
+	struct listnode *node;
+	struct bgp *bgp;
+	struct ecommunity *ecom;
+	uint32_t count = listcount(bm->bgp);
+	uint32_t idx, i;
+	afi_t afi;
+
+	for (afi = AFI_IP; afi < AFI_MAX; afi++) {
+		vpn_import_rts_init(&vpn_import_map.rts[afi]);
+
+		if (!count)
+			continue;
+
+		vpn_import_map.vrfs[afi] =
+			XCALLOC(MTYPE_BGP_VPN_IMPORT_MAP,
+				count * sizeof(vpn_import_map.vrfs[afi][0]));
+
+		for (ALL_LIST_ELEMENTS_RO(bm->bgp, node, bgp)) {
+			ecom = bgp->vpn_policy[afi]
+				       .rtlist[BGP_VPN_POLICY_DIR_FROMVPN];
+			if (!ecom || !ecom->size)
+				continue;
+
+			idx = vpn_import_map.n_vrfs[afi]++;
+			vpn_import_map.vrfs[afi][idx].bgp = bgp;
+
+			if (ecom->unit_size != ECOMMUNITY_SIZE) {
+				if (!vpn_import_map.any[afi])
+					vpn_import_map.any[afi] = XCALLOC(
+						MTYPE_BGP_VPN_IMPORT_MAP,
+						count * sizeof(uint32_t));
+				vpn_import_map.any[afi]
+						  [vpn_import_map.n_any[afi]++] =
+					idx;
+				continue;
+			}
+
+			for (i = 0; i < ecom->size; i++)
+				vpn_import_map_add(afi,
+						   ecom->val +
+							   i * ECOMMUNITY_SIZE,
+						   idx);
+		}
+	}
+
+	vpn_import_map.valid = true;
+
+	if (BGP_DEBUG(vpn, VPN_LEAK_TO_VRF))
+		zlog_debug("%s: %u/%u importing VRFs, %zu/%zu route-targets (IPv4/IPv6)",
+			   __func__, vpn_import_map.n_vrfs[AFI_IP],
+			   vpn_import_map.n_vrfs[AFI_IP6],
+			   vpn_import_rts_count(&vpn_import_map.rts[AFI_IP]),
+			   vpn_import_rts_count(&vpn_import_map.rts[AFI_IP6]));
+}
+
+static inline void vpn_import_map_pick(afi_t afi, uint32_t idx,
+				       struct bgp **out, uint32_t *n_out)
+{
+	struct vpn_import_vrf *vrf = &vpn_import_map.vrfs[afi][idx];
+
+	if (vrf->mark == vpn_import_map.mark)
+		return;
+	vrf->mark = vpn_import_map.mark;
+	out[(*n_out)++] = vrf->bgp;
+}
+
+/*
+ * Collect the VRFs that may import a VPN route carrying ecom.  Returns an
+ * array (to be freed with XFREE(MTYPE_BGP_VPN_IMPORT_MAP, ...)) and its
+ * size in *count; the array is a private copy, so the callers are free to
+ * do anything (including changing configuration) while walking it.
+ */
+static struct bgp **vpn_import_map_lookup(afi_t afi, struct ecommunity *ecom,
+					  uint32_t *count)
+{
+	struct vpn_import_rt ref, *rt;
+	struct bgp **out;
+	uint32_t n_out = 0;
+	uint32_t i, j;
+
+	*count = 0;
+
+	if (!vpn_import_map.valid)
+		vpn_import_map_build();
+
+	if (!vpn_import_map.n_vrfs[afi])
+		return NULL;
+	/* ecommunity_include() can't match anything on an empty set */
+	if (!ecom || !ecom->size)
+		return NULL;
+
+	out = XCALLOC(MTYPE_BGP_VPN_IMPORT_MAP,
+		      vpn_import_map.n_vrfs[afi] * sizeof(*out));
+
+	/* 0 is the initial value of every mark, skip it on wraparound */
+	if (++vpn_import_map.mark == 0)
+		vpn_import_map.mark = 1;
+
+	if (ecom->unit_size < ECOMMUNITY_SIZE) {
+		/* can't key on this, fall back to visiting everyone */
+		for (i = 0; i < vpn_import_map.n_vrfs[afi]; i++)
+			vpn_import_map_pick(afi, i, out, &n_out);
+		*count = n_out;
+		return out;
+	}
+
+	for (i = 0; i < vpn_import_map.n_any[afi]; i++)
+		vpn_import_map_pick(afi, vpn_import_map.any[afi][i], out,
+				    &n_out);
+
+	/* ecommunity_include() compares the first 8 bytes of each value */
+	for (i = 0; i < ecom->size; i++) {
+		memcpy(ref.val, ecom->val + i * ecom->unit_size,
+		       ECOMMUNITY_SIZE);
+		rt = vpn_import_rts_find(&vpn_import_map.rts[afi], &ref);
+		if (!rt)
+			continue;
+
+		for (j = 0; j < rt->n_vrfs; j++)
+			vpn_import_map_pick(afi, rt->vrfs[j], out, &n_out);
+	}
+
+	*count = n_out;
+	return out;
+}
+
 void vpn_leak_to_vrf_update(struct bgp *from_bgp, struct bgp_path_info *path_vpn,
 			    struct prefix_rd *prd, struct peer *peer)
 {
-	struct listnode *mnode, *mnnode;
-	struct bgp *bgp;
+	struct bgp *bgp, **vrfs;
+	uint32_t i, n_vrfs;
 	const struct prefix *p = bgp_dest_get_prefix(path_vpn->net);
 
 	int debug = BGP_DEBUG(vpn, VPN_LEAK_TO_VRF);
@@ -2713,13 +2954,18 @@ void vpn_leak_to_vrf_update(struct bgp *from_bgp, struct bgp_path_info *path_vpn
 	if (debug)
 		zlog_debug("%s: start (path_vpn=%p, prefix=%pFX)", __func__, path_vpn, p);
 
-	/* Loop over VRFs */
-	for (ALL_LIST_ELEMENTS(bm->bgp, mnode, mnnode, bgp)) {
+	/* Loop over VRFs importing any of the route's RTs */
+	vrfs = vpn_import_map_lookup(family2afi(p->family),
+				     bgp_attr_get_ecommunity(path_vpn->attr),
+				     &n_vrfs);
+	for (i = 0; i < n_vrfs; i++) {
+		bgp = vrfs[i];
 		if (!path_vpn->extra || !path_vpn->extra->vrfleak ||
 		    path_vpn->extra->vrfleak->bgp_orig != bgp) { /* no loop */
 			vpn_leak_to_vrf_update_onevrf(bgp, from_bgp, path_vpn, prd, peer);
 		}
 	}
+	XFREE(MTYPE_BGP_VPN_IMPORT_MAP, vrfs);
 }
 
 void vpn_leak_to_vrf_withdraw(struct bgp_path_info *path_vpn)
@@ -2727,8 +2973,8 @@ void vpn_leak_to_vrf_withdraw(struct bgp_path_info *path_vpn)
 	const struct prefix *p;
 	afi_t afi;
 	safi_t safi = SAFI_UNICAST;
-	struct bgp *bgp;
-	struct listnode *mnode, *mnnode;
+	struct bgp *bgp, **vrfs;
+	uint32_t i, n_vrfs;
 	struct bgp_dest *bn;
 	struct bgp_path_info *bpi;
 	const char *debugmsg;
@@ -2761,8 +3007,11 @@ void vpn_leak_to_vrf_withdraw(struct bgp_path_info *path_vpn)
 	p = bgp_dest_get_prefix(path_vpn->net);
 	afi = family2afi(p->family);
 
-	/* Loop over VRFs */
-	for (ALL_LIST_ELEMENTS(bm->bgp, mnode, mnnode, bgp)) {
+	/* Loop over VRFs importing any of the route's RTs */
+	vrfs = vpn_import_map_lookup(afi, bgp_attr_get_ecommunity(path_vpn->attr),
+				     &n_vrfs);
+	for (i = 0; i < n_vrfs; i++) {
+		bgp = vrfs[i];
 		if (!vpn_leak_from_vpn_active(bgp, afi, &debugmsg)) {
 			if (debug)
 				zlog_debug("%s: from %s, skipping: %s",
@@ -2805,6 +3054,7 @@ void vpn_leak_to_vrf_withdraw(struct bgp_path_info *path_vpn)
 		}
 		bgp_dest_unlock_node(bn);
 	}
+	XFREE(MTYPE_BGP_VPN_IMPORT_MAP, vrfs);
 }
 
 void vpn_leak_to_vrf_withdraw_all(struct bgp *to_bgp, afi_t afi)
@@ -3106,6 +3356,7 @@ void vpn_handle_router_id_update(struct bgp *bgp, bool withdraw,
 					bgp_import->vpn_policy[afi].rtlist[idir]
 						= ecommunity_dup(ecom);
 			}
+			vpn_leak_import_map_invalidate();
 
 			/* Update routes to VPN */
 			vpn_leak_postchange(BGP_VPN_POLICY_DIR_TOVPN,
@@ -3237,6 +3488,7 @@ void vrf_import_from_vrf(struct bgp *to_bgp, struct bgp *from_bgp, const char *i
 					 .rtlist[idir], ecom);
 	else
 		to_bgp->vpn_policy[afi].rtlist[idir] = ecommunity_dup(ecom);
+	vpn_leak_import_map_invalidate();
 
 	if (debug) {
 		const char *from_name;
@@ -71,6 +71,9 @@ extern void vpn_leak_to_vrf_update(struct bgp *from_bgp, struct bgp_path_info *p
 
 extern void vpn_leak_to_vrf_withdraw(struct bgp_path_info *path_vpn);
 
+/* Must be called whenever a VRF's "import from VPN" RT list may change */
+extern void vpn_leak_import_map_invalidate(void);
+
 extern void vpn_leak_zebra_vrf_label_update(struct bgp *bgp, afi_t afi);
 extern void vpn_leak_zebra_vrf_label_withdraw(struct bgp *bgp, afi_t afi);
 extern void vpn_leak_zebra_vrf_sid_update(struct bgp *bgp, afi_t afi);
@@ -248,6 +251,9 @@ static inline void vpn_leak_prechange(enum vpn_policy_direction direction,
 				      afi_t afi, struct bgp *bgp_vpn,
 				      struct bgp *bgp_vrf)
 {
+	if (direction == BGP_VPN_POLICY_DIR_FROMVPN)
+		vpn_leak_import_map_invalidate();
+
 	/* Detect when default bgp instance is not (yet) defined by config */
 	if (!bgp_vpn)
 		return;
@@ -267,6 +273,9 @@ static inline void vpn_leak_postchange(enum vpn_policy_direction direction,
 				       afi_t afi, struct bgp *bgp_vpn,
 				       struct bgp *bgp_vrf)
 {
+	if (direction == BGP_VPN_POLICY_DIR_FROMVPN)
+		vpn_leak_import_map_invalidate();
+
 	/* Detect when default bgp instance is not (yet) defined by config */
 	if (!bgp_vpn)
 		return;
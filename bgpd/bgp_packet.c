@@ -422,6 +422,22 @@ static void bgp_write_proceed_actions(struct peer *peer)
  * update group a peer belongs to, encode this information into packets, and
  * enqueue the packets onto the peer's output buffer.
  */
+/*
+ * Packets are built once per subgroup and shared by all of its peers, so
+ * split the time spent building them evenly across those peers.
+ */
+static void bgp_encode_account(struct update_subgroup *subgrp, uint64_t ns)
+{
+	struct peer_af *paf;
+
+	if (!subgrp || !SUBGRP_PCOUNT(subgrp))
+		return;
+
+	ns /= SUBGRP_PCOUNT(subgrp);
+	SUBGRP_FOREACH_PEER (subgrp, paf)
+		paf->peer->stat_encode_ns += ns;
+}
+
 void bgp_generate_updgrp_packets(struct event *event)
 {
 	struct peer_connection *connection = EVENT_ARG(event);
@@ -430,6 +446,7 @@ void bgp_generate_updgrp_packets(struct event *event)
 	struct peer_af *paf;
 	struct bpacket *next_pkt;
 	uint32_t wpq;
+	uint64_t encode_start;
 	uint32_t generated = 0;
 	afi_t afi;
 	safi_t safi;
@@ -520,11 +537,13 @@ void bgp_generate_updgrp_packets(struct event *event)
 			 * WITHDRAWs first.
 			 */
 			if (!next_pkt || !next_pkt->buffer) {
+				encode_start = monotime_ns();
 				next_pkt = subgroup_withdraw_packet(
 					PAF_SUBGRP(paf));
 				if (!next_pkt || !next_pkt->buffer)
 					subgroup_update_packet(PAF_SUBGRP(paf));
 				next_pkt = paf->next_pkt_to_send;
+				bgp_encode_account(PAF_SUBGRP(paf), monotime_ns() - encode_start);
 			}
 
 			/*
@@ -4111,6 +4130,7 @@ void bgp_process_packet(struct event *event)
 		uint8_t type = 0;
 		bgp_size_t size;
 		char notify_data_length[2];
+		uint64_t parse_start, policy_ns;
 
 		bool rearm_reads = false;
 
@@ -4165,7 +4185,12 @@ void bgp_process_packet(struct event *event)
 			atomic_fetch_add_explicit(&peer->update_in, 1,
 						  memory_order_relaxed);
 			peer->readtime = monotime(NULL);
+			parse_start = monotime_ns();
+			policy_ns = peer->stat_policy_ns;
 			mprc = bgp_update_receive(connection, peer, size);
+			/* inbound policy is accounted separately by bgp_update() */
+			peer->stat_parse_ns += monotime_ns() - parse_start -
+					       (peer->stat_policy_ns - policy_ns);
 			if (mprc == BGP_Stop)
 				flog_err(EC_BGP_UPDATE_RCV,
 					 "%s: BGP UPDATE receipt failed for peer: %s(%s)",
@@ -37,6 +37,7 @@
 #include "bgpd/bgp_nhc.h"
 #include "bgpd/bgp_table.h"
 #include "bgpd/bgp_route.h"
+#include "bgpd/bgp_conditional_adv.h"
 #include "bgpd/bgp_attr.h"
 #include "bgpd/bgp_debug.h"
 #include "bgpd/bgp_errors.h"
@@ -107,6 +108,11 @@ static bool bgp_attr_nexthop_same(const struct attr *attr1, const struct attr *a
 
 DEFINE_MTYPE_STATIC(BGPD, BGP_EOIU_MARKER_INFO, "BGP EOIU Marker info");
 DEFINE_MTYPE_STATIC(BGPD, BGP_METAQ, "BGP MetaQ");
+DEFINE_MTYPE_STATIC(BGPD, BGP_SHOW_STREAM, "BGP streaming show");
+DEFINE_MTYPE_STATIC(BGPD, BGP_AGGREGATE_MED, "BGP aggregate MED value");
+
+struct slab_pool bgp_path_info_pool = SLAB_POOL_INIT("BGP path info", MTYPE_BGP_ROUTE,
+						     struct bgp_path_info);
 /* Memory for batched clearing of peers from the RIB */
 DEFINE_MTYPE(BGPD, CLEARING_BATCH, "Clearing batch");
 
@@ -440,11 +446,24 @@ bool bgp_path_info_labels_same(const struct bgp_path_info *bpi,
 			       (const mpls_label_t *)label, n);
 }
 
+/*
+ * Charge the owning peer for the attribute a path is about to switch to.
+ * Must be called before the old attribute is uninterned.
+ */
+void bgp_path_info_attr_account(struct bgp_path_info *path,
+				const struct attr *attr)
+{
+	path->peer->stat_attr_bytes += bgp_attr_mem_size(attr);
+	path->peer->stat_attr_bytes -= bgp_attr_mem_size(path->attr);
+}
+
 /* Free bgp route information. */
 void bgp_path_info_free_with_caller(const char *name,
 				    struct bgp_path_info *path)
 {
 	frrtrace(2, frr_bgp, bgp_path_info_free, path, name);
+	bgp_path_info_attr_account(path, NULL);
+	path->peer->stat_adj_rib_in_bytes -= sizeof(*path);
 	bgp_attr_unintern(&path->attr);
 
 	bgp_unlink_nexthop(path);
@@ -455,7 +474,7 @@ void bgp_path_info_free_with_caller(const char *name,
 
 	peer_unlock(path->peer); /* bgp_path_info peer reference */
 
-	XFREE(MTYPE_BGP_ROUTE, path);
+	bgp_path_info_slab_free(path);
 }
 
 struct bgp_path_info *bgp_path_info_lock(struct bgp_path_info *path)
@@ -749,6 +768,8 @@ void bgp_path_info_set_flag(struct bgp_dest *dest, struct bgp_path_info *pi,
 			    uint32_t flag)
 {
 	SET_FLAG(pi->flags, flag);
+	if (CHECK_FLAG(flag, BGP_PATH_TX_FLAGS))
+		SET_FLAG(pi->flags, BGP_PATH_TX_CHANGED);
 
 	/* early bath if we know it's not a flag that changes countability state
 	 */
@@ -763,6 +784,8 @@ void bgp_path_info_unset_flag(struct bgp_dest *dest, struct bgp_path_info *pi,
 			      uint32_t flag)
 {
 	UNSET_FLAG(pi->flags, flag);
+	if (CHECK_FLAG(flag, BGP_PATH_TX_FLAGS))
+		SET_FLAG(pi->flags, BGP_PATH_TX_CHANGED);
 
 	/* early bath if we know it's not a flag that changes countability state
 	 */
@@ -4068,12 +4091,39 @@ bgp_mplsvpn_handle_label_allocation(struct bgp *bgp, struct bgp_dest *dest,
  *     We have no eligible route that we can announce or the rn
  *     is being removed.
  */
+/* update-groups have seen all changes to the dest's paths */
+static void bgp_addpath_tx_changes_done(struct bgp_dest *dest)
+{
+	struct bgp_path_info *pi;
+
+	for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = pi->next)
+		UNSET_FLAG(pi->flags, BGP_PATH_TX_CHANGED);
+
+	UNSET_FLAG(dest->flags,
+		   BGP_NODE_ADDPATH_TX_FULL | BGP_NODE_ADDPATH_TX_DELTA);
+}
+
+/*
+ * Charge the time spent on a dest's best-path run to the peer whose path
+ * won it, or on a withdrawal to the peer whose path used to be selected.
+ */
+static void bgp_bestpath_account(struct bgp_path_info *new_select,
+				 struct bgp_path_info *old_select,
+				 uint64_t start)
+{
+	struct bgp_path_info *pi = new_select ? new_select : old_select;
+
+	if (pi && pi->peer)
+		pi->peer->stat_bestpath_ns += monotime_ns() - start;
+}
+
 void bgp_process_main_one(struct bgp *bgp, struct bgp_dest *dest, afi_t afi, safi_t safi)
 {
 	struct bgp_path_info *new_select;
 	struct bgp_path_info *old_select;
 	struct bgp_path_info_pair old_and_new;
 	int debug = 0;
+	uint64_t bestpath_start;
 
 	/*
 	 * For default bgp instance, which is deleted i.e. marked hidden
@@ -4129,6 +4179,8 @@ void bgp_process_main_one(struct bgp *bgp, struct bgp_dest *dest, afi_t afi, saf
 		return;
 	}
 
+	bestpath_start = monotime_ns();
+
 	/* Best path selection. */
 	bgp_best_selection(bgp, dest, &bgp->maxpaths[afi][safi], &old_and_new,
 			   afi, safi);
@@ -4151,6 +4203,18 @@ void bgp_process_main_one(struct bgp *bgp, struct bgp_dest *dest, afi_t afi, saf
 		bgp_mplsvpn_handle_label_allocation(bgp, dest, new_select,
 						    old_select, afi);
 
+	/* Unless the change concerns the dest as a whole, update-groups
+	 * sending all paths only need to look at the ones that changed.
+	 */
+	if (old_select == new_select &&
+	    !CHECK_FLAG(dest->flags,
+			BGP_NODE_ADDPATH_TX_FULL | BGP_NODE_USER_CLEAR |
+				BGP_NODE_PROCESS_CLEAR | BGP_NODE_LABEL_CHANGED) &&
+	    !(new_select && CHECK_FLAG(new_select->flags,
+				       BGP_PATH_MULTIPATH_CHG |
+					       BGP_PATH_LINK_BW_CHG)))
+		SET_FLAG(dest->flags, BGP_NODE_ADDPATH_TX_DELTA);
+
 	if (debug)
 		zlog_debug(
 			"%s: p=%pBD(%s) afi=%s, safi=%s, old_select=%p, new_select=%p",
@@ -4211,8 +4275,10 @@ void bgp_process_main_one(struct bgp *bgp, struct bgp_dest *dest, afi_t afi, saf
 		UNSET_FLAG(old_select->flags, BGP_PATH_MULTIPATH_CHG);
 		UNSET_FLAG(old_select->flags, BGP_PATH_LINK_BW_CHG);
 		bgp_zebra_clear_route_change_flags(dest);
+		bgp_addpath_tx_changes_done(dest);
 		UNSET_FLAG(dest->flags, BGP_NODE_ZEBRA_ANNOUNCE_EARLY);
 		UNSET_FLAG(dest->flags, BGP_NODE_PROCESS_SCHEDULED);
+		bgp_bestpath_account(new_select, old_select, bestpath_start);
 		return;
 	}
 
@@ -4320,10 +4386,13 @@ void bgp_process_main_one(struct bgp *bgp, struct bgp_dest *dest, afi_t afi, saf
 
 	/* Clear any route change flags. */
 	bgp_zebra_clear_route_change_flags(dest);
+	bgp_addpath_tx_changes_done(dest);
 
 	UNSET_FLAG(dest->flags, BGP_NODE_ZEBRA_ANNOUNCE_EARLY);
 	UNSET_FLAG(dest->flags, BGP_NODE_PROCESS_SCHEDULED);
 
+	bgp_bestpath_account(new_select, old_select, bestpath_start);
+
 	/* Reap old select bgp_path_info, if it has been removed */
 	if (old_select && CHECK_FLAG(old_select->flags, BGP_PATH_REMOVED))
 		bgp_path_info_reap(dest, old_select);
@@ -4773,6 +4842,7 @@ static void process_subq_early_route(struct bgp_dest *dest)
 
 	/* note, new DESTs may be added as part of processing */
 	bgp_process_main_one(table->bgp, dest, table->afi, table->safi);
+	bgp_conditional_adv_dest_changed(dest);
 	bgp_dest_unlock_node(dest);
 	bgp_table_unlock(table);
 }
@@ -4790,6 +4860,7 @@ static void process_subq_other_route(struct bgp_dest *dest)
 
 	/* note, new DESTs may be added as part of processing */
 	bgp_process_main_one(table->bgp, dest, table->afi, table->safi);
+	bgp_conditional_adv_dest_changed(dest);
 	bgp_dest_unlock_node(dest);
 	bgp_table_unlock(table);
 }
@@ -4814,7 +4885,7 @@ static void process_eoiu_marker(struct bgp_dest *dest)
 	bgp_process_main_one(info->bgp, NULL, 0, 0);
 
 	XFREE(MTYPE_BGP_EOIU_MARKER_INFO, info);
-	XFREE(MTYPE_BGP_NODE, dest);
+	bgp_dest_slab_free(dest);
 }
 
 /*
@@ -5033,7 +5104,7 @@ static void eoiu_marker_queue_free(struct meta_queue *mq, struct bgp_dest_queue
 		XFREE(MTYPE_BGP_EOIU_MARKER_INFO, dest->info);
 		STAILQ_REMOVE_HEAD(l, pq);
 		STAILQ_NEXT(dest, pq) = NULL; /* complete unlink */
-		XFREE(MTYPE_BGP_NODE, dest);
+		bgp_dest_slab_free(dest);
 		mq->size--;
 	}
 }
@@ -5091,7 +5162,7 @@ static void bgp_process_internal(struct bgp *bgp, struct bgp_dest *dest,
 	if (pi) {
 		struct bgp_path_info *first = bgp_dest_get_bgp_path_info(dest);
 
-		SET_FLAG(pi->flags, BGP_PATH_UNSORTED);
+		SET_FLAG(pi->flags, BGP_PATH_UNSORTED | BGP_PATH_TX_CHANGED);
 
 		if (pi != first) {
 			if (pi->next)
@@ -5105,7 +5176,8 @@ static void bgp_process_internal(struct bgp *bgp, struct bgp_dest *dest,
 			pi->prev = NULL;
 			bgp_dest_set_bgp_path_info(dest, pi);
 		}
-	}
+	} else
+		SET_FLAG(dest->flags, BGP_NODE_ADDPATH_TX_FULL);
 
 	/* already scheduled for processing? */
 	if (CHECK_FLAG(dest->flags, BGP_NODE_PROCESS_SCHEDULED)) {
@@ -5163,7 +5235,7 @@ void bgp_add_eoiu_mark(struct bgp *bgp)
 	 * Create a dummy dest as the meta queue expects all its elements to be
 	 * dest's
 	 */
-	struct bgp_dest *dummy_dest = XCALLOC(MTYPE_BGP_NODE, sizeof(struct bgp_dest));
+	struct bgp_dest *dummy_dest = bgp_dest_slab_alloc();
 
 	struct bgp_eoiu_info *eoiu_info = XCALLOC(MTYPE_BGP_EOIU_MARKER_INFO,
 						  sizeof(struct bgp_eoiu_info));
@@ -5187,45 +5259,6 @@ static void bgp_maximum_prefix_restart_timer(struct event *event)
 		zlog_debug("%s: %s peer_clear failed", __func__, peer->host);
 }
 
-static uint32_t bgp_filtered_routes_count(struct peer *peer, afi_t afi,
-					  safi_t safi)
-{
-	uint32_t count = 0;
-	bool filtered = false;
-	struct bgp_dest *dest;
-	struct bgp_adj_in *ain;
-	struct attr attr = {};
-	struct bgp_table *table = peer->bgp->rib[afi][safi];
-
-	for (dest = bgp_table_top(table); dest; dest = bgp_route_next(dest)) {
-		for (ain = dest->adj_in; ain; ain = ain->next) {
-			const struct prefix *rn_p = bgp_dest_get_prefix(dest);
-
-			attr = *ain->attr;
-
-			filtered = false;
-
-			if (bgp_input_filter(peer, rn_p, &attr, afi, safi)
-			    == FILTER_DENY)
-				filtered = true;
-
-			if (bgp_input_modifier(
-				    peer, rn_p, &attr, afi, safi,
-				    ROUTE_MAP_IN_NAME(&peer->filter[afi][safi]),
-				    NULL, 0, NULL)
-			    == RMAP_DENY)
-				filtered = true;
-
-			if (filtered)
-				count++;
-
-			bgp_attr_flush(&attr);
-		}
-	}
-
-	return count;
-}
-
 bool bgp_maximum_prefix_overflow(struct peer *peer, afi_t afi, safi_t safi,
 				 int always)
 {
@@ -5233,7 +5266,7 @@ bool bgp_maximum_prefix_overflow(struct peer *peer, afi_t afi, safi_t safi,
 	iana_safi_t pkt_safi;
 	uint32_t pcount = (CHECK_FLAG(peer->af_flags[afi][safi],
 				      PEER_FLAG_MAX_PREFIX_FORCE))
-				  ? bgp_filtered_routes_count(peer, afi, safi)
+				  ? peer->pcount_filtered[afi][safi]
 					    + peer->pcount[afi][safi]
 				  : peer->pcount[afi][safi];
 	struct peer_connection *connection = peer->connection;
@@ -5414,7 +5447,7 @@ struct bgp_path_info *info_make(int type, int sub_type, unsigned short instance,
 	struct bgp_path_info *new;
 
 	/* Make new BGP info. */
-	new = XCALLOC(MTYPE_BGP_ROUTE, sizeof(struct bgp_path_info));
+	new = bgp_path_info_slab_alloc();
 	new->type = type;
 	new->instance = instance;
 	new->sub_type = sub_type;
@@ -5422,6 +5455,9 @@ struct bgp_path_info *info_make(int type, int sub_type, unsigned short instance,
 	new->attr = attr;
 	new->uptime = monotime(NULL);
 	new->net = dest;
+
+	peer->stat_attr_bytes += bgp_attr_mem_size(attr);
+	peer->stat_adj_rib_in_bytes += sizeof(*new);
 	return new;
 }
 
@@ -5721,6 +5757,8 @@ void bgp_update(struct peer *peer, const struct prefix *p, uint32_t addpath_id,
 	int vnc_implicit_withdraw = 0;
 #endif
 	int same_attr = 0;
+	bool policy_denied = false;
+	uint64_t policy_start;
 	const struct prefix *bgp_nht_param_prefix;
 
 	/* Special case for BGP-LU - map LU safi to ordinary unicast safi */
@@ -5883,12 +5921,17 @@ void bgp_update(struct peer *peer, const struct prefix *p, uint32_t addpath_id,
 	}
 
 	/* Apply incoming filter.  */
+	policy_start = monotime_ns();
 	if (bgp_input_filter(peer, p, attr, afi, orig_safi) == FILTER_DENY) {
+		peer->stat_policy_ns += monotime_ns() - policy_start;
 		peer->stat_pfx_filter++;
 		reason = "filter;";
+		policy_denied = true;
 		goto filtered;
 	}
 
+	peer->stat_policy_ns += monotime_ns() - policy_start;
+
 	if ((afi == AFI_IP || afi == AFI_IP6) && safi == SAFI_MPLS_VPN &&
 	    bgp->inst_type == BGP_INSTANCE_TYPE_DEFAULT &&
 	    !CHECK_FLAG(bgp->af_flags[afi][safi],
@@ -5946,15 +5989,20 @@ void bgp_update(struct peer *peer, const struct prefix *p, uint32_t addpath_id,
 	 * commands, so we need bgp_attr_flush in the error paths, until we
 	 * intern
 	 * the attr (which takes over the memory references) */
-	if (bgp_input_modifier(peer, p, &new_attr, afi, orig_safi, NULL, label,
-			       num_labels, dest)
-	    == RMAP_DENY) {
+	policy_start = monotime_ns();
+	ret = bgp_input_modifier(peer, p, &new_attr, afi, orig_safi, NULL, label, num_labels, dest);
+	peer->stat_policy_ns += monotime_ns() - policy_start;
+	if (ret == RMAP_DENY) {
 		peer->stat_pfx_filter++;
 		reason = "route-map;";
+		policy_denied = true;
 		bgp_attr_flush(&new_attr);
 		goto filtered;
 	}
 
+	if (dest->adj_in)
+		bgp_adj_in_filtered_set(dest, peer, addpath_id, false);
+
 	/*
 	 * Apply "nexthop prefer-global" configuration for IPv6 address families.
 	 * This is similar to "set ipv6 next-hop prefer-global" in a route-map,
@@ -6266,6 +6314,7 @@ void bgp_update(struct peer *peer, const struct prefix *p, uint32_t addpath_id,
 		}
 
 		/* Update to new attribute.  */
+		bgp_path_info_attr_account(pi, attr_new);
 		bgp_attr_unintern_clear_reuse(attr, &pi->attr);
 		pi->attr = attr_new;
 
@@ -6505,11 +6554,14 @@ void bgp_update(struct peer *peer, const struct prefix *p, uint32_t addpath_id,
 /* This BGP update is filtered.  Log the reason then update BGP
    entry.  */
 filtered:
+	if (dest->adj_in)
+		bgp_adj_in_filtered_set(dest, peer, addpath_id, policy_denied);
+
 	if (new) {
 		bgp_unlink_nexthop(new);
 		bgp_path_info_mark_for_delete(dest, new);
 		bgp_path_info_extra_free(&new->extra);
-		XFREE(MTYPE_BGP_ROUTE, new);
+		bgp_path_info_slab_free(new);
 	}
 
 	hook_call(bgp_process, bgp, afi, safi, dest, peer, true);
@@ -6904,6 +6956,16 @@ static void bgp_soft_reconfig_table_task(struct event *event)
 	*/
 	for (ALL_LIST_ELEMENTS(table->soft_reconfig_peers, node, nnode, peer)) {
 		listnode_delete(table->soft_reconfig_peers, peer);
+
+		/* The filtered count has been brought up to date with the new
+		 * inbound policy, recheck it against maximum-prefix force.
+		 */
+		if (CHECK_FLAG(peer->af_flags[table->afi][table->safi],
+			       PEER_FLAG_MAX_PREFIX_FORCE) &&
+		    bgp_maximum_prefix_overflow(peer, table->afi, table->safi,
+						0))
+			continue;
+
 		bgp_announce_route(peer, table->afi, table->safi, false);
 	}
 
@@ -8444,6 +8506,7 @@ void bgp_static_update(struct bgp *bgp, const struct prefix *p,
 				}
 			}
 #endif
+			bgp_path_info_attr_account(pi, attr_new);
 			bgp_attr_unintern(&pi->attr);
 			pi->attr = attr_new;
 			pi->uptime = monotime(NULL);
@@ -9170,6 +9233,7 @@ static struct bgp_aggregate *bgp_aggregate_new(void)
 
 void bgp_aggregate_free(struct bgp_aggregate *aggregate)
 {
+	event_cancel(&aggregate->t_update);
 	XFREE(MTYPE_ROUTE_MAP_NAME, aggregate->suppress_map_name);
 	route_map_counter_decrement(aggregate->suppress_map);
 	XFREE(MTYPE_ROUTE_MAP_NAME, aggregate->rmap.name);
@@ -9393,33 +9457,81 @@ static void bgp_aggregate_install(
 	bgp_dest_unlock_node(dest);
 }
 
-/**
- * Check if the current path has different MED than other known paths.
- *
- * \returns `true` if the MED matched the others else `false`.
+/*
+ * MED values of the routes under an aggregate, refcounted so that a route
+ * entering or leaving the aggregate is accounted for without looking at
+ * the other more-specifics.  MEDs mismatch as long as more than one value
+ * is present.
  */
-static bool bgp_aggregate_med_match(struct bgp_aggregate *aggregate,
-				    struct bgp *bgp, struct bgp_path_info *pi)
+struct bgp_aggr_med {
+	uint32_t med;
+	unsigned long refcnt;
+};
+
+static unsigned int bgp_aggr_med_hash_key(const void *arg)
+{
+	const struct bgp_aggr_med *m = arg;
+
+	return jhash_1word(m->med, 0xa6e2d5b1);
+}
+
+static bool bgp_aggr_med_hash_cmp(const void *arg1, const void *arg2)
+{
+	const struct bgp_aggr_med *m1 = arg1, *m2 = arg2;
+
+	return m1->med == m2->med;
+}
+
+static void *bgp_aggr_med_alloc(void *arg)
+{
+	const struct bgp_aggr_med *ref = arg;
+	struct bgp_aggr_med *m;
+
+	m = XCALLOC(MTYPE_BGP_AGGREGATE_MED, sizeof(*m));
+	m->med = ref->med;
+	return m;
+}
+
+static void bgp_aggr_med_free(void *arg)
+{
+	XFREE(MTYPE_BGP_AGGREGATE_MED, arg);
+}
+
+static void bgp_aggregate_med_count(struct bgp_aggregate *aggregate,
+				    struct bgp *bgp, struct bgp_path_info *pi,
+				    bool add)
 {
-	uint32_t cur_med = bgp_med_value(pi->attr, bgp);
+	struct bgp_aggr_med ref = { .med = bgp_med_value(pi->attr, bgp) };
+	struct bgp_aggr_med *m;
 
-	/* This is the first route being analyzed. */
-	if (!aggregate->med_initialized) {
-		aggregate->med_initialized = true;
-		aggregate->med_mismatched = false;
-		aggregate->med_matched_value = cur_med;
+	if (!aggregate->med_hash)
+		aggregate->med_hash = hash_create(bgp_aggr_med_hash_key,
+						  bgp_aggr_med_hash_cmp,
+						  "BGP Aggregator MED hash");
+
+	if (add) {
+		m = hash_get(aggregate->med_hash, &ref, bgp_aggr_med_alloc);
+		m->refcnt++;
 	} else {
-		/* Check if routes with different MED showed up. */
-		if (cur_med != aggregate->med_matched_value)
-			aggregate->med_mismatched = true;
+		m = hash_lookup(aggregate->med_hash, &ref);
+		if (m && --m->refcnt == 0) {
+			hash_release(aggregate->med_hash, m);
+			bgp_aggr_med_free(m);
+		}
 	}
 
-	return !aggregate->med_mismatched;
+	aggregate->med_mismatched = hash_count(aggregate->med_hash) > 1;
+}
+
+static void bgp_aggregate_med_reset(struct bgp_aggregate *aggregate)
+{
+	if (aggregate->med_hash)
+		hash_clean(aggregate->med_hash, bgp_aggr_med_free);
+	aggregate->med_mismatched = false;
 }
 
 /**
- * Initializes and tests all routes in the aggregate address path for MED
- * values.
+ * Initializes the MED state from all routes in the aggregate address path.
  *
  * \returns `true` if all MEDs are the same otherwise `false`.
  */
@@ -9431,9 +9543,8 @@ static bool bgp_aggregate_test_all_med(struct bgp_aggregate *aggregate,
 	const struct prefix *dest_p;
 	struct bgp_dest *dest, *top;
 	struct bgp_path_info *pi;
-	bool med_matched = true;
 
-	aggregate->med_initialized = false;
+	bgp_aggregate_med_reset(aggregate);
 
 	top = bgp_node_get(table, p);
 	for (dest = bgp_node_get(table, p); dest;
@@ -9447,17 +9558,12 @@ static bool bgp_aggregate_test_all_med(struct bgp_aggregate *aggregate,
 				continue;
 			if (pi->sub_type == BGP_ROUTE_AGGREGATE)
 				continue;
-			if (!bgp_aggregate_med_match(aggregate, bgp, pi)) {
-				med_matched = false;
-				break;
-			}
+			bgp_aggregate_med_count(aggregate, bgp, pi, true);
 		}
-		if (!med_matched)
-			break;
 	}
 	bgp_dest_unlock_node(top);
 
-	return med_matched;
+	return !aggregate->med_mismatched;
 }
 
 /**
@@ -9523,44 +9629,54 @@ void bgp_aggregate_toggle_suppressed(struct bgp_aggregate *aggregate,
 }
 
 /**
- * Aggregate address MED matching incremental test: this function is called
- * when the initial aggregation occurred and we are only testing a single
- * new path.
+ * Aggregate address MED matching incremental update: this function is called
+ * when the initial aggregation occurred and a single path is entering
+ * (`add`) or leaving the aggregate.
  *
- * In addition to testing and setting the MED validity it also installs back
- * suppressed routes (if summary is configured).
+ * If the MED (mis)match state flips it also suppresses or installs back
+ * the more-specific routes (if summary is configured).
  *
  * Must not be called in `bgp_aggregate_route`.
  */
 static void bgp_aggregate_med_update(struct bgp_aggregate *aggregate,
 				     struct bgp *bgp, const struct prefix *p,
 				     afi_t afi, safi_t safi,
-				     struct bgp_path_info *pi)
+				     struct bgp_path_info *pi, bool add)
 {
+	bool was_mismatched = aggregate->med_mismatched;
+
 	/* MED matching disabled. */
 	if (!aggregate->match_med)
 		return;
 
-	/* Aggregation with different MED, recheck if we have got equal MEDs
-	 * now.
-	 */
-	if (aggregate->med_mismatched &&
-	    bgp_aggregate_test_all_med(aggregate, bgp, p, afi, safi) &&
-	    aggregate->summary_only)
-		bgp_aggregate_toggle_suppressed(aggregate, bgp, p, afi, safi,
-						true);
-	else
-		bgp_aggregate_med_match(aggregate, bgp, pi);
+	bgp_aggregate_med_count(aggregate, bgp, pi, add);
 
-	/* No mismatches, just quit. */
-	if (!aggregate->med_mismatched)
+	/* Nothing changed for the other routes. */
+	if (aggregate->med_mismatched == was_mismatched)
 		return;
 
 	/* Route summarization is disabled. */
 	if (!aggregate->summary_only)
 		return;
 
-	bgp_aggregate_toggle_suppressed(aggregate, bgp, p, afi, safi, false);
+	bgp_aggregate_toggle_suppressed(aggregate, bgp, p, afi, safi,
+					!aggregate->med_mismatched);
+}
+
+/* Forget the attributes of all routes, before counting them again. */
+static void bgp_aggregate_attr_hash_reset(struct bgp_aggregate *aggregate)
+{
+	if (aggregate->aspath_hash)
+		hash_clean(aggregate->aspath_hash, bgp_aggr_aspath_remove);
+	if (aggregate->community_hash)
+		hash_clean(aggregate->community_hash,
+			   bgp_aggr_community_remove);
+	if (aggregate->ecommunity_hash)
+		hash_clean(aggregate->ecommunity_hash,
+			   bgp_aggr_ecommunity_remove);
+	if (aggregate->lcommunity_hash)
+		hash_clean(aggregate->lcommunity_hash,
+			   bgp_aggr_lcommunity_remove);
 }
 
 /* Update an aggregate as routes are added/removed from the BGP table */
@@ -9585,6 +9701,10 @@ bool bgp_aggregate_route(struct bgp *bgp, const struct prefix *p, afi_t afi,
 	    bgp->peer_self == NULL)
 		return false;
 
+	/* This recomputes everything, a pending update is superseded. */
+	event_cancel(&aggregate->t_update);
+	aggregate->attr_stale = false;
+
 	/* Initialize and test routes for MED difference. */
 	if (aggregate->match_med)
 		bgp_aggregate_test_all_med(aggregate, bgp, p, afi, safi);
@@ -9598,6 +9718,7 @@ bool bgp_aggregate_route(struct bgp *bgp, const struct prefix *p, afi_t afi,
 	aggregate->count = 0;
 	aggregate->incomplete_origin_count = 0;
 	aggregate->egp_origin_count = 0;
+	bgp_aggregate_attr_hash_reset(aggregate);
 
 	/* ORIGIN attribute: If at least one route among routes that are
 	   aggregated has ORIGIN with the value INCOMPLETE, then the
@@ -9897,18 +10018,20 @@ void bgp_aggregate_delete(struct bgp *bgp, const struct prefix *p, afi_t afi,
 			lcommunity_free(&aggregate->lcommunity);
 	}
 
+	bgp_aggregate_med_reset(aggregate);
+	event_cancel(&aggregate->t_update);
+	aggregate->attr_stale = false;
+
 	bgp_dest_unlock_node(top);
 }
 
-static void bgp_add_route_to_aggregate(struct bgp *bgp,
-				       const struct prefix *aggr_p,
-				       struct bgp_path_info *pinew, afi_t afi,
-				       safi_t safi,
-				       struct bgp_aggregate *aggregate)
+/* Install the aggregate route from the current refcounted state. */
+static void bgp_aggregate_update(struct event *event)
 {
+	struct bgp_aggregate *aggregate = EVENT_ARG(event);
+	struct bgp *bgp = aggregate->bgp;
 	uint8_t origin;
 	struct aspath *aspath = NULL;
-	uint8_t atomic_aggregate = 0;
 	struct community *community = NULL;
 	struct ecommunity *ecommunity = NULL;
 	struct lcommunity *lcommunity = NULL;
@@ -9920,6 +10043,17 @@ static void bgp_add_route_to_aggregate(struct bgp *bgp,
 	    || (bgp->peer_self == NULL))
 		return;
 
+	/* A value went away from one of the hashes, recompute once for
+	 * all the routes that left since the last run.
+	 */
+	if (aggregate->attr_stale) {
+		bgp_compute_aggregate_aspath_val(aggregate);
+		bgp_compute_aggregate_community_val(aggregate);
+		bgp_compute_aggregate_ecommunity_val(aggregate);
+		bgp_compute_aggregate_lcommunity_val(aggregate);
+		aggregate->attr_stale = false;
+	}
+
 	/* ORIGIN attribute: If at least one route among routes that are
 	 * aggregated has ORIGIN with the value INCOMPLETE, then the
 	 * aggregated route must have the ORIGIN attribute with the value
@@ -9930,6 +10064,64 @@ static void bgp_add_route_to_aggregate(struct bgp *bgp,
 	 * route is INTERNAL.
 	 */
 	origin = BGP_ORIGIN_IGP;
+	if (aggregate->incomplete_origin_count > 0)
+		origin = BGP_ORIGIN_INCOMPLETE;
+	else if (aggregate->egp_origin_count > 0)
+		origin = BGP_ORIGIN_EGP;
+
+	if (aggregate->origin != BGP_ORIGIN_UNSPECIFIED)
+		origin = aggregate->origin;
+
+	if (aggregate->as_set) {
+		/* Retrieve aggregate route's as-path.
+		 */
+		if (aggregate->aspath)
+			aspath = aspath_dup(aggregate->aspath);
+
+		/* Retrieve aggregate route's community.
+		 */
+		if (aggregate->community)
+			community = community_dup(aggregate->community);
+
+		/* Retrieve aggregate route's ecommunity.
+		 */
+		if (aggregate->ecommunity)
+			ecommunity = ecommunity_dup(aggregate->ecommunity);
+
+		/* Retrieve aggregate route's lcommunity.
+		 */
+		if (aggregate->lcommunity)
+			lcommunity = lcommunity_dup(aggregate->lcommunity);
+	}
+
+	bgp_aggregate_install(bgp, aggregate->afi, aggregate->safi,
+			      &aggregate->p, origin, aspath, community,
+			      ecommunity, lcommunity, 0, aggregate);
+}
+
+/*
+ * More-specific churn only updates the refcounted aggregate state; the
+ * aggregate route itself is rebuilt once per event loop run, however many
+ * routes came or went.
+ */
+static void bgp_aggregate_schedule_update(struct bgp_aggregate *aggregate)
+{
+	event_add_event(bm->master, bgp_aggregate_update, aggregate, 0,
+			&aggregate->t_update);
+}
+
+static void bgp_add_route_to_aggregate(struct bgp *bgp,
+				       const struct prefix *aggr_p,
+				       struct bgp_path_info *pinew, afi_t afi,
+				       safi_t safi,
+				       struct bgp_aggregate *aggregate)
+{
+	/* If the bgp instance is being deleted or self peer is deleted
+	 * then do not create aggregate route
+	 */
+	if (CHECK_FLAG(bgp->flags, BGP_FLAG_DELETE_IN_PROGRESS)
+	    || (bgp->peer_self == NULL))
+		return;
 
 	aggregate->count++;
 
@@ -9939,7 +10131,7 @@ static void bgp_add_route_to_aggregate(struct bgp *bgp,
 	 */
 	if (aggregate->match_med)
 		bgp_aggregate_med_update(aggregate, bgp, aggr_p, afi, safi,
-					 pinew);
+					 pinew, true);
 
 	if (aggregate->summary_only && AGGREGATE_MED_VALID(aggregate))
 		aggr_suppress_path(aggregate, pinew);
@@ -9961,14 +10153,6 @@ static void bgp_add_route_to_aggregate(struct bgp *bgp,
 	break;
 	}
 
-	if (aggregate->incomplete_origin_count > 0)
-		origin = BGP_ORIGIN_INCOMPLETE;
-	else if (aggregate->egp_origin_count > 0)
-		origin = BGP_ORIGIN_EGP;
-
-	if (aggregate->origin != BGP_ORIGIN_UNSPECIFIED)
-		origin = aggregate->origin;
-
 	if (aggregate->as_set) {
 		/* Compute aggregate route's as-path.
 		 */
@@ -9994,31 +10178,9 @@ static void bgp_add_route_to_aggregate(struct bgp *bgp,
 			bgp_compute_aggregate_lcommunity(
 				aggregate,
 				bgp_attr_get_lcommunity(pinew->attr));
-
-		/* Retrieve aggregate route's as-path.
-		 */
-		if (aggregate->aspath)
-			aspath = aspath_dup(aggregate->aspath);
-
-		/* Retrieve aggregate route's community.
-		 */
-		if (aggregate->community)
-			community = community_dup(aggregate->community);
-
-		/* Retrieve aggregate route's ecommunity.
-		 */
-		if (aggregate->ecommunity)
-			ecommunity = ecommunity_dup(aggregate->ecommunity);
-
-		/* Retrieve aggregate route's lcommunity.
-		 */
-		if (aggregate->lcommunity)
-			lcommunity = lcommunity_dup(aggregate->lcommunity);
 	}
 
-	bgp_aggregate_install(bgp, afi, safi, aggr_p, origin,
-			      aspath, community, ecommunity,
-			      lcommunity, atomic_aggregate, aggregate);
+	bgp_aggregate_schedule_update(aggregate);
 }
 
 static void bgp_remove_route_from_aggregate(struct bgp *bgp, afi_t afi,
@@ -10027,13 +10189,6 @@ static void bgp_remove_route_from_aggregate(struct bgp *bgp, afi_t afi,
 					    struct bgp_aggregate *aggregate,
 					    const struct prefix *aggr_p)
 {
-	uint8_t origin;
-	struct aspath *aspath = NULL;
-	uint8_t atomic_aggregate = 0;
-	struct community *community = NULL;
-	struct ecommunity *ecommunity = NULL;
-	struct lcommunity *lcommunity = NULL;
-
 	/* If the bgp instance is being deleted or self peer is deleted
 	 * then do not create aggregate route
 	 */
@@ -10075,7 +10230,8 @@ static void bgp_remove_route_from_aggregate(struct bgp *bgp, afi_t afi,
 	 * "unsuppressing" twice.
 	 */
 	if (aggregate->match_med)
-		bgp_aggregate_med_update(aggregate, bgp, aggr_p, afi, safi, pi);
+		bgp_aggregate_med_update(aggregate, bgp, aggr_p, afi, safi, pi,
+					 false);
 
 	if (aggregate->count > 0)
 		aggregate->count--;
@@ -10088,62 +10244,33 @@ static void bgp_remove_route_from_aggregate(struct bgp *bgp, afi_t afi,
 	if (aggregate->as_set) {
 		/* Remove as-path from aggregate.
 		 */
-		bgp_remove_aspath_from_aggregate(aggregate,
-						 pi->attr->aspath);
-
-		if (bgp_attr_get_community(pi->attr))
-			/* Remove community from aggregate.
-			 */
-			bgp_remove_community_from_aggregate(
-				aggregate, bgp_attr_get_community(pi->attr));
-
-		if (bgp_attr_get_ecommunity(pi->attr))
-			/* Remove ecommunity from aggregate.
-			 */
-			bgp_remove_ecommunity_from_aggregate(
-				aggregate, bgp_attr_get_ecommunity(pi->attr));
-
-		if (bgp_attr_get_lcommunity(pi->attr))
-			/* Remove lcommunity from aggregate.
-			 */
-			bgp_remove_lcommunity_from_aggregate(
-				aggregate, bgp_attr_get_lcommunity(pi->attr));
-	}
-
-	origin = BGP_ORIGIN_IGP;
-	if (aggregate->incomplete_origin_count > 0)
-		origin = BGP_ORIGIN_INCOMPLETE;
-	else if (aggregate->egp_origin_count > 0)
-		origin = BGP_ORIGIN_EGP;
-
-	if (aggregate->origin != BGP_ORIGIN_UNSPECIFIED)
-		origin = aggregate->origin;
-
-	if (aggregate->as_set) {
-		/* Retrieve aggregate route's as-path.
-		 */
-		if (aggregate->aspath)
-			aspath = aspath_dup(aggregate->aspath);
+		if (bgp_remove_aspath_from_aggregate_hash(aggregate,
+							  pi->attr->aspath))
+			aggregate->attr_stale = true;
 
-		/* Retrieve aggregate route's community.
-		 */
-		if (aggregate->community)
-			community = community_dup(aggregate->community);
+		if (bgp_attr_get_community(pi->attr) &&
+		    /* Remove community from aggregate.
+		     */
+		    bgp_remove_comm_from_aggregate_hash(
+			    aggregate, bgp_attr_get_community(pi->attr)))
+			aggregate->attr_stale = true;
 
-		/* Retrieve aggregate route's ecommunity.
-		 */
-		if (aggregate->ecommunity)
-			ecommunity = ecommunity_dup(aggregate->ecommunity);
+		if (bgp_attr_get_ecommunity(pi->attr) &&
+		    /* Remove ecommunity from aggregate.
+		     */
+		    bgp_remove_ecomm_from_aggregate_hash(
+			    aggregate, bgp_attr_get_ecommunity(pi->attr)))
+			aggregate->attr_stale = true;
 
-		/* Retrieve aggregate route's lcommunity.
-		 */
-		if (aggregate->lcommunity)
-			lcommunity = lcommunity_dup(aggregate->lcommunity);
+		if (bgp_attr_get_lcommunity(pi->attr) &&
+		    /* Remove lcommunity from aggregate.
+		     */
+		    bgp_remove_lcomm_from_aggregate_hash(
+			    aggregate, bgp_attr_get_lcommunity(pi->attr)))
+			aggregate->attr_stale = true;
 	}
 
-	bgp_aggregate_install(bgp, afi, safi, aggr_p, origin,
-			      aspath, community, ecommunity,
-			      lcommunity, atomic_aggregate, aggregate);
+	bgp_aggregate_schedule_update(aggregate);
 }
 
 void bgp_aggregate_increment(struct bgp *bgp, const struct prefix *p,
@@ -10371,6 +10498,10 @@ static int bgp_aggregate_set(struct vty *vty, const char *prefix_str, afi_t afi,
 
 	/* Make aggregate address structure. */
 	aggregate = bgp_aggregate_new();
+	aggregate->bgp = bgp;
+	aggregate->afi = afi;
+	aggregate->safi = safi;
+	prefix_copy(&aggregate->p, &p);
 	aggregate->summary_only = summary_only;
 	aggregate->match_med = match_med;
 
@@ -10521,6 +10652,8 @@ void bgp_free_aggregate_info(struct bgp_aggregate *aggregate)
 
 	hash_clean_and_free(&aggregate->aspath_hash, bgp_aggr_aspath_remove);
 
+	hash_clean_and_free(&aggregate->med_hash, bgp_aggr_med_free);
+
 	bgp_aggregate_free(aggregate);
 }
 
@@ -10732,6 +10865,7 @@ void bgp_redistribute_add(struct bgp *bgp, struct prefix *p,
 				else
 					bgp_aggregate_decrement(
 						bgp, p, bpi, afi, SAFI_UNICAST);
+				bgp_path_info_attr_account(bpi, new_attr);
 				bgp_attr_unintern(&bpi->attr);
 				bpi->attr = new_attr;
 				bpi->uptime = monotime(NULL);
@@ -13505,32 +13639,33 @@ static int bgp_show_community(struct vty *vty, struct bgp *bgp,
 			      const char *comstr, int exact, afi_t afi,
 			      safi_t safi, uint16_t show_flags);
 
-static int bgp_show_table(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
-			  struct bgp_table *table, enum bgp_show_type type, void *output_arg,
-			  const char *rd, int is_last, unsigned long *output_cum,
-			  unsigned long *total_cum, unsigned long *json_header_depth,
-			  uint16_t show_flags, enum rpki_states rpki_target_state, bool brief)
+/*
+ * Running state of a bgp_show_table() walk.  Kept outside of the walk
+ * itself so the JSON output can also be produced in chunks from the event
+ * loop, see bgp_show_json_stream().
+ */
+struct bgp_show_table_state {
+	bool header;
+	bool first;
+	bool json_detail_header;
+	unsigned long output_count;
+	unsigned long total_count;
+};
+
+/* Start a table walk: emit the JSON preamble and reset the counters. */
+static void bgp_show_table_begin(struct vty *vty, struct bgp *bgp, struct bgp_table *table,
+				 enum bgp_show_type type, const char *rd,
+				 unsigned long *output_cum, unsigned long *json_header_depth,
+				 uint16_t show_flags, bool brief,
+				 struct bgp_show_table_state *state)
 {
-	struct bgp_path_info *pi;
-	struct bgp_dest *dest;
-	bool header = true;
-	bool json_detail_header = false;
-	int display;
-	unsigned long output_count = 0;
-	unsigned long total_count = 0;
-	struct prefix *p;
-	json_object *json_paths = NULL;
-	int first = 1;
 	bool use_json = CHECK_FLAG(show_flags, BGP_SHOW_OPT_JSON);
-	bool wide = CHECK_FLAG(show_flags, BGP_SHOW_OPT_WIDE);
 	bool all = CHECK_FLAG(show_flags, BGP_SHOW_OPT_AFI_ALL);
 	bool detail_json = CHECK_FLAG(show_flags, BGP_SHOW_OPT_JSON_DETAIL);
-	bool detail_routes = CHECK_FLAG(show_flags, BGP_SHOW_OPT_ROUTES_DETAIL);
-	int prefix_path_count = 0;
-	bool best_path_selected = false;
 
-	if (output_cum && *output_cum != 0)
-		header = false;
+	memset(state, 0, sizeof(*state));
+	state->header = !(output_cum && *output_cum != 0);
+	state->first = true;
 
 	if (use_json && !*json_header_depth) {
 		if (all)
@@ -13575,448 +13710,470 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t sa
 	    type != bgp_show_type_damp_neighbor &&
 	    type != bgp_show_type_flap_statistics &&
 	    type != bgp_show_type_flap_neighbor)
-		json_detail_header = true;
-
-	/* Start processing of routes. */
-	for (dest = bgp_table_top(table); dest; dest = bgp_route_next(dest)) {
-		const struct prefix *dest_p = bgp_dest_get_prefix(dest);
-		enum rpki_states rpki_curr_state = RPKI_NOT_BEING_USED;
-		bool json_detail_header_used = false;
-
-		pi = bgp_dest_get_bgp_path_info(dest);
-		if (pi == NULL)
-			continue;
-
-		display = 0;
-		prefix_path_count = 0;
-		best_path_selected = false;
-		if (use_json && !brief)
-			json_paths = json_object_new_array();
-
-		for (; pi; pi = pi->next) {
-			struct community *picomm = NULL;
-
-			picomm = bgp_attr_get_community(pi->attr);
+		state->json_detail_header = true;
+}
 
-			total_count++;
-			if (type == bgp_show_type_prefix_version) {
-				uint32_t version =
-					strtoul(output_arg, NULL, 10);
-				if (dest->version < version)
-					continue;
-			}
+/* Display all paths of one destination, updating the walk counters. */
+static void bgp_show_table_dest(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
+				struct bgp_table *table, struct bgp_dest *dest,
+				enum bgp_show_type type, void *output_arg, const char *rd,
+				uint16_t show_flags, enum rpki_states rpki_target_state,
+				bool brief, struct bgp_show_table_state *state)
+{
+	const struct prefix *dest_p = bgp_dest_get_prefix(dest);
+	enum rpki_states rpki_curr_state = RPKI_NOT_BEING_USED;
+	bool json_detail_header_used = false;
+	struct bgp_path_info *pi;
+	int display = 0;
+	struct prefix *p;
+	json_object *json_paths = NULL;
+	bool use_json = CHECK_FLAG(show_flags, BGP_SHOW_OPT_JSON);
+	bool wide = CHECK_FLAG(show_flags, BGP_SHOW_OPT_WIDE);
+	bool detail_json = CHECK_FLAG(show_flags, BGP_SHOW_OPT_JSON_DETAIL);
+	bool detail_routes = CHECK_FLAG(show_flags, BGP_SHOW_OPT_ROUTES_DETAIL);
+	int prefix_path_count = 0;
+	bool best_path_selected = false;
 
-			if (type == bgp_show_type_community_alias) {
-				char *alias = output_arg;
-				char **communities;
-				int num;
-				bool found = false;
-
-				if (picomm) {
-					frrstr_split(picomm->str, " ",
-						     &communities, &num);
-					for (int i = 0; i < num; i++) {
-						const char *com2alias =
-							bgp_community2alias(
-								communities[i]);
-						if (!found
-						    && strcmp(alias, com2alias)
-							       == 0)
-							found = true;
-						XFREE(MTYPE_TMP,
-						      communities[i]);
-					}
-					XFREE(MTYPE_TMP, communities);
-				}
+	pi = bgp_dest_get_bgp_path_info(dest);
+	if (pi == NULL)
+		return;
 
-				if (!found &&
-				    bgp_attr_get_lcommunity(pi->attr)) {
-					frrstr_split(bgp_attr_get_lcommunity(
-							     pi->attr)
-							     ->str,
-						     " ", &communities, &num);
-					for (int i = 0; i < num; i++) {
-						const char *com2alias =
-							bgp_community2alias(
-								communities[i]);
-						if (!found
-						    && strcmp(alias, com2alias)
-							       == 0)
-							found = true;
-						XFREE(MTYPE_TMP,
-						      communities[i]);
-					}
-					XFREE(MTYPE_TMP, communities);
-				}
+	if (use_json && !brief)
+		json_paths = json_object_new_array();
 
-				if (!found)
-					continue;
-			}
+	for (; pi; pi = pi->next) {
+		struct community *picomm = NULL;
 
-			if ((dest_p->family == AF_INET || dest_p->family == AF_INET6) &&
-			    (detail_routes || detail_json || type == bgp_show_type_rpki)) {
-				rpki_curr_state = hook_call(bgp_rpki_prefix_status, pi->peer,
-							    pi->attr, dest_p);
-				if (type == bgp_show_type_rpki &&
-				    rpki_target_state != RPKI_NOT_BEING_USED &&
-				    rpki_curr_state != rpki_target_state)
-					continue;
-			}
+		picomm = bgp_attr_get_community(pi->attr);
 
-			if (type == bgp_show_type_flap_statistics
-			    || type == bgp_show_type_flap_neighbor
-			    || type == bgp_show_type_dampend_paths
-			    || type == bgp_show_type_damp_neighbor) {
-				if (!(pi->extra && pi->extra->damp_info))
-					continue;
-			}
-			if (type == bgp_show_type_regexp) {
-				struct frregex *regex = output_arg;
+		state->total_count++;
+		if (type == bgp_show_type_prefix_version) {
+			uint32_t version =
+				strtoul(output_arg, NULL, 10);
+			if (dest->version < version)
+				continue;
+		}
 
-				if (bgp_regexec(regex, pi->attr->aspath)
-				    == REG_NOMATCH)
-					continue;
+		if (type == bgp_show_type_community_alias) {
+			char *alias = output_arg;
+			char **communities;
+			int num;
+			bool found = false;
+
+			if (picomm) {
+				frrstr_split(picomm->str, " ",
+					     &communities, &num);
+				for (int i = 0; i < num; i++) {
+					const char *com2alias =
+						bgp_community2alias(
+							communities[i]);
+					if (!found
+					    && strcmp(alias, com2alias)
+						       == 0)
+						found = true;
+					XFREE(MTYPE_TMP,
+					      communities[i]);
+				}
+				XFREE(MTYPE_TMP, communities);
 			}
-			if (type == bgp_show_type_prefix_list) {
-				struct prefix_list *plist = output_arg;
 
-				if (prefix_list_apply(plist, dest_p)
-				    != PREFIX_PERMIT)
-					continue;
+			if (!found &&
+			    bgp_attr_get_lcommunity(pi->attr)) {
+				frrstr_split(bgp_attr_get_lcommunity(
+						     pi->attr)
+						     ->str,
+					     " ", &communities, &num);
+				for (int i = 0; i < num; i++) {
+					const char *com2alias =
+						bgp_community2alias(
+							communities[i]);
+					if (!found
+					    && strcmp(alias, com2alias)
+						       == 0)
+						found = true;
+					XFREE(MTYPE_TMP,
+					      communities[i]);
+				}
+				XFREE(MTYPE_TMP, communities);
 			}
-			if (type == bgp_show_type_access_list) {
-				struct access_list *alist = output_arg;
 
-				if (access_list_apply(alist, dest_p) !=
-				    FILTER_PERMIT)
-					continue;
-			}
-			if (type == bgp_show_type_filter_list) {
-				struct as_list *as_list = output_arg;
+			if (!found)
+				continue;
+		}
 
-				if (as_list_apply(as_list, pi->attr->aspath)
-				    != AS_FILTER_PERMIT)
-					continue;
-			}
-			if (type == bgp_show_type_route_map) {
-				struct route_map *rmap = output_arg;
-				struct bgp_path_info path;
-				struct bgp_path_info_extra extra;
-				struct attr dummy_attr = {};
-				route_map_result_t ret;
+		if ((dest_p->family == AF_INET || dest_p->family == AF_INET6) &&
+		    (detail_routes || detail_json || type == bgp_show_type_rpki)) {
+			rpki_curr_state = hook_call(bgp_rpki_prefix_status, pi->peer,
+						    pi->attr, dest_p);
+			if (type == bgp_show_type_rpki &&
+			    rpki_target_state != RPKI_NOT_BEING_USED &&
+			    rpki_curr_state != rpki_target_state)
+				continue;
+		}
 
-				dummy_attr = *pi->attr;
+		if (type == bgp_show_type_flap_statistics
+		    || type == bgp_show_type_flap_neighbor
+		    || type == bgp_show_type_dampend_paths
+		    || type == bgp_show_type_damp_neighbor) {
+			if (!(pi->extra && pi->extra->damp_info))
+				continue;
+		}
+		if (type == bgp_show_type_regexp) {
+			struct frregex *regex = output_arg;
 
-				prep_for_rmap_apply(&path, &extra, dest, pi, pi->peer, NULL,
-						    &dummy_attr);
+			if (bgp_regexec(regex, pi->attr->aspath)
+			    == REG_NOMATCH)
+				continue;
+		}
+		if (type == bgp_show_type_prefix_list) {
+			struct prefix_list *plist = output_arg;
 
-				ret = route_map_apply(rmap, dest_p, &path);
-				bgp_attr_flush(&dummy_attr);
-				if (ret == RMAP_DENYMATCH)
-					continue;
-			}
-			if (type == bgp_show_type_neighbor
-			    || type == bgp_show_type_flap_neighbor
-			    || type == bgp_show_type_damp_neighbor) {
-				union sockunion *su = output_arg;
+			if (prefix_list_apply(plist, dest_p)
+			    != PREFIX_PERMIT)
+				continue;
+		}
+		if (type == bgp_show_type_access_list) {
+			struct access_list *alist = output_arg;
 
-				if (pi->peer == NULL || pi->peer->connection->su_remote == NULL ||
-				    !sockunion_same(pi->peer->connection->su_remote, su))
-					continue;
-			}
-			if (type == bgp_show_type_cidr_only) {
-				uint32_t destination;
+			if (access_list_apply(alist, dest_p) !=
+			    FILTER_PERMIT)
+				continue;
+		}
+		if (type == bgp_show_type_filter_list) {
+			struct as_list *as_list = output_arg;
 
-				destination = ntohl(dest_p->u.prefix4.s_addr);
-				if (IN_CLASSC(destination)
-				    && dest_p->prefixlen == 24)
-					continue;
-				if (IN_CLASSB(destination)
-				    && dest_p->prefixlen == 16)
-					continue;
-				if (IN_CLASSA(destination)
-				    && dest_p->prefixlen == 8)
-					continue;
-			}
-			if (type == bgp_show_type_prefix_longer) {
-				p = output_arg;
-				if (!prefix_match(p, dest_p))
-					continue;
-			}
-			if (type == bgp_show_type_community_all) {
-				if (!picomm)
-					continue;
-			}
-			if (type == bgp_show_type_community) {
-				struct community *com = output_arg;
+			if (as_list_apply(as_list, pi->attr->aspath)
+			    != AS_FILTER_PERMIT)
+				continue;
+		}
+		if (type == bgp_show_type_route_map) {
+			struct route_map *rmap = output_arg;
+			struct bgp_path_info path;
+			struct bgp_path_info_extra extra;
+			struct attr dummy_attr = {};
+			route_map_result_t ret;
 
-				if (!picomm || !community_match(picomm, com))
-					continue;
-			}
-			if (type == bgp_show_type_community_exact) {
-				struct community *com = output_arg;
+			dummy_attr = *pi->attr;
 
-				if (!picomm || !community_cmp(picomm, com))
-					continue;
-			}
-			if (type == bgp_show_type_community_list) {
-				struct community_list *list = output_arg;
+			prep_for_rmap_apply(&path, &extra, dest, pi, pi->peer, NULL,
+					    &dummy_attr);
 
-				if (!community_list_match(picomm, list))
-					continue;
-			}
-			if (type == bgp_show_type_community_list_exact) {
-				struct community_list *list = output_arg;
+			ret = route_map_apply(rmap, dest_p, &path);
+			bgp_attr_flush(&dummy_attr);
+			if (ret == RMAP_DENYMATCH)
+				continue;
+		}
+		if (type == bgp_show_type_neighbor
+		    || type == bgp_show_type_flap_neighbor
+		    || type == bgp_show_type_damp_neighbor) {
+			union sockunion *su = output_arg;
 
-				if (!community_list_exact_match(picomm, list))
-					continue;
-			}
-			if (type == bgp_show_type_lcommunity) {
-				struct lcommunity *lcom = output_arg;
+			if (pi->peer == NULL || pi->peer->connection->su_remote == NULL ||
+			    !sockunion_same(pi->peer->connection->su_remote, su))
+				continue;
+		}
+		if (type == bgp_show_type_cidr_only) {
+			uint32_t destination;
 
-				if (!bgp_attr_get_lcommunity(pi->attr) ||
-				    !lcommunity_match(
-					    bgp_attr_get_lcommunity(pi->attr),
-					    lcom))
-					continue;
-			}
+			destination = ntohl(dest_p->u.prefix4.s_addr);
+			if (IN_CLASSC(destination)
+			    && dest_p->prefixlen == 24)
+				continue;
+			if (IN_CLASSB(destination)
+			    && dest_p->prefixlen == 16)
+				continue;
+			if (IN_CLASSA(destination)
+			    && dest_p->prefixlen == 8)
+				continue;
+		}
+		if (type == bgp_show_type_prefix_longer) {
+			p = output_arg;
+			if (!prefix_match(p, dest_p))
+				continue;
+		}
+		if (type == bgp_show_type_community_all) {
+			if (!picomm)
+				continue;
+		}
+		if (type == bgp_show_type_community) {
+			struct community *com = output_arg;
 
-			if (type == bgp_show_type_lcommunity_exact) {
-				struct lcommunity *lcom = output_arg;
+			if (!picomm || !community_match(picomm, com))
+				continue;
+		}
+		if (type == bgp_show_type_community_exact) {
+			struct community *com = output_arg;
 
-				if (!bgp_attr_get_lcommunity(pi->attr) ||
-				    !lcommunity_cmp(
-					    bgp_attr_get_lcommunity(pi->attr),
-					    lcom))
-					continue;
-			}
-			if (type == bgp_show_type_lcommunity_list) {
-				struct community_list *list = output_arg;
+			if (!picomm || !community_cmp(picomm, com))
+				continue;
+		}
+		if (type == bgp_show_type_community_list) {
+			struct community_list *list = output_arg;
 
-				if (!lcommunity_list_match(
-					    bgp_attr_get_lcommunity(pi->attr),
-					    list))
-					continue;
-			}
-			if (type
-			    == bgp_show_type_lcommunity_list_exact) {
-				struct community_list *list = output_arg;
+			if (!community_list_match(picomm, list))
+				continue;
+		}
+		if (type == bgp_show_type_community_list_exact) {
+			struct community_list *list = output_arg;
 
-				if (!lcommunity_list_exact_match(
-					    bgp_attr_get_lcommunity(pi->attr),
-					    list))
-					continue;
-			}
-			if (type == bgp_show_type_lcommunity_all) {
-				if (!bgp_attr_get_lcommunity(pi->attr))
-					continue;
-			}
-			if (type == bgp_show_type_dampend_paths
-			    || type == bgp_show_type_damp_neighbor) {
-				if (!CHECK_FLAG(pi->flags, BGP_PATH_DAMPED)
-				    || CHECK_FLAG(pi->flags, BGP_PATH_HISTORY))
-					continue;
-			}
-			if (type == bgp_show_type_self_originated) {
-				if (pi->peer != bgp->peer_self)
-					continue;
-			}
+			if (!community_list_exact_match(picomm, list))
+				continue;
+		}
+		if (type == bgp_show_type_lcommunity) {
+			struct lcommunity *lcom = output_arg;
 
-			if (!brief && !use_json && header) {
-				vty_out(vty,
-					"BGP table version is %" PRIu64
-					", local router ID is %pI4, vrf id ",
-					table->version, &bgp->router_id);
-				if (bgp->vrf_id == VRF_UNKNOWN)
-					vty_out(vty, "%s", VRFID_NONE_STR);
-				else
-					vty_out(vty, "%u", bgp->vrf_id);
-				vty_out(vty, "\n");
-				vty_out(vty, "Default local pref %u, ",
-					bgp->default_local_pref);
-				vty_out(vty, "local AS ");
-				vty_out(vty, ASN_FORMAT(bgp->asnotation), &bgp->as);
-				vty_out(vty, "\n");
-				if (!detail_routes) {
-					vty_out(vty, BGP_SHOW_SCODE_HEADER);
-					vty_out(vty, BGP_SHOW_NCODE_HEADER);
-					vty_out(vty, BGP_SHOW_OCODE_HEADER);
-					vty_out(vty, BGP_SHOW_RPKI_HEADER);
-					if (safi == SAFI_BGP_LS)
-						vty_out(vty, BGP_SHOW_BGP_LS_PREFIX_CODES_HEADER);
-				}
-				if (type == bgp_show_type_dampend_paths ||
-				    type == bgp_show_type_damp_neighbor)
-					vty_out(vty, BGP_SHOW_DAMP_HEADER);
-				else if (type == bgp_show_type_flap_statistics ||
-					 type == bgp_show_type_flap_neighbor)
-					vty_out(vty, BGP_SHOW_FLAP_HEADER);
-				else if (!detail_routes)
-					vty_out(vty, (wide ? BGP_SHOW_HEADER_WIDE
-							   : BGP_SHOW_HEADER));
-				header = false;
-			}
-			if (!brief) {
-				if (rd != NULL && !display && !output_count) {
-					if (!use_json)
-						vty_out(vty, "Route Distinguisher: %s\n", rd);
-				}
+			if (!bgp_attr_get_lcommunity(pi->attr) ||
+			    !lcommunity_match(
+				    bgp_attr_get_lcommunity(pi->attr),
+				    lcom))
+				continue;
+		}
 
-				if (type == bgp_show_type_dampend_paths ||
-				    type == bgp_show_type_damp_neighbor)
-					damp_route_vty_out(vty, dest_p, pi, display, afi, safi,
-							   use_json, json_paths);
-				else if (type == bgp_show_type_flap_statistics ||
-					 type == bgp_show_type_flap_neighbor)
-					flap_route_vty_out(vty, dest_p, pi, display, afi, safi,
-							   use_json, json_paths);
-				else if (detail_routes || detail_json) {
-					const struct prefix_rd *prd = NULL;
-
-					if (dest->pdest)
-						prd = bgp_rd_from_dest(dest->pdest, safi);
-
-					if (!use_json)
-						route_vty_out_detail_header(vty, bgp, dest,
-									    bgp_dest_get_prefix(
-										    dest),
-									    prd, table->afi, safi,
-									    NULL, false, false);
-
-					route_vty_out_detail(vty, bgp, dest, dest_p, pi,
-							     family2afi(dest_p->family), safi,
-							     rpki_curr_state, json_paths, NULL,
-							     show_flags);
-				} else {
-					route_vty_out(vty, dest_p, pi, display, NULL, safi,
-						      json_paths, wide, NULL);
-				}
-			}
-			display++;
-			prefix_path_count++;
-			if (CHECK_FLAG(pi->flags, BGP_PATH_SELECTED))
-				best_path_selected = true;
+		if (type == bgp_show_type_lcommunity_exact) {
+			struct lcommunity *lcom = output_arg;
+
+			if (!bgp_attr_get_lcommunity(pi->attr) ||
+			    !lcommunity_cmp(
+				    bgp_attr_get_lcommunity(pi->attr),
+				    lcom))
+				continue;
 		}
+		if (type == bgp_show_type_lcommunity_list) {
+			struct community_list *list = output_arg;
 
-		if (display) {
-			output_count++;
-			if (!use_json)
+			if (!lcommunity_list_match(
+				    bgp_attr_get_lcommunity(pi->attr),
+				    list))
 				continue;
+		}
+		if (type
+		    == bgp_show_type_lcommunity_list_exact) {
+			struct community_list *list = output_arg;
 
-			/* encode prefix */
-			if (dest_p->family == AF_FLOWSPEC) {
-				char retstr[BGP_FLOWSPEC_STRING_DISPLAY_MAX];
-
-
-				bgp_fs_nlri_get_string(
-					(unsigned char *)
-						dest_p->u.prefix_flowspec.ptr,
-					dest_p->u.prefix_flowspec.prefixlen,
-					retstr, NLRI_STRING_FORMAT_MIN, NULL,
-					family2afi(dest_p->u
-						   .prefix_flowspec.family));
-				if (first)
-					vty_out(vty, "\"%s/%d\": ", retstr,
-						dest_p->u.prefix_flowspec
-							.prefixlen);
-				else
-					vty_out(vty, ",\"%s/%d\": ", retstr,
-						dest_p->u.prefix_flowspec
-							.prefixlen);
-			} else if (safi == SAFI_BGP_LS) {
-				char nlri_str[1024];
+			if (!lcommunity_list_exact_match(
+				    bgp_attr_get_lcommunity(pi->attr),
+				    list))
+				continue;
+		}
+		if (type == bgp_show_type_lcommunity_all) {
+			if (!bgp_attr_get_lcommunity(pi->attr))
+				continue;
+		}
+		if (type == bgp_show_type_dampend_paths
+		    || type == bgp_show_type_damp_neighbor) {
+			if (!CHECK_FLAG(pi->flags, BGP_PATH_DAMPED)
+			    || CHECK_FLAG(pi->flags, BGP_PATH_HISTORY))
+				continue;
+		}
+		if (type == bgp_show_type_self_originated) {
+			if (pi->peer != bgp->peer_self)
+				continue;
+		}
 
-				bgp_ls_nlri_format(dest->ls_nlri, nlri_str, sizeof(nlri_str));
-				if (first)
-					vty_out(vty, "\"%s\": ", nlri_str);
-				else
-					vty_out(vty, ",\"%s\": ", nlri_str);
+		if (!brief && !use_json && state->header) {
+			vty_out(vty,
+				"BGP table version is %" PRIu64
+				", local router ID is %pI4, vrf id ",
+				table->version, &bgp->router_id);
+			if (bgp->vrf_id == VRF_UNKNOWN)
+				vty_out(vty, "%s", VRFID_NONE_STR);
+			else
+				vty_out(vty, "%u", bgp->vrf_id);
+			vty_out(vty, "\n");
+			vty_out(vty, "Default local pref %u, ",
+				bgp->default_local_pref);
+			vty_out(vty, "local AS ");
+			vty_out(vty, ASN_FORMAT(bgp->asnotation), &bgp->as);
+			vty_out(vty, "\n");
+			if (!detail_routes) {
+				vty_out(vty, BGP_SHOW_SCODE_HEADER);
+				vty_out(vty, BGP_SHOW_NCODE_HEADER);
+				vty_out(vty, BGP_SHOW_OCODE_HEADER);
+				vty_out(vty, BGP_SHOW_RPKI_HEADER);
+				if (safi == SAFI_BGP_LS)
+					vty_out(vty, BGP_SHOW_BGP_LS_PREFIX_CODES_HEADER);
+			}
+			if (type == bgp_show_type_dampend_paths ||
+			    type == bgp_show_type_damp_neighbor)
+				vty_out(vty, BGP_SHOW_DAMP_HEADER);
+			else if (type == bgp_show_type_flap_statistics ||
+				 type == bgp_show_type_flap_neighbor)
+				vty_out(vty, BGP_SHOW_FLAP_HEADER);
+			else if (!detail_routes)
+				vty_out(vty, (wide ? BGP_SHOW_HEADER_WIDE
+						   : BGP_SHOW_HEADER));
+			state->header = false;
+		}
+		if (!brief) {
+			if (rd != NULL && !display && !state->output_count) {
+				if (!use_json)
+					vty_out(vty, "Route Distinguisher: %s\n", rd);
+			}
+
+			if (type == bgp_show_type_dampend_paths ||
+			    type == bgp_show_type_damp_neighbor)
+				damp_route_vty_out(vty, dest_p, pi, display, afi, safi,
+						   use_json, json_paths);
+			else if (type == bgp_show_type_flap_statistics ||
+				 type == bgp_show_type_flap_neighbor)
+				flap_route_vty_out(vty, dest_p, pi, display, afi, safi,
+						   use_json, json_paths);
+			else if (detail_routes || detail_json) {
+				const struct prefix_rd *prd = NULL;
+
+				if (dest->pdest)
+					prd = bgp_rd_from_dest(dest->pdest, safi);
+
+				if (!use_json)
+					route_vty_out_detail_header(vty, bgp, dest,
+								    bgp_dest_get_prefix(
+									    dest),
+								    prd, table->afi, safi,
+								    NULL, false, false);
+
+				route_vty_out_detail(vty, bgp, dest, dest_p, pi,
+						     family2afi(dest_p->family), safi,
+						     rpki_curr_state, json_paths, NULL,
+						     show_flags);
 			} else {
-				if (first)
-					vty_out(vty, "\"%pFX\": ", dest_p);
-				else
-					vty_out(vty, ",\"%pFX\": ", dest_p);
+				route_vty_out(vty, dest_p, pi, display, NULL, safi,
+					      json_paths, wide, NULL);
 			}
+		}
+		display++;
+		prefix_path_count++;
+		if (CHECK_FLAG(pi->flags, BGP_PATH_SELECTED))
+			best_path_selected = true;
+	}
 
-			/* json detail: per-prefix dict with header keys + "paths": [..] */
-			if (json_detail_header && json_paths != NULL && !brief) {
-				const struct prefix_rd *prd;
+	if (display) {
+		state->output_count++;
+		if (!use_json)
+			return;
 
-				/* Start per-prefix dictionary */
-				vty_out(vty, "{\n");
+		/* encode prefix */
+		if (dest_p->family == AF_FLOWSPEC) {
+			char retstr[BGP_FLOWSPEC_STRING_DISPLAY_MAX];
+
+
+			bgp_fs_nlri_get_string(
+				(unsigned char *)
+					dest_p->u.prefix_flowspec.ptr,
+				dest_p->u.prefix_flowspec.prefixlen,
+				retstr, NLRI_STRING_FORMAT_MIN, NULL,
+				family2afi(dest_p->u
+					   .prefix_flowspec.family));
+			if (state->first)
+				vty_out(vty, "\"%s/%d\": ", retstr,
+					dest_p->u.prefix_flowspec
+						.prefixlen);
+			else
+				vty_out(vty, ",\"%s/%d\": ", retstr,
+					dest_p->u.prefix_flowspec
+						.prefixlen);
+		} else if (safi == SAFI_BGP_LS) {
+			char nlri_str[1024];
+
+			bgp_ls_nlri_format(dest->ls_nlri, nlri_str, sizeof(nlri_str));
+			if (state->first)
+				vty_out(vty, "\"%s\": ", nlri_str);
+			else
+				vty_out(vty, ",\"%s\": ", nlri_str);
+		} else {
+			if (state->first)
+				vty_out(vty, "\"%pFX\": ", dest_p);
+			else
+				vty_out(vty, ",\"%pFX\": ", dest_p);
+		}
 
-				prd = bgp_rd_from_dest(dest, safi);
+		/* json detail: per-prefix dict with header keys + "paths": [..] */
+		if (state->json_detail_header && json_paths != NULL && !brief) {
+			const struct prefix_rd *prd;
 
-				route_vty_out_detail_header(vty, bgp, dest,
-							    bgp_dest_get_prefix(dest), prd,
-							    table->afi, safi, json_paths, true,
-							    false);
+			/* Start per-prefix dictionary */
+			vty_out(vty, "{\n");
 
-				vty_out(vty, "\"paths\": ");
-				json_detail_header_used = true;
-			}
+			prd = bgp_rd_from_dest(dest, safi);
 
-			/*
-			 * We are using no_pretty here because under
-			 * extremely high settings( say lots and lots of
-			 * routes with lots and lots of ways to reach
-			 * that route via different paths ) this can
-			 * save several minutes of output when FRR
-			 * is run on older cpu's or more underperforming
-			 * routers out there
+			route_vty_out_detail_header(vty, bgp, dest,
+						    bgp_dest_get_prefix(dest), prd,
+						    table->afi, safi, json_paths, true,
+						    false);
+
+			vty_out(vty, "\"paths\": ");
+			json_detail_header_used = true;
+		}
+
+		/*
+		 * We are using no_pretty here because under
+		 * extremely high settings( say lots and lots of
+		 * routes with lots and lots of ways to reach
+		 * that route via different paths ) this can
+		 * save several minutes of output when FRR
+		 * is run on older cpu's or more underperforming
+		 * routers out there
+		 */
+		if (brief) {
+			/* Start per-prefix entry for brief */
+			vty_out(vty, "{\n");
+			/* Free the json_paths as it is not part of brief
+			 * display
 			 */
-			if (brief) {
-				/* Start per-prefix entry for brief */
-				vty_out(vty, "{\n");
-				/* Free the json_paths as it is not part of brief
-				 * display
-				 */
-				json_object_free(json_paths);
-			} else {
-				vty_json_no_pretty(vty, json_paths);
-			}
+			json_object_free(json_paths);
+		} else {
+			vty_json_no_pretty(vty, json_paths);
+		}
 
-			if (json_detail_header_used || brief) {
-				json_object *json_flags = json_object_new_object();
-
-				json_object_boolean_add(json_flags, "bestPathExists",
-							best_path_selected);
-				if (CHECK_FLAG(bgp->flags, BGP_FLAG_SUPPRESS_FIB_PENDING)) {
-					if (CHECK_FLAG(dest->flags, BGP_NODE_FIB_INSTALLED))
-						json_object_boolean_true_add(json_flags,
-									     "fibInstalled");
-					if (CHECK_FLAG(dest->flags, BGP_NODE_FIB_INSTALL_PENDING))
-						json_object_boolean_true_add(json_flags,
-									     "fibWaitForInstall");
-				}
+		if (json_detail_header_used || brief) {
+			json_object *json_flags = json_object_new_object();
 
-				if (brief)
-					vty_out(vty, "\"pathCount\":%d\n", prefix_path_count);
-				vty_out(vty, ",\"multiPathCount\":%d\n",
-					best_path_selected ? (int)bgp_path_info_mpath_count(dest)
-							   : 0);
-				vty_out(vty, ",\"flags\": ");
-				vty_json_no_pretty(vty, json_flags);
-				/* vty_json_no_pretty (vty_json_helper) already frees json_flags */
+			json_object_boolean_add(json_flags, "bestPathExists",
+						best_path_selected);
+			if (CHECK_FLAG(bgp->flags, BGP_FLAG_SUPPRESS_FIB_PENDING)) {
+				if (CHECK_FLAG(dest->flags, BGP_NODE_FIB_INSTALLED))
+					json_object_boolean_true_add(json_flags,
+								     "fibInstalled");
+				if (CHECK_FLAG(dest->flags, BGP_NODE_FIB_INSTALL_PENDING))
+					json_object_boolean_true_add(json_flags,
+								     "fibWaitForInstall");
 			}
 
-			/* End per-prefix dictionary */
-			if (json_detail_header_used || brief)
-				vty_out(vty, "} ");
+			if (brief)
+				vty_out(vty, "\"pathCount\":%d\n", prefix_path_count);
+			vty_out(vty, ",\"multiPathCount\":%d\n",
+				best_path_selected ? (int)bgp_path_info_mpath_count(dest)
+						   : 0);
+			vty_out(vty, ",\"flags\": ");
+			vty_json_no_pretty(vty, json_flags);
+			/* vty_json_no_pretty (vty_json_helper) already frees json_flags */
+		}
+
+		/* End per-prefix dictionary */
+		if (json_detail_header_used || brief)
+			vty_out(vty, "} ");
 
-			json_paths = NULL;
-			first = 0;
-		} else if (!brief)
-			json_object_free(json_paths);
-	}
+		json_paths = NULL;
+		state->first = false;
+	} else if (!brief)
+		json_object_free(json_paths);
+}
+
+/* Finish a table walk: fold in the cumulative counters and close the output. */
+static void bgp_show_table_end(struct vty *vty, enum bgp_show_type type, const char *rd,
+			       int is_last, unsigned long *output_cum, unsigned long *total_cum,
+			       unsigned long *json_header_depth, uint16_t show_flags,
+			       struct bgp_show_table_state *state)
+{
+	bool use_json = CHECK_FLAG(show_flags, BGP_SHOW_OPT_JSON);
+	bool all = CHECK_FLAG(show_flags, BGP_SHOW_OPT_AFI_ALL);
 
 	if (output_cum) {
-		output_count += *output_cum;
-		*output_cum = output_count;
+		state->output_count += *output_cum;
+		*output_cum = state->output_count;
 	}
 	if (total_cum) {
-		total_count += *total_cum;
-		*total_cum = total_count;
+		state->total_count += *total_cum;
+		*total_cum = state->total_count;
 	}
 	if (use_json) {
 		if (rd) {
@@ -14026,12 +14183,12 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t sa
 			unsigned long i;
 			for (i = 0; i < *json_header_depth; ++i) {
 				if (i == *json_header_depth - 1)
-					vty_out(vty, ",\"numRoutes\":%lu\n", output_count);
+					vty_out(vty, ",\"numRoutes\":%lu\n", state->output_count);
 				vty_out(vty, " } ");
 				/* Put this information before closing the last `}` */
 				if (i == *json_header_depth - 2)
 					vty_out(vty, ", \"totalRoutes\": %ld, \"totalPaths\": %ld",
-						output_count, total_count);
+						state->output_count, state->total_count);
 			}
 			if (!all)
 				vty_out(vty, "\n");
@@ -14039,17 +14196,38 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t sa
 	} else {
 		if (is_last) {
 			/* No route is displayed */
-			if (output_count == 0) {
+			if (state->output_count == 0) {
 				if (type == bgp_show_type_normal)
 					vty_out(vty,
 						"No BGP prefixes displayed, %ld exist\n",
-						total_count);
+						state->total_count);
 			} else
 				vty_out(vty,
 					"\nDisplayed %ld routes and %ld total paths\n",
-					output_count, total_count);
+					state->output_count, state->total_count);
 		}
 	}
+}
+
+static int bgp_show_table(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
+			  struct bgp_table *table, enum bgp_show_type type, void *output_arg,
+			  const char *rd, int is_last, unsigned long *output_cum,
+			  unsigned long *total_cum, unsigned long *json_header_depth,
+			  uint16_t show_flags, enum rpki_states rpki_target_state, bool brief)
+{
+	struct bgp_dest *dest;
+	struct bgp_show_table_state state;
+
+	bgp_show_table_begin(vty, bgp, table, type, rd, output_cum, json_header_depth,
+			     show_flags, brief, &state);
+
+	/* Start processing of routes. */
+	for (dest = bgp_table_top(table); dest; dest = bgp_route_next(dest))
+		bgp_show_table_dest(vty, bgp, afi, safi, table, dest, type, output_arg, rd,
+				    show_flags, rpki_target_state, brief, &state);
+
+	bgp_show_table_end(vty, type, rd, is_last, output_cum, total_cum, json_header_depth,
+			   show_flags, &state);
 
 	return CMD_SUCCESS;
 }
@@ -14158,6 +14336,188 @@ static int bgp_show(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
 			      &json_header_depth, show_flags, rpki_target_state, brief);
 }
 
+/*
+ * Streaming "show bgp ... json" for vtysh sessions.
+ *
+ * bgp_show_table() runs the whole table in one go, so on a full table
+ * the main thread is blocked for as long as it takes and everything the
+ * client has not read yet piles up in the vty output buffer.  Here the
+ * same walk is cut into chunks run from the event loop: the command
+ * returns CMD_SUSPEND, each chunk emits up to BGP_SHOW_STREAM_CHUNK
+ * prefixes and the next chunk only starts once vtysh has drained what
+ * was produced before.  Memory use no longer depends on the table size.
+ */
+#define BGP_SHOW_STREAM_CHUNK 1000
+#define BGP_SHOW_STREAM_BACKOFF_MSEC 10
+
+struct bgp_show_stream {
+	struct vty *vty;
+	struct bgp *bgp;
+	afi_t afi;
+	safi_t safi;
+	struct bgp_table *table;
+
+	/* Next destination to display, locked while we are suspended */
+	struct bgp_dest *dest;
+
+	enum bgp_show_type type;
+	uint16_t show_flags;
+	enum rpki_states rpki_target_state;
+	bool brief;
+
+	unsigned long json_header_depth;
+	struct bgp_show_table_state state;
+
+	struct event *t_walk;
+};
+
+static void bgp_show_stream_free(struct bgp_show_stream *stream)
+{
+	event_cancel(&stream->t_walk);
+
+	if (stream->dest)
+		bgp_dest_unlock_node(stream->dest);
+	bgp_table_unlock(stream->table);
+	bgp_unlock(stream->bgp);
+
+	XFREE(MTYPE_BGP_SHOW_STREAM, stream);
+}
+
+static void bgp_show_stream_cancel(struct vty *vty, void *arg)
+{
+	bgp_show_stream_free(arg);
+}
+
+static void bgp_show_stream_walk(struct event *event)
+{
+	struct bgp_show_stream *stream = EVENT_ARG(event);
+	struct vty *vty = stream->vty;
+	unsigned int count = 0;
+
+	/* Wait for vtysh to catch up before producing more output */
+	if (vty_output_backlog(vty)) {
+		event_add_timer_msec(bm->master, bgp_show_stream_walk, stream,
+				     BGP_SHOW_STREAM_BACKOFF_MSEC, &stream->t_walk);
+		return;
+	}
+
+	if (vty->status == VTY_CLOSE ||
+	    CHECK_FLAG(stream->bgp->flags, BGP_FLAG_DELETE_IN_PROGRESS)) {
+		/* Still terminate the JSON document with what we have */
+		if (stream->dest) {
+			bgp_dest_unlock_node(stream->dest);
+			stream->dest = NULL;
+		}
+	}
+
+	while (stream->dest && count < BGP_SHOW_STREAM_CHUNK) {
+		bgp_show_table_dest(vty, stream->bgp, stream->afi, stream->safi, stream->table,
+				    stream->dest, stream->type, NULL, NULL, stream->show_flags,
+				    stream->rpki_target_state, stream->brief, &stream->state);
+		stream->dest = bgp_route_next(stream->dest);
+		count++;
+	}
+
+	if (stream->dest) {
+		event_add_event(bm->master, bgp_show_stream_walk, stream, 0, &stream->t_walk);
+		return;
+	}
+
+	bgp_show_table_end(vty, stream->type, NULL, 1, NULL, NULL, &stream->json_header_depth,
+			   stream->show_flags, &stream->state);
+
+	vty->suspend_cancel = NULL;
+	vty->suspend_arg = NULL;
+	bgp_show_stream_free(stream);
+
+	vty_resume_response(vty, CMD_SUCCESS);
+}
+
+/*
+ * Only the plain table dumps are streamed: the filters that take an
+ * output_arg point at data owned by the calling command, and the "all"
+ * variants keep writing output after bgp_show() returns.
+ */
+static bool bgp_show_stream_possible(struct vty *vty, safi_t safi, enum bgp_show_type type,
+				     void *output_arg, uint16_t show_flags)
+{
+	if (vty->type != VTY_SHELL_SERV || vty->suspend_cancel)
+		return false;
+
+	if (!CHECK_FLAG(show_flags, BGP_SHOW_OPT_JSON) ||
+	    CHECK_FLAG(show_flags, BGP_SHOW_OPT_AFI_ALL))
+		return false;
+
+	if (output_arg)
+		return false;
+
+	switch (type) {
+	case bgp_show_type_normal:
+	case bgp_show_type_cidr_only:
+	case bgp_show_type_community_all:
+	case bgp_show_type_lcommunity_all:
+	case bgp_show_type_self_originated:
+	case bgp_show_type_rpki:
+		break;
+	default:
+		return false;
+	}
+
+	switch (safi) {
+	case SAFI_UNICAST:
+	case SAFI_MULTICAST:
+	case SAFI_LABELED_UNICAST:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static int bgp_show_json_stream(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
+				enum bgp_show_type type, uint16_t show_flags,
+				enum rpki_states rpki_target_state, bool brief)
+{
+	struct bgp_show_stream *stream;
+	struct bgp_table *table;
+
+	if (bgp == NULL)
+		bgp = bgp_get_default();
+
+	if (bgp == NULL || IS_BGP_INSTANCE_HIDDEN(bgp)) {
+		vty_out(vty, "{}\n");
+		return CMD_WARNING;
+	}
+
+	/* Labeled-unicast routes live in the unicast table. */
+	if (safi == SAFI_LABELED_UNICAST)
+		safi = SAFI_UNICAST;
+
+	table = bgp->rib[afi][safi];
+
+	stream = XCALLOC(MTYPE_BGP_SHOW_STREAM, sizeof(*stream));
+	stream->vty = vty;
+	stream->bgp = bgp_lock(bgp);
+	stream->afi = afi;
+	stream->safi = safi;
+	stream->table = table;
+	bgp_table_lock(table);
+	stream->type = type;
+	stream->show_flags = show_flags;
+	stream->rpki_target_state = rpki_target_state;
+	stream->brief = brief;
+
+	bgp_show_table_begin(vty, bgp, table, type, NULL, NULL, &stream->json_header_depth,
+			     show_flags, brief, &stream->state);
+	stream->dest = bgp_table_top(table);
+
+	vty->suspend_cancel = bgp_show_stream_cancel;
+	vty->suspend_arg = stream;
+
+	event_add_event(bm->master, bgp_show_stream_walk, stream, 0, &stream->t_walk);
+
+	return CMD_SUSPEND;
+}
+
 static void bgp_show_all_instances_routes_vty(struct vty *vty, afi_t afi,
 					      safi_t safi, uint16_t show_flags)
 {
@@ -15370,6 +15730,9 @@ DEFPY(show_ip_bgp, show_ip_bgp_cmd,
 			return bgp_show_community(vty, bgp, community,
 						  match_p, afi, safi,
 						  show_flags);
+		else if (bgp_show_stream_possible(vty, safi, sh_type, output_arg, show_flags))
+			return bgp_show_json_stream(vty, bgp, afi, safi, sh_type, show_flags,
+						    rpki_target_state, brief);
 		else
 			return bgp_show(vty, bgp, afi, safi, sh_type, output_arg, show_flags,
 					rpki_target_state, brief);
@@ -18694,4 +19057,12 @@ void bgp_route_finish(void)
 		bgp_table_unlock(bgp_distance_table[afi][safi]);
 		bgp_distance_table[afi][safi] = NULL;
 	}
+
+	/* Anything still allocated at this point shows up as a leak */
+	if (!bgp_path_info_pool.n_inuse)
+		slab_pool_fini(&bgp_path_info_pool);
+	if (!bgp_dest_pool.n_inuse)
+		slab_pool_fini(&bgp_dest_pool);
+	if (!bgp_table_node_pool.n_inuse)
+		slab_pool_fini(&bgp_table_node_pool);
 }
@@ -316,6 +316,9 @@ struct bgp_path_info {
 	/* reference count */
 	int lock;
 
+	/* Dense ID out of bgp_path_info_pool */
+	uint32_t id;
+
 	/* BGP information status.  */
 	uint32_t flags;
 #define BGP_PATH_IGP_CHANGED (1 << 0)
@@ -352,6 +355,18 @@ struct bgp_path_info {
  * the actual ecmp path.
  */
 #define BGP_PATH_MULTIPATH_NEW (1 << 20)
+/*
+ * Set when anything that goes into advertising this path changed since
+ * update-groups last walked the dest; lets addpath-tx-all-paths skip the
+ * paths that did not change.
+ */
+#define BGP_PATH_TX_CHANGED (1 << 21)
+#define BGP_PATH_TX_FLAGS                                                      \
+	(BGP_PATH_IGP_CHANGED | BGP_PATH_DAMPED | BGP_PATH_HISTORY |            \
+	 BGP_PATH_SELECTED | BGP_PATH_VALID | BGP_PATH_ATTR_CHANGED |           \
+	 BGP_PATH_STALE | BGP_PATH_REMOVED | BGP_PATH_ANNC_NH_SELF |            \
+	 BGP_PATH_LINK_BW_CHG | BGP_PATH_ACCEPT_OWN |                           \
+	 BGP_PATH_MPLSVPN_LABEL_NH | BGP_PATH_MPLSVPN_NH_LABEL_BIND)
 
 	/* BGP route type.  This can be static, RIP, OSPF, BGP etc.  */
 	uint8_t type;
@@ -452,9 +467,6 @@ struct bgp_aggregate {
 
 	/** Are there MED mismatches? */
 	bool med_mismatched;
-	/* MED matching state. */
-	/** Did we get the first MED value? */
-	bool med_initialized;
 	/** Match only equal MED. */
 	bool match_med;
 
@@ -505,8 +517,18 @@ struct bgp_aggregate {
 	/* Aggregate route's as-path. */
 	struct aspath *aspath;
 
-	/** MED value found in current group. */
-	uint32_t med_matched_value;
+	/** Refcounted MED values of the routes under this aggregate. */
+	struct hash *med_hash;
+
+	/** Aggregate attributes must be recomputed from the hashes. */
+	bool attr_stale;
+
+	/** Pending update of the aggregate route, see bgp_aggregate_update. */
+	struct event *t_update;
+	struct bgp *bgp;
+	afi_t afi;
+	safi_t safi;
+	struct prefix p;
 
 	/**
 	 * Test if aggregated address MED of all route match, otherwise
@@ -1018,6 +1040,8 @@ extern bool bgp_path_suppressed(struct bgp_path_info *pi);
 extern bool bgp_addpath_encode_rx(struct peer *peer, afi_t afi, safi_t safi);
 extern const struct prefix_rd *bgp_rd_from_dest(const struct bgp_dest *dest,
 						safi_t safi);
+extern void bgp_path_info_attr_account(struct bgp_path_info *path,
+				       const struct attr *attr);
 extern void bgp_path_info_free_with_caller(const char *caller,
 					   struct bgp_path_info *path);
 extern void bgp_path_info_add_with_caller(const char *caller,
@@ -1032,6 +1056,24 @@ extern int bgp_path_info_cmp(struct bgp *bgp, struct bgp_path_info *new,
 #define bgp_path_info_add(A, B)                                                \
 	bgp_path_info_add_with_caller(__func__, (A), (B))
 #define bgp_path_info_free(B) bgp_path_info_free_with_caller(__func__, (B))
+
+extern struct slab_pool bgp_path_info_pool;
+
+static inline struct bgp_path_info *bgp_path_info_slab_alloc(void)
+{
+	struct bgp_path_info *path;
+	uint32_t id;
+
+	path = slab_alloc(&bgp_path_info_pool, &id);
+	path->id = id;
+	return path;
+}
+
+#define bgp_path_info_slab_free(path)                                          \
+	do {                                                                   \
+		slab_free(&bgp_path_info_pool, (path), (path)->id);            \
+		(path) = NULL;                                                 \
+	} while (0)
 extern void bgp_meta_queue_free(struct meta_queue *mq);
 extern int early_route_process(struct bgp *bgp, struct bgp_dest *dest);
 extern int other_route_process(struct bgp *bgp, struct bgp_dest *dest);
@@ -51,6 +51,7 @@
 #include "bgpd/bgp_script.h"
 #include "bgpd/bgp_encap_types.h"
 #include "bgpd/bgp_errors.h"
+#include "bgpd/bgp_conditional_adv.h"
 #ifdef ENABLE_BGP_VNC
 #include "bgpd/rfapi/bgp_rfapi_cfg.h"
 #endif
@@ -4681,16 +4682,18 @@ static const struct route_map_rule_cmd route_match_vpn_dataplane_cmd = {
 
 /*
  * This is the workhorse routine for processing in/out routemap
- * modifications.
+ * modifications.  Returns true if the route-map is one of the peer's
+ * condition-maps.
  */
-static void bgp_route_map_process_peer(const char *rmap_name,
+static bool bgp_route_map_process_peer(const char *rmap_name,
 				       struct route_map *map, struct peer *peer,
 				       int afi, int safi, int route_update)
 {
 	struct bgp_filter *filter;
+	bool cmap_changed = false;
 
 	if (!peer || !rmap_name)
-		return;
+		return false;
 
 	filter = &peer->filter[afi][safi];
 	/*
@@ -4744,6 +4747,7 @@ static void bgp_route_map_process_peer(const char *rmap_name,
 	if (filter->advmap.cname
 	    && (strcmp(rmap_name, filter->advmap.cname) == 0)) {
 		filter->advmap.cmap = map;
+		cmap_changed = true;
 	}
 
 	if (peer->default_rmap[afi][safi].name
@@ -4752,6 +4756,8 @@ static void bgp_route_map_process_peer(const char *rmap_name,
 
 	/* Notify BGP conditional advertisement scanner percess */
 	peer->advmap_config_change[afi][safi] = true;
+
+	return cmap_changed;
 }
 
 static void bgp_route_map_update_peer_group(const char *rmap_name,
@@ -4816,6 +4822,7 @@ static void bgp_route_map_process_update(struct bgp *bgp, const char *rmap_name,
 {
 	int i;
 	bool matched;
+	bool cmap_changed = false;
 	afi_t afi;
 	safi_t safi;
 	struct peer *peer;
@@ -4837,11 +4844,16 @@ static void bgp_route_map_process_update(struct bgp *bgp, const char *rmap_name,
 		FOREACH_AFI_SAFI (afi, safi) {
 			/* process in/out/import/export/default-orig
 			 * route-maps */
-			bgp_route_map_process_peer(rmap_name, map, peer, afi,
-						   safi, route_update);
+			if (bgp_route_map_process_peer(rmap_name, map, peer,
+						       afi, safi, route_update))
+				cmap_changed = true;
 		}
 	}
 
+	/* Condition-map changed: drop the watchers once, not per peer */
+	if (cmap_changed)
+		bgp_conditional_adv_watch_reset(bgp);
+
 	/* for outbound/default-orig route-maps, process for groups */
 	update_group_policy_update(bgp, BGP_POLICY_ROUTE_MAP, rmap_name,
 				   route_update, 0);
@@ -20,6 +20,17 @@
 #include "bgp_mpath.h"
 #include "bgp_ls.h"
 
+struct slab_pool bgp_dest_pool = SLAB_POOL_INIT("BGP destination", MTYPE_BGP_NODE,
+						struct bgp_dest);
+
+/*
+ * Tree nodes, including the ones that only exist for the tree structure.
+ * Carving them out of chunks saves the per-allocation malloc overhead and
+ * keeps nodes created together close to each other in memory.
+ */
+struct slab_pool bgp_table_node_pool = SLAB_POOL_INIT("BGP table node", MTYPE_BGP_TABLE_NODE,
+						      struct route_node);
+
 void bgp_table_lock(struct bgp_table *rt)
 {
 	rt->lock++;
@@ -106,7 +117,7 @@ inline struct bgp_dest *bgp_dest_unlock_node(struct bgp_dest *dest)
 			bgp_ls_nlri_free(dest->ls_nlri);
 		}
 
-		XFREE(MTYPE_BGP_NODE, dest);
+		bgp_dest_slab_free(dest);
 		dest = NULL;
 		route_node_set_info(rn, NULL);
 	}
@@ -115,6 +126,20 @@ inline struct bgp_dest *bgp_dest_unlock_node(struct bgp_dest *dest)
 	return dest;
 }
 
+/*
+ * bgp_node_create
+ */
+static struct route_node *bgp_node_create(route_table_delegate_t *delegate,
+					  struct route_table *table)
+{
+	struct route_node *node;
+	uint32_t id;
+
+	node = slab_alloc(&bgp_table_node_pool, &id);
+	node->delegate_id = id;
+	return node;
+}
+
 /*
  * bgp_node_destroy
  */
@@ -136,21 +161,21 @@ static void bgp_node_destroy(route_table_delegate_t *delegate,
 		if (dest->mpath)
 			bgp_path_info_mpath_free(&dest->mpath);
 
-		XFREE(MTYPE_BGP_NODE, dest);
+		bgp_dest_slab_free(dest);
 		route_node_set_info(node, NULL);
 	}
 
 	if (node->p.family == AF_FLOWSPEC)
 		prefix_flowspec_ptr_free(&node->p);
 
-	XFREE(MTYPE_ROUTE_NODE, node);
+	slab_free(&bgp_table_node_pool, node, node->delegate_id);
 }
 
 /*
  * Function vector to customize the behavior of the route table
  * library for BGP route tables.
  */
-route_table_delegate_t bgp_table_delegate = { .create_node = route_node_create,
+route_table_delegate_t bgp_table_delegate = { .create_node = bgp_node_create,
 					      .destroy_node = bgp_node_destroy };
 
 /*
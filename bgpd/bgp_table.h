@@ -11,6 +11,7 @@
 #include "queue.h"
 #include "linklist.h"
 #include "typesafe.h"
+#include "slab.h"
 #include "bgpd.h"
 #include "bgp_advertise.h"
 #include "bgp_attr_srv6.h"
@@ -113,6 +114,13 @@ struct bgp_dest {
 #define BGP_NODE_SCHEDULE_FOR_DELETE	(1 << 11)
 #define BGP_NODE_NHT_RESOLVED_NODE	(1 << 12)
 #define BGP_NODE_ZEBRA_ANNOUNCE_EARLY	(1 << 13)
+/* a change not tied to one path, addpath TX has to look at all of them */
+#define BGP_NODE_ADDPATH_TX_FULL	(1 << 14)
+/* update-groups may only look at the paths flagged BGP_PATH_TX_CHANGED */
+#define BGP_NODE_ADDPATH_TX_DELTA	(1 << 15)
+
+	/* Dense ID out of bgp_dest_pool, usable to index per-dest arrays */
+	uint32_t id;
 
 	struct bgp_addpath_node_data tx_addpath;
 
@@ -124,6 +132,25 @@ struct bgp_dest {
 
 DECLARE_LIST(zebra_announce, struct bgp_bp_install_node, zai);
 
+extern struct slab_pool bgp_dest_pool;
+extern struct slab_pool bgp_table_node_pool;
+
+static inline struct bgp_dest *bgp_dest_slab_alloc(void)
+{
+	struct bgp_dest *dest;
+	uint32_t id;
+
+	dest = slab_alloc(&bgp_dest_pool, &id);
+	dest->id = id;
+	return dest;
+}
+
+#define bgp_dest_slab_free(dest)                                               \
+	do {                                                                   \
+		slab_free(&bgp_dest_pool, (dest), (dest)->id);                 \
+		(dest) = NULL;                                                 \
+	} while (0)
+
 extern void bgp_delete_listnode(struct bgp_dest *dest);
 /*
  * bgp_table_iter_t
@@ -181,8 +208,13 @@ static inline struct bgp_table *bgp_dest_table(struct bgp_dest *dest)
  */
 static inline struct bgp_dest *bgp_dest_parent_nolock(struct bgp_dest *dest)
 {
-	struct route_node *rn = bgp_dest_to_rnode(dest)->parent;
+	struct route_node *rn = bgp_dest_to_rnode(dest);
+
+	/* Unique mode tables have no tree, hence no parents */
+	if (route_table_is_unique_mode(rn->table))
+		return NULL;
 
+	rn = rn->parent;
 	while (rn && !rn->info)
 		rn = rn->parent;
 
@@ -263,8 +295,7 @@ static inline struct bgp_dest *bgp_node_get(struct bgp_table *const table,
 	struct route_node *rn = route_node_get(table->route_table, p);
 
 	if (!rn->info) {
-		struct bgp_dest *dest = XCALLOC(MTYPE_BGP_NODE,
-						sizeof(struct bgp_dest));
+		struct bgp_dest *dest = bgp_dest_slab_alloc();
 
 		RB_INIT(bgp_adj_out_rb, &dest->adj_out);
 		route_node_set_info(rn, dest);
@@ -918,6 +918,8 @@ static int update_group_show_walkcb(struct update_group *updgrp, void *arg)
 			json_object_int_add(json_subgrp_event,
 					    "mergeCheckEvents",
 					    subgrp->merge_checks_triggered);
+			json_object_int_add(json_subgrp_event, "catchUpEvents",
+					    subgrp->catchup_events);
 			json_object_object_add(json_subgrp, "statistics",
 					       json_subgrp_event);
 			json_object_int_add(json_subgrp, "coalesceTime",
@@ -961,6 +963,8 @@ static int update_group_show_walkcb(struct update_group *updgrp, void *arg)
 				subgrp->peer_refreshes_combined);
 			vty_out(vty, "    Merge checks triggered: %u\n",
 				subgrp->merge_checks_triggered);
+			vty_out(vty, "    Catch-up events: %u\n",
+				subgrp->catchup_events);
 			vty_out(vty, "    Coalesce Time: %u%s\n",
 				(UPDGRP_INST(subgrp->update_group))
 					->coalesce_time,
@@ -1556,6 +1560,119 @@ bool update_subgroup_trigger_merge_check(struct update_subgroup *subgrp,
 	return true;
 }
 
+/*
+ * update_subgroup_find_catchup_source
+ *
+ * Returns the converged subgroup with the most peers in the update group
+ * of the given subgroup, if any.
+ */
+static struct update_subgroup *
+update_subgroup_find_catchup_source(struct update_subgroup *subgrp)
+{
+	struct update_subgroup *target, *source = NULL;
+
+	UPDGRP_FOREACH_SUBGRP (subgrp->update_group, target) {
+		if (target == subgrp)
+			continue;
+
+		if (CHECK_FLAG(target->sflags, SUBGRP_STATUS_DEFAULT_ORIGINATE))
+			continue;
+
+		if (!update_subgroup_ready_for_merge(target))
+			continue;
+
+		if (!source || target->peer_count > source->peer_count)
+			source = target;
+	}
+
+	return source;
+}
+
+static struct bgp_path_info *update_subgroup_catchup_path(struct bgp_dest *dest)
+{
+	struct bgp_path_info *pi;
+
+	for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = pi->next)
+		if (CHECK_FLAG(pi->flags, BGP_PATH_SELECTED))
+			return pi;
+
+	return NULL;
+}
+
+/*
+ * update_subgroup_catchup
+ *
+ * Brings a subgroup that has not advertised anything yet up to date by
+ * replaying the adj-out of a converged subgroup in the same update group,
+ * instead of walking the whole table and running outbound policy on every
+ * route. Peers in the same update group share their outbound policy, so
+ * the adj-out of the other subgroup is exactly what the table walk would
+ * produce. Once the replayed updates have been written out both subgroups
+ * are in the same state and the regular merge check folds them together.
+ *
+ * Returns true if the subgroup was brought up to date.
+ */
+bool update_subgroup_catchup(struct update_subgroup *subgrp)
+{
+	struct update_subgroup *source;
+	struct bgp_adj_out *aout;
+	struct bgp_path_info *pi;
+	struct peer *peer;
+	afi_t afi;
+	safi_t safi;
+
+	peer = SUBGRP_PEER(subgrp);
+	afi = SUBGRP_AFI(subgrp);
+	safi = SUBGRP_SAFI(subgrp);
+
+	if (subgrp->adj_count || !advertise_list_is_empty(subgrp) ||
+	    !bpacket_queue_is_empty(SUBGRP_PKTQ(subgrp)))
+		return false;
+
+	if (CHECK_FLAG(subgrp->sflags, SUBGRP_STATUS_DEFAULT_ORIGINATE))
+		return false;
+
+	/*
+	 * default-originate and the addpath paths limit are evaluated per
+	 * peer, leave those to the table walk.
+	 */
+	if (CHECK_FLAG(peer->af_flags[afi][safi], PEER_FLAG_DEFAULT_ORIGINATE) ||
+	    bgp_addpath_encode_tx(peer, afi, safi))
+		return false;
+
+	source = update_subgroup_find_catchup_source(subgrp);
+	if (!source)
+		return false;
+
+	/*
+	 * Every advertisement needs a path to hang off; if the table has
+	 * moved on for some prefix, fall back to the table walk.
+	 */
+	SUBGRP_FOREACH_ADJ (source, aout) {
+		if (aout->attr && !update_subgroup_catchup_path(aout->dest))
+			return false;
+	}
+
+	SUBGRP_FOREACH_ADJ (source, aout) {
+		if (!aout->attr)
+			continue;
+
+		pi = update_subgroup_catchup_path(aout->dest);
+		bgp_adj_out_set_subgroup(aout->dest, subgrp, aout->attr, pi);
+	}
+
+	subgrp->version = source->version;
+	SUBGRP_INCR_STAT(subgrp, catchup_events);
+
+	if (BGP_DEBUG(update_groups, UPDATE_GROUPS))
+		zlog_debug("u%" PRIu64 ":s%" PRIu64 " caught up from s%" PRIu64
+			   ", %u routes",
+			   subgrp->update_group->id, subgrp->id, source->id,
+			   subgrp->adj_count);
+
+	return true;
+}
+
 /*
  * update_subgroup_copy_adj_out
  *
@@ -2033,6 +2150,8 @@ void update_group_show_stats(struct bgp *bgp, struct vty *vty)
 		bgp->update_group_stats.peer_refreshes_combined);
 	vty_out(vty, "Merge checks triggered: %u\n",
 		bgp->update_group_stats.merge_checks_triggered);
+	vty_out(vty, "Catch-up events: %u\n",
+		bgp->update_group_stats.catchup_events);
 }
 
 /*
@@ -126,6 +126,7 @@ struct update_group {
 	uint32_t adj_count;
 	uint32_t split_events;
 	uint32_t merge_checks_triggered;
+	uint32_t catchup_events;
 
 	uint32_t subgrps_created;
 	uint32_t subgrps_deleted;
@@ -231,6 +232,12 @@ struct update_subgroup {
 	uint32_t split_events;
 	uint32_t merge_checks_triggered;
 
+	/*
+	 * This is bumped up when the subgroup is brought up to date from the
+	 * adj-out of another subgroup instead of a table walk.
+	 */
+	uint32_t catchup_events;
+
 	uint64_t id;
 
 	uint16_t sflags;
@@ -358,6 +365,7 @@ extern void update_subgroup_remove_peer(struct update_subgroup *subgrp, struct p
 extern struct bgp_table *update_subgroup_rib(struct update_subgroup *);
 extern void update_subgroup_split_peer(struct peer_af *paf, struct update_group *updgrp);
 extern bool update_subgroup_check_merge(struct update_subgroup *subgrp, const char *reason);
+extern bool update_subgroup_catchup(struct update_subgroup *subgrp);
 extern bool update_subgroup_trigger_merge_check(struct update_subgroup *subgrp, int force);
 extern void update_group_policy_update(struct bgp *bgp,
 				       enum bgp_policy_type ptype,
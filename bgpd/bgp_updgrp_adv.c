@@ -91,9 +91,16 @@ static void adj_free(struct bgp_adj_out *adj)
 	XFREE(MTYPE_BGP_ADJ_OUT, adj);
 }
 
+/*
+ * With delta set, only the paths changed since update-groups last walked
+ * the dest are looked at (BGP_PATH_TX_CHANGED); the others already have
+ * their adj-out.  That only holds when each path is advertised on its own
+ * merits, i.e. for all-paths without a paths-limit.
+ */
 static void
 subgrp_announce_addpath_best_selected(struct bgp_dest *dest,
-				      struct update_subgroup *subgrp)
+				      struct update_subgroup *subgrp,
+				      bool delta)
 {
 	afi_t afi = SUBGRP_AFI(subgrp);
 	safi_t safi = SUBGRP_SAFI(subgrp);
@@ -105,6 +112,7 @@ subgrp_announce_addpath_best_selected(struct bgp_dest *dest,
 	struct bgp_path_info *pi = NULL;
 	uint16_t paths_count = 0;
 	uint16_t paths_limit = peer->addpath_paths_limit[afi][safi].receive;
+	bool all_paths = peer->addpath_type[afi][safi] == BGP_ADDPATH_ALL;
 
 	if (peer->addpath_type[afi][safi] == BGP_ADDPATH_BEST_SELECTED) {
 		paths_limit =
@@ -155,6 +163,11 @@ subgrp_announce_addpath_best_selected(struct bgp_dest *dest,
 		} else {
 			/* No Paths-Limit involved */
 			if (!paths_limit) {
+				if (delta && all_paths &&
+				    !CHECK_FLAG(pi->flags, BGP_PATH_TX_CHANGED) &&
+				    adj_lookup(dest, subgrp, id))
+					continue;
+
 				subgroup_process_announce_selected(subgrp, pi,
 								   dest, afi,
 								   safi, id);
@@ -183,7 +196,7 @@ subgrp_announce_addpath_best_selected(struct bgp_dest *dest,
 static void subgrp_withdraw_stale_addpath(struct updwalk_context *ctx,
 					  struct update_subgroup *subgrp)
 {
-	struct bgp_adj_out *adj, *adj_next;
+	struct bgp_adj_out *adj, *adj_next, lookup;
 	uint32_t id;
 	struct bgp_path_info *pi;
 	afi_t afi = SUBGRP_AFI(subgrp);
@@ -191,10 +204,13 @@ static void subgrp_withdraw_stale_addpath(struct updwalk_context *ctx,
 	struct peer *peer = SUBGRP_PEER(subgrp);
 
 	/* Look through all of the paths we have advertised for this rn and send
-	 * a withdraw for the ones that are no longer present */
-	RB_FOREACH_SAFE (adj, bgp_adj_out_rb, &ctx->dest->adj_out, adj_next) {
-		if (adj->subgroup != subgrp)
-			continue;
+	 * a withdraw for the ones that are no longer present.  adj-outs are
+	 * sorted by subgroup, so only this subgroup's range is visited. */
+	lookup.subgroup = subgrp;
+	lookup.addpath_tx_id = 0;
+	for (adj = RB_NFIND(bgp_adj_out_rb, &ctx->dest->adj_out, &lookup);
+	     adj && adj->subgroup == subgrp; adj = adj_next) {
+		adj_next = RB_NEXT(bgp_adj_out_rb, adj);
 
 		for (pi = bgp_dest_get_bgp_path_info(ctx->dest); pi;
 		     pi = pi->next) {
@@ -246,7 +262,10 @@ static int group_announce_route_walkcb(struct update_group *updgrp, void *arg)
 			}
 
 			subgrp_withdraw_stale_addpath(ctx, subgrp);
-			subgrp_announce_addpath_best_selected(ctx->dest, subgrp);
+			subgrp_announce_addpath_best_selected(
+				ctx->dest, subgrp,
+				CHECK_FLAG(ctx->dest->flags,
+					   BGP_NODE_ADDPATH_TX_DELTA));
 
 			/* Process the bestpath last so the
 			 * "show [ip] bgp neighbor x.x.x.x advertised" output shows
@@ -830,7 +849,8 @@ void subgroup_announce_table(struct update_subgroup *subgrp,
 	for (dest = bgp_table_top(table); dest; dest = bgp_route_next(dest)) {
 
 		if (addpath_capable)
-			subgrp_announce_addpath_best_selected(dest, subgrp);
+			subgrp_announce_addpath_best_selected(dest, subgrp,
+							      false);
 
 		for (ri = bgp_dest_get_bgp_path_info(dest); ri; ri = ri->next) {
 
@@ -903,6 +923,14 @@ void subgroup_announce_route(struct update_subgroup *subgrp)
 
 	force_update = !!CHECK_FLAG(subgrp->sflags, SUBGRP_STATUS_FORCE_UPDATES);
 
+	/*
+	 * A subgroup that has not advertised anything yet, typically that of
+	 * a peer that just came up, can copy what a converged subgroup of the
+	 * same update group has advertised instead of walking the table.
+	 */
+	if (!force_update && update_subgroup_catchup(subgrp))
+		return;
+
 	if (SUBGRP_SAFI(subgrp) != SAFI_MPLS_VPN
 	    && SUBGRP_SAFI(subgrp) != SAFI_ENCAP
 	    && SUBGRP_SAFI(subgrp) != SAFI_EVPN)
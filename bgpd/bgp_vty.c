@@ -59,6 +59,7 @@
 #include "bgpd/bgp_updgrp.h"
 #include "bgpd/bgp_bfd.h"
 #include "bgpd/bgp_io.h"
+#include "bgpd/bgp_keepalives.h"
 #include "bgpd/bgp_evpn.h"
 #include "bgpd/bgp_evpn_vty.h"
 #include "bgpd/bgp_evpn_mh.h"
@@ -12958,15 +12959,20 @@ DEFUN (show_bgp_memory,
 	unsigned long count;
 
 	/* RIB related usage stats */
-	count = mtype_stats_alloc(MTYPE_BGP_NODE);
+	count = bgp_dest_pool.n_inuse;
 	vty_out(vty, "%ld RIB nodes, using %s of memory\n", count,
 		mtype_memstr(memstrbuf, sizeof(memstrbuf),
-			     count * sizeof(struct bgp_dest)));
+			     count * bgp_dest_pool.objsize));
 
-	count = mtype_stats_alloc(MTYPE_BGP_ROUTE);
+	count = bgp_table_node_pool.n_inuse;
+	vty_out(vty, "%ld BGP table nodes, using %s of memory\n", count,
+		mtype_memstr(memstrbuf, sizeof(memstrbuf),
+			     count * bgp_table_node_pool.objsize));
+
+	count = bgp_path_info_pool.n_inuse;
 	vty_out(vty, "%ld BGP routes, using %s of memory\n", count,
 		mtype_memstr(memstrbuf, sizeof(memstrbuf),
-			     count * sizeof(struct bgp_path_info)));
+			     count * bgp_path_info_pool.objsize));
 	if ((count = mtype_stats_alloc(MTYPE_BGP_ROUTE_EXTRA)))
 		vty_out(vty, "%ld BGP route ancillaries, using %s of memory\n",
 			count,
@@ -13089,6 +13095,62 @@ DEFUN (show_bgp_memory,
 	return CMD_SUCCESS;
 }
 
+DEFPY (show_bgp_keepalives,
+       show_bgp_keepalives_cmd,
+       "show [ip] bgp keepalives [json]",
+       SHOW_STR
+       IP_STR
+       BGP_STR
+       "Keepalive thread statistics\n"
+       JSON_STR)
+{
+	struct bgp_keepalives_stats stats;
+	int64_t late_avg;
+
+	bgp_keepalives_stats_get(&stats);
+	late_avg = stats.wakeups ? stats.late_total / (int64_t)stats.wakeups
+				 : 0;
+
+	if (json) {
+		json_object *json_ka = json_object_new_object();
+		json_object *json_hist = json_object_new_object();
+
+		json_object_int_add(json_ka, "peers", stats.peers);
+		json_object_int_add(json_ka, "keepalivesSent", stats.sent);
+		json_object_int_add(json_ka, "maxBatch", stats.batch_max);
+		json_object_int_add(json_ka, "wakeups", stats.wakeups);
+		json_object_int_add(json_ka, "wakeupLatencyMinUsec",
+				    stats.late_min);
+		json_object_int_add(json_ka, "wakeupLatencyAvgUsec", late_avg);
+		json_object_int_add(json_ka, "wakeupLatencyMaxUsec",
+				    stats.late_max);
+		json_object_int_add(json_hist, "under1ms", stats.late_hist[0]);
+		json_object_int_add(json_hist, "under10ms", stats.late_hist[1]);
+		json_object_int_add(json_hist, "under100ms", stats.late_hist[2]);
+		json_object_int_add(json_hist, "over100ms", stats.late_hist[3]);
+		json_object_object_add(json_ka, "wakeupLatencyHistogram",
+				       json_hist);
+		vty_json(vty, json_ka);
+		return CMD_SUCCESS;
+	}
+
+	vty_out(vty, "Peers: %u\n", stats.peers);
+	vty_out(vty, "Keepalives sent: %" PRIu64 ", at most %u per wakeup\n",
+		stats.sent, stats.batch_max);
+	vty_out(vty, "Wakeups: %" PRIu64 "\n", stats.wakeups);
+	vty_out(vty,
+		"Wakeup latency (usec): min %" PRId64 ", avg %" PRId64
+		", max %" PRId64 "\n",
+		stats.late_min, late_avg, stats.late_max);
+	vty_out(vty,
+		"  < 1ms: %" PRIu64 ", < 10ms: %" PRIu64 ", < 100ms: %" PRIu64
+		", >= 100ms: %" PRIu64 "\n",
+		stats.late_hist[0], stats.late_hist[1], stats.late_hist[2],
+		stats.late_hist[3]);
+
+	return CMD_SUCCESS;
+}
+
 static void bgp_show_bestpath_json(struct bgp *bgp, json_object *json)
 {
 	json_object *bestpath = json_object_new_object();
@@ -15652,6 +15714,43 @@ static void bgp_show_peer_gr_info(struct vty *vty, struct peer *p, bool use_json
 	bgp_show_peer_gr_extra_info(vty, p, use_json, json_neigh);
 }
 
+/*
+ * Adj-RIB-Out entries live in the subgroups, share them out evenly among the
+ * peers of each subgroup the peer belongs to.
+ */
+static uint64_t bgp_peer_adj_rib_out_bytes(struct peer *p)
+{
+	struct update_subgroup *subgrp;
+	enum bgp_af_index index;
+	uint64_t bytes = 0;
+
+	for (index = BGP_AF_START; index < BGP_AF_MAX; index++) {
+		if (!p->peer_af_array[index])
+			continue;
+		subgrp = PAF_SUBGRP(p->peer_af_array[index]);
+		if (!subgrp || !SUBGRP_PCOUNT(subgrp))
+			continue;
+		bytes += (uint64_t)subgrp->adj_count * sizeof(struct bgp_adj_out) /
+			 SUBGRP_PCOUNT(subgrp);
+	}
+
+	return bytes;
+}
+
+static void bgp_show_peer_resource_stats(struct peer *p, json_object *json_neigh)
+{
+	json_object *json_res = json_object_new_object();
+
+	json_object_int_add(json_res, "parseTimeUsecs", p->stat_parse_ns / 1000);
+	json_object_int_add(json_res, "policyTimeUsecs", p->stat_policy_ns / 1000);
+	json_object_int_add(json_res, "bestpathTimeUsecs", p->stat_bestpath_ns / 1000);
+	json_object_int_add(json_res, "encodeTimeUsecs", p->stat_encode_ns / 1000);
+	json_object_int_add(json_res, "attrBytes", p->stat_attr_bytes);
+	json_object_int_add(json_res, "adjRibInBytes", p->stat_adj_rib_in_bytes);
+	json_object_int_add(json_res, "adjRibOutBytes", bgp_peer_adj_rib_out_bytes(p));
+	json_object_object_add(json_neigh, "resourceStats", json_res);
+}
+
 static void bgp_show_peer(struct vty *vty, struct peer *p, uint16_t sh_flags, bool use_json,
 			  json_object *json)
 {
@@ -17097,6 +17196,8 @@ static void bgp_show_peer(struct vty *vty, struct peer *p, uint16_t sh_flags, bo
 		json_object_int_add(json_pfx_stat, "withdrawn", p->stat_pfx_withdraw);
 		json_object_int_add(json_pfx_stat, "attributesDiscarded", p->stat_pfx_discard);
 		json_object_object_add(json_neigh, "prefixStats", json_pfx_stat);
+
+		bgp_show_peer_resource_stats(p, json_neigh);
 	} else {
 		atomic_size_t outq_count, inq_count, open_out, open_in,
 			notify_out, notify_in, update_out, update_in,
@@ -23547,6 +23648,7 @@ void bgp_vty_init(void)
 
 	/* "show [ip] bgp memory" commands. */
 	install_element(VIEW_NODE, &show_bgp_memory_cmd);
+	install_element(VIEW_NODE, &show_bgp_keepalives_cmd);
 
 	/* "show bgp martian next-hop" */
 	install_element(VIEW_NODE, &show_bgp_martian_nexthop_db_cmd);
@@ -1837,6 +1837,96 @@ enum zclient_send_status bgp_zebra_withdraw_actual(struct bgp_dest *dest,
 	return zclient_route_send(ZEBRA_ROUTE_DELETE, bgp_zclient, &api);
 }
 
+/*
+ * Flowspec ipset creations/destructions and ipset entry additions/removals
+ * are packed into multi-item ZEBRA_IPSET_* messages; zebra walks the item
+ * count of those.  While route announcements are walked, items accumulate
+ * so a large flowspec push costs a few hundred messages instead of one per
+ * rule.  Any other PBR message refers to ipsets by name and therefore
+ * flushes what is pending first.
+ */
+/* unique, name, 2x (family, length, address), 4 ports, proto */
+#define PBR_BATCH_ITEM_MAX                                                     \
+	(4 + ZEBRA_IPSET_NAME_SIZE + 2 * (2 + IPV6_MAX_BYTELEN) + 8 + 1)
+
+static struct bgp_pbr_batch {
+	/* message being built, ZAPI header and item count included */
+	struct stream *s;
+	uint16_t cmd;
+	uint32_t count;
+	bool batching;
+} bgp_pbr_batch;
+
+static enum zclient_send_status bgp_pbr_batch_flush(void)
+{
+	struct bgp_pbr_batch *b = &bgp_pbr_batch;
+	enum zclient_send_status ret;
+	uint32_t count = b->count;
+
+	if (!count)
+		return ZCLIENT_SEND_SUCCESS;
+
+	stream_putl_at(b->s, ZEBRA_HEADER_SIZE, count);
+	stream_putw_at(b->s, 0, stream_get_endp(b->s));
+	b->count = 0;
+
+	if (count > 1 && BGP_DEBUG(zebra, ZEBRA))
+		zlog_debug("Tx %u PBR %s items in one message", count,
+			   zserv_command_string(b->cmd));
+
+	stream_copy(bgp_zclient->obuf, b->s);
+	stream_reset(b->s);
+	ret = zclient_send_message(bgp_zclient);
+	if (ret == ZCLIENT_SEND_FAILURE && count > 1)
+		flog_err(EC_BGP_FLOWSPEC_INSTALLATION,
+			 "Failed to send %u PBR %s items to zebra", count,
+			 zserv_command_string(b->cmd));
+	return ret;
+}
+
+/*
+ * Return the stream the next item of type cmd is to be encoded into; a
+ * change of command or running out of room sends out what is pending.
+ */
+static struct stream *bgp_pbr_batch_item(uint16_t cmd)
+{
+	struct bgp_pbr_batch *b = &bgp_pbr_batch;
+
+	if (!b->s)
+		b->s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+
+	if (b->count &&
+	    (b->cmd != cmd || STREAM_WRITEABLE(b->s) < PBR_BATCH_ITEM_MAX))
+		bgp_pbr_batch_flush();
+
+	if (!b->count) {
+		stream_reset(b->s);
+		zclient_create_header(b->s, cmd, VRF_DEFAULT);
+		stream_putl(b->s, 0); /* item count, filled in on flush */
+		b->cmd = cmd;
+	}
+	return b->s;
+}
+
+static enum zclient_send_status bgp_pbr_batch_item_done(void)
+{
+	bgp_pbr_batch.count++;
+	if (bgp_pbr_batch.batching)
+		return ZCLIENT_SEND_SUCCESS;
+	return bgp_pbr_batch_flush();
+}
+
+static void bgp_pbr_batch_begin(void)
+{
+	bgp_pbr_batch.batching = true;
+}
+
+static enum zclient_send_status bgp_pbr_batch_end(void)
+{
+	bgp_pbr_batch.batching = false;
+	return bgp_pbr_batch_flush();
+}
+
 /*
  * Walk the new Fifo list one by one and invoke bgp_zebra_announce/withdraw
  * to install/withdraw the routes to zebra.
@@ -1885,9 +1975,14 @@ static void bgp_handle_route_announcements_to_zebra(struct event *e)
 	struct bgp_dest *dest = NULL;
 	struct bgp_table *table = NULL;
 	enum zclient_send_status status = ZCLIENT_SEND_SUCCESS;
+	enum zclient_send_status batch_status;
 	bool install;
 	const struct prefix_evpn *evp = NULL;
 
+	/* EVPN remote MAC/IPs and flowspec ipsets go out in bulk messages */
+	bgp_evpn_zebra_batch_begin();
+	bgp_pbr_batch_begin();
+
 	while (count < ZEBRA_ANNOUNCEMENTS_LIMIT) {
 		is_evpn = false;
 
@@ -1913,6 +2008,11 @@ static void bgp_handle_route_announcements_to_zebra(struct event *e)
 				dest);
 		}
 
+		/* Keep ordering with MAC/IPs still sitting in the batch */
+		batch_status = ZCLIENT_SEND_SUCCESS;
+		if (!is_evpn || evp->prefix.route_type != BGP_EVPN_MAC_IP_ROUTE)
+			batch_status = bgp_evpn_zebra_batch_flush();
+
 		if (BGP_DEBUG(zebra, ZEBRA))
 			zlog_debug("BGP %s%s route %pBD(%s) with dest %p and flags 0x%x to zebra",
 				   install ? "announcing" : "withdrawing",
@@ -1967,12 +2067,19 @@ static void bgp_handle_route_announcements_to_zebra(struct event *e)
 		bgp_dest_unlock_node(dest);
 		XFREE(MTYPE_BGP_BP_INSTALL_NODE, inode);
 
+		if (batch_status == ZCLIENT_SEND_BUFFERED)
+			status = ZCLIENT_SEND_BUFFERED;
 		if (status == ZCLIENT_SEND_BUFFERED)
 			break;
 
 		count++;
 	}
 
+	if (bgp_evpn_zebra_batch_end() == ZCLIENT_SEND_BUFFERED)
+		status = ZCLIENT_SEND_BUFFERED;
+	if (bgp_pbr_batch_end() == ZCLIENT_SEND_BUFFERED)
+		status = ZCLIENT_SEND_BUFFERED;
+
 	if (status != ZCLIENT_SEND_BUFFERED &&
 	    (zebra_announce_count(&bm->zebra_announce_early_head) ||
 	     zebra_announce_count(&bm->zebra_announce_head)))
@@ -2359,13 +2466,15 @@ bool bgp_redistribute_metric_set(struct bgp *bgp, struct bgp_redist *red,
 			if (pi->sub_type == BGP_ROUTE_REDISTRIBUTE
 			    && pi->type == type
 			    && pi->instance == red->instance) {
-				struct attr *old_attr;
+				struct attr *old_attr, *attr_new;
 				struct attr new_attr;
 
 				new_attr = *pi->attr;
 				new_attr.med = red->redist_metric;
 				old_attr = pi->attr;
-				pi->attr = bgp_attr_intern(&new_attr);
+				attr_new = bgp_attr_intern(&new_attr);
+				bgp_path_info_attr_account(pi, attr_new);
+				pi->attr = attr_new;
 				bgp_attr_unintern(&old_attr);
 
 				bgp_path_info_set_flag(dest, pi,
@@ -4578,6 +4687,9 @@ void bgp_zebra_init(struct event_loop *master, unsigned short instance)
 
 void bgp_zebra_destroy(void)
 {
+	stream_free(bgp_pbr_batch.s);
+	memset(&bgp_pbr_batch, 0, sizeof(bgp_pbr_batch));
+
 	if (bgp_zclient == NULL)
 		return;
 	zclient_stop(bgp_zclient);
@@ -4614,6 +4726,7 @@ void bgp_send_pbr_rule_action(struct bgp_pbr_action *pbra,
 			zlog_debug("%s: table %d fwmark %d %d", __func__,
 				   pbra->table_id, pbra->fwmark, install);
 	}
+	bgp_pbr_batch_flush();
 	s = bgp_zclient->obuf;
 	stream_reset(s);
 
@@ -4642,20 +4755,12 @@ void bgp_send_pbr_ipset_match(struct bgp_pbr_match *pbrim, bool install)
 		zlog_debug("%s: name %s type %d %d, ID %u", __func__,
 			   pbrim->ipset_name, pbrim->type, install,
 			   pbrim->unique);
-	s = bgp_zclient->obuf;
-	stream_reset(s);
-
-	zclient_create_header(s,
-			      install ? ZEBRA_IPSET_CREATE :
-			      ZEBRA_IPSET_DESTROY,
-			      VRF_DEFAULT);
-
-	stream_putl(s, 1); /* send one pbr action */
+	s = bgp_pbr_batch_item(install ? ZEBRA_IPSET_CREATE
+				       : ZEBRA_IPSET_DESTROY);
 
 	bgp_encode_pbr_ipset_match(s, pbrim);
 
-	stream_putw_at(s, 0, stream_get_endp(s));
-	if ((zclient_send_message(bgp_zclient) != ZCLIENT_SEND_FAILURE) && install)
+	if ((bgp_pbr_batch_item_done() != ZCLIENT_SEND_FAILURE) && install)
 		pbrim->install_in_progress = true;
 }
 
@@ -4670,20 +4775,12 @@ void bgp_send_pbr_ipset_entry_match(struct bgp_pbr_match_entry *pbrime,
 		zlog_debug("%s: name %s %d %d, ID %u", __func__,
 			   pbrime->backpointer->ipset_name, pbrime->unique,
 			   install, pbrime->unique);
-	s = bgp_zclient->obuf;
-	stream_reset(s);
-
-	zclient_create_header(s,
-			      install ? ZEBRA_IPSET_ENTRY_ADD :
-			      ZEBRA_IPSET_ENTRY_DELETE,
-			      VRF_DEFAULT);
-
-	stream_putl(s, 1); /* send one pbr action */
+	s = bgp_pbr_batch_item(install ? ZEBRA_IPSET_ENTRY_ADD
+				       : ZEBRA_IPSET_ENTRY_DELETE);
 
 	bgp_encode_pbr_ipset_entry_match(s, pbrime);
 
-	stream_putw_at(s, 0, stream_get_endp(s));
-	if ((zclient_send_message(bgp_zclient) != ZCLIENT_SEND_FAILURE) && install)
+	if ((bgp_pbr_batch_item_done() != ZCLIENT_SEND_FAILURE) && install)
 		pbrime->install_in_progress = true;
 }
 
@@ -4742,6 +4839,8 @@ void bgp_send_pbr_iptable(struct bgp_pbr_action *pba,
 		zlog_debug("%s: name %s type %d mark %d %d, ID %u", __func__,
 			   pbm->ipset_name, pbm->type, pba->fwmark, install,
 			   pbm->unique2);
+	/* the ipset has to exist in zebra before iptables refers to it */
+	bgp_pbr_batch_flush();
 	s = bgp_zclient->obuf;
 	stream_reset(s);
 
@@ -4757,12 +4856,13 @@ void bgp_send_pbr_iptable(struct bgp_pbr_action *pba,
 		bgp_encode_pbr_interface_list(pba->bgp, s, pbm->family);
 	stream_putw_at(s, 0, stream_get_endp(s));
 	ret = zclient_send_message(bgp_zclient);
-	if (install) {
-		if (ret != ZCLIENT_SEND_FAILURE)
-			pba->refcnt++;
-		else
-			pbm->install_iptable_in_progress = true;
-	}
+	/*
+	 * Every rule of a match group lands here until zebra acknowledges
+	 * the iptable; only the first one needs to go out.  The action
+	 * reference is taken on IPTABLE_INSTALLED.
+	 */
+	if (install && ret != ZCLIENT_SEND_FAILURE)
+		pbm->install_iptable_in_progress = true;
 }
 
 /* inject in table <table_id> a default route to:
@@ -4426,7 +4426,7 @@ int bgp_delete(struct bgp *bgp)
 	FOREACH_AFI_SAFI (afi, safi)
 		event_cancel(&bgp->t_revalidate[afi][safi]);
 
-	event_cancel(&bgp->t_condition_check);
+	bgp_conditional_adv_fini(bgp);
 	event_cancel(&bgp->t_startup);
 	event_cancel(&bgp->t_maxmed_onstartup);
 	event_cancel(&bgp->t_update_delay);
@@ -4625,6 +4625,7 @@ int bgp_delete(struct bgp *bgp)
 		 * still referencing the struct bgp.
 		 */
 		listnode_delete(bm->bgp, bgp);
+		vpn_leak_import_map_invalidate();
 		/* Free interfaces in this instance. */
 		bgp_if_finish(bgp);
 	}
@@ -4658,6 +4659,7 @@ int bgp_delete(struct bgp *bgp)
 				ecommunity_free(
 					&bgp->vpn_policy[afi].rtlist[dir]);
 		}
+		vpn_leak_import_map_invalidate();
 	}
 
 	/* Clean BGP address family parameters */
@@ -610,6 +610,7 @@ struct bgp {
 		uint32_t peer_refreshes_combined;
 		uint32_t adj_count;
 		uint32_t merge_checks_triggered;
+		uint32_t catchup_events;
 
 		uint32_t updgrps_created;
 		uint32_t updgrps_deleted;
@@ -1052,6 +1053,8 @@ struct bgp {
 	uint32_t condition_check_period;
 	uint32_t condition_filter_count;
 	struct event *t_condition_check;
+	/* condition-map watchers, see bgp_conditional_adv.c */
+	struct list *cond_watch;
 
 	/* Advertisement delay (ms) for suppress-fib-pending */
 	uint16_t suppress_fib_adv_delay;
@@ -2038,6 +2041,21 @@ struct peer {
 	uint64_t stat_pfx_loc_rib; /* RFC7854 : Number of routes in Loc-RIB */
 	uint64_t stat_pfx_adj_rib_in; /* RFC7854 : Number of routes in Adj-RIBs-In */
 
+	/*
+	 * Resource accounting, in nanoseconds spent on behalf of this peer and
+	 * in bytes it currently holds.  Best-path time is charged to the peer
+	 * owning the selected (or, on withdrawal, the previously selected)
+	 * path; encode time of an UPDATE is split evenly across the peers of
+	 * the subgroup it was built for.  Shared interned attributes are
+	 * charged to every path that references them.
+	 */
+	uint64_t stat_parse_ns;
+	uint64_t stat_policy_ns;
+	uint64_t stat_bestpath_ns;
+	uint64_t stat_encode_ns;
+	uint64_t stat_attr_bytes;
+	uint64_t stat_adj_rib_in_bytes;
+
 	/* BGP state count */
 	uint32_t established; /* Established */
 	uint32_t dropped;     /* Dropped */
@@ -2105,6 +2123,11 @@ struct peer {
 	/* Duplicate update count */
 	uint32_t pcount_dup[AFI_MAX][SAFI_MAX];
 
+	/* Adj-RIB-In entries denied by inbound filter or route-map, kept
+	 * up to date by bgp_update() for maximum-prefix force.
+	 */
+	uint32_t pcount_filtered[AFI_MAX][SAFI_MAX];
+
 	/* Max prefix count. */
 	uint32_t pmax[AFI_MAX][SAFI_MAX];
 	uint8_t pmax_threshold[AFI_MAX][SAFI_MAX];
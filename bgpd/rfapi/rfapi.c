@@ -977,6 +977,7 @@ void add_vnc_route(struct rfapi_descriptor *rfd, /* cookie, VPN UN addr, peer */
 				bgp_path_info_restore(bn, bpi);
 			else
 				bgp_aggregate_decrement(bgp, p, bpi, afi, safi);
+			bgp_path_info_attr_account(bpi, new_attr);
 			bgp_attr_unintern(&bpi->attr);
 			bpi->attr = new_attr;
 			bpi->uptime = monotime(NULL);
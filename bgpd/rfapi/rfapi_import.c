@@ -499,6 +499,10 @@ static void rfapiBgpInfoFree(struct bgp_path_info *goner)
 		return;
 
 	if (goner->peer) {
+		/* Give back what info_make() charged the peer */
+		bgp_path_info_attr_account(goner, NULL);
+		goner->peer->stat_adj_rib_in_bytes -= sizeof(*goner);
+
 		vnc_zlog_debug_verbose("%s: calling peer_unlock(%p), #%d",
 				       __func__, goner->peer,
 				       goner->peer->lock);
@@ -509,7 +513,7 @@ static void rfapiBgpInfoFree(struct bgp_path_info *goner)
 
 	if (goner->extra)
 		bgp_path_info_extra_free(&goner->extra);
-	XFREE(MTYPE_BGP_ROUTE, goner);
+	bgp_path_info_slab_free(goner);
 }
 
 struct rfapi_import_table *rfapiMacImportTableGetNoAlloc(struct bgp *bgp,
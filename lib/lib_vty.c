@@ -21,6 +21,7 @@
 
 #include "log.h"
 #include "memory.h"
+#include "slab.h"
 #include "seqlock.h"
 #include "module.h"
 #include "defaults.h"
@@ -164,6 +165,36 @@ static int qmem_walker_json(void *arg, struct memgroup *mg, struct memtype *mt)
 }
 
 
+static int slab_walker(void *arg, const struct slab_pool *pool)
+{
+	struct vty *vty = arg;
+	char buf[MTYPE_MEMSTR_LEN];
+
+	vty_out(vty, "%-30s: %8zu %6zu %9s %8zu %12" PRIu64 " %12" PRIu64 "\n", pool->name,
+		pool->n_inuse, pool->objsize,
+		mtype_memstr(buf, sizeof(buf),
+			     (size_t)pool->n_chunks * SLAB_CHUNK_OBJS * pool->objsize),
+		pool->n_max, pool->n_allocs, pool->n_recycled);
+	return 0;
+}
+
+static int slab_walker_json(void *arg, const struct slab_pool *pool)
+{
+	struct json_object *json = arg;
+	struct json_object *jpool = json_object_new_object();
+
+	json_object_string_add(jpool, "name", pool->name);
+	json_object_int_add(jpool, "currentAllocations", pool->n_inuse);
+	json_object_int_add(jpool, "size", pool->objsize);
+	json_object_int_add(jpool, "chunks", pool->n_chunks);
+	json_object_int_add(jpool, "capacity", (int64_t)pool->n_chunks * SLAB_CHUNK_OBJS);
+	json_object_int_add(jpool, "maxAllocations", pool->n_max);
+	json_object_int_add(jpool, "totalAllocations", pool->n_allocs);
+	json_object_int_add(jpool, "recycledAllocations", pool->n_recycled);
+	json_object_array_add(json, jpool);
+	return 0;
+}
+
 DEFUN_NOSH (show_memory,
 	    show_memory_cmd,
 	    "show memory [json]",
@@ -182,6 +213,10 @@ DEFUN_NOSH (show_memory,
 		jarg.current_group = NULL;
 		qmem_walk(qmem_walker_json, &jarg);
 
+		jarg.current_group = json_object_new_array();
+		slab_pool_walk(slab_walker_json, jarg.current_group);
+		json_object_object_add(json, "slabAllocators", jarg.current_group);
+
 		vty_json(vty, json);
 	} else {
 #ifdef HAVE_MALLINFO
@@ -189,6 +224,11 @@ DEFUN_NOSH (show_memory,
 #endif /* HAVE_MALLINFO */
 
 		qmem_walk(qmem_walker, vty);
+
+		vty_out(vty, "--- slab allocators ---\n");
+		vty_out(vty, "%-30s: %8s %6s %9s %8s %12s %12s\n", "Pool", "Current#", "Size",
+			"Reserved", "Max#", "Allocs", "Recycled");
+		slab_pool_walk(slab_walker, vty);
 	}
 
 	return CMD_SUCCESS;
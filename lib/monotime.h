@@ -73,6 +73,15 @@ static inline time_t monotime(struct timeval *tvo)
 	return ts.tv_sec;
 }
 
+/* nanoseconds on the monotonic clock, for cheap fine-grained accounting */
+static inline uint64_t monotime_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 #define ONE_DAY_SECOND (60 * 60 * 24)
 #define ONE_WEEK_SECOND (ONE_DAY_SECOND * 7)
 #define ONE_YEAR_SECOND (ONE_DAY_SECOND * 365)
@@ -97,6 +97,56 @@ size_t ringbuf_peek(struct ringbuf *buf, size_t offset, void *data, size_t size)
 	return copysize;
 }
 
+void *ringbuf_peek_ptr(struct ringbuf *buf, size_t offset, size_t size)
+{
+	size_t remain = ringbuf_remain(buf);
+	size_t cstart;
+
+	if (offset >= remain || size > remain - offset)
+		return NULL;
+	cstart = (buf->start + offset) % buf->size;
+	if (size > buf->size - cstart)
+		return NULL;
+	return buf->data + cstart;
+}
+
+size_t ringbuf_skip(struct ringbuf *buf, size_t size)
+{
+	size_t remain = ringbuf_remain(buf);
+	size_t skipsize = MIN(remain, size);
+
+	buf->start = (buf->start + skipsize) % buf->size;
+	buf->empty = (buf->start == buf->end) && (buf->empty || skipsize);
+	return skipsize;
+}
+
+int ringbuf_space_iov(struct ringbuf *buf, struct iovec *iov)
+{
+	size_t space = ringbuf_space(buf);
+	size_t first;
+
+	if (!space)
+		return 0;
+	first = MIN(space, buf->size - buf->end);
+	iov[0].iov_base = buf->data + buf->end;
+	iov[0].iov_len = first;
+	if (first == space)
+		return 1;
+	iov[1].iov_base = buf->data;
+	iov[1].iov_len = space - first;
+	return 2;
+}
+
+size_t ringbuf_commit(struct ringbuf *buf, size_t size)
+{
+	size_t space = ringbuf_space(buf);
+	size_t commitsize = MIN(space, size);
+
+	buf->end = (buf->end + commitsize) % buf->size;
+	buf->empty = (buf->start == buf->end) && (buf->empty && !commitsize);
+	return commitsize;
+}
+
 size_t ringbuf_copy(struct ringbuf *to, struct ringbuf *from, size_t size)
 {
 	size_t tocopy = MIN(ringbuf_space(to), size);
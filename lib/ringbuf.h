@@ -89,6 +89,47 @@ size_t ringbuf_get(struct ringbuf *buf, void *data, size_t size);
 size_t ringbuf_peek(struct ringbuf *buf, size_t offset, void *data,
 		    size_t size);
 
+/*
+ * Get a pointer to data in the ring buffer, without copying it. Only works if
+ * the data doesn't wrap around the end of the buffer.
+ *
+ * @param offset	where the data starts, in bytes offset from the start
+ *			of the data
+ * @param size		how much data there must be
+ * @return		pointer to the data; NULL if there isn't that much data
+ *			or it isn't contiguous
+ */
+void *ringbuf_peek_ptr(struct ringbuf *buf, size_t offset, size_t size);
+
+/*
+ * Discard data from the start of the ring buffer.
+ *
+ * @param size	how much data to discard
+ * @return number of bytes discarded; will be less than size if there was not
+ * enough data
+ */
+size_t ringbuf_skip(struct ringbuf *buf, size_t size);
+
+/*
+ * Describe the space left in the ring buffer, so that it can be written to
+ * directly, e.g. by readv(). At most two pieces, the second one wrapping
+ * around to the start of the buffer.
+ *
+ * @param iov	where to put the description, room for two entries
+ * @return number of entries filled in; 0 if the buffer is full
+ */
+int ringbuf_space_iov(struct ringbuf *buf, struct iovec *iov);
+
+/*
+ * Add data written directly into the space described by ringbuf_space_iov()
+ * to the ring buffer.
+ *
+ * @param size	how much data was written
+ * @return number of bytes added; will be less than size if there was not
+ * enough space
+ */
+size_t ringbuf_commit(struct ringbuf *buf, size_t size);
+
 /*
  * Copy data from one ringbuf to another.
  *
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Fixed-size object pools with dense integer IDs
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <assert.h>
+
+#include "slab.h"
+
+DEFINE_MTYPE_STATIC(LIB, SLAB_DIR, "Slab chunk directory");
+
+DECLARE_DLIST(slab_pools, struct slab_pool, itm);
+
+static struct slab_pools_head slab_pools[1] = { INIT_DLIST(slab_pools[0]) };
+
+/* Keep objects 8-byte aligned and large enough to hold the free list link */
+#define SLAB_ALIGN sizeof(uint64_t)
+
+static inline uint32_t *slab_free_link(struct slab_pool *pool, uint32_t id)
+{
+	return slab_get(pool, id);
+}
+
+static void slab_grow(struct slab_pool *pool)
+{
+	if (!pool->n_chunks_alloc) {
+		pool->objsize = (pool->objsize + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+		slab_pools_add_tail(slab_pools, pool);
+	}
+
+	if (pool->n_chunks == pool->n_chunks_alloc) {
+		pool->n_chunks_alloc = pool->n_chunks_alloc ? pool->n_chunks_alloc * 2 : 16;
+		pool->chunks = XREALLOC(MTYPE_SLAB_DIR, pool->chunks,
+					pool->n_chunks_alloc * sizeof(pool->chunks[0]));
+	}
+
+	pool->chunks[pool->n_chunks++] = XMALLOC(pool->mtype, SLAB_CHUNK_OBJS * pool->objsize);
+}
+
+void *slab_alloc(struct slab_pool *pool, uint32_t *id)
+{
+	uint32_t new_id;
+	void *obj;
+
+	if (pool->free_head != SLAB_ID_NONE) {
+		new_id = pool->free_head;
+		pool->free_head = *slab_free_link(pool, new_id);
+		pool->n_recycled++;
+	} else {
+		if (pool->next_id == 0)
+			pool->next_id = 1;
+		if (((pool->next_id - 1) >> SLAB_CHUNK_BITS) >= pool->n_chunks)
+			slab_grow(pool);
+		new_id = pool->next_id++;
+	}
+
+	obj = slab_get(pool, new_id);
+	memset(obj, 0, pool->objsize);
+
+	pool->n_allocs++;
+	pool->n_inuse++;
+	if (pool->n_inuse > pool->n_max)
+		pool->n_max = pool->n_inuse;
+
+	*id = new_id;
+	return obj;
+}
+
+void slab_free(struct slab_pool *pool, void *obj, uint32_t id)
+{
+	assert(obj && obj == slab_get(pool, id));
+	assert(pool->n_inuse > 0);
+
+	*slab_free_link(pool, id) = pool->free_head;
+	pool->free_head = id;
+	pool->n_inuse--;
+}
+
+void slab_pool_fini(struct slab_pool *pool)
+{
+	uint32_t i;
+
+	if (!pool->n_chunks_alloc)
+		return;
+
+	for (i = 0; i < pool->n_chunks; i++)
+		XFREE(pool->mtype, pool->chunks[i]);
+	XFREE(MTYPE_SLAB_DIR, pool->chunks);
+
+	slab_pools_del(slab_pools, pool);
+
+	pool->n_chunks = pool->n_chunks_alloc = 0;
+	pool->next_id = SLAB_ID_NONE;
+	pool->free_head = SLAB_ID_NONE;
+	pool->n_inuse = 0;
+}
+
+void slab_pool_walk(int (*func)(void *arg, const struct slab_pool *pool), void *arg)
+{
+	struct slab_pool *pool;
+
+	frr_each (slab_pools, slab_pools, pool)
+		if (func(arg, pool))
+			break;
+}
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Fixed-size object pools with dense integer IDs
+ *
+ * Objects are carved out of large chunks instead of being malloc'ed one by
+ * one, and every object gets a small integer ID that stays valid for its
+ * lifetime.  IDs are handed out densely (freed IDs are reused before the
+ * pool grows), so they can be used to index plain arrays holding
+ * per-object side data.
+ *
+ * Pools are not thread-safe; they are meant for objects that are only
+ * created and destroyed from one pthread.
+ */
+
+#ifndef _FRR_SLAB_H
+#define _FRR_SLAB_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "memory.h"
+#include "typesafe.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ID 0 is never handed out, zeroed objects therefore carry "no ID" */
+#define SLAB_ID_NONE 0
+
+#define SLAB_CHUNK_BITS 10
+#define SLAB_CHUNK_OBJS (1U << SLAB_CHUNK_BITS)
+
+PREDECL_DLIST(slab_pools);
+
+struct slab_pool {
+	struct slab_pools_item itm;
+
+	const char *name;
+	struct memtype *mtype;
+	size_t objsize;
+
+	/* Chunk directory; object <id> lives in chunk (id - 1) >> BITS */
+	uint8_t **chunks;
+	uint32_t n_chunks;
+	uint32_t n_chunks_alloc;
+
+	/* Next never-used ID */
+	uint32_t next_id;
+	/* Freed IDs, LIFO, threaded through the free slots themselves */
+	uint32_t free_head;
+
+	/* Statistics */
+	size_t n_inuse;
+	size_t n_max;
+	uint64_t n_allocs;
+	uint64_t n_recycled;
+};
+
+/*
+ * Pools are set up statically so they can be used before (and without)
+ * any daemon init code running, e.g. from unit tests:
+ *
+ *   struct slab_pool foo_pool = SLAB_POOL_INIT("Foo", MTYPE_FOO, struct foo);
+ *
+ * mtype is charged once per chunk.
+ */
+#define SLAB_POOL_INIT(pname, mt, type)                                        \
+	{                                                                      \
+		.name = (pname), .mtype = (mt), .objsize = sizeof(type),       \
+	}
+
+/* Returns a zeroed object and stores its ID in *id. */
+extern void *slab_alloc(struct slab_pool *pool, uint32_t *id);
+extern void slab_free(struct slab_pool *pool, void *obj, uint32_t id);
+
+/* Number of IDs that may currently be in use, for sizing side arrays. */
+static inline uint32_t slab_id_max(const struct slab_pool *pool)
+{
+	return pool->next_id;
+}
+
+static inline void *slab_get(const struct slab_pool *pool, uint32_t id)
+{
+	uint32_t idx = id - 1;
+
+	if (id == SLAB_ID_NONE || id >= pool->next_id)
+		return NULL;
+
+	return pool->chunks[idx >> SLAB_CHUNK_BITS] +
+	       (size_t)(idx & (SLAB_CHUNK_OBJS - 1)) * pool->objsize;
+}
+
+/* Release all memory held by the pool, remaining objects become invalid. */
+extern void slab_pool_fini(struct slab_pool *pool);
+
+/* Iterate over all pools that have allocated memory, for "show memory". */
+extern void slab_pool_walk(int (*func)(void *arg, const struct slab_pool *pool),
+			   void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_SLAB_H */
@@ -114,6 +114,15 @@ struct stream *stream_new_expandable(size_t size)
 	return s;
 }
 
+void stream_view_init(struct stream *s, const void *data, size_t len)
+{
+	s->next = NULL;
+	s->getp = 0;
+	s->endp = s->size = len;
+	s->allow_expansion = false;
+	s->data = (uint8_t *)data;
+}
+
 /* Free it now. */
 void stream_free(struct stream *s)
 {
@@ -139,6 +139,10 @@ extern void stream_free(struct stream *s);
 extern struct stream *stream_copy(struct stream *dest,
 				  const struct stream *src);
 extern struct stream *stream_dup(const struct stream *s);
+/* Set up 's' to read 'len' bytes at 'data' in place, without copying them;
+ * 's' doesn't own the data and must not be freed or written to.
+ */
+extern void stream_view_init(struct stream *s, const void *data, size_t len);
 
 extern size_t stream_resize_inplace(struct stream **sptr, size_t newsize);
 
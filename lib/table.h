@@ -125,14 +125,22 @@ struct route_table {
                                                                                \
 	/* Tree link. */                                                       \
 	struct route_table *table_rdonly(table);                               \
-	struct route_node *table_rdonly(parent);                               \
-	struct route_node *table_rdonly(link[2]);                              \
+	union {                                                                \
+		/* prefix tree, not used by unique mode tables */              \
+		struct {                                                       \
+			struct route_node *table_rdonly(parent);               \
+			struct route_node *table_rdonly(link[2]);              \
+		};                                                             \
+		/* unique mode tables only */                                  \
+		struct rn_tree_item rbitem;                                    \
+	};                                                                     \
                                                                                \
 	/* Lock of this radix */                                               \
 	unsigned int table_rdonly(lock);                                       \
+	/* Free for use by the table delegate, e.g. to keep a slab ID */       \
+	uint32_t delegate_id;                                                  \
                                                                                \
 	struct rn_hash_node_item nodehash;                                     \
-	struct rn_tree_item rbitem;                                            \
                                                                                \
 	/* Each node of route. */                                              \
 	void *info;                                                            \
@@ -157,6 +157,17 @@ void vty_resume_response(struct vty *vty, int ret)
 		zlog_err("mgmtd: unexpected resume while reading config file");
 }
 
+bool vty_output_backlog(struct vty *vty)
+{
+	if (vty->type != VTY_SHELL_SERV || vty->status == VTY_CLOSE)
+		return false;
+
+	if (!vty->t_write && !buffer_empty(vty->obuf) && vtysh_flush(vty) < 0)
+		return false;
+
+	return !buffer_empty(vty->obuf);
+}
+
 void vty_frame(struct vty *vty, const char *format, ...)
 {
 	va_list args;
@@ -2442,6 +2453,12 @@ void vty_close(struct vty *vty)
 	if (vty_close_mgmt_cb)
 		vty_close_mgmt_cb(vty);
 
+	if (vty->suspend_cancel) {
+		vty->suspend_cancel(vty, vty->suspend_arg);
+		vty->suspend_cancel = NULL;
+		vty->suspend_arg = NULL;
+	}
+
 	/* Cancel threads.*/
 	event_cancel(&vty->t_read);
 	event_cancel(&vty->t_write);
@@ -238,6 +238,13 @@ struct vty {
 	 */
 	size_t vty_buf_threshold;
 	size_t vty_buf_size_accum;
+
+	/* A command that returned CMD_SUSPEND and keeps producing output
+	 * from the event loop registers here, so its state can be torn
+	 * down if the session is closed before vty_resume_response().
+	 */
+	void (*suspend_cancel)(struct vty *vty, void *arg);
+	void *suspend_arg;
 };
 
 static inline void vty_push_context(struct vty *vty, int node, uint64_t id)
@@ -438,6 +445,13 @@ static inline bool vty_is_closed(const struct vty *vty)
  */
 extern void vty_resume_response(struct vty *vty, int ret);
 
+/*
+ * For suspended commands producing output in the background: push out
+ * what has been buffered so far, returns true if output is still waiting
+ * for the client to read it.
+ */
+extern bool vty_output_backlog(struct vty *vty);
+
 /* --------------------------------------------------- */
 /* Callbacks for Mgmtd front-end CLI vty modifications */
 /* --------------------------------------------------- */
@@ -0,0 +1,375 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Shared memory ring transport for ZAPI
+ */
+
+#include <zebra.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "log.h"
+#include "memory.h"
+#include "network.h"
+#include "zapi_shm.h"
+
+#ifdef HAVE_ZAPI_SHM
+#include <sys/eventfd.h>
+#endif
+
+DEFINE_MTYPE_STATIC(LIB, ZAPI_SHM, "ZAPI shared memory ring");
+
+/* Large enough for the descriptors of one ring */
+union zapi_shm_cmsgbuf {
+	char buf[CMSG_SPACE(sizeof(int) * ZAPI_SHM_FD_MAX)];
+	struct cmsghdr align;
+};
+
+static struct zapi_shm *zapi_shm_new(void)
+{
+	struct zapi_shm *shm = XCALLOC(MTYPE_ZAPI_SHM, sizeof(*shm));
+	int i;
+
+	for (i = 0; i < ZAPI_SHM_FD_MAX; i++)
+		shm->fds[i] = -1;
+	return shm;
+}
+
+struct zapi_shm *zapi_shm_create(size_t size)
+{
+#ifdef HAVE_ZAPI_SHM
+	struct zapi_shm *shm;
+	struct zapi_shm_ring *ring;
+	size_t map_size = sizeof(*ring) + size;
+	int saved_errno;
+
+	if (size < ZAPI_SHM_SIZE_MIN || size > ZAPI_SHM_SIZE_MAX ||
+	    (size & (size - 1))) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	shm = zapi_shm_new();
+	shm->fds[ZAPI_SHM_FD_MEM] =
+		memfd_create("zapi_shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (shm->fds[ZAPI_SHM_FD_MEM] < 0)
+		goto fail;
+
+	/* The consumer insists on this, so it can't be made to SIGBUS */
+	if (ftruncate(shm->fds[ZAPI_SHM_FD_MEM], map_size) < 0 ||
+	    fcntl(shm->fds[ZAPI_SHM_FD_MEM], F_ADD_SEALS,
+		  F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0)
+		goto fail;
+
+	ring = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		    shm->fds[ZAPI_SHM_FD_MEM], 0);
+	if (ring == MAP_FAILED)
+		goto fail;
+	shm->ring = ring;
+	shm->map_size = map_size;
+	shm->size = size;
+
+	shm->fds[ZAPI_SHM_FD_DATA] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	shm->fds[ZAPI_SHM_FD_SPACE] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (shm->fds[ZAPI_SHM_FD_DATA] < 0 || shm->fds[ZAPI_SHM_FD_SPACE] < 0)
+		goto fail;
+
+	/* Fresh from the memfd, everything else is zero */
+	ring->magic = ZAPI_SHM_MAGIC;
+	ring->version = ZAPI_SHM_VERSION;
+	ring->size = size;
+
+	return shm;
+
+fail:
+	saved_errno = errno;
+	zapi_shm_free(&shm);
+	errno = saved_errno;
+#else
+	errno = ENOSYS;
+#endif
+	return NULL;
+}
+
+#ifdef HAVE_ZAPI_SHM
+/*
+ * The client hands over the descriptors, so check that they really are
+ * eventfds: anything else (a pipe, /dev/zero, ...) could block or never
+ * run dry when read.
+ */
+static bool zapi_shm_is_eventfd(int fd)
+{
+	char path[64], target[64];
+	struct stat st;
+	ssize_t len;
+
+	/* Anonymous inodes have no file type */
+	if (fstat(fd, &st) < 0 || (st.st_mode & S_IFMT) != 0)
+		return false;
+
+	snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+	len = readlink(path, target, sizeof(target) - 1);
+	if (len < 0)
+		return false;
+	target[len] = '\0';
+
+	return strmatch(target, "anon_inode:[eventfd]");
+}
+#endif
+
+struct zapi_shm *zapi_shm_attach(int fds[ZAPI_SHM_FD_MAX])
+{
+	struct zapi_shm *shm = zapi_shm_new();
+#ifdef HAVE_ZAPI_SHM
+	struct zapi_shm_ring *ring;
+	struct stat st;
+	uint64_t size;
+	int seals;
+#endif
+
+	memcpy(shm->fds, fds, sizeof(shm->fds));
+
+#ifdef HAVE_ZAPI_SHM
+	if (!zapi_shm_is_eventfd(shm->fds[ZAPI_SHM_FD_DATA]) ||
+	    !zapi_shm_is_eventfd(shm->fds[ZAPI_SHM_FD_SPACE]))
+		goto refuse;
+
+	/* Reading an eventfd must never block */
+	set_nonblocking(shm->fds[ZAPI_SHM_FD_DATA]);
+	set_nonblocking(shm->fds[ZAPI_SHM_FD_SPACE]);
+
+	/* Nobody must be able to shrink the memory under us */
+	if (fstat(shm->fds[ZAPI_SHM_FD_MEM], &st) < 0 || !S_ISREG(st.st_mode))
+		goto refuse;
+	seals = fcntl(shm->fds[ZAPI_SHM_FD_MEM], F_GET_SEALS);
+	if (seals < 0 || !(seals & F_SEAL_SHRINK))
+		goto refuse;
+	if (st.st_size < (off_t)(sizeof(*ring) + ZAPI_SHM_SIZE_MIN) ||
+	    st.st_size > (off_t)(sizeof(*ring) + ZAPI_SHM_SIZE_MAX))
+		goto refuse;
+
+	ring = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		    shm->fds[ZAPI_SHM_FD_MEM], 0);
+	if (ring == MAP_FAILED)
+		goto refuse;
+	shm->ring = ring;
+	shm->map_size = st.st_size;
+
+	size = ring->size;
+	if (ring->magic != ZAPI_SHM_MAGIC || ring->version != ZAPI_SHM_VERSION ||
+	    size < ZAPI_SHM_SIZE_MIN || (size & (size - 1)) ||
+	    size > shm->map_size - sizeof(*ring))
+		goto refuse;
+
+	shm->size = size;
+	shm->pos = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	return shm;
+
+refuse:
+#endif
+	zapi_shm_free(&shm);
+	return NULL;
+}
+
+void zapi_shm_free(struct zapi_shm **shmp)
+{
+	struct zapi_shm *shm = *shmp;
+	int i;
+
+	if (!shm)
+		return;
+
+	if (shm->ring)
+		munmap(shm->ring, shm->map_size);
+	for (i = 0; i < ZAPI_SHM_FD_MAX; i++)
+		if (shm->fds[i] >= 0)
+			close(shm->fds[i]);
+
+	XFREE(MTYPE_ZAPI_SHM, *shmp);
+}
+
+static void zapi_shm_signal(int fd)
+{
+	uint64_t one = 1;
+
+	/* EAGAIN means the counter would overflow, so it is set anyway */
+	if (write(fd, &one, sizeof(one)) <= 0 && errno != EAGAIN)
+		zlog_warn("%s: eventfd %d: %s", __func__, fd,
+			  safe_strerror(errno));
+}
+
+void zapi_shm_event_clear(int fd)
+{
+	uint64_t count;
+
+	/* One read resets an eventfd's counter */
+	if (read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+		zlog_warn("%s: eventfd %d: %s", __func__, fd,
+			  safe_strerror(errno));
+}
+
+size_t zapi_shm_write(struct zapi_shm *shm, const void *data, size_t len)
+{
+	struct zapi_shm_ring *ring = shm->ring;
+	uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	size_t off = shm->pos & (shm->size - 1);
+	size_t space, n, first;
+
+	space = shm->pos - tail <= shm->size ? shm->size - (shm->pos - tail) : 0;
+	n = MIN(len, space);
+	if (!n)
+		return 0;
+
+	first = MIN(n, shm->size - off);
+	memcpy(ring->data + off, data, first);
+	memcpy(ring->data, (const uint8_t *)data + first, n - first);
+	shm->pos += n;
+
+	/* Pairs with zapi_shm_data_wait() */
+	atomic_store_explicit(&ring->head, shm->pos, memory_order_seq_cst);
+	if (atomic_load_explicit(&ring->data_waiting, memory_order_seq_cst) &&
+	    atomic_exchange_explicit(&ring->data_waiting, 0,
+				     memory_order_seq_cst))
+		zapi_shm_signal(shm->fds[ZAPI_SHM_FD_DATA]);
+
+	return n;
+}
+
+ssize_t zapi_shm_read(struct zapi_shm *shm, const struct iovec *iov,
+		      int iovcnt)
+{
+	struct zapi_shm_ring *ring = shm->ring;
+	uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	uint64_t avail = head - shm->pos;
+	size_t total = 0, off, n, first;
+	int i;
+
+	if (avail > shm->size)
+		return -1;
+
+	for (i = 0; i < iovcnt && avail; i++) {
+		n = MIN(avail, iov[i].iov_len);
+		off = shm->pos & (shm->size - 1);
+		first = MIN(n, shm->size - off);
+		memcpy(iov[i].iov_base, ring->data + off, first);
+		memcpy((uint8_t *)iov[i].iov_base + first, ring->data,
+		       n - first);
+
+		shm->pos += n;
+		avail -= n;
+		total += n;
+	}
+
+	if (!total)
+		return 0;
+
+	/* Pairs with zapi_shm_space_wait() */
+	atomic_store_explicit(&ring->tail, shm->pos, memory_order_seq_cst);
+	if (atomic_load_explicit(&ring->space_waiting, memory_order_seq_cst) &&
+	    atomic_exchange_explicit(&ring->space_waiting, 0,
+				     memory_order_seq_cst))
+		zapi_shm_signal(shm->fds[ZAPI_SHM_FD_SPACE]);
+
+	return total;
+}
+
+/*
+ * Flag first, then check again: either the other side sees the flag after
+ * moving its position, or we see the position it moved to.
+ */
+bool zapi_shm_data_wait(struct zapi_shm *shm)
+{
+	struct zapi_shm_ring *ring = shm->ring;
+
+	atomic_store_explicit(&ring->data_waiting, 1, memory_order_seq_cst);
+	if (atomic_load_explicit(&ring->head, memory_order_seq_cst) !=
+	    shm->pos) {
+		atomic_store_explicit(&ring->data_waiting, 0,
+				      memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
+
+bool zapi_shm_space_wait(struct zapi_shm *shm)
+{
+	struct zapi_shm_ring *ring = shm->ring;
+
+	atomic_store_explicit(&ring->space_waiting, 1, memory_order_seq_cst);
+	if (shm->pos - atomic_load_explicit(&ring->tail, memory_order_seq_cst) <
+	    shm->size) {
+		atomic_store_explicit(&ring->space_waiting, 0,
+				      memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
+
+ssize_t zapi_shm_sendmsg(int sock, const void *data, size_t len,
+			 const int fds[ZAPI_SHM_FD_MAX])
+{
+	union zapi_shm_cmsgbuf cmsgbuf = {};
+	struct iovec iov = { .iov_base = (void *)data, .iov_len = len };
+	struct msghdr mh = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+		.msg_control = cmsgbuf.buf,
+		.msg_controllen = sizeof(cmsgbuf.buf),
+	};
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&mh);
+
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int) * ZAPI_SHM_FD_MAX);
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * ZAPI_SHM_FD_MAX);
+
+	return sendmsg(sock, &mh, 0);
+}
+
+ssize_t zapi_shm_recvmsg(int sock, const struct iovec *iov, int iovcnt,
+			 int fds[ZAPI_SHM_FD_MAX], int *nfds)
+{
+	union zapi_shm_cmsgbuf cmsgbuf;
+	struct msghdr mh = {
+		.msg_iov = (struct iovec *)iov,
+		.msg_iovlen = iovcnt,
+		.msg_control = cmsgbuf.buf,
+		.msg_controllen = sizeof(cmsgbuf.buf),
+	};
+	struct cmsghdr *cmsg;
+	int flags = 0;
+	size_t i, n;
+	ssize_t nb;
+	int fd;
+
+#ifdef MSG_CMSG_CLOEXEC
+	flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+	*nfds = 0;
+	nb = recvmsg(sock, &mh, flags);
+	if (nb < 0)
+		return nb;
+
+	for (cmsg = CMSG_FIRSTHDR(&mh); cmsg; cmsg = CMSG_NXTHDR(&mh, cmsg)) {
+		if (cmsg->cmsg_level != SOL_SOCKET ||
+		    cmsg->cmsg_type != SCM_RIGHTS)
+			continue;
+
+		n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		for (i = 0; i < n; i++) {
+			memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int),
+			       sizeof(int));
+			if (*nfds < ZAPI_SHM_FD_MAX)
+				fds[(*nfds)++] = fd;
+			else
+				close(fd);
+		}
+	}
+
+	return nb;
+}
@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Shared memory ring transport for ZAPI
+ */
+
+#ifndef _FRR_ZAPI_SHM_H
+#define _FRR_ZAPI_SHM_H
+
+#include <stdalign.h>
+#include <sys/uio.h>
+
+#include "frratomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A single producer, single consumer byte ring in a sealed memfd, shared
+ * between a daemon (producer) and zebra (consumer), carrying the same stream
+ * of ZAPI messages that would otherwise go over the zserv socket.  Each side
+ * has an eventfd the other side signals, only when asked to: the consumer
+ * sets data_waiting before it goes to sleep, the producer sets space_waiting
+ * when the ring is full.
+ *
+ * The memory is shared with another process that is not to be trusted with
+ * zebra's state: the consumer copies data out before looking at it, keeps
+ * its own idea of the ring size and checks every position it is given.
+ */
+#if defined(HAVE_MEMFD_CREATE) && defined(HAVE_EVENTFD)
+#define HAVE_ZAPI_SHM 1
+#endif
+
+#define ZAPI_SHM_MAGIC	 0x5a534852 /* "ZSHR" */
+#define ZAPI_SHM_VERSION 1
+
+/* Ring sizes, powers of two */
+#define ZAPI_SHM_SIZE	  (4 * 1024 * 1024)
+#define ZAPI_SHM_SIZE_MIN (64 * 1024)
+#define ZAPI_SHM_SIZE_MAX (64 * 1024 * 1024)
+
+#define ZAPI_SHM_CACHELINE 64
+
+/* File descriptors passed from the daemon to zebra, in this order */
+enum zapi_shm_fd {
+	ZAPI_SHM_FD_MEM,
+	ZAPI_SHM_FD_DATA,
+	ZAPI_SHM_FD_SPACE,
+	ZAPI_SHM_FD_MAX,
+};
+
+/* Layout of the shared memory */
+struct zapi_shm_ring {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t size;
+
+	/* Written by the producer */
+	alignas(ZAPI_SHM_CACHELINE) _Atomic uint64_t head;
+	_Atomic uint32_t data_waiting;
+
+	/* Written by the consumer */
+	alignas(ZAPI_SHM_CACHELINE) _Atomic uint64_t tail;
+	_Atomic uint32_t space_waiting;
+
+	alignas(ZAPI_SHM_CACHELINE) uint8_t data[];
+};
+
+/* One side's handle on the ring */
+struct zapi_shm {
+	struct zapi_shm_ring *ring;
+	size_t map_size;
+
+	/* Local copy of the ring size, never re-read from the ring */
+	uint64_t size;
+
+	/* Head for the producer, tail for the consumer */
+	uint64_t pos;
+
+	int fds[ZAPI_SHM_FD_MAX];
+};
+
+/*
+ * Create a ring of the given size, for the producer.
+ *
+ * @param size	ring size in bytes, a power of two
+ * @return the ring, or NULL with errno set; always NULL where memfds and
+ * eventfds are not available
+ */
+extern struct zapi_shm *zapi_shm_create(size_t size);
+
+/*
+ * Map the ring created by the other side, for the consumer.  Takes ownership
+ * of the file descriptors, which are closed if the ring is refused.
+ *
+ * @param fds	the ZAPI_SHM_FD_MAX descriptors received
+ * @return the ring, or NULL if it is not usable
+ */
+extern struct zapi_shm *zapi_shm_attach(int fds[ZAPI_SHM_FD_MAX]);
+
+/*
+ * Unmap the ring and close its descriptors.
+ */
+extern void zapi_shm_free(struct zapi_shm **shm);
+
+/*
+ * Put data into the ring, and wake up the consumer if it asked for it.
+ *
+ * @return number of bytes written; less than len if the ring is full
+ */
+extern size_t zapi_shm_write(struct zapi_shm *shm, const void *data,
+			     size_t len);
+
+/*
+ * Get as much data as fits into iov out of the ring, and wake up the
+ * producer if it is waiting for space.
+ *
+ * @return number of bytes read, or -1 if the producer corrupted the ring
+ */
+extern ssize_t zapi_shm_read(struct zapi_shm *shm, const struct iovec *iov,
+			     int iovcnt);
+
+/*
+ * Ask to be woken up through ZAPI_SHM_FD_DATA when data arrives.
+ *
+ * @return false if data arrived in the meantime: don't wait, read
+ */
+extern bool zapi_shm_data_wait(struct zapi_shm *shm);
+
+/*
+ * Ask to be woken up through ZAPI_SHM_FD_SPACE when the ring has room.
+ *
+ * @return false if there is room already: don't wait, write
+ */
+extern bool zapi_shm_space_wait(struct zapi_shm *shm);
+
+/*
+ * Reset an eventfd after it woke us up.
+ */
+extern void zapi_shm_event_clear(int fd);
+
+/*
+ * Send data over a stream socket, along with the ring's descriptors.
+ *
+ * @return number of bytes sent, or -1 with errno set
+ */
+extern ssize_t zapi_shm_sendmsg(int sock, const void *data, size_t len,
+				const int fds[ZAPI_SHM_FD_MAX]);
+
+/*
+ * readv() on a stream socket that also picks up descriptors passed along
+ * with the data.  At most ZAPI_SHM_FD_MAX are returned, any more are closed.
+ *
+ * @param fds	where to put the descriptors
+ * @param nfds	set to the number of descriptors received
+ * @return as readv()
+ */
+extern ssize_t zapi_shm_recvmsg(int sock, const struct iovec *iov, int iovcnt,
+				int fds[ZAPI_SHM_FD_MAX], int *nfds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_ZAPI_SHM_H */
@@ -28,6 +28,7 @@
 #include "srte.h"
 #include "printfrr.h"
 #include "srv6.h"
+#include "zapi_shm.h"
 
 DEFINE_MTYPE_STATIC(LIB, ZCLIENT, "Zclient");
 DEFINE_MTYPE_STATIC(LIB, REDIST_INST, "Redistribution instance IDs");
@@ -84,6 +85,9 @@ struct zclient *zclient_new(struct event_loop *master,
 
 	zclient->synchronous = opt->synchronous;
 	zclient->auxiliary = opt->auxiliary;
+	zclient->zapi_shm = opt->zapi_shm && !opt->synchronous &&
+			    !opt->auxiliary;
+	zclient->shm_pending = stream_fifo_new();
 
 	return zclient;
 }
@@ -101,6 +105,9 @@ void zclient_free(struct zclient *zclient)
 		stream_free(zclient->obuf);
 	if (zclient->wb)
 		buffer_free(zclient->wb);
+	if (zclient->shm_pending)
+		stream_fifo_free(zclient->shm_pending);
+	zapi_shm_free(&zclient->shm);
 
 	XFREE(MTYPE_ZCLIENT, zclient);
 }
@@ -260,6 +267,7 @@ void zclient_stop(struct zclient *zclient)
 	event_cancel(&zclient->t_read);
 	event_cancel(&zclient->t_connect);
 	event_cancel(&zclient->t_write);
+	event_cancel(&zclient->t_shm_space);
 
 	/* Reset streams. */
 	stream_reset(zclient->ibuf);
@@ -268,6 +276,11 @@ void zclient_stop(struct zclient *zclient)
 	/* Empty the write buffer. */
 	buffer_reset(zclient->wb);
 
+	/* Drop the shared memory ring, the next connection gets a new one. */
+	stream_fifo_clean(zclient->shm_pending);
+	zapi_shm_free(&zclient->shm);
+	zclient->shm_active = false;
+
 	/* Close socket. */
 	if (zclient->sock >= 0) {
 		close(zclient->sock);
@@ -368,12 +381,77 @@ static void zclient_flush_data(struct event *event)
 		break;
 	case BUFFER_EMPTY:
 		/* Currently only Sharpd and Bgpd has callbacks defined */
-		if (zclient->zebra_buffer_write_ready)
+		if (zclient->zebra_buffer_write_ready &&
+		    !stream_fifo_head(zclient->shm_pending))
 			(*zclient->zebra_buffer_write_ready)();
 		break;
 	}
 }
 
+static void zclient_shm_flush(struct event *event);
+
+/* Have zclient_shm_flush() run once zebra made room in the ring. */
+static void zclient_shm_wait(struct zclient *zclient)
+{
+	if (zapi_shm_space_wait(zclient->shm))
+		event_add_read(zclient->master, zclient_shm_flush, zclient,
+			       zclient->shm->fds[ZAPI_SHM_FD_SPACE],
+			       &zclient->t_shm_space);
+	else
+		event_add_event(zclient->master, zclient_shm_flush, zclient, 0,
+				&zclient->t_shm_space);
+}
+
+static void zclient_shm_flush(struct event *event)
+{
+	struct zclient *zclient = EVENT_ARG(event);
+	struct stream *s;
+	size_t nb;
+
+	if (!zclient->shm_active)
+		return;
+
+	zapi_shm_event_clear(zclient->shm->fds[ZAPI_SHM_FD_SPACE]);
+
+	while ((s = stream_fifo_head(zclient->shm_pending))) {
+		nb = zapi_shm_write(zclient->shm, stream_pnt(s),
+				    STREAM_READABLE(s));
+		stream_forward_getp(s, nb);
+		if (STREAM_READABLE(s)) {
+			zclient_shm_wait(zclient);
+			return;
+		}
+		stream_free(stream_fifo_pop(zclient->shm_pending));
+	}
+
+	if (zclient->zebra_buffer_write_ready)
+		(*zclient->zebra_buffer_write_ready)();
+}
+
+/*
+ * Put the message in obuf into the shared memory ring; what doesn't fit,
+ * or would overtake messages still waiting to, is queued up.
+ */
+static enum zclient_send_status zclient_shm_send(struct zclient *zclient)
+{
+	struct stream *s = zclient->obuf;
+	size_t len = stream_get_endp(s);
+	size_t nb = 0;
+
+	if (!stream_fifo_head(zclient->shm_pending)) {
+		nb = zapi_shm_write(zclient->shm, STREAM_DATA(s), len);
+		if (nb == len)
+			return ZCLIENT_SEND_SUCCESS;
+	}
+
+	s = stream_dup(s);
+	stream_set_getp(s, nb);
+	stream_fifo_push(zclient->shm_pending, s);
+	if (!zclient->t_shm_space)
+		zclient_shm_wait(zclient);
+	return ZCLIENT_SEND_BUFFERED;
+}
+
 /*
  * Returns:
  * ZCLIENT_SEND_FAILED   - is a failure
@@ -384,6 +462,8 @@ enum zclient_send_status zclient_send_message(struct zclient *zclient)
 {
 	if (zclient->sock < 0)
 		return ZCLIENT_SEND_FAILURE;
+	if (zclient->shm_active)
+		return zclient_shm_send(zclient);
 	switch (buffer_write(zclient->wb, zclient->sock,
 			     STREAM_DATA(zclient->obuf),
 			     stream_get_endp(zclient->obuf))) {
@@ -477,9 +557,47 @@ static enum zclient_send_status zebra_message_send(struct zclient *zclient,
 	return zclient_send_message(zclient);
 }
 
+/*
+ * Send the hello in obuf along with the descriptors of a shared memory ring.
+ * If the socket is too busy to take any of it, the ring is dropped and the
+ * hello goes the usual way, without the offer.
+ */
+static enum zclient_send_status zclient_send_hello_shm(struct zclient *zclient,
+						      size_t shm_at)
+{
+	struct stream *s = zclient->obuf;
+	size_t len = stream_get_endp(s);
+	ssize_t nb;
+
+	nb = zapi_shm_sendmsg(zclient->sock, STREAM_DATA(s), len,
+			      zclient->shm->fds);
+	if (nb < 0) {
+		if (!ERRNO_IO_RETRY(errno)) {
+			flog_err(EC_LIB_ZAPI_SOCKET,
+				 "%s: sendmsg failed to zclient fd %d, closing",
+				 __func__, zclient->sock);
+			return zclient_failed(zclient);
+		}
+		zapi_shm_free(&zclient->shm);
+		stream_putc_at(s, shm_at, 0);
+		return zclient_send_message(zclient);
+	}
+
+	if ((size_t)nb < len) {
+		buffer_put(zclient->wb, STREAM_DATA(s) + nb, len - nb);
+		event_add_write(zclient->master, zclient_flush_data, zclient,
+				zclient->sock, &zclient->t_write);
+		return ZCLIENT_SEND_BUFFERED;
+	}
+
+	return ZCLIENT_SEND_SUCCESS;
+}
+
 enum zclient_send_status zclient_send_hello(struct zclient *zclient)
 {
 	struct stream *s;
+	size_t shm_at;
+	uint32_t capabilities = 0;
 
 	if (zclient->redist_default || zclient->synchronous) {
 		s = zclient->obuf;
@@ -495,6 +613,30 @@ enum zclient_send_status zclient_send_hello(struct zclient *zclient)
 		else
 			stream_putc(s, 0);
 
+		/* Shared memory ring offer, filled in below */
+		shm_at = stream_get_endp(s);
+		stream_putc(s, 0);
+
+		/* Bulk NHT updates are unpacked by the lib handler, which only
+		 * runs for the main client.
+		 */
+		if (!zclient->auxiliary)
+			SET_FLAG(capabilities, ZAPI_CLIENT_CAP_NHT_BULK);
+		stream_putl(s, capabilities);
+
+		/* Offer a shared memory ring, nothing may go out before */
+		if (zclient->zapi_shm && !zclient->shm &&
+		    buffer_empty(zclient->wb)) {
+			zclient->shm = zapi_shm_create(ZAPI_SHM_SIZE);
+			if (zclient->shm) {
+				stream_putc_at(s, shm_at, 1);
+				stream_putw_at(s, 0, stream_get_endp(s));
+				return zclient_send_hello_shm(zclient, shm_at);
+			}
+			zlog_warn("%s: no shared memory ring for zebra: %s",
+				  __func__, safe_strerror(errno));
+		}
+
 		stream_putw_at(s, 0, stream_get_endp(s));
 		return zclient_send_message(zclient);
 	}
@@ -4754,10 +4896,87 @@ static int zclient_nexthop_update(ZAPI_CALLBACK_ARGS)
 	return 0;
 }
 
+/*
+ * Several nexthop tracking updates in one message, see
+ * ZAPI_CLIENT_CAP_NHT_BULK.  Each one is prefixed with its vrf and handed to
+ * the daemon like a ZEBRA_NEXTHOP_UPDATE would be.
+ */
+static int zclient_nexthop_update_bulk(ZAPI_CALLBACK_ARGS)
+{
+	struct stream *s = zclient->ibuf;
+	struct vrf *vrf;
+	struct prefix match;
+	struct zapi_route route;
+	vrf_id_t nh_vrf_id;
+	uint16_t count, i;
+
+	STREAM_GETW(s, count);
+
+	for (i = 0; i < count; i++) {
+		STREAM_GETL(s, nh_vrf_id);
+
+		if (!zapi_nexthop_update_decode(s, &match, &route)) {
+			zlog_err("failed to decode bulk nexthop update");
+			return -1;
+		}
+
+		vrf = vrf_lookup_by_id(nh_vrf_id);
+		if (!vrf) {
+			zlog_warn("nexthop update for unknown VRF ID %u",
+				  nh_vrf_id);
+			continue;
+		}
+
+		if (zclient->nexthop_update)
+			zclient->nexthop_update(vrf, &match, &route);
+	}
+
+	return 0;
+
+stream_failure:
+	zlog_err("failed to decode bulk nexthop update");
+	return -1;
+}
+
+/*
+ * Zebra's answer to the shared memory ring offered with the hello. If it
+ * accepted, tell it on the socket that everything from now on goes through
+ * the ring.
+ */
+static int zclient_zapi_shm(ZAPI_CALLBACK_ARGS)
+{
+	uint8_t accepted;
+
+	STREAM_GETC(zclient->ibuf, accepted);
+
+	if (!zclient->shm || zclient->shm_active)
+		return 0;
+
+	if (!accepted) {
+		zlog_info("zebra refused the shared memory ring, using the socket");
+		zapi_shm_free(&zclient->shm);
+		return 0;
+	}
+
+	if (zebra_message_send(zclient, ZEBRA_ZAPI_SHM, VRF_DEFAULT) ==
+	    ZCLIENT_SEND_FAILURE)
+		return -1;
+	zclient->shm_active = true;
+
+	if (zclient_debug)
+		zlog_debug("zclient %p sends through a shared memory ring",
+			   zclient);
+	return 0;
+
+stream_failure:
+	return -1;
+}
+
 static zclient_handler *const lib_handlers[] = {
 	/* fundamentals */
 	[ZEBRA_CAPABILITIES] = zclient_capability_decode,
 	[ZEBRA_ERROR] = zclient_handle_error,
+	[ZEBRA_ZAPI_SHM] = zclient_zapi_shm,
 
 	/* VRF & interface code is shared in lib */
 	[ZEBRA_VRF_ADD] = zclient_vrf_add,
@@ -4769,6 +4988,7 @@ static zclient_handler *const lib_handlers[] = {
 
 	/* NHT pre-decode */
 	[ZEBRA_NEXTHOP_UPDATE] = zclient_nexthop_update,
+	[ZEBRA_NEXTHOP_UPDATE_BULK] = zclient_nexthop_update_bulk,
 
 	/* BFD */
 	[ZEBRA_BFD_DEST_REPLAY] = zclient_bfd_session_replay,
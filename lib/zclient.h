@@ -238,6 +238,8 @@ typedef enum {
 	ZEBRA_TC_FILTER_DELETE,
 	ZEBRA_OPAQUE_NOTIFY,
 	ZEBRA_SRV6_SID_NOTIFY,
+	ZEBRA_ZAPI_SHM,
+	ZEBRA_NEXTHOP_UPDATE_BULK,
 } zebra_message_types_t;
 /* Zebra message types. Please update the corresponding
  * command_types array with any changes!
@@ -308,6 +310,7 @@ typedef int (zclient_handler)(ZAPI_CALLBACK_ARGS);
 /* clang-format on */
 
 struct zapi_route;
+struct zapi_shm;
 
 /* Structure for the zebra client. */
 struct zclient {
@@ -353,6 +356,16 @@ struct zclient {
 	/* Thread to write buffered data to zebra. */
 	struct event *t_write;
 
+	/* Shared memory ring to zebra, if asked for: offered with the hello,
+	 * active once zebra accepted it.  Messages that don't fit wait on
+	 * shm_pending until zebra made room.
+	 */
+	bool zapi_shm;
+	bool shm_active;
+	struct zapi_shm *shm;
+	struct stream_fifo *shm_pending;
+	struct event *t_shm_space;
+
 	/* Redistribute information. */
 	uint8_t redist_default; /* clients protocol */
 	unsigned short instance;
@@ -420,6 +433,15 @@ extern int zclient_bfd_session_update(ZAPI_CALLBACK_ARGS);
 #define ZAPI_MESSAGE_SRTE 0x0200
 #define ZAPI_MESSAGE_OPAQUE 0x0400
 
+/*
+ * Client capabilities, sent with the ZEBRA_HELLO.
+ *
+ * NHT_BULK: zebra may send nexthop tracking updates packed into
+ * ZEBRA_NEXTHOP_UPDATE_BULK messages instead of one ZEBRA_NEXTHOP_UPDATE
+ * each.
+ */
+#define ZAPI_CLIENT_CAP_NHT_BULK (1 << 0)
+
 #define ZSERV_VERSION 6
 /* Zserv protocol message header */
 struct zmsghdr {
@@ -887,6 +909,12 @@ struct zclient_options {
 	 * not.  (This is also set for synchronous clients.)
 	 */
 	bool auxiliary;
+
+	/* Offer zebra a shared memory ring to send messages through, instead
+	 * of the socket (see lib/zapi_shm.h).  Not for synchronous or
+	 * auxiliary clients.
+	 */
+	bool zapi_shm;
 };
 
 extern const struct zclient_options zclient_options_default;
@@ -65,6 +65,9 @@ struct sharp_global {
 	struct list *srv6_locators;
 
 	bool use_underlying_nexthop_group_weight;
+
+	/* Offer zebra a shared memory ring (--zapi-shm) */
+	bool zapi_shm;
 };
 
 extern struct sharp_global sg;
@@ -52,7 +52,12 @@ struct zebra_privs_t sharp_privs = {
 	.cap_num_p = array_size(_caps_p),
 	.cap_num_i = 0};
 
-struct option longopts[] = {{0}};
+#define OPTION_ZAPI_SHM 2000
+
+struct option longopts[] = {
+	{ "zapi-shm", no_argument, NULL, OPTION_ZAPI_SHM },
+	{ 0 }
+};
 
 struct sharp_global sg;
 
@@ -163,8 +168,11 @@ static void sharp_end_configuration(struct vty *vty)
 
 int main(int argc, char **argv, char **envp)
 {
+	bool zapi_shm = false;
+
 	frr_preinit(&sharpd_di, argc, argv);
-	frr_opt_add("", longopts, "");
+	frr_opt_add("", longopts,
+		    "      --zapi-shm    Send to zebra through a shared memory ring\n");
 
 	while (1) {
 		int opt;
@@ -177,6 +185,9 @@ int main(int argc, char **argv, char **envp)
 		switch (opt) {
 		case 0:
 			break;
+		case OPTION_ZAPI_SHM:
+			zapi_shm = true;
+			break;
 		default:
 			frr_help_exit(1);
 		}
@@ -187,6 +198,7 @@ int main(int argc, char **argv, char **envp)
 	cmd_init_config_callbacks(sharp_start_configuration,
 				  sharp_end_configuration);
 	sharp_global_init();
+	sg.zapi_shm = zapi_shm;
 
 	sharp_nhgroup_init();
 	vrf_init(NULL, NULL, NULL, NULL);
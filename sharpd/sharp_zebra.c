@@ -1161,12 +1161,15 @@ static zclient_handler *const sharp_handlers[] = {
 
 void sharp_zebra_init(void)
 {
+	struct zclient_options opt = zclient_options_default;
+
 	hook_register_prio(if_real, 0, sharp_ifp_create);
 	hook_register_prio(if_up, 0, sharp_ifp_up);
 	hook_register_prio(if_down, 0, sharp_ifp_down);
 	hook_register_prio(if_unreal, 0, sharp_ifp_destroy);
 
-	g_zclient = zclient_new(master, &zclient_options_default, sharp_handlers,
+	opt.zapi_shm = sg.zapi_shm;
+	g_zclient = zclient_new(master, &opt, sharp_handlers,
 				array_size(sharp_handlers));
 
 	zclient_init(g_zclient, ZEBRA_ROUTE_SHARP, 0, &sharp_privs);
@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Benchmark for BGP-LS NLRI parsing and encoding
+ *
+ * Builds the Node, Link and Prefix NLRIs of a synthetic IS-IS domain and
+ * pushes them through a full round trip: field-by-field encoding, decoding
+ * back from the wire, interning and encoding again from the interned copy,
+ * which is what every UPDATE towards a BGP-LS peer does.  Decoded NLRIs
+ * must compare equal to the originals and both encodings must produce the
+ * same bytes.  Not run as part of the test suite; invoke it manually,
+ * optionally passing the number of nodes.
+ */
+
+#include <zebra.h>
+
+#include "stream.h"
+#include "monotime.h"
+#include "bgpd/bgp_ls_nlri.h"
+
+/* Satisfy link requirements from including bgpd.h */
+struct zebra_privs_t bgpd_privs = {0};
+
+#define PERF_NODES 20000
+
+/* Every node has this many links and prefixes */
+#define PERF_LINKS    4
+#define PERF_PREFIXES 8
+
+/* Generous upper bound for a single encoded NLRI */
+#define PERF_NLRI_MAX 256
+
+static void perf_node_desc(struct bgp_ls_node_descriptor *desc, uint32_t node)
+{
+	desc->asn = 65000 + node % 16;
+	BGP_LS_TLV_SET(desc->present_tlvs, BGP_LS_NODE_DESC_AS_BIT);
+
+	desc->igp_router_id_len = BGP_LS_IGP_ROUTER_ID_ISIS_LEN;
+	desc->igp_router_id[2] = (node >> 24) & 0xff;
+	desc->igp_router_id[3] = (node >> 16) & 0xff;
+	desc->igp_router_id[4] = (node >> 8) & 0xff;
+	desc->igp_router_id[5] = node & 0xff;
+	BGP_LS_TLV_SET(desc->present_tlvs, BGP_LS_NODE_DESC_IGP_ROUTER_BIT);
+}
+
+/* NLRI number i of the domain, nodes first, then links, then prefixes */
+static void perf_nlri(struct bgp_ls_nlri *nlri, unsigned long i, unsigned long n_nodes)
+{
+	struct bgp_ls_link_descriptor *link;
+	struct bgp_ls_prefix_descriptor *pfx;
+	uint32_t node, k;
+
+	memset(nlri, 0, sizeof(*nlri));
+
+	if (i < n_nodes) {
+		nlri->nlri_type = BGP_LS_NLRI_TYPE_NODE;
+		nlri->nlri_data.node.protocol_id = BGP_LS_PROTO_ISIS_L2;
+		perf_node_desc(&nlri->nlri_data.node.local_node, i);
+		return;
+	}
+
+	i -= n_nodes;
+	if (i < n_nodes * PERF_LINKS) {
+		node = i / PERF_LINKS;
+		k = i % PERF_LINKS;
+
+		nlri->nlri_type = BGP_LS_NLRI_TYPE_LINK;
+		nlri->nlri_data.link.protocol_id = BGP_LS_PROTO_ISIS_L2;
+		perf_node_desc(&nlri->nlri_data.link.local_node, node);
+		perf_node_desc(&nlri->nlri_data.link.remote_node, (node + k + 1) % n_nodes);
+
+		link = &nlri->nlri_data.link.link_desc;
+		link->link_local_id = k + 1;
+		link->link_remote_id = PERF_LINKS - k;
+		BGP_LS_TLV_SET(link->present_tlvs, BGP_LS_LINK_DESC_LINK_ID_BIT);
+		link->ipv4_intf_addr.s_addr = htonl(0x0a000000 | (i << 1));
+		BGP_LS_TLV_SET(link->present_tlvs, BGP_LS_LINK_DESC_IPV4_INTF_BIT);
+		link->ipv4_neigh_addr.s_addr = htonl(0x0a000000 | (i << 1) | 1);
+		BGP_LS_TLV_SET(link->present_tlvs, BGP_LS_LINK_DESC_IPV4_NEIGH_BIT);
+		if (k == 0) {
+			link->mt_id[0] = 0;
+			link->mt_id[1] = 2;
+			link->mt_id_count = 2;
+			BGP_LS_TLV_SET(link->present_tlvs, BGP_LS_LINK_DESC_MT_ID_BIT);
+		}
+		return;
+	}
+
+	i -= n_nodes * PERF_LINKS;
+	node = i / PERF_PREFIXES;
+	k = i % PERF_PREFIXES;
+
+	nlri->nlri_data.prefix.protocol_id = BGP_LS_PROTO_ISIS_L2;
+	perf_node_desc(&nlri->nlri_data.prefix.local_node, node);
+
+	pfx = &nlri->nlri_data.prefix.prefix_desc;
+	if (k % 2) {
+		nlri->nlri_type = BGP_LS_NLRI_TYPE_IPV6_PREFIX;
+		pfx->prefix.family = AF_INET6;
+		pfx->prefix.prefixlen = 64;
+		pfx->prefix.u.prefix6.s6_addr[0] = 0x20;
+		pfx->prefix.u.prefix6.s6_addr[1] = 0x01;
+		pfx->prefix.u.prefix6.s6_addr32[1] = htonl(i);
+		pfx->mt_id[0] = 2;
+		pfx->mt_id_count = 1;
+		BGP_LS_TLV_SET(pfx->present_tlvs, BGP_LS_PREFIX_DESC_MT_ID_BIT);
+	} else {
+		nlri->nlri_type = BGP_LS_NLRI_TYPE_IPV4_PREFIX;
+		pfx->prefix.family = AF_INET;
+		pfx->prefix.prefixlen = 24 + k;
+		pfx->prefix.u.prefix4.s_addr = htonl(0xac000000 | (i << 8));
+	}
+	apply_mask(&pfx->prefix);
+	BGP_LS_TLV_SET(pfx->present_tlvs, BGP_LS_PREFIX_DESC_IP_REACH_BIT);
+}
+
+static int64_t perf_lap(struct timeval *start)
+{
+	int64_t elapsed = monotime_since(start, NULL);
+
+	monotime(start);
+	return elapsed;
+}
+
+static void perf_report(const char *op, unsigned long n, size_t bytes, int64_t usec)
+{
+	printf("%-16s %8lu NLRIs %9" PRId64 " us %7.1f ns/NLRI %8.1f MB/s\n", op, n, usec,
+	       n ? usec * 1000.0 / n : 0.0, usec ? (double)bytes / usec : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n_nodes = PERF_NODES;
+	unsigned long n, i;
+	struct bgp_ls_nlri nlri, expect;
+	struct bgp_ls_nlri **interned;
+	struct stream *wire, *cached;
+	struct timeval start;
+	size_t bytes;
+	int failed = 0;
+
+	if (argc > 1)
+		n_nodes = strtoul(argv[1], NULL, 10);
+	if (!n_nodes)
+		return 1;
+
+	n = n_nodes * (1 + PERF_LINKS + PERF_PREFIXES);
+	wire = stream_new(n * PERF_NLRI_MAX);
+	cached = stream_new(n * PERF_NLRI_MAX);
+	interned = calloc(n, sizeof(*interned));
+	assert(interned);
+
+	printf("%lu nodes, %lu NLRIs, %zu bytes per decoded NLRI\n", n_nodes, n, sizeof(nlri));
+
+	monotime(&start);
+	for (i = 0; i < n; i++) {
+		perf_nlri(&nlri, i, n_nodes);
+		if (bgp_ls_encode_nlri(wire, &nlri) < 0) {
+			printf("NLRI %lu failed to encode\n", i);
+			return 1;
+		}
+	}
+	bytes = stream_get_endp(wire);
+	perf_report("encode", n, bytes, perf_lap(&start));
+
+	for (i = 0; i < n; i++) {
+		memset(&nlri, 0, sizeof(nlri));
+		if (bgp_ls_decode_nlri(wire, &nlri) < 0) {
+			printf("NLRI %lu failed to decode\n", i);
+			return 1;
+		}
+	}
+	perf_report("decode", n, bytes, perf_lap(&start));
+	assert(STREAM_READABLE(wire) == 0);
+
+	/* Untimed, check the round trip */
+	stream_set_getp(wire, 0);
+	for (i = 0; i < n; i++) {
+		memset(&nlri, 0, sizeof(nlri));
+		bgp_ls_decode_nlri(wire, &nlri);
+		perf_nlri(&expect, i, n_nodes);
+		if (bgp_ls_nlri_cmp(&nlri, &expect)) {
+			printf("NLRI %lu differs after decoding\n", i);
+			failed++;
+		}
+	}
+	stream_set_getp(wire, 0);
+
+	monotime(&start);
+	for (i = 0; i < n; i++) {
+		memset(&nlri, 0, sizeof(nlri));
+		bgp_ls_decode_nlri(wire, &nlri);
+		interned[i] = bgp_ls_nlri_copy(&nlri);
+	}
+	perf_report("decode+intern", n, bytes, perf_lap(&start));
+
+	for (i = 0; i < n; i++)
+		if (bgp_ls_encode_nlri(cached, interned[i]) < 0) {
+			printf("interned NLRI %lu failed to encode\n", i);
+			return 1;
+		}
+	perf_report("encode interned", n, bytes, perf_lap(&start));
+
+	if (stream_get_endp(cached) != bytes ||
+	    memcmp(STREAM_DATA(wire), STREAM_DATA(cached), bytes)) {
+		printf("interned encoding differs\n");
+		failed++;
+	}
+
+	for (i = 0; i < n; i++)
+		bgp_ls_nlri_free(interned[i]);
+	free(interned);
+	bgp_ls_nlri_fini();
+	stream_free(cached);
+	stream_free(wire);
+
+	if (failed)
+		return 1;
+	printf("BGP-LS NLRI round trip successful.\n");
+	return 0;
+}
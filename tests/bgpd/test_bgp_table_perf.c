@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Benchmark for the BGP routing table
+ *
+ * Loads a full-table sized set of random IPv4 and IPv6 prefixes into a
+ * bgp_table and, as a reference, into a plain route_table with malloc'ed
+ * nodes, and measures insert, exact lookup, longest prefix match, a full
+ * walk and deletion on both. Not run as part of the test suite; invoke it
+ * manually, optionally passing the number of IPv4 and IPv6 prefixes.
+ */
+
+#include <zebra.h>
+
+#include "prefix.h"
+#include "table.h"
+#include "monotime.h"
+#include "bgpd/bgp_table.h"
+#include "prng.h"
+
+/* Satisfy link requirements from including bgpd.h */
+struct zebra_privs_t bgpd_privs = {0};
+
+#define PERF_V4_PREFIXES 1200000
+#define PERF_V6_PREFIXES 250000
+
+/* any non-NULL value, the tables never look at it */
+static int perf_info;
+
+static void perf_prefix(struct prng *prng, afi_t afi, struct prefix *p)
+{
+	uint32_t r = prng_rand(prng);
+
+	memset(p, 0, sizeof(*p));
+
+	if (afi == AFI_IP) {
+		/* roughly the length distribution of the DFZ */
+		p->family = AF_INET;
+		p->prefixlen = (r % 100 < 60) ? 24 : 16 + r % 8;
+		p->u.prefix4.s_addr = htonl(prng_rand(prng) ^ (r << 16));
+	} else {
+		p->family = AF_INET6;
+		p->prefixlen = (r % 100 < 50) ? 48 : 29 + r % 19;
+		p->u.prefix6.s6_addr[0] = 0x20;
+		p->u.prefix6.s6_addr[1] = 0x01 + r % 3;
+		p->u.prefix6.s6_addr32[1] = prng_rand(prng);
+	}
+	apply_mask(p);
+}
+
+static int64_t perf_lap(struct timeval *start)
+{
+	int64_t elapsed = monotime_since(start, NULL);
+
+	monotime(start);
+	return elapsed;
+}
+
+static void perf_report(const char *table, const char *op, unsigned long n,
+			int64_t usec)
+{
+	printf("%-12s %-8s %8lu ops %9" PRId64 " us %7.1f ns/op\n", table, op, n,
+	       usec, n ? usec * 1000.0 / n : 0.0);
+}
+
+static void perf_bgp_table(afi_t afi, struct prefix *pfx, unsigned long n)
+{
+	struct bgp_table *table = bgp_table_init(NULL, afi, SAFI_UNICAST);
+	struct bgp_dest *dest;
+	struct timeval start;
+	unsigned long i, count = 0;
+	size_t inuse = bgp_table_node_pool.n_inuse;
+
+	monotime(&start);
+	for (i = 0; i < n; i++) {
+		dest = bgp_node_get(table, &pfx[i]);
+		if (dest->info)
+			bgp_dest_unlock_node(dest);
+		else
+			dest->info = &perf_info;
+	}
+	perf_report("bgp_table", "insert", n, perf_lap(&start));
+
+	for (i = 0; i < n; i++) {
+		dest = bgp_node_lookup(table, &pfx[i]);
+		assert(dest);
+		bgp_dest_unlock_node(dest);
+	}
+	perf_report("bgp_table", "lookup", n, perf_lap(&start));
+
+	for (i = 0; i < n; i++) {
+		dest = bgp_node_match(table, &pfx[i]);
+		assert(dest);
+		bgp_dest_unlock_node(dest);
+	}
+	perf_report("bgp_table", "match", n, perf_lap(&start));
+
+	for (dest = bgp_table_top(table); dest; dest = bgp_route_next(dest))
+		count++;
+	perf_report("bgp_table", "walk", count, perf_lap(&start));
+
+	printf("bgp_table    %lu prefixes, %lu tree nodes, %zu bytes per tree node\n",
+	       bgp_table_count(table), table->route_table->count,
+	       bgp_table_node_pool.objsize);
+	assert(bgp_table_node_pool.n_inuse - inuse == table->route_table->count);
+
+	monotime(&start);
+	for (i = 0; i < n; i++) {
+		dest = bgp_node_lookup(table, &pfx[i]);
+		if (!dest)
+			continue;
+		dest->info = NULL;
+		bgp_dest_unlock_node(dest);
+		bgp_dest_unlock_node(dest);
+	}
+	perf_report("bgp_table", "delete", n, perf_lap(&start));
+
+	assert(bgp_table_count(table) == 0);
+	bgp_table_unlock(table);
+}
+
+static void perf_route_table(struct prefix *pfx, unsigned long n)
+{
+	struct route_table *table = route_table_init();
+	struct route_node *rn;
+	struct timeval start;
+	unsigned long i, count = 0;
+
+	monotime(&start);
+	for (i = 0; i < n; i++) {
+		rn = route_node_get(table, &pfx[i]);
+		if (rn->info)
+			route_unlock_node(rn);
+		else
+			rn->info = &perf_info;
+	}
+	perf_report("route_table", "insert", n, perf_lap(&start));
+
+	for (i = 0; i < n; i++) {
+		rn = route_node_lookup(table, &pfx[i]);
+		assert(rn);
+		route_unlock_node(rn);
+	}
+	perf_report("route_table", "lookup", n, perf_lap(&start));
+
+	for (i = 0; i < n; i++) {
+		rn = route_node_match(table, &pfx[i]);
+		assert(rn);
+		route_unlock_node(rn);
+	}
+	perf_report("route_table", "match", n, perf_lap(&start));
+
+	for (rn = route_top(table); rn; rn = route_next(rn))
+		if (rn->info)
+			count++;
+	perf_report("route_table", "walk", count, perf_lap(&start));
+
+	printf("route_table  %lu prefixes, %lu tree nodes, %zu bytes per tree node + malloc overhead\n",
+	       route_table_info_count(table), table->count,
+	       sizeof(struct route_node));
+
+	monotime(&start);
+	for (i = 0; i < n; i++) {
+		rn = route_node_lookup(table, &pfx[i]);
+		if (!rn)
+			continue;
+		rn->info = NULL;
+		route_unlock_node(rn);
+		route_unlock_node(rn);
+	}
+	perf_report("route_table", "delete", n, perf_lap(&start));
+
+	assert(route_table_info_count(table) == 0);
+	route_table_finish(table);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n_v4 = PERF_V4_PREFIXES, n_v6 = PERF_V6_PREFIXES;
+	struct prng *prng;
+	struct prefix *pfx;
+	unsigned long i;
+
+	if (argc > 1)
+		n_v4 = strtoul(argv[1], NULL, 10);
+	if (argc > 2)
+		n_v6 = strtoul(argv[2], NULL, 10);
+
+	prng = prng_new(0);
+	pfx = calloc(MAX(n_v4, n_v6) + 1, sizeof(*pfx));
+	assert(pfx);
+
+	printf("IPv4, %lu random prefixes\n", n_v4);
+	for (i = 0; i < n_v4; i++)
+		perf_prefix(prng, AFI_IP, &pfx[i]);
+	perf_route_table(pfx, n_v4);
+	perf_bgp_table(AFI_IP, pfx, n_v4);
+
+	printf("\nIPv6, %lu random prefixes\n", n_v6);
+	for (i = 0; i < n_v6; i++)
+		perf_prefix(prng, AFI_IP6, &pfx[i]);
+	perf_route_table(pfx, n_v6);
+	perf_bgp_table(AFI_IP6, pfx, n_v6);
+
+	free(pfx);
+	prng_free(prng);
+	return 0;
+}
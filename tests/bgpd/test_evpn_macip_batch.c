@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Synthetic scale test for bulk EVPN remote MAC/IP ZAPI messages
+ *
+ * Pushes a large number of MAC/IP entries spread over many VNIs through the
+ * bgpd MAC/IP batcher and decodes every resulting message the same way
+ * zebra does, checking that nothing is lost, reordered or mangled.
+ */
+
+#include <zebra.h>
+
+#include "stream.h"
+#include "privs.h"
+#include "memory.h"
+#include "monotime.h"
+#include "zclient.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_evpn.h"
+
+/* need these to link in libbgp */
+struct zebra_privs_t bgpd_privs = {};
+struct event_loop *master = NULL;
+
+#define TEST_VNIS     4096
+#define TEST_MACS_VNI 64
+
+static unsigned int n_vnis = TEST_VNIS;
+static unsigned int n_macs = TEST_MACS_VNI;
+
+/* running position of the decoder in the synthetic sequence */
+static uint64_t rx_pos;
+static uint64_t rx_msgs;
+static bool rx_add;
+static int failed;
+
+static void entry_gen(uint64_t pos, bool add, vni_t *vni, struct ethaddr *mac,
+		      struct ipaddr *ip, struct ipaddr *vtep, uint8_t *flags,
+		      uint32_t *seq, esi_t *esi)
+{
+	uint32_t m = pos % n_macs;
+
+	*vni = 10000 + pos / n_macs;
+
+	memset(mac, 0, sizeof(*mac));
+	mac->octet[0] = 0x02;
+	mac->octet[2] = (pos >> 24) & 0xff;
+	mac->octet[3] = (pos >> 16) & 0xff;
+	mac->octet[4] = (pos >> 8) & 0xff;
+	mac->octet[5] = pos & 0xff;
+
+	memset(ip, 0, sizeof(*ip));
+	switch (m % 3) {
+	case 0:
+		ip->ipa_type = IPADDR_NONE;
+		break;
+	case 1:
+		ip->ipa_type = IPADDR_V4;
+		ip->ipaddr_v4.s_addr = htonl(0x0a000000 | (pos & 0xffffff));
+		break;
+	case 2:
+		ip->ipa_type = IPADDR_V6;
+		ip->ipaddr_v6.s6_addr[0] = 0xfd;
+		ip->ipaddr_v6.s6_addr[12] = (pos >> 24) & 0xff;
+		ip->ipaddr_v6.s6_addr[13] = (pos >> 16) & 0xff;
+		ip->ipaddr_v6.s6_addr[14] = (pos >> 8) & 0xff;
+		ip->ipaddr_v6.s6_addr[15] = pos & 0xff;
+		break;
+	}
+
+	memset(vtep, 0, sizeof(*vtep));
+	if (m % 8 == 7) {
+		vtep->ipa_type = IPADDR_V6;
+		vtep->ipaddr_v6.s6_addr[0] = 0x20;
+		vtep->ipaddr_v6.s6_addr[15] = m;
+	} else {
+		vtep->ipa_type = IPADDR_V4;
+		vtep->ipaddr_v4.s_addr = htonl(0xc0a80000 | (m & 0xff));
+	}
+
+	memset(esi, 0, sizeof(*esi));
+	*flags = 0;
+	*seq = 0;
+	if (add) {
+		*flags = m & 0x7;
+		*seq = pos & 0xffff;
+		if (m % 5 == 0) {
+			esi->val[0] = 0x03;
+			esi->val[9] = m;
+		}
+	}
+}
+
+/* Mirrors zebra_vxlan_remote_macip_helper() */
+static int entry_check(struct stream *s, bool add)
+{
+	vni_t vni, x_vni;
+	struct ethaddr mac, x_mac;
+	struct ipaddr ip, x_ip, vtep, x_vtep;
+	uint8_t flags = 0, x_flags;
+	uint32_t seq = 0, x_seq;
+	esi_t esi, x_esi;
+	uint16_t ipa_len;
+
+	memset(&ip, 0, sizeof(ip));
+	memset(&vtep, 0, sizeof(vtep));
+	memset(&esi, 0, sizeof(esi));
+
+	STREAM_GETL(s, vni);
+	STREAM_GET(mac.octet, s, ETH_ALEN);
+	STREAM_GETW(s, ipa_len);
+	if (ipa_len) {
+		if (ipa_len == IPV4_MAX_BYTELEN)
+			ip.ipa_type = IPADDR_V4;
+		else if (ipa_len == IPV6_MAX_BYTELEN)
+			ip.ipa_type = IPADDR_V6;
+		else
+			goto stream_failure;
+		STREAM_GET(&ip.ip.addr, s, ipa_len);
+	}
+	STREAM_GET_IPADDR(s, &vtep);
+	if (add) {
+		STREAM_GETC(s, flags);
+		STREAM_GETL(s, seq);
+		STREAM_GET(&esi, s, sizeof(esi_t));
+	}
+
+	entry_gen(rx_pos, add, &x_vni, &x_mac, &x_ip, &x_vtep, &x_flags,
+		  &x_seq, &x_esi);
+
+	if (vni != x_vni || memcmp(&mac, &x_mac, sizeof(mac)) ||
+	    ipaddr_cmp(&ip, &x_ip) || ipaddr_cmp(&vtep, &x_vtep) ||
+	    flags != x_flags || seq != x_seq ||
+	    memcmp(&esi, &x_esi, sizeof(esi))) {
+		printf("entry %" PRIu64 " mismatch (VNI %u, expected %u)\n",
+		       rx_pos, vni, x_vni);
+		return -1;
+	}
+
+	rx_pos++;
+	return 0;
+
+stream_failure:
+	printf("entry %" PRIu64 " truncated\n", rx_pos);
+	return -1;
+}
+
+static enum zclient_send_status test_send(struct stream *s, uint32_t entries)
+{
+	uint16_t length, cmd;
+	uint8_t marker, version;
+	vrf_id_t vrf_id;
+	uint32_t i;
+
+	STREAM_GETW(s, length);
+	STREAM_GETC(s, marker);
+	STREAM_GETC(s, version);
+	STREAM_GETL(s, vrf_id);
+	STREAM_GETW(s, cmd);
+
+	if (length != stream_get_endp(s) || marker != ZEBRA_HEADER_MARKER ||
+	    version != ZSERV_VERSION || vrf_id != VRF_DEFAULT ||
+	    cmd != (rx_add ? ZEBRA_REMOTE_MACIP_ADD : ZEBRA_REMOTE_MACIP_DEL)) {
+		printf("bad header: length %u/%zu cmd %u\n", length,
+		       stream_get_endp(s), cmd);
+		failed++;
+		return ZCLIENT_SEND_FAILURE;
+	}
+
+	for (i = 0; i < entries; i++)
+		if (entry_check(s, rx_add)) {
+			failed++;
+			return ZCLIENT_SEND_FAILURE;
+		}
+
+	if (STREAM_READABLE(s)) {
+		printf("%zu trailing bytes\n", STREAM_READABLE(s));
+		failed++;
+		return ZCLIENT_SEND_FAILURE;
+	}
+
+	rx_msgs++;
+	return ZCLIENT_SEND_SUCCESS;
+
+stream_failure:
+	printf("short header\n");
+	failed++;
+	return ZCLIENT_SEND_FAILURE;
+}
+
+static void run_phase(struct bgp_evpn_macip_batch *batch, bool add)
+{
+	uint64_t total = (uint64_t)n_vnis * n_macs;
+	struct timeval start;
+	int64_t elapsed;
+	vni_t vni;
+	struct ethaddr mac;
+	struct ipaddr ip, vtep;
+	uint8_t flags;
+	uint32_t seq;
+	esi_t esi;
+	uint64_t pos;
+	int prev_failed = failed;
+
+	rx_pos = 0;
+	rx_msgs = 0;
+	rx_add = add;
+
+	monotime(&start);
+	for (pos = 0; pos < total; pos++) {
+		entry_gen(pos, add, &vni, &mac, &ip, &vtep, &flags, &seq, &esi);
+		bgp_evpn_macip_batch_add(batch, add, VRF_DEFAULT, vni, &mac,
+					 &ip, &vtep, flags, seq, &esi);
+	}
+	bgp_evpn_macip_batch_flush(batch);
+	elapsed = monotime_since(&start, NULL);
+
+	printf("%s: %" PRIu64 " entries in %" PRIu64 " messages, %" PRId64
+	       " us\n",
+	       add ? "add" : "del", rx_pos, rx_msgs, elapsed);
+
+	if (rx_pos != total) {
+		printf("%" PRIu64 " of %" PRIu64 " entries received\n", rx_pos,
+		       total);
+		failed++;
+	}
+	/* a ZAPI packet holds a couple hundred entries at least */
+	if (rx_msgs > total / 100 + 1) {
+		printf("too many messages\n");
+		failed++;
+	}
+
+	printf("%s: %s\n", add ? "add" : "del",
+	       failed == prev_failed ? "OK" : "failed");
+}
+
+int main(int argc, char **argv)
+{
+	struct bgp_evpn_macip_batch batch;
+
+	if (argc > 1)
+		n_vnis = atoi(argv[1]);
+	if (argc > 2)
+		n_macs = atoi(argv[2]);
+	if (!n_vnis || !n_macs)
+		return 1;
+
+	bgp_evpn_macip_batch_init(&batch, test_send);
+
+	run_phase(&batch, true);
+	run_phase(&batch, false);
+
+	bgp_evpn_macip_batch_fini(&batch);
+
+	if (failed)
+		return 1;
+	printf("EVPN MACIP batch test successful.\n");
+	return 0;
+}
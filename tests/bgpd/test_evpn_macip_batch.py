@@ -0,0 +1,11 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+import frrtest
+
+
+class TestEvpnMacipBatch(frrtest.TestMultiOut):
+    program = "./test_evpn_macip_batch"
+
+
+TestEvpnMacipBatch.okfail("add:")
+TestEvpnMacipBatch.okfail("del:")
+TestEvpnMacipBatch.onesimple("EVPN MACIP batch test successful.")
@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Per-peer memory accounting of VNC import table paths
+ *
+ * Imports a VPN path into an rfapi import table and withdraws it again,
+ * checking that the peer's attribute and Adj-RIB-In byte counters go back
+ * to where they started.
+ */
+
+#include <zebra.h>
+
+#include "memory.h"
+#include "privs.h"
+#include "frr_pthread.h"
+#include "northbound.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_ecommunity.h"
+#include "bgpd/bgp_network.h"
+#include "bgpd/bgp_rd.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/rfapi/rfapi.h"
+#include "bgpd/rfapi/rfapi_import.h"
+
+/* need these to link in libbgp */
+struct zebra_privs_t bgpd_privs = {};
+struct event_loop *master = NULL;
+
+static int failed;
+
+/* more: counters must have grown past the given values, else match them */
+static void check_counters(const char *what, struct peer *peer,
+			   uint64_t attr_bytes, uint64_t rib_bytes, bool more)
+{
+	bool ok;
+
+	if (more)
+		ok = peer->stat_attr_bytes > attr_bytes &&
+		     peer->stat_adj_rib_in_bytes > rib_bytes;
+	else
+		ok = peer->stat_attr_bytes == attr_bytes &&
+		     peer->stat_adj_rib_in_bytes == rib_bytes;
+
+	printf("%s: attr %" PRIu64 " adj-rib-in %" PRIu64 ": %s\n", what,
+	       peer->stat_attr_bytes, peer->stat_adj_rib_in_bytes,
+	       ok ? "OK" : "failed");
+	if (!ok)
+		failed++;
+}
+
+int main(void)
+{
+	struct bgp *bgp;
+	as_t asn = 100;
+	struct peer *peer;
+	struct ecommunity *ecom;
+	struct rfapi_import_table *it;
+	struct attr attr;
+	struct prefix p;
+	struct prefix_rd prd = {};
+	uint64_t attr_bytes, rib_bytes;
+	uint64_t attr_bytes_1, rib_bytes_1;
+
+	qobj_init();
+	cmd_init(0);
+	zprivs_preinit(&bgpd_privs);
+	zprivs_init(&bgpd_privs);
+
+	master = event_master_create(NULL);
+	nb_init(master, NULL, 0, false, false);
+	bgp_master_init(master, BGP_SOCKET_SNDBUF_SIZE, list_new());
+	bgp_option_set(BGP_OPT_NO_LISTEN);
+	vrf_init(NULL, NULL, NULL, NULL);
+	frr_pthread_init();
+	bgp_init(0);
+
+	if (bgp_get(&bgp, &asn, NULL, BGP_INSTANCE_TYPE_DEFAULT, NULL,
+		    ASNOTATION_PLAIN) < 0)
+		return 1;
+
+	peer = peer_create_accept(bgp, NULL);
+	peer->host = (char *)"test";
+
+	ecom = ecommunity_str2com("100:1", ECOMMUNITY_ROUTE_TARGET, 0);
+	assert(ecom);
+	it = rfapiImportTableRefAdd(bgp, ecom, NULL);
+
+	bgp_attr_default_set(&attr, bgp, BGP_ORIGIN_IGP);
+	bgp_attr_set_ecommunity(&attr, ecommunity_intern(ecom));
+	attr.mp_nexthop_len = BGP_ATTR_NHLEN_IPV4;
+	inet_pton(AF_INET, "192.0.2.1", &attr.mp_nexthop_global_in);
+
+	str2prefix("10.0.0.0/24", &p);
+	str2prefix_rd("100:1", &prd);
+
+	attr_bytes = peer->stat_attr_bytes;
+	rib_bytes = peer->stat_adj_rib_in_bytes;
+
+	rfapiBgpInfoFilteredImportVPN(it, FIF_ACTION_UPDATE, peer, NULL, &p,
+				      NULL, AFI_IP, &prd, &attr, ZEBRA_ROUTE_BGP,
+				      BGP_ROUTE_NORMAL, NULL);
+	check_counters("import", peer, attr_bytes, rib_bytes, true);
+	attr_bytes_1 = peer->stat_attr_bytes;
+	rib_bytes_1 = peer->stat_adj_rib_in_bytes;
+
+	/* Replacing the path must not leave the old one charged */
+	rfapiBgpInfoFilteredImportVPN(it, FIF_ACTION_UPDATE, peer, NULL, &p,
+				      NULL, AFI_IP, &prd, &attr, ZEBRA_ROUTE_BGP,
+				      BGP_ROUTE_NORMAL, NULL);
+	check_counters("replace", peer, attr_bytes_1, rib_bytes_1, false);
+
+	rfapiBgpInfoFilteredImportVPN(it, FIF_ACTION_KILL, peer, NULL, &p,
+				      NULL, AFI_IP, &prd, NULL, ZEBRA_ROUTE_BGP,
+				      BGP_ROUTE_NORMAL, NULL);
+	check_counters("withdraw", peer, attr_bytes, rib_bytes, false);
+
+	if (failed)
+		return 1;
+	printf("rfapi import accounting test successful.\n");
+	return 0;
+}
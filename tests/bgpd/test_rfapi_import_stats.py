@@ -0,0 +1,12 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+import frrtest
+
+
+class TestRfapiImportStats(frrtest.TestMultiOut):
+    program = "./test_rfapi_import_stats"
+
+
+TestRfapiImportStats.okfail("import:")
+TestRfapiImportStats.okfail("replace:")
+TestRfapiImportStats.okfail("withdraw:")
+TestRfapiImportStats.onesimple("rfapi import accounting test successful.")
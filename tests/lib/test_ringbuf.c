@@ -169,6 +169,39 @@ int main(int argc, char **argv)
 	printf("Retrieved: %s\n", sixteen);
 	assert(!strcmp(sixteen, "vascular plants"));
 
+	/* validate direct writes across ring boundary */
+	printf("Validating direct write...\n");
+	struct iovec iov[2];
+	const char *sap = "leaf";
+
+	ringbuf_reset(soil);
+	soil->start = soil->end = 13;
+	assert(ringbuf_space_iov(soil, iov) == 2);
+	assert(iov[0].iov_base == soil->data + 13 && iov[0].iov_len == 2);
+	assert(iov[1].iov_base == soil->data && iov[1].iov_len == 13);
+	memcpy(iov[0].iov_base, sap, 2);
+	memcpy(iov[1].iov_base, sap + 2, 2);
+	assert(ringbuf_commit(soil, 4) == 4);
+	validate_state(soil, 15, 4);
+	assert(soil->end == 2);
+
+	/* validate zero-copy peek and skip */
+	printf("Validating pointer peek...\n");
+	assert(ringbuf_peek_ptr(soil, 0, 2) == soil->data + 13);
+	assert(ringbuf_peek_ptr(soil, 0, 3) == NULL);
+	assert(ringbuf_peek_ptr(soil, 2, 2) == soil->data);
+	assert(ringbuf_peek_ptr(soil, 2, 3) == NULL);
+	assert(ringbuf_skip(soil, 3) == 3);
+	validate_state(soil, 15, 1);
+	assert(*(char *)ringbuf_peek_ptr(soil, 0, 1) == 'f');
+	assert(ringbuf_skip(soil, 3) == 1);
+	validate_state(soil, 15, 0);
+
+	/* a full buffer has no space to describe */
+	assert(ringbuf_commit(soil, 20) == 15);
+	validate_state(soil, 15, 15);
+	assert(ringbuf_space_iov(soil, iov) == 0);
+
 	printf("Deleting...\n");
 	ringbuf_del(soil);
 
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Slab allocator tests
+ */
+
+#include <zebra.h>
+
+#include "memory.h"
+#include "slab.h"
+
+DEFINE_MGROUP(TEST_SLAB, "slab test");
+DEFINE_MTYPE_STATIC(TEST_SLAB, TEST_SLAB_OBJ, "slab test object");
+
+struct slab_obj {
+	uint64_t cookie;
+	char payload[20];
+};
+
+static struct slab_pool test_pool = SLAB_POOL_INIT("Test objects", MTYPE_TEST_SLAB_OBJ,
+						   struct slab_obj);
+
+#define NOBJS (3 * SLAB_CHUNK_OBJS + 17)
+
+static struct slab_obj *objs[NOBJS + 1];
+
+static int count_pools(void *arg, const struct slab_pool *pool)
+{
+	int *count = arg;
+
+	if (pool == &test_pool)
+		(*count)++;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct slab_obj *obj;
+	uint32_t id, i;
+	int pools = 0;
+
+	/* 1. IDs are dense, start at 1 and map back to their objects */
+	for (i = 1; i <= NOBJS; i++) {
+		obj = slab_alloc(&test_pool, &id);
+		assert(id == i);
+		assert(obj->cookie == 0);
+		obj->cookie = id;
+		objs[id] = obj;
+	}
+	assert(test_pool.n_inuse == NOBJS);
+	assert(test_pool.n_chunks == 4);
+	assert(slab_id_max(&test_pool) == NOBJS + 1);
+
+	for (i = 1; i <= NOBJS; i++) {
+		assert(slab_get(&test_pool, i) == objs[i]);
+		assert(objs[i]->cookie == i);
+	}
+	assert(slab_get(&test_pool, SLAB_ID_NONE) == NULL);
+	assert(slab_get(&test_pool, NOBJS + 1) == NULL);
+
+	/* 2. Freed IDs are recycled before the pool grows, and come back zeroed */
+	slab_free(&test_pool, objs[5], 5);
+	slab_free(&test_pool, objs[SLAB_CHUNK_OBJS + 3], SLAB_CHUNK_OBJS + 3);
+	assert(test_pool.n_inuse == NOBJS - 2);
+
+	obj = slab_alloc(&test_pool, &id);
+	assert(id == SLAB_CHUNK_OBJS + 3 && obj == objs[id]);
+	assert(obj->cookie == 0);
+	obj->cookie = id;
+
+	obj = slab_alloc(&test_pool, &id);
+	assert(id == 5 && obj == objs[id]);
+	assert(obj->cookie == 0);
+	obj->cookie = id;
+
+	assert(test_pool.n_recycled == 2);
+	assert(test_pool.n_max == NOBJS);
+	assert(slab_id_max(&test_pool) == NOBJS + 1);
+
+	/* 3. Pool is visible to the walker until it is torn down */
+	slab_pool_walk(count_pools, &pools);
+	assert(pools == 1);
+
+	for (i = 1; i <= NOBJS; i++)
+		slab_free(&test_pool, objs[i], i);
+	assert(test_pool.n_inuse == 0);
+
+	slab_pool_fini(&test_pool);
+	pools = 0;
+	slab_pool_walk(count_pools, &pools);
+	assert(pools == 0);
+	assert(mtype_stats_alloc(MTYPE_TEST_SLAB_OBJ) == 0);
+
+	/* 4. A finished pool can be used again */
+	obj = slab_alloc(&test_pool, &id);
+	assert(id == 1 && obj);
+	slab_free(&test_pool, obj, id);
+	slab_pool_fini(&test_pool);
+
+	puts("Slab allocator test successful.\n");
+	return 0;
+}
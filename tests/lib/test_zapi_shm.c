@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * ZAPI shared memory ring tests.
+ */
+#include <zebra.h>
+#include <poll.h>
+
+#include "memory.h"
+#include "log.h"
+#include "zapi_shm.h"
+
+#define TEST_BYTES 300000
+
+static bool signalled(int fd)
+{
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+	if (poll(&pfd, 1, 0) != 1)
+		return false;
+	zapi_shm_event_clear(fd);
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	struct zapi_shm *prod, *cons;
+	int sv[2], pipefds[2], fds[ZAPI_SHM_FD_MAX], nfds;
+	uint8_t *out, *in, buf[7000];
+	struct iovec iov[2];
+	size_t written = 0, got = 0, i;
+	ssize_t nb;
+
+	prod = zapi_shm_create(ZAPI_SHM_SIZE_MIN);
+	if (!prod) {
+		printf("No shared memory ring here: %s\n", safe_strerror(errno));
+		return 0;
+	}
+
+	printf("Validating size checks...\n");
+	assert(zapi_shm_create(ZAPI_SHM_SIZE_MIN + 1) == NULL);
+	assert(zapi_shm_create(ZAPI_SHM_SIZE_MAX * 2) == NULL);
+
+	printf("Validating descriptor passing...\n");
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+	assert(zapi_shm_sendmsg(sv[0], "hello", 5, prod->fds) == 5);
+	iov[0].iov_base = buf;
+	iov[0].iov_len = sizeof(buf);
+	assert(zapi_shm_recvmsg(sv[1], iov, 1, fds, &nfds) == 5);
+	assert(nfds == ZAPI_SHM_FD_MAX);
+	assert(!memcmp(buf, "hello", 5));
+
+	cons = zapi_shm_attach(fds);
+	assert(cons);
+	assert(cons->size == ZAPI_SHM_SIZE_MIN);
+
+	printf("Validating empty ring...\n");
+	assert(zapi_shm_read(cons, iov, 1) == 0);
+	assert(zapi_shm_data_wait(cons));
+	assert(zapi_shm_write(prod, "x", 1) == 1);
+	assert(signalled(cons->fds[ZAPI_SHM_FD_DATA]));
+	assert(zapi_shm_read(cons, iov, 1) == 1 && buf[0] == 'x');
+	assert(!signalled(cons->fds[ZAPI_SHM_FD_DATA]));
+
+	printf("Validating streaming through a full ring...\n");
+	out = XMALLOC(MTYPE_TMP, TEST_BYTES);
+	in = XMALLOC(MTYPE_TMP, TEST_BYTES);
+	for (i = 0; i < TEST_BYTES; i++)
+		out[i] = i * 7 + i / 251;
+
+	while (got < TEST_BYTES) {
+		written += zapi_shm_write(prod, out + written,
+					  TEST_BYTES - written);
+		if (written < TEST_BYTES)
+			assert(zapi_shm_space_wait(prod));
+
+		/* split reads, so that some of them wrap */
+		iov[0].iov_base = buf;
+		iov[0].iov_len = 4000;
+		iov[1].iov_base = buf + 4000;
+		iov[1].iov_len = sizeof(buf) - 4000;
+		nb = zapi_shm_read(cons, iov, 2);
+		assert(nb > 0);
+		memcpy(in + got, buf, nb);
+		got += nb;
+
+		if (written < TEST_BYTES)
+			assert(signalled(prod->fds[ZAPI_SHM_FD_SPACE]));
+	}
+	assert(written == TEST_BYTES);
+	assert(!memcmp(in, out, TEST_BYTES));
+
+	printf("Validating corrupt ring...\n");
+	atomic_store_explicit(&prod->ring->head, cons->pos + 2 * cons->size,
+			      memory_order_relaxed);
+	assert(zapi_shm_read(cons, iov, 1) == -1);
+
+	printf("Validating refused ring...\n");
+	prod->ring->magic = 0;
+	assert(zapi_shm_sendmsg(sv[0], "x", 1, prod->fds) == 1);
+	iov[0].iov_len = 1;
+	assert(zapi_shm_recvmsg(sv[1], iov, 1, fds, &nfds) == 1);
+	assert(nfds == ZAPI_SHM_FD_MAX);
+	assert(zapi_shm_attach(fds) == NULL);
+
+	printf("Validating refused event descriptors...\n");
+	prod->ring->magic = ZAPI_SHM_MAGIC;
+	memcpy(fds, prod->fds, sizeof(fds));
+	assert(pipe(pipefds) == 0);
+	fds[ZAPI_SHM_FD_DATA] = pipefds[0];
+	assert(zapi_shm_sendmsg(sv[0], "x", 1, fds) == 1);
+	assert(zapi_shm_recvmsg(sv[1], iov, 1, fds, &nfds) == 1);
+	assert(nfds == ZAPI_SHM_FD_MAX);
+	assert(zapi_shm_attach(fds) == NULL);
+	close(pipefds[0]);
+	close(pipefds[1]);
+
+	printf("Deleting...\n");
+	zapi_shm_free(&cons);
+	zapi_shm_free(&prod);
+	assert(!cons && !prod);
+	XFREE(MTYPE_TMP, out);
+	XFREE(MTYPE_TMP, in);
+	close(sv[0]);
+	close(sv[1]);
+
+	printf("Done.\n");
+	return 0;
+}
@@ -0,0 +1,9 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+import frrtest
+
+
+class TestZapiShm(frrtest.TestMultiOut):
+    program = "./test_zapi_shm"
+
+
+TestZapiShm.exit_cleanly()
@@ -0,0 +1,368 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Benchmark for pipelined netlink batches
+ *
+ * Drives the kernel dplane's own batching code in zebra/kernel_netlink.c:
+ * kernel_update_multi() with a list of blackhole route installs or deletes,
+ * first with the pipeline off and then at the given depth, the same as the
+ * hidden "zebra kernel netlink batch-pipeline" command sets it.  Only the
+ * dplane contexts and the route encoder are stand-ins, the batching, sending
+ * and reaping of responses are the real thing.  Every context must come back
+ * in order and, except in the stand-in below, successfully.
+ *
+ * Runs in a private network namespace (a user namespace is created for it
+ * when not running as root).  Where none can be had, falls back to deleting
+ * routes that do not exist from an unused table, which leaves the system
+ * alone and still gets every request answered, with an error that the
+ * command socket would ignore.  Not run as part of the test suite; invoke it
+ * manually, optionally passing the number of routes and the pipeline depth.
+ */
+
+#include <zebra.h>
+
+#include <sched.h>
+
+#include "zebra/kernel_netlink.c"
+
+#include "monotime.h"
+
+#define PERF_ROUTES 200000
+#define PERF_DEPTH  8
+
+/* Table the stand-in deletes from, never used by anything */
+#define PERF_STANDIN_TABLE 0x7ffffff0
+
+/* What kernel_netlink.c needs from the rest of zebra */
+DEFINE_MGROUP(ZEBRA, "zebra");
+
+struct zebra_privs_t zserv_privs = {};
+struct zebra_router zrouter = {};
+unsigned long zebra_debug_kernel;
+uint32_t rcvbufsize = 4 * 1024 * 1024;
+
+/* Just enough of a dplane context for the batching code */
+struct zebra_dplane_ctx {
+	enum dplane_op_e zd_op;
+	enum zebra_dplane_result zd_status;
+	struct zebra_dplane_info zd_ns_info;
+	uint32_t dst;
+
+	struct dplane_ctx_list_item zd_entries;
+};
+
+DECLARE_DLIST(dplane_ctx_list, struct zebra_dplane_ctx, zd_entries);
+
+static struct nlsock perf_nl = { .sock = -1, .name = "netlink-dp (perf)" };
+static bool standin;
+static int failed;
+
+void dplane_ctx_q_init(struct dplane_ctx_list_head *q)
+{
+	dplane_ctx_list_init(q);
+}
+
+void dplane_ctx_enqueue_tail(struct dplane_ctx_list_head *q,
+			     const struct zebra_dplane_ctx *ctx)
+{
+	dplane_ctx_list_add_tail(q, (struct zebra_dplane_ctx *)ctx);
+}
+
+void dplane_ctx_list_append(struct dplane_ctx_list_head *to_list,
+			    struct dplane_ctx_list_head *from_list)
+{
+	struct zebra_dplane_ctx *ctx;
+
+	while ((ctx = dplane_ctx_list_pop(from_list)) != NULL)
+		dplane_ctx_list_add_tail(to_list, ctx);
+}
+
+struct zebra_dplane_ctx *dplane_ctx_get_head(struct dplane_ctx_list_head *q)
+{
+	return dplane_ctx_list_first(q);
+}
+
+struct zebra_dplane_ctx *dplane_ctx_dequeue(struct dplane_ctx_list_head *q)
+{
+	return dplane_ctx_list_pop(q);
+}
+
+uint32_t dplane_ctx_queue_count(struct dplane_ctx_list_head *q)
+{
+	return dplane_ctx_list_count(q);
+}
+
+const struct zebra_dplane_info *
+dplane_ctx_get_ns(const struct zebra_dplane_ctx *ctx)
+{
+	return &ctx->zd_ns_info;
+}
+
+int dplane_ctx_get_ns_sock(const struct zebra_dplane_ctx *ctx)
+{
+	return ctx->zd_ns_info.sock;
+}
+
+void dplane_ctx_set_ns_sock(struct zebra_dplane_ctx *ctx, int sock)
+{
+	ctx->zd_ns_info.sock = sock;
+}
+
+enum dplane_op_e dplane_ctx_get_op(const struct zebra_dplane_ctx *ctx)
+{
+	return ctx->zd_op;
+}
+
+bool dplane_ctx_is_update(const struct zebra_dplane_ctx *ctx)
+{
+	return false;
+}
+
+void dplane_ctx_set_status(struct zebra_dplane_ctx *ctx,
+			   enum zebra_dplane_result status)
+{
+	ctx->zd_status = status;
+}
+
+uint32_t dplane_get_kernel_workers(void)
+{
+	return 0;
+}
+
+uint32_t zebra_router_get_next_sequence(void)
+{
+	return ++perf_nl.seq;
+}
+
+/* A blackhole route, the smallest message a route install can be */
+static ssize_t perf_route_encode(struct zebra_dplane_ctx *ctx, void *buf,
+				 size_t buflen)
+{
+	struct {
+		struct nlmsghdr n;
+		struct rtmsg r;
+		char buf[0];
+	} *req = buf;
+	uint32_t table = standin ? PERF_STANDIN_TABLE : RT_TABLE_MAIN;
+	bool add = ctx->zd_op == DPLANE_OP_ROUTE_INSTALL;
+
+	if (buflen < sizeof(*req))
+		return 0;
+
+	memset(req, 0, sizeof(*req));
+	req->n.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+	req->n.nlmsg_type = add ? RTM_NEWROUTE : RTM_DELROUTE;
+	req->n.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+	if (add)
+		req->n.nlmsg_flags |= NLM_F_CREATE | NLM_F_REPLACE;
+
+	req->r.rtm_family = AF_INET;
+	req->r.rtm_dst_len = 32;
+	req->r.rtm_table = RT_TABLE_UNSPEC;
+	req->r.rtm_protocol = RTPROT_STATIC;
+	req->r.rtm_scope = RT_SCOPE_UNIVERSE;
+	req->r.rtm_type = RTN_BLACKHOLE;
+
+	if (!nl_attr_put32(&req->n, buflen, RTA_DST, ctx->dst) ||
+	    !nl_attr_put32(&req->n, buflen, RTA_TABLE, table))
+		return 0;
+
+	return NLMSG_ALIGN(req->n.nlmsg_len);
+}
+
+enum netlink_msg_status
+netlink_put_route_update_msg(struct nl_batch *bth, struct zebra_dplane_ctx *ctx)
+{
+	return netlink_batch_add_msg(bth, ctx, perf_route_encode, false);
+}
+
+/* Nothing but routes in here */
+#define PERF_NO_PUT(name)                                                     \
+	enum netlink_msg_status name(struct nl_batch *bth,                     \
+				     struct zebra_dplane_ctx *ctx)             \
+	{                                                                      \
+		return FRR_NETLINK_ERROR;                                      \
+	}
+
+PERF_NO_PUT(netlink_put_nexthop_update_msg)
+PERF_NO_PUT(netlink_put_lsp_update_msg)
+PERF_NO_PUT(netlink_put_pw_update_msg)
+PERF_NO_PUT(netlink_put_address_update_msg)
+PERF_NO_PUT(netlink_put_mac_update_msg)
+PERF_NO_PUT(netlink_put_neigh_update_msg)
+PERF_NO_PUT(netlink_put_rule_update_msg)
+PERF_NO_PUT(netlink_put_gre_set_msg)
+PERF_NO_PUT(netlink_put_intf_netconfig)
+PERF_NO_PUT(netlink_put_intf_update_msg)
+PERF_NO_PUT(netlink_put_tc_qdisc_update_msg)
+PERF_NO_PUT(netlink_put_tc_class_update_msg)
+PERF_NO_PUT(netlink_put_tc_filter_update_msg)
+PERF_NO_PUT(netlink_put_sr_tunsrc_set_msg)
+
+/* Nor are there any kernel notifications to dispatch */
+#define PERF_NO_CHANGE(name)                                                   \
+	int name(struct nlmsghdr *h, ns_id_t ns_id, int startup)               \
+	{                                                                      \
+		return 0;                                                      \
+	}
+
+PERF_NO_CHANGE(netlink_route_change)
+PERF_NO_CHANGE(netlink_link_change)
+PERF_NO_CHANGE(netlink_interface_addr_dplane)
+PERF_NO_CHANGE(netlink_rule_change)
+PERF_NO_CHANGE(netlink_nexthop_change)
+PERF_NO_CHANGE(netlink_netconf_change)
+PERF_NO_CHANGE(netlink_qdisc_change)
+PERF_NO_CHANGE(netlink_tclass_change)
+PERF_NO_CHANGE(netlink_tfilter_change)
+PERF_NO_CHANGE(netlink_vlan_change)
+
+int netlink_neigh_change(struct nlmsghdr *h, ns_id_t ns_id)
+{
+	return 0;
+}
+
+void rt_netlink_init(void)
+{
+}
+
+void ge_netlink_init(struct zebra_ns *zns)
+{
+}
+
+/* The dplane's outbound socket, set up the way kernel_init() does */
+static int perf_nlsock_open(struct nlsock *nl)
+{
+	socklen_t namelen = sizeof(nl->snl);
+	int one = 1;
+
+	nl->sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+	if (nl->sock < 0)
+		return -1;
+
+	nl->snl.nl_family = AF_NETLINK;
+	if (bind(nl->sock, (struct sockaddr *)&nl->snl, sizeof(nl->snl)) < 0 ||
+	    getsockname(nl->sock, (struct sockaddr *)&nl->snl, &namelen) < 0) {
+		close(nl->sock);
+		nl->sock = -1;
+		return -1;
+	}
+
+	nl->buflen = NL_RCV_PKT_BUF_SIZE;
+	nl->buf = XMALLOC(MTYPE_NL_BUF, nl->buflen);
+
+	netlink_recvbuf(nl, rcvbufsize);
+#if defined SOL_NETLINK
+	setsockopt(nl->sock, SOL_NETLINK, NETLINK_EXT_ACK, &one, sizeof(one));
+	setsockopt(nl->sock, SOL_NETLINK, NETLINK_CAP_ACK, &one, sizeof(one));
+#endif
+	if (fcntl(nl->sock, F_SETFL, O_NONBLOCK) < 0)
+		return -1;
+
+	kernel_netlink_nlsock_insert(nl);
+	return 0;
+}
+
+static void perf_run(struct zebra_dplane_ctx *ctxs, unsigned long n, bool add,
+		     uint32_t depth)
+{
+	struct dplane_ctx_list_head ctx_list;
+	struct zebra_dplane_ctx *ctx;
+	unsigned long i, errors = 0;
+	struct timeval start;
+	int64_t usec;
+
+	netlink_set_batch_pipeline_depth(depth, true);
+
+	dplane_ctx_q_init(&ctx_list);
+	for (i = 0; i < n; i++) {
+		ctx = &ctxs[i];
+		memset(ctx, 0, sizeof(*ctx));
+		ctx->zd_op = add ? DPLANE_OP_ROUTE_INSTALL
+				 : DPLANE_OP_ROUTE_DELETE;
+		ctx->zd_ns_info.ns_id = NS_DEFAULT;
+		ctx->zd_ns_info.sock = perf_nl.sock;
+		ctx->zd_ns_info.seq = zebra_router_get_next_sequence();
+		/* the stand-in's missing routes are expected, as on cmd */
+		ctx->zd_ns_info.is_cmd = standin;
+		ctx->dst = htonl(0x0a000000 | i);
+		dplane_ctx_enqueue_tail(&ctx_list, ctx);
+	}
+
+	monotime(&start);
+	kernel_update_multi(&ctx_list);
+	usec = monotime_since(&start, NULL);
+
+	for (i = 0; (ctx = dplane_ctx_dequeue(&ctx_list)) != NULL; i++) {
+		if (ctx != &ctxs[i]) {
+			printf("context %lu handed back out of order\n", i);
+			failed++;
+			break;
+		}
+		if (ctx->zd_status != ZEBRA_DPLANE_REQUEST_SUCCESS)
+			errors++;
+	}
+
+	printf("%-6s depth %2u %8lu routes %9" PRId64 " us %7.1f ns/route\n",
+	       add ? "add" : "delete", depth, n, usec,
+	       n ? usec * 1000.0 / n : 0.0);
+
+	if (i != n) {
+		printf("%lu of %lu contexts handed back\n", i, n);
+		failed++;
+	}
+	/* the stand-in may not even be allowed to look for its routes */
+	if (errors) {
+		printf("%lu requests failed\n", errors);
+		if (!standin)
+			failed++;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long n = PERF_ROUTES;
+	uint32_t depth = PERF_DEPTH;
+	struct zebra_dplane_ctx *ctxs;
+
+	if (argc > 1)
+		n = strtoul(argv[1], NULL, 10);
+	if (argc > 2)
+		depth = strtoul(argv[2], NULL, 10);
+	if (!n || n > 0xffffff || depth < 1 || depth > 64)
+		return 1;
+
+	if (unshare(CLONE_NEWNET) < 0 &&
+	    unshare(CLONE_NEWUSER | CLONE_NEWNET) < 0) {
+		printf("no private network namespace (%s), deleting missing routes instead\n",
+		       safe_strerror(errno));
+		standin = true;
+	}
+
+	zprivs_preinit(&zserv_privs);
+	zprivs_init(&zserv_privs);
+	kernel_router_init();
+
+	if (perf_nlsock_open(&perf_nl) < 0) {
+		printf("netlink socket: %s\n", safe_strerror(errno));
+		return 1;
+	}
+
+	ctxs = XCALLOC(MTYPE_TMP, n * sizeof(*ctxs));
+
+	/* the stand-in must not add anything to the system's tables */
+	if (!standin)
+		perf_run(ctxs, n, true, 1);
+	perf_run(ctxs, n, false, 1);
+	if (!standin)
+		perf_run(ctxs, n, true, depth);
+	perf_run(ctxs, n, false, depth);
+
+	XFREE(MTYPE_TMP, ctxs);
+	kernel_nlsock_fini(&perf_nl);
+	kernel_router_terminate();
+
+	if (failed)
+		return 1;
+	printf("Netlink pipeline benchmark successful.\n");
+	return 0;
+}
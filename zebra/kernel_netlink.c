@@ -72,6 +72,27 @@
  */
 #define NL_DEFAULT_BATCH_SEND_THRESHOLD (15 * NL_PKT_BUF_SIZE)
 
+/*
+ * Number of batches that may be sent before their responses are read back.
+ * With 1, every batch is sent and then all of its responses are read, one
+ * recvmsg() each, before the next batch gets built.
+ */
+#define NL_DEFAULT_BATCH_PIPELINE_DEPTH 1
+
+/*
+ * Responses of pipelined batches are read NL_REAP_VLEN at a time with
+ * recvmmsg(). ACKs are tiny, errors are capped to the failed message's
+ * header; anything bigger is truncated and only its error code is used.
+ */
+#define NL_REAP_VLEN    32
+#define NL_REAP_BUFSIZE 4096
+
+/*
+ * Rough socket receive buffer cost of a queued ACK, used to keep the
+ * responses of the batches in flight from overrunning the receive buffer.
+ */
+#define NL_REAP_ACK_TRUESIZE 1024
+
 static const struct message nlmsg_str[] = {
 	{ RTM_NEWROUTE, "RTM_NEWROUTE" },
 	{ RTM_DELROUTE, "RTM_DELROUTE" },
@@ -174,11 +195,23 @@ pthread_mutex_t nlsock_mutex;
 #define NLSOCK_LOCK() pthread_mutex_lock(&nlsock_mutex)
 #define NLSOCK_UNLOCK() pthread_mutex_unlock(&nlsock_mutex)
 
-size_t nl_batch_tx_bufsize;
-char *nl_batch_tx_buf;
+/*
+ * Batch transmit buffers: the first one is used by the dplane pthread, then
+ * one per kernel dplane worker.
+ */
+struct nl_batch_txbuf {
+	char *buf;
+	size_t size;
+
+	/* Receive vector for the responses of pipelined batches */
+	char *rxbuf;
+};
+
+static struct nl_batch_txbuf *nl_batch_txbufs;
 
 _Atomic uint32_t nl_batch_bufsize = NL_DEFAULT_BATCH_BUFSIZE;
 _Atomic uint32_t nl_batch_send_threshold = NL_DEFAULT_BATCH_SEND_THRESHOLD;
+_Atomic uint32_t nl_batch_pipeline_depth = NL_DEFAULT_BATCH_PIPELINE_DEPTH;
 
 struct nl_batch {
 	void *buf;
@@ -198,6 +231,19 @@ struct nl_batch {
 	 * towards the dataplane module.
 	 */
 	struct dplane_ctx_list_head *ctx_out_q;
+
+	/*
+	 * Pipelined mode: contexts of the batches sent but whose responses
+	 * have not been read yet, all of them on the same socket.
+	 */
+	uint32_t depth;
+	struct nl_batch_txbuf *txbuf;
+	struct dplane_ctx_list_head inflight;
+	struct nlsock *inflight_nl;
+	const struct zebra_dplane_info *inflight_zns;
+	uint32_t inflight_batches;
+	size_t inflight_msgs;
+	size_t inflight_max;
 };
 
 int netlink_config_write_helper(struct vty *vty)
@@ -207,11 +253,17 @@ int netlink_config_write_helper(struct vty *vty)
 	uint32_t threshold = atomic_load_explicit(&nl_batch_send_threshold,
 						  memory_order_relaxed);
 
+	uint32_t depth = atomic_load_explicit(&nl_batch_pipeline_depth,
+					      memory_order_relaxed);
+
 	if (size != NL_DEFAULT_BATCH_BUFSIZE
 	    || threshold != NL_DEFAULT_BATCH_SEND_THRESHOLD)
 		vty_out(vty, "zebra kernel netlink batch-tx-buf %u %u\n", size,
 			threshold);
 
+	if (depth != NL_DEFAULT_BATCH_PIPELINE_DEPTH)
+		vty_out(vty, "zebra kernel netlink batch-pipeline %u\n", depth);
+
 	if (if_netlink_frr_protodown_r_bit_is_set())
 		vty_out(vty, "zebra protodown reason-bit %u\n",
 			if_netlink_get_frr_protodown_r_bit());
@@ -231,6 +283,15 @@ void netlink_set_batch_buffer_size(uint32_t size, uint32_t threshold, bool set)
 			      memory_order_relaxed);
 }
 
+void netlink_set_batch_pipeline_depth(uint32_t depth, bool set)
+{
+	if (!set || depth == 0)
+		depth = NL_DEFAULT_BATCH_PIPELINE_DEPTH;
+
+	atomic_store_explicit(&nl_batch_pipeline_depth, depth,
+			      memory_order_relaxed);
+}
+
 int netlink_talk_filter(struct nlmsghdr *h, ns_id_t ns_id, int startup)
 {
 	/*
@@ -534,79 +595,95 @@ int kernel_dplane_read(struct zebra_dplane_info *info)
  * so that we only have to write one way to handle incoming
  * address add/delete and xxxNETCONF changes.
  */
-static void netlink_install_filter(int sock, uint32_t pid, uint32_t dplane_pid)
+static void netlink_install_filter(int sock, uint32_t pid,
+				   const struct nlsock *dplane)
 {
+	/*
+	 * Our own sockets: the command one, the dplane one and those of any
+	 * kernel dplane workers.
+	 */
+	uint32_t i, npids = 2 + dplane->n_workers;
+	uint32_t pids[npids];
+
 	/*
 	 * BPF_JUMP instructions and where you jump to are based upon
 	 * 0 as being the next statement.  So count from 0.  Writing
 	 * this down because every time I look at this I have to
 	 * re-remember it.
 	 */
-	struct sock_filter filter[] = {
+	struct sock_filter filter[1 + npids + 7];
+	struct sock_filter tail[] = {
 		/*
-		 * Logic:
-		 *   if (nlmsg_pid == pid ||
-		 *       nlmsg_pid == dplane_pid) {
-		 *       if (the incoming nlmsg_type ==
-		 *           RTM_NEWADDR || RTM_DELADDR || RTM_NEWNETCONF ||
-		 *           RTM_DELNETCONF)
-		 *           keep this message
-		 *       else
-		 *           skip this message
-		 *   } else
-		 *       keep this netlink message
-		 */
-		/*
-		 * 0: Load the nlmsg_pid into the BPF register
-		 */
-		BPF_STMT(BPF_LD | BPF_ABS | BPF_W,
-			 offsetof(struct nlmsghdr, nlmsg_pid)),
-		/*
-		 * 1: Compare to pid
-		 */
-		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htonl(pid), 1, 0),
-		/*
-		 * 2: Compare to dplane pid
-		 */
-		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htonl(dplane_pid), 0, 6),
-		/*
-		 * 3: Load the nlmsg_type into BPF register
+		 * npids + 1: Load the nlmsg_type into BPF register
 		 */
 		BPF_STMT(BPF_LD | BPF_ABS | BPF_H,
 			 offsetof(struct nlmsghdr, nlmsg_type)),
 		/*
-		 * 4: Compare to RTM_NEWADDR
+		 * npids + 2: Compare to RTM_NEWADDR
 		 */
 		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htons(RTM_NEWADDR), 4, 0),
 		/*
-		 * 5: Compare to RTM_DELADDR
+		 * npids + 3: Compare to RTM_DELADDR
 		 */
 		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htons(RTM_DELADDR), 3, 0),
 		/*
-		 * 6: Compare to RTM_NEWNETCONF
+		 * npids + 4: Compare to RTM_NEWNETCONF
 		 */
 		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htons(RTM_NEWNETCONF), 2,
 			 0),
 		/*
-		 * 7: Compare to RTM_DELNETCONF
+		 * npids + 5: Compare to RTM_DELNETCONF
 		 */
 		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htons(RTM_DELNETCONF), 1,
 			 0),
 		/*
-		 * 8: This is the end state of we want to skip the
+		 * npids + 6: This is the end state of we want to skip the
 		 *    message
 		 */
 		BPF_STMT(BPF_RET | BPF_K, 0),
-		/* 9: This is the end state of we want to keep
+		/* npids + 7: This is the end state of we want to keep
 		 *     the message
 		 */
 		BPF_STMT(BPF_RET | BPF_K, 0xffff),
 	};
-
 	struct sock_fprog prog = {
 		.len = array_size(filter), .filter = filter,
 	};
 
+	/*
+	 * Logic:
+	 *   if (nlmsg_pid == pid ||
+	 *       nlmsg_pid == dplane_pid ||
+	 *       nlmsg_pid == any worker pid) {
+	 *       if (the incoming nlmsg_type ==
+	 *           RTM_NEWADDR || RTM_DELADDR || RTM_NEWNETCONF ||
+	 *           RTM_DELNETCONF)
+	 *           keep this message
+	 *       else
+	 *           skip this message
+	 *   } else
+	 *       keep this netlink message
+	 */
+	pids[0] = pid;
+	pids[1] = dplane->snl.nl_pid;
+	for (i = 0; i < dplane->n_workers; i++)
+		pids[2 + i] = dplane->workers[i].snl.nl_pid;
+
+	/*
+	 * 0: Load the nlmsg_pid into the BPF register
+	 */
+	filter[0] = (struct sock_filter)BPF_STMT(BPF_LD | BPF_ABS | BPF_W,
+						 offsetof(struct nlmsghdr, nlmsg_pid));
+	/*
+	 * 1 .. npids: Compare to each of our pids, on a match go check the
+	 * type; if none matched, keep the message.
+	 */
+	for (i = 0; i < npids; i++)
+		filter[1 + i] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,
+							     htonl(pids[i]), npids - i - 1,
+							     i == npids - 1 ? 6 : 0);
+	memcpy(&filter[1 + npids], tail, sizeof(tail));
+
 	if (setsockopt(sock, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog))
 	    < 0)
 		flog_err_sys(EC_LIB_SOCKET, "Can't install socket filter: %s",
@@ -1132,14 +1209,134 @@ int netlink_request(struct nlsock *nl, void *req)
 	return 0;
 }
 
+/*
+ * Match a response to the context it belongs to, taking the contexts
+ * answered in the meantime (i.e. successfully, the kernel only responds
+ * with errors or ACKs) off 'pending' and onto the outbound queue.
+ */
+static void nl_batch_handle_resp(struct nl_batch *bth, struct nlsock *nl,
+				 const struct zebra_dplane_info *zns,
+				 struct dplane_ctx_list_head *pending,
+				 struct nlmsghdr *h)
+{
+	struct zebra_dplane_ctx *ctx;
+	int seq = h->nlmsg_seq;
+
+	/*
+	 * Find the corresponding context object. Received responses are
+	 * in the same order as requests we sent, so we can simply
+	 * iterate over the context list and match responses with
+	 * requests at same time.
+	 */
+	while (true) {
+		ctx = dplane_ctx_get_head(pending);
+		if (ctx == NULL) {
+			/*
+			 * This is a situation where we have gotten
+			 * into a bad spot.  We need to know that
+			 * this happens( does it? )
+			 */
+			flog_err(EC_ZEBRA_NETLINK_NO_CONTEXT,
+				 "%s:WARNING Received netlink Response for an error and no Contexts to associate with it",
+				 __func__);
+			break;
+		}
+
+		/*
+		 * 'update' context objects take two consecutive
+		 * sequence numbers.
+		 */
+		if (dplane_ctx_is_update(ctx) &&
+		    dplane_ctx_get_ns(ctx)->seq + 1 == seq) {
+			/*
+			 * This is the situation where we get a response
+			 * to a message that should be ignored.
+			 *
+			 * We should still fricking decode the
+			 * message for our operator to understand
+			 * what is going on
+			 */
+			int err = netlink_parse_error(nl, h, zns->is_cmd,
+						      false);
+
+			zlog_debug("%s: netlink error message seq=%d %d",
+				   __func__, h->nlmsg_seq, err);
+			return;
+		}
+
+		ctx = dplane_ctx_dequeue(pending);
+		dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
+
+		/* We have found corresponding context object. */
+		if (dplane_ctx_get_ns(ctx)->seq == seq)
+			break;
+
+		if (dplane_ctx_get_ns(ctx)->seq > seq)
+			zlog_warn(
+				"%s:WARNING Received %u is less than any context on the queue ctx->seq %u",
+				__func__, seq,
+				dplane_ctx_get_ns(ctx)->seq);
+	}
+
+	/*
+	 * We received a message with the sequence number that isn't
+	 * associated with any dplane context object.
+	 */
+	if (ctx == NULL) {
+		if (IS_ZEBRA_DEBUG_KERNEL)
+			zlog_debug(
+				"%s: skipping unassociated response, seq number %d NS %u",
+				__func__, h->nlmsg_seq, zns->ns_id);
+		return;
+	}
+
+	if (h->nlmsg_type == NLMSG_ERROR) {
+		int err = netlink_parse_error(nl, h, zns->is_cmd, false);
+
+		if (err == -1)
+			dplane_ctx_set_status(ctx,
+					      ZEBRA_DPLANE_REQUEST_FAILURE);
+
+		if (IS_ZEBRA_DEBUG_KERNEL)
+			zlog_debug("%s: netlink error message seq=%d ",
+				   __func__, h->nlmsg_seq);
+		return;
+	}
+
+	/*
+	 * If we get here then we did not receive neither the ack nor
+	 * the error and instead received some other message in an
+	 * unexpected way.
+	 */
+	if (IS_ZEBRA_DEBUG_KERNEL)
+		zlog_debug("%s: ignoring message type 0x%04x(%s) NS %u",
+			   __func__, h->nlmsg_type,
+			   nl_msg_type_to_str(h->nlmsg_type), zns->ns_id);
+}
+
+/*
+ * Contexts still pending once all responses have been read went through
+ * fine, unless reading failed altogether and we cannot tell.
+ */
+static void nl_batch_flush_pending(struct nl_batch *bth,
+				   struct dplane_ctx_list_head *pending,
+				   bool failed)
+{
+	struct zebra_dplane_ctx *ctx;
+
+	while ((ctx = dplane_ctx_dequeue(pending)) != NULL) {
+		if (failed)
+			dplane_ctx_set_status(ctx,
+					      ZEBRA_DPLANE_REQUEST_FAILURE);
+		dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
+	}
+}
+
 static int nl_batch_read_resp(struct nl_batch *bth, struct nlsock *nl)
 {
-	struct nlmsghdr *h;
 	struct sockaddr_nl snl;
 	struct msghdr msg = {};
-	int status, seq;
-	struct zebra_dplane_ctx *ctx;
-	bool ignore_msg;
+	int status;
 
 	msg.msg_name = (void *)&snl;
 	msg.msg_namelen = sizeof(snl);
@@ -1159,123 +1356,143 @@ static int nl_batch_read_resp(struct nl_batch *bth, struct nlsock *nl)
 		 *
 		 */
 		if (status == -1 || status == 0) {
-			while ((ctx = dplane_ctx_dequeue(&(bth->ctx_list))) !=
-			       NULL) {
-				if (status == -1)
-					dplane_ctx_set_status(
-						ctx,
-						ZEBRA_DPLANE_REQUEST_FAILURE);
-				dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
-			}
+			nl_batch_flush_pending(bth, &bth->ctx_list,
+					       status == -1);
 			return status;
 		}
 
-		h = (struct nlmsghdr *)nl->buf;
-		ignore_msg = false;
-		seq = h->nlmsg_seq;
-		/*
-		 * Find the corresponding context object. Received responses are
-		 * in the same order as requests we sent, so we can simply
-		 * iterate over the context list and match responses with
-		 * requests at same time.
-		 */
-		while (true) {
-			ctx = dplane_ctx_get_head(&(bth->ctx_list));
-			if (ctx == NULL) {
-				/*
-				 * This is a situation where we have gotten
-				 * into a bad spot.  We need to know that
-				 * this happens( does it? )
-				 */
-				flog_err(EC_ZEBRA_NETLINK_NO_CONTEXT,
-					 "%s:WARNING Received netlink Response for an error and no Contexts to associate with it",
-					 __func__);
-				break;
-			}
+		nl_batch_handle_resp(bth, nl, bth->zns, &bth->ctx_list,
+				     (struct nlmsghdr *)nl->buf);
+	}
 
-			/*
-			 * 'update' context objects take two consecutive
-			 * sequence numbers.
-			 */
-			if (dplane_ctx_is_update(ctx) &&
-			    dplane_ctx_get_ns(ctx)->seq + 1 == seq) {
-				/*
-				 * This is the situation where we get a response
-				 * to a message that should be ignored.
-				 */
-				ignore_msg = true;
-				break;
-			}
+	return 0;
+}
 
-			ctx = dplane_ctx_dequeue(&(bth->ctx_list));
-			dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
+/*
+ * Read up to NL_REAP_VLEN responses in one go. Returns the number of
+ * responses read, 0 once there are none left, -1 on failure.
+ */
+static int netlink_recv_msgs(struct nlsock *nl, struct nl_batch_txbuf *txbuf,
+			     struct mmsghdr *msgs)
+{
+	struct sockaddr_nl snl[NL_REAP_VLEN];
+	struct iovec iov[NL_REAP_VLEN];
+	int i, n;
+
+	if (!txbuf->rxbuf)
+		txbuf->rxbuf = XMALLOC(MTYPE_NL_BUF,
+				       NL_REAP_VLEN * NL_REAP_BUFSIZE);
+
+	memset(msgs, 0, NL_REAP_VLEN * sizeof(*msgs));
+	for (i = 0; i < NL_REAP_VLEN; i++) {
+		iov[i].iov_base = txbuf->rxbuf + i * NL_REAP_BUFSIZE;
+		iov[i].iov_len = NL_REAP_BUFSIZE;
+		msgs[i].msg_hdr.msg_name = &snl[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(snl[i]);
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
 
-			/* We have found corresponding context object. */
-			if (dplane_ctx_get_ns(ctx)->seq == seq)
-				break;
+	do {
+		n = recvmmsg(nl->sock, msgs, NL_REAP_VLEN, MSG_DONTWAIT, NULL);
+	} while (n == -1 && errno == EINTR);
 
-			if (dplane_ctx_get_ns(ctx)->seq > seq)
-				zlog_warn(
-					"%s:WARNING Received %u is less than any context on the queue ctx->seq %u",
-					__func__, seq,
-					dplane_ctx_get_ns(ctx)->seq);
-		}
+	if (n == -1) {
+		if (errno == EWOULDBLOCK || errno == EAGAIN)
+			return 0;
+		flog_err(EC_ZEBRA_RECVMSG_OVERRUN, "%s recvmmsg overrun: %s",
+			 nl->name, safe_strerror(errno));
+		/* Same as netlink_recv_msg(), we cannot recover from this */
+		frr_exit_with_buffer_flush(-1);
+	}
 
-		if (ignore_msg) {
-			/*
-			 * If we ignore the message due to an update
-			 * above we should still fricking decode the
-			 * message for our operator to understand
-			 * what is going on
-			 */
-			int err = netlink_parse_error(nl, h, bth->zns->is_cmd,
-						      false);
+	for (i = 0; i < n; i++) {
+		struct nlmsghdr *h = msgs[i].msg_hdr.msg_iov->iov_base;
 
-			zlog_debug("%s: netlink error message seq=%d %d",
-				   __func__, h->nlmsg_seq, err);
-			continue;
+		if (msgs[i].msg_len < sizeof(struct nlmsghdr)) {
+			flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
+				 "%s short response: length %u", nl->name,
+				 msgs[i].msg_len);
+			return -1;
 		}
 
 		/*
-		 * We received a message with the sequence number that isn't
-		 * associated with any dplane context object.
+		 * Only an error carrying the whole failed message can get
+		 * here, keep the error code and drop the rest.
 		 */
-		if (ctx == NULL) {
-			if (IS_ZEBRA_DEBUG_KERNEL)
-				zlog_debug(
-					"%s: skipping unassociated response, seq number %d NS %u",
-					__func__, h->nlmsg_seq,
-					bth->zns->ns_id);
-			continue;
+		if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+			h->nlmsg_len = msgs[i].msg_len;
+			h->nlmsg_flags &= ~NLM_F_ACK_TLVS;
 		}
 
-		if (h->nlmsg_type == NLMSG_ERROR) {
-			int err = netlink_parse_error(nl, h, bth->zns->is_cmd,
-						      false);
+		if (IS_ZEBRA_DEBUG_KERNEL_MSGDUMP_RECV) {
+			zlog_debug("%s: << netlink message dump [recv]",
+				   __func__);
+#ifdef NETLINK_DEBUG
+			nl_dump(h, msgs[i].msg_len);
+#else
+			zlog_hexdump(h, msgs[i].msg_len);
+#endif /* NETLINK_DEBUG */
+		}
+	}
 
-			if (err == -1)
-				dplane_ctx_set_status(
-					ctx, ZEBRA_DPLANE_REQUEST_FAILURE);
+	return n;
+}
 
-			if (IS_ZEBRA_DEBUG_KERNEL)
-				zlog_debug("%s: netlink error message seq=%d ",
-					   __func__, h->nlmsg_seq);
-			continue;
-		}
+/* Read back the responses of all batches in flight. */
+static void nl_batch_reap(struct nl_batch *bth)
+{
+	struct mmsghdr msgs[NL_REAP_VLEN];
+	int i, n;
 
-		/*
-		 * If we get here then we did not receive neither the ack nor
-		 * the error and instead received some other message in an
-		 * unexpected way.
-		 */
-		if (IS_ZEBRA_DEBUG_KERNEL)
-			zlog_debug("%s: ignoring message type 0x%04x(%s) NS %u",
-				   __func__, h->nlmsg_type,
-				   nl_msg_type_to_str(h->nlmsg_type),
-				   bth->zns->ns_id);
+	if (bth->inflight_nl == NULL)
+		return;
+
+	if (IS_ZEBRA_DEBUG_KERNEL)
+		zlog_debug("%s: %s, %u batches, %zu msgs in flight", __func__,
+			   bth->inflight_nl->name, bth->inflight_batches,
+			   bth->inflight_msgs);
+
+	while ((n = netlink_recv_msgs(bth->inflight_nl, bth->txbuf, msgs)) > 0)
+		for (i = 0; i < n; i++)
+			nl_batch_handle_resp(bth, bth->inflight_nl,
+					     bth->inflight_zns, &bth->inflight,
+					     msgs[i].msg_hdr.msg_iov->iov_base);
+
+	nl_batch_flush_pending(bth, &bth->inflight, n == -1);
+
+	bth->inflight_nl = NULL;
+	bth->inflight_zns = NULL;
+	bth->inflight_batches = 0;
+	bth->inflight_msgs = 0;
+}
+
+/*
+ * Queue a batch just sent as in flight, and read back the responses once
+ * enough of them have piled up.
+ */
+static void nl_batch_inflight_add(struct nl_batch *bth, struct nlsock *nl)
+{
+	int rcvbuf = 0;
+	socklen_t len = sizeof(rcvbuf);
+
+	if (bth->inflight_nl == NULL) {
+		bth->inflight_nl = nl;
+		bth->inflight_zns = bth->zns;
+
+		/* Keep half of the receive buffer as headroom */
+		if (getsockopt(nl->sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, &len) < 0)
+			rcvbuf = 0;
+		bth->inflight_max = MAX(rcvbuf / 2 / NL_REAP_ACK_TRUESIZE, 1);
 	}
 
-	return 0;
+	dplane_ctx_list_append(&bth->inflight, &bth->ctx_list);
+	bth->inflight_batches++;
+	bth->inflight_msgs += bth->msgcnt;
+
+	if (bth->inflight_batches >= bth->depth ||
+	    bth->inflight_msgs >= bth->inflight_max)
+		nl_batch_reap(bth);
 }
 
 static void nl_batch_reset(struct nl_batch *bth)
@@ -1289,7 +1506,8 @@ static void nl_batch_reset(struct nl_batch *bth)
 }
 
 static void nl_batch_init(struct nl_batch *bth,
-			  struct dplane_ctx_list_head *ctx_out_q)
+			  struct dplane_ctx_list_head *ctx_out_q,
+			  struct nl_batch_txbuf *txbuf)
 {
 	/*
 	 * If the size of the buffer has changed, free and then allocate a new
@@ -1297,21 +1515,30 @@ static void nl_batch_init(struct nl_batch *bth,
 	 */
 	size_t bufsize =
 		atomic_load_explicit(&nl_batch_bufsize, memory_order_relaxed);
-	if (bufsize != nl_batch_tx_bufsize) {
-		if (nl_batch_tx_buf)
-			XFREE(MTYPE_NL_BUF, nl_batch_tx_buf);
+	if (bufsize != txbuf->size) {
+		if (txbuf->buf)
+			XFREE(MTYPE_NL_BUF, txbuf->buf);
 
-		nl_batch_tx_buf = XCALLOC(MTYPE_NL_BUF, bufsize);
-		nl_batch_tx_bufsize = bufsize;
+		txbuf->buf = XCALLOC(MTYPE_NL_BUF, bufsize);
+		txbuf->size = bufsize;
 	}
 
-	bth->buf = nl_batch_tx_buf;
+	bth->buf = txbuf->buf;
 	bth->bufsiz = bufsize;
 	bth->limit = atomic_load_explicit(&nl_batch_send_threshold,
 					  memory_order_relaxed);
 
 	bth->ctx_out_q = ctx_out_q;
 
+	bth->depth = atomic_load_explicit(&nl_batch_pipeline_depth,
+					  memory_order_relaxed);
+	bth->txbuf = txbuf;
+	dplane_ctx_q_init(&bth->inflight);
+	bth->inflight_nl = NULL;
+	bth->inflight_zns = NULL;
+	bth->inflight_batches = 0;
+	bth->inflight_msgs = 0;
+
 	nl_batch_reset(bth);
 }
 
@@ -1329,15 +1556,27 @@ static void nl_batch_send(struct nl_batch *bth)
 				   __func__, nl->name, bth->curlen,
 				   bth->msgcnt);
 
-		if (netlink_send_msg(nl, bth->buf, bth->curlen) == -1)
-			err = true;
+		/* Batches in flight all have to be on the same socket */
+		if (bth->inflight_nl && bth->inflight_nl != nl)
+			nl_batch_reap(bth);
 
-		if (!err) {
-			if (nl_batch_read_resp(bth, nl) == -1)
-				err = true;
-		}
+		if (netlink_send_msg(nl, bth->buf, bth->curlen) == -1) {
+			err = true;
+			/* Keep the results in order */
+			nl_batch_reap(bth);
+		} else if (bth->depth > 1) {
+			nl_batch_inflight_add(bth, nl);
+		} else if (nl_batch_read_resp(bth, nl) == -1)
+			err = true;
 	}
 
+	/*
+	 * Contexts that never made it into a batch (encode failures, or
+	 * nothing to send) must not overtake the batches still in flight.
+	 */
+	if (bth->inflight_nl && dplane_ctx_queue_count(&bth->ctx_list) > 0)
+		nl_batch_reap(bth);
+
 	/* Move remaining contexts to the outbound queue. */
 	while (true) {
 		ctx = dplane_ctx_dequeue(&(bth->ctx_list));
@@ -1509,7 +1748,8 @@ static enum netlink_msg_status nl_put_msg(struct nl_batch *bth,
 	return FRR_NETLINK_ERROR;
 }
 
-void kernel_update_multi(struct dplane_ctx_list_head *ctx_list)
+static void kernel_update_multi_txbuf(struct dplane_ctx_list_head *ctx_list,
+				      struct nl_batch_txbuf *txbuf)
 {
 	struct nl_batch batch;
 	struct zebra_dplane_ctx *ctx;
@@ -1517,7 +1757,7 @@ void kernel_update_multi(struct dplane_ctx_list_head *ctx_list)
 	enum netlink_msg_status res;
 
 	dplane_ctx_q_init(&handled_list);
-	nl_batch_init(&batch, &handled_list);
+	nl_batch_init(&batch, &handled_list, txbuf);
 
 	while (true) {
 		ctx = dplane_ctx_dequeue(ctx_list);
@@ -1546,11 +1786,43 @@ void kernel_update_multi(struct dplane_ctx_list_head *ctx_list)
 	}
 
 	nl_batch_send(&batch);
+	nl_batch_reap(&batch);
 
 	dplane_ctx_q_init(ctx_list);
 	dplane_ctx_list_append(ctx_list, &handled_list);
 }
 
+void kernel_update_multi(struct dplane_ctx_list_head *ctx_list)
+{
+	kernel_update_multi_txbuf(ctx_list, &nl_batch_txbufs[0]);
+}
+
+void kernel_update_multi_worker(struct dplane_ctx_list_head *ctx_list,
+				uint32_t worker)
+{
+	struct zebra_dplane_ctx *ctx;
+	struct dplane_ctx_list_head work_list;
+	struct nlsock *nl;
+
+	/*
+	 * Contexts carry the ns' dplane socket, move them over to the
+	 * worker's own one. Sequence numbers were allocated off the dplane
+	 * socket and stay increasing on the worker's, which is all the ACK
+	 * matching needs.
+	 */
+	dplane_ctx_q_init(&work_list);
+	while ((ctx = dplane_ctx_dequeue(ctx_list)) != NULL) {
+		nl = kernel_netlink_nlsock_lookup(dplane_ctx_get_ns_sock(ctx));
+		if (nl && worker < nl->n_workers)
+			dplane_ctx_set_ns_sock(ctx, nl->workers[worker].sock);
+		dplane_ctx_enqueue_tail(&work_list, ctx);
+	}
+
+	kernel_update_multi_txbuf(&work_list, &nl_batch_txbufs[worker + 1]);
+
+	dplane_ctx_list_append(ctx_list, &work_list);
+}
+
 struct nlsock *kernel_netlink_nlsock_lookup(int sock)
 {
 	struct nlsock lookup, *retval;
@@ -1598,6 +1870,52 @@ static bool kernel_netlink_nlsock_hash_equal(const void *arg1, const void *arg2)
 	return false;
 }
 
+static void kernel_init_dplane_workers(struct zebra_ns *zns)
+{
+	struct nlsock *dp = &zns->netlink_dplane_out, *nl;
+	uint32_t i, n = dplane_get_kernel_workers();
+#if defined SOL_NETLINK
+	int one;
+#endif
+
+	if (n <= 1)
+		return;
+
+	dp->workers = XCALLOC(MTYPE_NL_BUF, n * sizeof(*dp->workers));
+
+	for (i = 0; i < n; i++) {
+		nl = &dp->workers[i];
+		snprintf(nl->name, sizeof(nl->name), "netlink-dp-%u (NS %u)", i,
+			 zns->ns_id);
+		nl->sock = -1;
+		if (netlink_socket(nl, 0, 0, 0, zns->ns_id, NETLINK_ROUTE) < 0) {
+			flog_err(EC_LIB_SOCKET, "Failure to create %s socket",
+				 nl->name);
+			frr_exit_with_buffer_flush(-1);
+		}
+
+		kernel_netlink_nlsock_insert(nl);
+
+#if defined SOL_NETLINK
+		one = 1;
+		setsockopt(nl->sock, SOL_NETLINK, NETLINK_EXT_ACK, &one,
+			   sizeof(one));
+		one = 1;
+		setsockopt(nl->sock, SOL_NETLINK, NETLINK_CAP_ACK, &one,
+			   sizeof(one));
+#endif
+
+		if (fcntl(nl->sock, F_SETFL, O_NONBLOCK) < 0)
+			flog_err(EC_LIB_SOCKET, "Can't set %s socket error: %s(%d)",
+				 nl->name, safe_strerror(errno), errno);
+
+		if (rcvbufsize)
+			netlink_recvbuf(nl, rcvbufsize);
+	}
+
+	dp->n_workers = n;
+}
+
 /* Exported interface function.  This function simply calls
    netlink_socket (). */
 void kernel_init(struct zebra_ns *zns)
@@ -1670,6 +1988,9 @@ void kernel_init(struct zebra_ns *zns)
 
 	kernel_netlink_nlsock_insert(&zns->netlink_dplane_out);
 
+	/* Outbound sockets of the kernel dplane workers, if any. */
+	kernel_init_dplane_workers(zns);
+
 	/* Inbound socket for OS events coming to the dplane. */
 	snprintf(zns->netlink_dplane_in.name,
 		 sizeof(zns->netlink_dplane_in.name), "netlink-dp-in (NS %u)",
@@ -1795,11 +2116,11 @@ void kernel_init(struct zebra_ns *zns)
 	 * ourselves.
 	 */
 	netlink_install_filter(zns->netlink.sock, zns->netlink_cmd.snl.nl_pid,
-			       zns->netlink_dplane_out.snl.nl_pid);
+			       &zns->netlink_dplane_out);
 
 	netlink_install_filter(zns->netlink_dplane_in.sock,
 			       zns->netlink_cmd.snl.nl_pid,
-			       zns->netlink_dplane_out.snl.nl_pid);
+			       &zns->netlink_dplane_out);
 
 	zns->t_netlink = NULL;
 
@@ -1838,8 +2159,16 @@ void kernel_terminate(struct zebra_ns *zns, bool complete)
 	/* During zebra shutdown, we need to leave the dataplane socket
 	 * around until all work is done.
 	 */
-	if (complete)
+	if (complete) {
+		uint32_t i;
+
+		for (i = 0; i < zns->netlink_dplane_out.n_workers; i++)
+			kernel_nlsock_fini(&zns->netlink_dplane_out.workers[i]);
+		zns->netlink_dplane_out.n_workers = 0;
+		XFREE(MTYPE_NL_BUF, zns->netlink_dplane_out.workers);
+
 		kernel_nlsock_fini(&zns->netlink_dplane_out);
+	}
 }
 
 /*
@@ -1847,6 +2176,10 @@ void kernel_terminate(struct zebra_ns *zns, bool complete)
  */
 void kernel_router_init(void)
 {
+	nl_batch_txbufs = XCALLOC(MTYPE_NL_BUF,
+				  (1 + dplane_get_kernel_workers()) *
+					  sizeof(*nl_batch_txbufs));
+
 	/* Init nlsock hash and lock */
 	pthread_mutex_init(&nlsock_mutex, NULL);
 	nlsock_hash = hash_create_size(8, kernel_netlink_nlsock_key,
@@ -1859,7 +2192,13 @@ void kernel_router_init(void)
  */
 void kernel_router_terminate(void)
 {
-	XFREE(MTYPE_NL_BUF, nl_batch_tx_buf);
+	uint32_t i;
+
+	for (i = 0; i <= dplane_get_kernel_workers(); i++) {
+		XFREE(MTYPE_NL_BUF, nl_batch_txbufs[i].buf);
+		XFREE(MTYPE_NL_BUF, nl_batch_txbufs[i].rxbuf);
+	}
+	XFREE(MTYPE_NL_BUF, nl_batch_txbufs);
 
 	pthread_mutex_destroy(&nlsock_mutex);
 
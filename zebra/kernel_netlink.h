@@ -94,6 +94,12 @@ extern int netlink_config_write_helper(struct vty *vty);
 extern void netlink_set_batch_buffer_size(uint32_t size, uint32_t threshold,
 					  bool set);
 
+/*
+ * Configure how many batches may be sent before their responses are read
+ * back. If 'unset', reset to default value.
+ */
+extern void netlink_set_batch_pipeline_depth(uint32_t depth, bool set);
+
 extern struct nlsock *kernel_netlink_nlsock_lookup(int sock);
 
 #ifdef __cplusplus
@@ -1155,7 +1155,7 @@ void rtm_read(struct rt_msghdr *rtm)
 		op = DPLANE_OP_SYS_ROUTE_DELETE;
 
 	/* Allocate and initialize dplane context */
-	ctx = dplane_ctx_alloc();
+	ctx = dplane_ctx_route_alloc();
 	if (!ctx)
 		return;
 
@@ -1709,4 +1709,11 @@ void kernel_update_multi(struct dplane_ctx_list_head *ctx_list)
 	dplane_ctx_list_append(ctx_list, &handled_list);
 }
 
+/* Kernel dplane workers are only configurable with netlink */
+void kernel_update_multi_worker(struct dplane_ctx_list_head *ctx_list,
+				uint32_t worker)
+{
+	kernel_update_multi(ctx_list);
+}
+
 #endif /* !HAVE_NETLINK */
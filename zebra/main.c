@@ -80,6 +80,8 @@ uint32_t rt_table_main_id = RT_TABLE_MAIN;
 #define OPTION_ASIC_OFFLOAD    2001
 #define OPTION_V6_WITH_V4_NEXTHOP 2002
 #define OPTION_NEXTHOP_WEIGHT_16_BIT 2003
+#define OPTION_DPLANE_KERNEL_WORKERS 2004
+#define OPTION_RIB_WORKERS 2005
 
 /* Command line options. */
 const struct option longopts[] = {
@@ -91,10 +93,12 @@ const struct option longopts[] = {
 	{ "asic-offload", optional_argument, NULL, OPTION_ASIC_OFFLOAD },
 	{ "v6-with-v4-nexthops", no_argument, NULL, OPTION_V6_WITH_V4_NEXTHOP },
 	{ "nexthop-weight-16-bit", no_argument, NULL, OPTION_NEXTHOP_WEIGHT_16_BIT },
+	{ "rib-workers", required_argument, NULL, OPTION_RIB_WORKERS },
 #ifdef HAVE_NETLINK
 	{ "vrfwnetns", no_argument, NULL, 'n' },
 	{ "nl-bufsize", required_argument, NULL, 's' },
 	{ "v6-rr-semantics", no_argument, NULL, OPTION_V6_RR_SEMANTICS },
+	{ "dplane-kernel-workers", required_argument, NULL, OPTION_DPLANE_KERNEL_WORKERS },
 #endif /* HAVE_NETLINK */
 	{ "routing-table", optional_argument, NULL, 'R' },
 	{ 0 }
@@ -410,10 +414,12 @@ int main(int argc, char **argv)
 		    "  -A, --asic-offload          FRR is interacting with an asic underneath the linux kernel\n"
 		    "      --v6-with-v4-nexthops   Underlying dataplane supports v6 routes with v4 nexthops\n"
 		    "      --nexthop-weight-16-bit Use 16 bit nexthop weights instead of 8\n"
+		    "      --rib-workers           Number of pthreads resolving nexthops, by vrf\n"
 #ifdef HAVE_NETLINK
 		    "  -s, --nl-bufsize            Set netlink receive buffer size\n"
 		    "  -n, --vrfwnetns             Use NetNS as VRF backend (deprecated, use -w)\n"
 		    "      --v6-rr-semantics       Use v6 RR semantics\n"
+		    "      --dplane-kernel-workers Number of pthreads programming kernel routes\n"
 #else
 		    "  -s,                         Set kernel socket receive buffer size\n"
 #endif /* HAVE_NETLINK */
@@ -490,10 +496,34 @@ int main(int argc, char **argv)
 		case OPTION_V6_WITH_V4_NEXTHOP:
 			v6_with_v4_nexthop = true;
 			break;
+		case OPTION_DPLANE_KERNEL_WORKERS: {
+			unsigned long workers = strtoul(optarg, NULL, 10);
+
+			if (workers == 0 || workers > DPLANE_KERNEL_WORKERS_MAX) {
+				fprintf(stderr,
+					"Kernel dplane workers must be between 1 and %u\n",
+					DPLANE_KERNEL_WORKERS_MAX);
+				return 1;
+			}
+			dplane_set_kernel_workers(workers);
+			break;
+		}
 #endif /* HAVE_NETLINK */
 		case OPTION_NEXTHOP_WEIGHT_16_BIT:
 			nexthop_weight_16_bit = true;
 			break;
+		case OPTION_RIB_WORKERS: {
+			unsigned long workers = strtoul(optarg, NULL, 10);
+
+			if (workers == 0 || workers > RIB_WORKERS_MAX) {
+				fprintf(stderr,
+					"RIB workers must be between 1 and %u\n",
+					RIB_WORKERS_MAX);
+				return 1;
+			}
+			zebra_rib_set_workers(workers);
+			break;
+		}
 		default:
 			frr_help_exit(1);
 		}
@@ -562,6 +592,9 @@ int main(int argc, char **argv)
 	/* Start dataplane system */
 	zebra_dplane_start();
 
+	/* Start the RIB workers, if any */
+	zebra_rib_start();
+
 	/* Start the ted module, before zserv */
 	zebra_opaque_start();
 
@@ -31,7 +31,7 @@ DECLARE_MGROUP(ZEBRA);
 
 DECLARE_MTYPE(RE);
 
-PREDECL_LIST(rnh_list);
+PREDECL_RBTREE_NONUNIQ(rnh_deps);
 PREDECL_RBTREE_UNIQ(rnh_rbtree);
 
 /* Nexthop structure. */
@@ -66,7 +66,7 @@ struct rnh {
 	 */
 	bool filtered;
 
-	struct rnh_list_item rnh_list_item;
+	struct rnh_deps_item rnh_deps_item;
 
 	struct rnh_rbtree_item rnh_rbtree_item;
 };
@@ -238,7 +238,7 @@ typedef struct rib_dest_t_ {
 	 * the data plane we will run evaluate_rnh
 	 * on these prefixes.
 	 */
-	struct rnh_list_head nht;
+	struct rnh_deps_head nht;
 
 	/*
 	 * Linkage to put dest on the FPM processing queue.
@@ -247,7 +247,30 @@ typedef struct rib_dest_t_ {
 
 } rib_dest_t;
 
-DECLARE_LIST(rnh_list, struct rnh, rnh_list_item);
+/*
+ * The rnhs resolving over a route node are sorted by the prefix they track,
+ * address first, so that the ones a more specific route could take over
+ * are next to each other.
+ */
+static inline int rnh_deps_cmp(const struct rnh *a, const struct rnh *b)
+{
+	const struct prefix *pa = &a->node->p, *pb = &b->node->p;
+	int ret;
+
+	if (pa->family != pb->family)
+		return numcmp(pa->family, pb->family);
+
+	ret = memcmp(&pa->u.prefix, &pb->u.prefix, prefix_blen(pa));
+	if (ret)
+		return ret;
+
+	if (pa->prefixlen != pb->prefixlen)
+		return numcmp(pa->prefixlen, pb->prefixlen);
+
+	return numcmp(a->safi, b->safi);
+}
+
+DECLARE_RBTREE_NONUNIQ(rnh_deps, struct rnh, rnh_deps_item, rnh_deps_cmp);
 DECLARE_LIST(re_list, struct route_entry, next);
 
 #define RIB_ROUTE_QUEUED(x)	(1 << (x))
@@ -423,7 +446,11 @@ extern void rib_sweep_route(struct event *t);
 extern void rib_sweep_table(struct route_table *table);
 extern void rib_close_table(struct route_table *table);
 extern void zebra_rib_init(void);
+extern void zebra_rib_start(void);
 extern void zebra_rib_terminate(void);
+
+#define RIB_WORKERS_MAX 16
+extern void zebra_rib_set_workers(uint32_t count);
 extern unsigned long rib_score_proto(uint8_t proto, unsigned short instance);
 extern unsigned long rib_score_proto_table(uint8_t proto,
 					   unsigned short instance,
@@ -113,6 +113,13 @@ extern int kernel_del_mac_nhg(uint32_t nhg_id);
  */
 extern void kernel_update_multi(struct dplane_ctx_list_head *ctx_list);
 
+/*
+ * Same, for one of the kernel dplane workers: the worker's own OS channel is
+ * used. Called in the worker's pthread.
+ */
+extern void kernel_update_multi_worker(struct dplane_ctx_list_head *ctx_list,
+				       uint32_t worker);
+
 /*
  * Called by the dplane pthread to read incoming OS messages and dispatch them.
  */
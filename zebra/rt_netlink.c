@@ -1192,7 +1192,7 @@ static int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 	 * After this point, note that we need to 'goto done' to exit,
 	 * so that the ctx gets cleaned-up.
 	 */
-	ctx = dplane_ctx_alloc();
+	ctx = dplane_ctx_route_alloc();
 
 	dplane_ctx_route_init(ctx,
 			      h->nlmsg_type == RTM_NEWROUTE ?
@@ -2473,6 +2473,17 @@ void zsend_capabilities_all_clients(void)
 	}
 }
 
+/* Accept or refuse the shared memory ring offered with a hello */
+static void zsend_zapi_shm(struct zserv *client, bool accepted)
+{
+	struct stream *s = stream_new(ZEBRA_SMALL_PACKET_SIZE);
+
+	zclient_create_header(s, ZEBRA_ZAPI_SHM, VRF_DEFAULT);
+	stream_putc(s, accepted);
+	stream_putw_at(s, 0, stream_get_endp(s));
+	zserv_send_message(client, s);
+}
+
 /* Tie up route-type and client->sock */
 static void zread_hello(ZAPI_HANDLER_ARGS)
 {
@@ -2481,14 +2492,27 @@ static void zread_hello(ZAPI_HANDLER_ARGS)
 	unsigned short instance;
 	uint8_t synchronous;
 	uint32_t session_id;
+	uint8_t shm = 0;
+	uint32_t capabilities = 0;
 
 	STREAM_GETC(msg, proto);
 	STREAM_GETW(msg, instance);
 	STREAM_GETL(msg, session_id);
 	STREAM_GETC(msg, synchronous);
+	/* Optional: the client offers a shared memory ring */
+	if (STREAM_READABLE(msg))
+		STREAM_GETC(msg, shm);
+	/* Optional: ZAPI_CLIENT_CAP_* */
+	if (STREAM_READABLE(msg) >= 4)
+		STREAM_GETL(msg, capabilities);
 
 	if (synchronous)
 		client->synchronous = true;
+	client->capabilities = capabilities;
+
+	if (shm)
+		zsend_zapi_shm(client,
+			       !client->synchronous && zserv_shm_attach(client));
 
 	/* accept only dynamic routing protocols */
 	if ((proto < ZEBRA_ROUTE_MAX) && (proto > ZEBRA_ROUTE_LOCAL)) {
@@ -2515,6 +2539,14 @@ stream_failure:
 	return;
 }
 
+/*
+ * The client switched over to its shared memory ring; that was taken care of
+ * as the message came in.
+ */
+static void zread_zapi_shm(ZAPI_HANDLER_ARGS)
+{
+}
+
 /*
  * Validate incoming zapi mpls lsp / labels message
  */
@@ -3752,19 +3784,23 @@ static inline void zread_ipset_entry(ZAPI_HANDLER_ARGS)
 		if (zpi.proto != 0)
 			zpi.filter_bm |= PBR_FILTER_IP_PROTOCOL;
 
+		/*
+		 * Entries come in batches: skip a bad one, the stream is
+		 * already past it.
+		 */
 		if (!(zpi.dst.family == AF_INET
 		      || zpi.dst.family == AF_INET6)) {
 			zlog_warn(
 				"Unsupported PBR destination IP family: %s (%hhu)",
 				family2str(zpi.dst.family), zpi.dst.family);
-			goto stream_failure;
+			continue;
 		}
 		if (!(zpi.src.family == AF_INET
 		      || zpi.src.family == AF_INET6)) {
 			zlog_warn(
 				"Unsupported PBR source IP family: %s (%hhu)",
 				family2str(zpi.src.family), zpi.src.family);
-			goto stream_failure;
+			continue;
 		}
 
 		/* calculate backpointer */
@@ -3774,7 +3810,7 @@ static inline void zread_ipset_entry(ZAPI_HANDLER_ARGS)
 		if (!zpi.backpointer) {
 			zlog_warn("ipset name specified: %s does not exist",
 				  ipset.ipset_name);
-			goto stream_failure;
+			continue;
 		}
 
 		if (hdr->command == ZEBRA_IPSET_ENTRY_ADD)
@@ -4166,6 +4202,7 @@ void (*const zserv_handlers[])(ZAPI_HANDLER_ARGS) = {
 	[ZEBRA_REDISTRIBUTE_DEFAULT_DELETE] = zebra_redistribute_default_delete,
 	[ZEBRA_NEXTHOP_LOOKUP] = zread_nexthop_lookup,
 	[ZEBRA_HELLO] = zread_hello,
+	[ZEBRA_ZAPI_SHM] = zread_zapi_shm,
 	[ZEBRA_NEXTHOP_REGISTER] = zread_rnh_register,
 	[ZEBRA_NEXTHOP_UNREGISTER] = zread_rnh_unregister,
 	[ZEBRA_BFD_DEST_UPDATE] = zebra_ptm_bfd_dst_register,
@@ -4252,73 +4289,65 @@ void (*const zserv_handlers[])(ZAPI_HANDLER_ARGS) = {
 };
 
 /*
- * Process a batch of zapi messages.
+ * Process a zapi message. The message is usually a view of the client's
+ * input buffer, only valid for the duration of the call: the few that have
+ * to be kept around are copied onto 'deferred'.
  */
-void zserv_handle_commands(struct zserv *client, struct stream_fifo *fifo)
+void zserv_handle_command(struct zserv *client, struct stream *msg,
+			  struct stream_fifo *deferred)
 {
 	struct zmsghdr hdr;
 	struct zebra_vrf *zvrf;
-	struct stream *msg;
-	struct stream_fifo temp_fifo;
-
-	stream_fifo_init(&temp_fifo);
-
-	while (stream_fifo_head(fifo)) {
-		msg = stream_fifo_pop(fifo);
 
-		if (STREAM_READABLE(msg) > ZEBRA_MAX_PACKET_SIZ) {
-			if (IS_ZEBRA_DEBUG_PACKET && IS_ZEBRA_DEBUG_RECV)
-				zlog_debug(
-					"ZAPI message is %zu bytes long but the maximum packet size is %u; dropping",
-					STREAM_READABLE(msg),
-					ZEBRA_MAX_PACKET_SIZ);
-			goto continue_loop;
-		}
-
-		zapi_parse_header(msg, &hdr);
-
-		if (IS_ZEBRA_DEBUG_PACKET && IS_ZEBRA_DEBUG_RECV
-		    && IS_ZEBRA_DEBUG_DETAIL)
-			zserv_log_message(NULL, msg, &hdr);
-
-		hdr.length -= ZEBRA_HEADER_SIZE;
-
-		/* Before checking for a handler function, check for
-		 * special messages that are handled the 'opaque zapi' module.
-		 */
-		if (zebra_opaque_handles_msgid(hdr.command)) {
-			/* Reset message buffer */
-			stream_set_getp(msg, 0);
+	if (STREAM_READABLE(msg) > ZEBRA_MAX_PACKET_SIZ) {
+		if (IS_ZEBRA_DEBUG_PACKET && IS_ZEBRA_DEBUG_RECV)
+			zlog_debug(
+				"ZAPI message is %zu bytes long but the maximum packet size is %u; dropping",
+				STREAM_READABLE(msg),
+				ZEBRA_MAX_PACKET_SIZ);
+		return;
+	}
 
-			stream_fifo_push(&temp_fifo, msg);
+	zapi_parse_header(msg, &hdr);
 
-			/* Continue without freeing the message */
-			msg = NULL;
-			goto continue_loop;
-		}
+	if (IS_ZEBRA_DEBUG_PACKET && IS_ZEBRA_DEBUG_RECV
+	    && IS_ZEBRA_DEBUG_DETAIL)
+		zserv_log_message(NULL, msg, &hdr);
 
-		/* lookup vrf */
-		zvrf = zebra_vrf_lookup_by_id(hdr.vrf_id);
-		if (!zvrf) {
-			zserv_error_no_vrf(client, &hdr, msg, zvrf);
-			goto continue_loop;
-		}
+	hdr.length -= ZEBRA_HEADER_SIZE;
 
-		if (hdr.command >= array_size(zserv_handlers)
-		    || zserv_handlers[hdr.command] == NULL) {
-			zserv_error_invalid_msg_type(client, &hdr, msg, zvrf);
-			goto continue_loop;
-		}
+	/* Before checking for a handler function, check for
+	 * special messages that are handled the 'opaque zapi' module.
+	 * They are processed by another pthread, so need a copy.
+	 */
+	if (zebra_opaque_handles_msgid(hdr.command)) {
+		msg = stream_dup(msg);
+		stream_set_getp(msg, 0);
+		stream_fifo_push(deferred, msg);
+		return;
+	}
 
-		zserv_handlers[hdr.command](client, &hdr, msg, zvrf);
+	/* lookup vrf */
+	zvrf = zebra_vrf_lookup_by_id(hdr.vrf_id);
+	if (!zvrf) {
+		zserv_error_no_vrf(client, &hdr, msg, zvrf);
+		return;
+	}
 
-continue_loop:
-		stream_free(msg);
+	if (hdr.command >= array_size(zserv_handlers)
+	    || zserv_handlers[hdr.command] == NULL) {
+		zserv_error_invalid_msg_type(client, &hdr, msg, zvrf);
+		return;
 	}
 
-	/* Dispatch any special messages from the temp fifo */
-	if (stream_fifo_head(&temp_fifo) != NULL)
-		zebra_opaque_enqueue_batch(&temp_fifo);
+	zserv_handlers[hdr.command](client, &hdr, msg, zvrf);
+}
 
-	stream_fifo_deinit(&temp_fifo);
+/*
+ * Dispatch the messages set aside by zserv_handle_command() for a batch.
+ */
+void zserv_handle_deferred(struct stream_fifo *deferred)
+{
+	if (stream_fifo_head(deferred) != NULL)
+		zebra_opaque_enqueue_batch(deferred);
 }
@@ -30,11 +30,16 @@ extern "C" {
  * client
  *    the client datastructure
  *
- * fifo
- *    a batch of messages
+ * msg
+ *    the message, which need not outlive the call
+ *
+ * deferred
+ *    messages to be handed to other pthreads, copied; pass to
+ *    zserv_handle_deferred() at the end of a batch
  */
-extern void zserv_handle_commands(struct zserv *client,
-				  struct stream_fifo *fifo);
+extern void zserv_handle_command(struct zserv *client, struct stream *msg,
+				 struct stream_fifo *deferred);
+extern void zserv_handle_deferred(struct stream_fifo *deferred);
 
 extern int zsend_vrf_add(struct zserv *zclient, struct zebra_vrf *zvrf);
 extern int zsend_vrf_delete(struct zserv *zclient, struct zebra_vrf *zvrf);
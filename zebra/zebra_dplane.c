@@ -29,13 +29,17 @@
 #include "zebra/zebra_tc.h"
 #include "zebra/zebra_trace.h"
 #include "printfrr.h"
+#include "jhash.h"
 
 /* Memory types */
 DEFINE_MTYPE_STATIC(ZEBRA, DP_CTX, "Zebra DPlane Ctx");
+DEFINE_MTYPE_STATIC(ZEBRA, DP_CTX_ROUTE, "Zebra DPlane Route Ctx");
+DEFINE_MTYPE_STATIC(ZEBRA, DP_CTX_POOL, "Zebra DPlane Ctx Pool");
 DEFINE_MTYPE_STATIC(ZEBRA, DP_INTF, "Zebra DPlane Intf");
 DEFINE_MTYPE_STATIC(ZEBRA, DP_PROV, "Zebra DPlane Provider");
 DEFINE_MTYPE_STATIC(ZEBRA, DP_NETFILTER, "Zebra Netfilter Internal Object");
 DEFINE_MTYPE_STATIC(ZEBRA, DP_NS, "DPlane NSes");
+DEFINE_MTYPE_STATIC(ZEBRA, DP_KWORKER, "Zebra DPlane Kernel Worker");
 
 DEFINE_MTYPE(ZEBRA, VLAN_CHANGE_ARR, "Vlan Change Array");
 
@@ -64,6 +68,9 @@ const uint32_t DPLANE_DEFAULT_MAX_QUEUED = 200;
 /* Default value for new work per cycle */
 const uint32_t DPLANE_DEFAULT_NEW_WORK = 100;
 
+/* Number of kernel dplane workers, set from the command line */
+static uint32_t dplane_kernel_workers = 1;
+
 /* Validation check macro for context blocks */
 /* #define DPLANE_DEBUG 1 */
 
@@ -89,8 +96,10 @@ struct dplane_nexthop_info {
 	int type;
 
 	struct nexthop_group ng;
-	struct nh_grp nh_grp[MULTIPATH_NUM];
 	uint16_t nh_grp_count;
+
+	/* Last, route-sized contexts stop short of it */
+	struct nh_grp nh_grp[MULTIPATH_NUM];
 };
 
 /*
@@ -137,9 +146,6 @@ struct dplane_route_info {
 	uint32_t zd_flags;
 	bool zd_replace;
 
-	/* Nexthop hash entry info */
-	struct dplane_nexthop_info nhe;
-
 	/* Nexthops */
 	uint32_t zd_nhg_id;
 	struct nexthop_group zd_ng;
@@ -158,6 +164,9 @@ struct dplane_route_info {
 	enum blackhole_type zd_bh_type;
 	struct ipaddr zd_prefsrc;
 	struct ipaddr zd_gateway;
+
+	/* Nexthop hash entry info, last (see DPLANE_CTX_SIZE_ROUTE) */
+	struct dplane_nexthop_info nhe;
 };
 
 /*
@@ -402,6 +411,9 @@ struct dplane_vlan_info {
 	struct zebra_vxlan_vlan_array *vlan_array;
 };
 
+/* Route updates pending in one batch of incoming work, by destination */
+PREDECL_HASH(dplane_route_pend);
+
 /*
  * The context block used to exchange info about route updates across
  * the boundary between the zebra main context (and pthread) and the
@@ -412,6 +424,9 @@ struct zebra_dplane_ctx {
 	/* Operation code */
 	enum dplane_op_e zd_op;
 
+	/* Size of the object, see dplane_ctx_size */
+	uint8_t zd_size;
+
 	/* Status on return */
 	enum zebra_dplane_result zd_status;
 
@@ -441,7 +456,19 @@ struct zebra_dplane_ctx {
 	char zd_ifname[IFNAMSIZ];
 	ifindex_t zd_ifindex;
 
-	/* Support info for different kinds of updates */
+	/* Namespace info, used especially for netlink kernel communication */
+	struct zebra_dplane_info zd_ns_info;
+
+	/* Embedded list linkage */
+	struct dplane_ctx_list_item zd_entries;
+
+	/* Linkage while looking for updates to coalesce */
+	struct dplane_route_pend_item zd_pend;
+
+	/*
+	 * Support info for different kinds of updates; must be last, objects
+	 * may be allocated short of the full union.
+	 */
 	union {
 		struct dplane_route_info rinfo;
 		struct zebra_lsp lsp;
@@ -467,12 +494,6 @@ struct zebra_dplane_ctx {
 		enum zebra_dplane_startup_notifications spot;
 		struct dplane_srv6_encap_ctx srv6_encap;
 	} u;
-
-	/* Namespace info, used especially for netlink kernel communication */
-	struct zebra_dplane_info zd_ns_info;
-
-	/* Embedded list linkage */
-	struct dplane_ctx_list_item zd_entries;
 };
 
 /* Flag that can be set by a pre-kernel provider as a signal that an update
@@ -480,10 +501,124 @@ struct zebra_dplane_ctx {
  */
 #define DPLANE_CTX_FLAG_NO_KERNEL 0x01
 
+/* A route update that took over the kernel programming of earlier ones,
+ * see dplane_routes_coalesce().
+ */
+#define DPLANE_CTX_FLAG_COALESCED 0x02
+
 /* List types declared now that the structs involved are defined. */
 DECLARE_DLIST(dplane_ctx_list, struct zebra_dplane_ctx, zd_entries);
 DECLARE_DLIST(dplane_intf_extra_list, struct dplane_intf_extra, dlink);
 
+static int dplane_route_pend_cmp(const struct zebra_dplane_ctx *a,
+				 const struct zebra_dplane_ctx *b)
+{
+	if (a->zd_ns_info.ns_id != b->zd_ns_info.ns_id)
+		return numcmp(a->zd_ns_info.ns_id, b->zd_ns_info.ns_id);
+	if (a->zd_vrf_id != b->zd_vrf_id)
+		return numcmp(a->zd_vrf_id, b->zd_vrf_id);
+	if (a->zd_table_id != b->zd_table_id)
+		return numcmp(a->zd_table_id, b->zd_table_id);
+	if (a->u.rinfo.zd_safi != b->u.rinfo.zd_safi)
+		return numcmp(a->u.rinfo.zd_safi, b->u.rinfo.zd_safi);
+	if (prefix_cmp(&a->u.rinfo.zd_dest, &b->u.rinfo.zd_dest))
+		return prefix_cmp(&a->u.rinfo.zd_dest, &b->u.rinfo.zd_dest);
+
+	/* The source prefix is all zeroes when not in use */
+	return prefix_cmp(&a->u.rinfo.zd_src, &b->u.rinfo.zd_src);
+}
+
+static uint32_t dplane_route_pend_hash(const struct zebra_dplane_ctx *ctx)
+{
+	uint32_t src = 0;
+
+	if (ctx->u.rinfo.zd_src.family)
+		src = prefix_hash_key(&ctx->u.rinfo.zd_src);
+
+	return jhash_3words(prefix_hash_key(&ctx->u.rinfo.zd_dest), src,
+			    ctx->zd_table_id ^ ctx->zd_vrf_id, ctx->zd_ns_info.ns_id);
+}
+
+DECLARE_HASH(dplane_route_pend, struct zebra_dplane_ctx, zd_pend,
+	     dplane_route_pend_cmp, dplane_route_pend_hash);
+
+/*
+ * Context object sizes. Route updates, by far the most frequent ones, only
+ * get the union up to the route info, without the nexthop group id array
+ * which nexthop group updates need. Everything else is full-sized, since
+ * these objects may get reset and reused for any kind of update.
+ */
+enum dplane_ctx_size {
+	DPLANE_CTX_SIZE_FULL = 0,
+	DPLANE_CTX_SIZE_ROUTE,
+	DPLANE_CTX_SIZE_MAX,
+};
+
+static const struct dplane_ctx_size_info {
+	const char *name;
+	struct memtype *mtype;
+	size_t size;
+	/* Max number of free objects each pthread keeps around */
+	uint32_t pool_max;
+} dplane_ctx_sizes[DPLANE_CTX_SIZE_MAX] = {
+	[DPLANE_CTX_SIZE_FULL] = {
+		.name = "full",
+		.mtype = MTYPE_DP_CTX,
+		.size = sizeof(struct zebra_dplane_ctx),
+		.pool_max = 512,
+	},
+	[DPLANE_CTX_SIZE_ROUTE] = {
+		.name = "route",
+		.mtype = MTYPE_DP_CTX_ROUTE,
+		.size = offsetof(struct zebra_dplane_ctx, u.rinfo.nhe.nh_grp),
+		.pool_max = 4096,
+	},
+};
+
+/*
+ * Per-pthread pools of free context objects. Contexts are mostly allocated
+ * and freed on the main pthread, and only the owning pthread touches a
+ * pool's lists, so no locking is needed but for the statistics.
+ */
+PREDECL_DLIST(dplane_ctx_pool_list);
+
+struct dplane_ctx_pool {
+	uint32_t id;
+
+	struct dplane_ctx_list_head free[DPLANE_CTX_SIZE_MAX];
+
+	_Atomic uint64_t hits[DPLANE_CTX_SIZE_MAX];
+	_Atomic uint64_t misses[DPLANE_CTX_SIZE_MAX];
+	_Atomic uint32_t cached_max[DPLANE_CTX_SIZE_MAX];
+
+	struct dplane_ctx_pool_list_item itm;
+};
+
+DECLARE_DLIST(dplane_ctx_pool_list, struct dplane_ctx_pool, itm);
+
+#ifndef thread_local
+#define thread_local __thread
+#endif
+
+static thread_local struct dplane_ctx_pool *dplane_ctx_pool_tls;
+
+/*
+ * Not part of zdplane_info: contexts can be allocated before the dplane
+ * gets initialised, and freed after it is shut down.
+ */
+static struct {
+	pthread_mutex_t mutex;
+	struct dplane_ctx_pool_list_head pools;
+	uint32_t next_id;
+	_Atomic bool disabled;
+
+	_Atomic uint32_t inuse[DPLANE_CTX_SIZE_MAX];
+	_Atomic uint32_t inuse_max[DPLANE_CTX_SIZE_MAX];
+} dplane_ctx_pools_info = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.pools = INIT_DLIST(dplane_ctx_pools_info.pools),
+};
+
 /* List for dplane plugins/providers */
 PREDECL_DLIST(dplane_prov_list);
 
@@ -552,6 +687,24 @@ struct dplane_zns_info {
 	struct zns_info_list_item link;
 };
 
+/*
+ * Kernel dplane worker: a pthread programming its share of the route
+ * updates of a cycle over its own netlink socket.
+ */
+struct dplane_kernel_worker {
+	uint32_t id;
+
+	struct frr_pthread *pthread;
+	struct event *t_work;
+
+	/* Updates of the current round, owned by the worker while it runs */
+	struct dplane_ctx_list_head work_list;
+
+	/* Statistics */
+	_Atomic uint32_t updates;
+	_Atomic uint32_t rounds;
+};
+
 /*
  * Globals
  */
@@ -598,6 +751,7 @@ static struct zebra_dplane_globals {
 	_Atomic uint32_t dg_routes_queued;
 	_Atomic uint32_t dg_routes_queued_max;
 	_Atomic uint32_t dg_routes_kernel_skipped;
+	_Atomic uint32_t dg_routes_coalesced;
 	_Atomic uint32_t dg_route_errors;
 	_Atomic uint32_t dg_other_errors;
 
@@ -664,6 +818,15 @@ static struct zebra_dplane_globals {
 	/* Event pointer for pending shutdown check loop */
 	struct event *dg_t_shutdown_check;
 
+	/* Kernel dplane workers, only when more than one is configured */
+	uint32_t dg_kernel_workers;
+	struct dplane_kernel_worker *dg_kworkers;
+
+	/* Workers still busy with the current round */
+	pthread_mutex_t dg_kworker_mutex;
+	pthread_cond_t dg_kworker_cond;
+	uint32_t dg_kworkers_busy;
+
 } zdplane_info;
 
 /* Instantiate zns list type */
@@ -723,19 +886,104 @@ uint32_t zebra_dplane_get_work_limit(void)
 	return zdplane_info.dg_updates_per_cycle;
 }
 
+/* Pool of the calling pthread, NULL once pools are torn down */
+static struct dplane_ctx_pool *dplane_ctx_pool_get(void)
+{
+	struct dplane_ctx_pool *pool = dplane_ctx_pool_tls;
+	int i;
+
+	if (atomic_load_explicit(&dplane_ctx_pools_info.disabled,
+				 memory_order_relaxed))
+		return NULL;
+
+	if (pool)
+		return pool;
+
+	pool = XCALLOC(MTYPE_DP_CTX_POOL, sizeof(*pool));
+	for (i = 0; i < DPLANE_CTX_SIZE_MAX; i++)
+		dplane_ctx_list_init(&pool->free[i]);
+
+	frr_with_mutex (&dplane_ctx_pools_info.mutex) {
+		pool->id = dplane_ctx_pools_info.next_id++;
+		dplane_ctx_pool_list_add_tail(&dplane_ctx_pools_info.pools, pool);
+	}
+
+	dplane_ctx_pool_tls = pool;
+	return pool;
+}
+
+static struct zebra_dplane_ctx *dplane_ctx_alloc_size(enum dplane_ctx_size size)
+{
+	const struct dplane_ctx_size_info *info = &dplane_ctx_sizes[size];
+	struct dplane_ctx_pool *pool = dplane_ctx_pool_get();
+	struct zebra_dplane_ctx *ctx = NULL;
+	uint32_t inuse, inuse_max;
+
+	if (pool)
+		ctx = dplane_ctx_list_pop(&pool->free[size]);
+
+	if (ctx) {
+		memset(ctx, 0, info->size);
+		atomic_fetch_add_explicit(&pool->hits[size], 1,
+					  memory_order_relaxed);
+	} else {
+		ctx = XCALLOC(info->mtype, info->size);
+		if (pool)
+			atomic_fetch_add_explicit(&pool->misses[size], 1,
+						  memory_order_relaxed);
+	}
+
+	ctx->zd_size = size;
+
+	inuse = atomic_fetch_add_explicit(&dplane_ctx_pools_info.inuse[size],
+					  1, memory_order_relaxed) + 1;
+	inuse_max = atomic_load_explicit(&dplane_ctx_pools_info.inuse_max[size],
+					 memory_order_relaxed);
+	while (inuse > inuse_max &&
+	       !atomic_compare_exchange_weak_explicit(
+		       &dplane_ctx_pools_info.inuse_max[size], &inuse_max, inuse,
+		       memory_order_relaxed, memory_order_relaxed))
+		;
+
+	return ctx;
+}
+
 /*
  * Allocate a dataplane update context
  */
 struct zebra_dplane_ctx *dplane_ctx_alloc(void)
 {
-	struct zebra_dplane_ctx *p;
+	return dplane_ctx_alloc_size(DPLANE_CTX_SIZE_FULL);
+}
 
-	/* TODO -- just alloc'ing memory, but would like to maintain
-	 * a pool
-	 */
-	p = XCALLOC(MTYPE_DP_CTX, sizeof(struct zebra_dplane_ctx));
+/*
+ * Allocate a context that will only ever carry a route update
+ */
+struct zebra_dplane_ctx *dplane_ctx_route_alloc(void)
+{
+	return dplane_ctx_alloc_size(DPLANE_CTX_SIZE_ROUTE);
+}
+
+/* Release the free objects of all pools; from here on, pools are bypassed */
+static void dplane_ctx_pools_fini(void)
+{
+	struct dplane_ctx_pool *pool;
+	struct zebra_dplane_ctx *ctx;
+	int i;
+
+	atomic_store_explicit(&dplane_ctx_pools_info.disabled, true,
+			      memory_order_relaxed);
 
-	return p;
+	frr_with_mutex (&dplane_ctx_pools_info.mutex) {
+		while ((pool = dplane_ctx_pool_list_pop(
+				&dplane_ctx_pools_info.pools))) {
+			for (i = 0; i < DPLANE_CTX_SIZE_MAX; i++)
+				while ((ctx = dplane_ctx_list_pop(
+						&pool->free[i])))
+					XFREE(dplane_ctx_sizes[i].mtype, ctx);
+			XFREE(MTYPE_DP_CTX_POOL, pool);
+		}
+	}
 }
 
 /* Enable system route notifications */
@@ -940,21 +1188,41 @@ static void dplane_ctx_free_internal(struct zebra_dplane_ctx *ctx)
  */
 static void dplane_ctx_free(struct zebra_dplane_ctx **pctx)
 {
+	struct dplane_ctx_pool *pool;
+	enum dplane_ctx_size size;
+	uint32_t cached;
+
 	if (pctx == NULL)
 		return;
 
 	DPLANE_CTX_VALID(*pctx);
 
-	/* TODO -- just freeing memory, but would like to maintain
-	 * a pool
-	 */
-
 	/* Some internal allocations may need to be freed, depending on
 	 * the type of info captured in the ctx.
 	 */
 	dplane_ctx_free_internal(*pctx);
 
-	XFREE(MTYPE_DP_CTX, *pctx);
+	size = (*pctx)->zd_size;
+	atomic_fetch_sub_explicit(&dplane_ctx_pools_info.inuse[size], 1,
+				  memory_order_relaxed);
+
+	/* Back to the pool of this pthread, if there's room */
+	pool = dplane_ctx_pool_get();
+	if (pool) {
+		cached = dplane_ctx_list_count(&pool->free[size]);
+		if (cached < dplane_ctx_sizes[size].pool_max) {
+			dplane_ctx_list_add_head(&pool->free[size], *pctx);
+			if (cached + 1 > atomic_load_explicit(&pool->cached_max[size],
+							      memory_order_relaxed))
+				atomic_store_explicit(&pool->cached_max[size],
+						      cached + 1,
+						      memory_order_relaxed);
+			*pctx = NULL;
+			return;
+		}
+	}
+
+	XFREE(dplane_ctx_sizes[size].mtype, *pctx);
 }
 
 /*
@@ -963,8 +1231,11 @@ static void dplane_ctx_free(struct zebra_dplane_ctx **pctx)
  */
 void dplane_ctx_reset(struct zebra_dplane_ctx *ctx)
 {
+	uint8_t size = ctx->zd_size;
+
 	dplane_ctx_free_internal(ctx);
-	memset(ctx, 0, sizeof(*ctx));
+	memset(ctx, 0, dplane_ctx_sizes[size].size);
+	ctx->zd_size = size;
 }
 
 /*
@@ -972,7 +1243,6 @@ void dplane_ctx_reset(struct zebra_dplane_ctx *ctx)
  */
 void dplane_ctx_fini(struct zebra_dplane_ctx **pctx)
 {
-	/* TODO -- maintain pool; for now, just free */
 	dplane_ctx_free(pctx);
 }
 
@@ -2377,6 +2647,15 @@ int dplane_ctx_get_ns_sock(const struct zebra_dplane_ctx *ctx)
 #endif
 }
 
+void dplane_ctx_set_ns_sock(struct zebra_dplane_ctx *ctx, int sock)
+{
+	DPLANE_CTX_VALID(ctx);
+
+#ifdef HAVE_NETLINK
+	ctx->zd_ns_info.sock = sock;
+#endif
+}
+
 /* Accessors for nexthop information */
 uint32_t dplane_ctx_get_nhe_id(const struct zebra_dplane_ctx *ctx)
 {
@@ -2419,6 +2698,11 @@ const struct nh_grp *
 dplane_ctx_get_nhe_nh_grp(const struct zebra_dplane_ctx *ctx)
 {
 	DPLANE_CTX_VALID(ctx);
+
+	/* Not part of route-sized objects */
+	if (ctx->zd_size == DPLANE_CTX_SIZE_ROUTE)
+		return NULL;
+
 	return ctx->u.rinfo.nhe.nh_grp;
 }
 
@@ -4630,7 +4914,7 @@ dplane_route_update_internal(struct route_node *rn,
 	struct zebra_dplane_ctx *ctx = NULL;
 
 	/* Obtain context block */
-	ctx = dplane_ctx_alloc();
+	ctx = dplane_ctx_route_alloc();
 
 	/* Init context with info from zebra data structs */
 	ret = dplane_ctx_route_init(ctx, op, rn, re);
@@ -4986,7 +5270,7 @@ dplane_route_notif_update(struct route_node *rn,
 	if (rn == NULL || re == NULL)
 		goto done;
 
-	new_ctx = dplane_ctx_alloc();
+	new_ctx = dplane_ctx_route_alloc();
 
 	/* Init context with info from zebra data structs */
 	dplane_ctx_route_init(new_ctx, op, rn, re);
@@ -6303,12 +6587,68 @@ dplane_srv6_encap_srcaddr_set(const struct in6_addr *addr, ns_id_t ns_id)
 	return result;
 }
 
+/* Context pool statistics, for 'show zebra dplane' */
+static void dplane_ctx_pools_show(struct vty *vty, bool detailed)
+{
+	struct dplane_ctx_pool *pool;
+	uint64_t hits[DPLANE_CTX_SIZE_MAX] = {}, misses[DPLANE_CTX_SIZE_MAX] = {};
+	uint64_t h, m;
+	int i;
+
+	vty_out(vty, "Context pools:\n");
+	vty_out(vty, "  %-6s %5s %8s %12s %12s %8s\n", "Size", "Bytes",
+		"In use", "Max in use", "Allocs", "Hit rate");
+
+	frr_with_mutex (&dplane_ctx_pools_info.mutex) {
+		frr_each (dplane_ctx_pool_list, &dplane_ctx_pools_info.pools, pool)
+			for (i = 0; i < DPLANE_CTX_SIZE_MAX; i++) {
+				hits[i] += atomic_load_explicit(&pool->hits[i],
+								memory_order_relaxed);
+				misses[i] += atomic_load_explicit(&pool->misses[i],
+								  memory_order_relaxed);
+			}
+	}
+
+	for (i = 0; i < DPLANE_CTX_SIZE_MAX; i++)
+		vty_out(vty, "  %-6s %5zu %8u %12u %12" PRIu64 " %7.1f%%\n",
+			dplane_ctx_sizes[i].name, dplane_ctx_sizes[i].size,
+			atomic_load_explicit(&dplane_ctx_pools_info.inuse[i],
+					     memory_order_relaxed),
+			atomic_load_explicit(&dplane_ctx_pools_info.inuse_max[i],
+					     memory_order_relaxed),
+			hits[i] + misses[i],
+			hits[i] + misses[i] ? 100.0 * hits[i] / (hits[i] + misses[i])
+					    : 0.0);
+
+	if (!detailed)
+		return;
+
+	frr_with_mutex (&dplane_ctx_pools_info.mutex) {
+		frr_each (dplane_ctx_pool_list, &dplane_ctx_pools_info.pools, pool)
+			for (i = 0; i < DPLANE_CTX_SIZE_MAX; i++) {
+				h = atomic_load_explicit(&pool->hits[i],
+							 memory_order_relaxed);
+				m = atomic_load_explicit(&pool->misses[i],
+							 memory_order_relaxed);
+				if (h + m == 0)
+					continue;
+				vty_out(vty,
+					"  Pool %u %-6s: %" PRIu64 " hits, %" PRIu64
+					" misses, max %u cached\n",
+					pool->id, dplane_ctx_sizes[i].name, h, m,
+					atomic_load_explicit(&pool->cached_max[i],
+							     memory_order_relaxed));
+			}
+	}
+}
+
 /*
  * Handler for 'show dplane'
  */
 int dplane_show_helper(struct vty *vty, bool detailed)
 {
 	uint64_t queued, queue_max, limit, errs, incoming, yields, other_errs, kernels_skipped;
+	uint64_t coalesced;
 
 	/* Using atomics because counters are being changed in different
 	 * pthread contexts.
@@ -6325,6 +6665,8 @@ int dplane_show_helper(struct vty *vty, bool detailed)
 				    memory_order_relaxed);
 	kernels_skipped = atomic_load_explicit(&zdplane_info.dg_routes_kernel_skipped,
 					       memory_order_relaxed);
+	coalesced = atomic_load_explicit(&zdplane_info.dg_routes_coalesced,
+					 memory_order_relaxed);
 	yields = atomic_load_explicit(&zdplane_info.dg_update_yields,
 				      memory_order_relaxed);
 	other_errs = atomic_load_explicit(&zdplane_info.dg_other_errors,
@@ -6346,8 +6688,22 @@ int dplane_show_helper(struct vty *vty, bool detailed)
 	vty_out(vty, "Route update queue depth: %"PRIu64"\n", queued);
 	vty_out(vty, "Route update queue max:   %"PRIu64"\n", queue_max);
 	vty_out(vty, "Route updates skipped:    %" PRIu64 "\n", kernels_skipped);
+	vty_out(vty, "Route updates coalesced:  %" PRIu64 "\n", coalesced);
 	vty_out(vty, "Dplane update yields:     %"PRIu64"\n", yields);
 
+	if (zdplane_info.dg_kworkers) {
+		uint32_t i;
+
+		vty_out(vty, "Kernel workers:           %u\n",
+			zdplane_info.dg_kernel_workers);
+		for (i = 0; detailed && i < zdplane_info.dg_kernel_workers; i++)
+			vty_out(vty, "  Worker %u: %u updates in %u rounds\n", i,
+				atomic_load_explicit(&zdplane_info.dg_kworkers[i].updates,
+						     memory_order_relaxed),
+				atomic_load_explicit(&zdplane_info.dg_kworkers[i].rounds,
+						     memory_order_relaxed));
+	}
+
 	incoming = atomic_load_explicit(&zdplane_info.dg_lsps_in,
 					memory_order_relaxed);
 	errs = atomic_load_explicit(&zdplane_info.dg_lsp_errors,
@@ -6436,6 +6792,9 @@ int dplane_show_helper(struct vty *vty, bool detailed)
 				    memory_order_relaxed);
 	vty_out(vty, "GRE set updates:       %"PRIu64"\n", incoming);
 	vty_out(vty, "GRE set errors:        %"PRIu64"\n", errs);
+
+	dplane_ctx_pools_show(vty, detailed);
+
 	return CMD_SUCCESS;
 }
 
@@ -7256,16 +7615,186 @@ kernel_dplane_process_ipset_entry(struct zebra_dplane_provider *prov,
 	dplane_provider_enqueue_out_ctx(prov, ctx);
 }
 
+/* Route updates are the only ones spread across kernel dplane workers */
+static bool kernel_dplane_is_sharded(const struct zebra_dplane_ctx *ctx)
+{
+	if (zdplane_info.dg_kernel_workers <= 1)
+		return false;
+
+	switch (dplane_ctx_get_op(ctx)) {
+	case DPLANE_OP_ROUTE_INSTALL:
+	case DPLANE_OP_ROUTE_UPDATE:
+	case DPLANE_OP_ROUTE_DELETE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* All updates to a given route end up on the same worker, in order */
+static uint32_t kernel_dplane_shard(const struct zebra_dplane_ctx *ctx)
+{
+	uint32_t key = prefix_hash_key(dplane_ctx_get_dest(ctx));
+
+	key = jhash_2words(key, dplane_ctx_get_table(ctx), 0);
+	return key % zdplane_info.dg_kernel_workers;
+}
+
+/*
+ * Kernel dplane worker pthread: program the round's updates, then tell the
+ * dplane pthread.
+ */
+static void kernel_dplane_worker_run(struct event *event)
+{
+	struct dplane_kernel_worker *w = EVENT_ARG(event);
+	struct zebra_dplane_ctx *ctx;
+	uint32_t count;
+
+	count = dplane_ctx_queue_count(&w->work_list);
+
+	kernel_update_multi_worker(&w->work_list, w->id);
+
+	frr_each (dplane_ctx_list, &w->work_list, ctx)
+		kernel_dplane_handle_result(ctx);
+
+	atomic_fetch_add_explicit(&w->updates, count, memory_order_relaxed);
+	atomic_fetch_add_explicit(&w->rounds, 1, memory_order_relaxed);
+
+	frr_with_mutex (&zdplane_info.dg_kworker_mutex) {
+		if (--zdplane_info.dg_kworkers_busy == 0)
+			pthread_cond_signal(&zdplane_info.dg_kworker_cond);
+	}
+}
+
+/*
+ * Spread route updates across the kernel dplane workers and wait for all of
+ * them to be done. Updates to a route stay in order since they all hash to
+ * the same worker; the dplane pthread is blocked meanwhile, so ordering
+ * against other kinds of updates (nexthop groups in particular) holds too.
+ */
+static void kernel_dplane_run_workers(struct dplane_ctx_list_head *work_list,
+				      struct dplane_ctx_list_head *done_list)
+{
+	struct dplane_kernel_worker *w;
+	struct zebra_dplane_ctx *ctx;
+	uint32_t i, busy = 0;
+
+	while ((ctx = dplane_ctx_list_pop(work_list)) != NULL) {
+		w = &zdplane_info.dg_kworkers[kernel_dplane_shard(ctx)];
+		dplane_ctx_list_add_tail(&w->work_list, ctx);
+	}
+
+	for (i = 0; i < zdplane_info.dg_kernel_workers; i++)
+		if (dplane_ctx_queue_count(&zdplane_info.dg_kworkers[i].work_list))
+			busy++;
+
+	frr_with_mutex (&zdplane_info.dg_kworker_mutex)
+		zdplane_info.dg_kworkers_busy = busy;
+
+	for (i = 0; i < zdplane_info.dg_kernel_workers; i++) {
+		w = &zdplane_info.dg_kworkers[i];
+		if (dplane_ctx_queue_count(&w->work_list))
+			event_add_event(w->pthread->master,
+					kernel_dplane_worker_run, w, 0,
+					&w->t_work);
+	}
+
+	frr_with_mutex (&zdplane_info.dg_kworker_mutex) {
+		while (zdplane_info.dg_kworkers_busy > 0)
+			pthread_cond_wait(&zdplane_info.dg_kworker_cond,
+					  &zdplane_info.dg_kworker_mutex);
+	}
+
+	for (i = 0; i < zdplane_info.dg_kernel_workers; i++)
+		dplane_ctx_list_append(done_list,
+				       &zdplane_info.dg_kworkers[i].work_list);
+}
+
+/*
+ * Program a run of updates, either all of them route updates for the
+ * workers or none of them.
+ */
+static void kernel_dplane_flush(struct dplane_ctx_list_head *work_list,
+				bool sharded,
+				struct dplane_ctx_list_head *done_list)
+{
+	struct zebra_dplane_ctx *ctx;
+
+	if (dplane_ctx_queue_count(work_list) == 0)
+		return;
+
+	if (sharded) {
+		kernel_dplane_run_workers(work_list, done_list);
+		return;
+	}
+
+	kernel_update_multi(work_list);
+
+	while ((ctx = dplane_ctx_list_pop(work_list)) != NULL) {
+		kernel_dplane_handle_result(ctx);
+		dplane_ctx_list_add_tail(done_list, ctx);
+	}
+}
+
+static void kernel_dplane_workers_start(void)
+{
+	struct frr_pthread_attr pattr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop
+	};
+	struct dplane_kernel_worker *w;
+	char name[64], os_name[OS_THREAD_NAMELEN];
+	uint32_t i;
+
+	if (zdplane_info.dg_kernel_workers <= 1)
+		return;
+
+	zdplane_info.dg_kworkers =
+		XCALLOC(MTYPE_DP_KWORKER, zdplane_info.dg_kernel_workers *
+						  sizeof(*zdplane_info.dg_kworkers));
+
+	for (i = 0; i < zdplane_info.dg_kernel_workers; i++) {
+		w = &zdplane_info.dg_kworkers[i];
+		w->id = i;
+		dplane_ctx_list_init(&w->work_list);
+
+		snprintf(name, sizeof(name), "Zebra dplane kernel worker %u", i);
+		snprintf(os_name, sizeof(os_name), "zebra_dpk%u", i);
+		w->pthread = frr_pthread_new(&pattr, name, os_name);
+		frr_pthread_run(w->pthread, NULL);
+	}
+}
+
+static void kernel_dplane_workers_stop(void)
+{
+	struct dplane_kernel_worker *w;
+	uint32_t i;
+
+	if (!zdplane_info.dg_kworkers)
+		return;
+
+	for (i = 0; i < zdplane_info.dg_kernel_workers; i++) {
+		w = &zdplane_info.dg_kworkers[i];
+		frr_pthread_stop(w->pthread, NULL);
+		frr_pthread_destroy(w->pthread);
+		w->pthread = NULL;
+	}
+
+	XFREE(MTYPE_DP_KWORKER, zdplane_info.dg_kworkers);
+}
+
 /*
  * Kernel provider callback
  */
 static int kernel_dplane_process_func(struct zebra_dplane_provider *prov)
 {
 	struct zebra_dplane_ctx *ctx;
-	struct dplane_ctx_list_head work_list;
+	struct dplane_ctx_list_head work_list, done_list;
 	int counter, limit;
+	bool sharded = false;
 
 	dplane_ctx_list_init(&work_list);
+	dplane_ctx_list_init(&done_list);
 
 	limit = dplane_provider_get_work_limit(prov);
 
@@ -7290,8 +7819,12 @@ static int kernel_dplane_process_func(struct zebra_dplane_provider *prov)
 			continue;
 		}
 
+		/* Not when the update stands in for earlier ones, whose
+		 * nexthops the kernel never got.
+		 */
 		if (zebra_nhg_kernel_nexthops_enabled() &&
 		    dplane_ctx_get_op(ctx) == DPLANE_OP_ROUTE_UPDATE &&
+		    !CHECK_FLAG(ctx->zd_flags, DPLANE_CTX_FLAG_COALESCED) &&
 		    dplane_ctx_get_old_nhe_id(ctx) == dplane_ctx_get_nhe_id(ctx) &&
 		    dplane_ctx_get_old_type(ctx) == dplane_ctx_get_type(ctx)) {
 			if (IS_ZEBRA_DEBUG_DPLANE_DETAIL)
@@ -7314,17 +7847,21 @@ static int kernel_dplane_process_func(struct zebra_dplane_provider *prov)
 			  || dplane_ctx_get_op(ctx)
 				     == DPLANE_OP_IPSET_ENTRY_DELETE))
 			kernel_dplane_process_ipset_entry(prov, ctx);
-		else
+		else {
+			/* Keep runs of worker and non-worker updates apart */
+			if (kernel_dplane_is_sharded(ctx) != sharded) {
+				kernel_dplane_flush(&work_list, sharded,
+						    &done_list);
+				sharded = !sharded;
+			}
 			dplane_ctx_list_add_tail(&work_list, ctx);
+		}
 	}
 
-	kernel_update_multi(&work_list);
-
-	while ((ctx = dplane_ctx_list_pop(&work_list)) != NULL) {
-		kernel_dplane_handle_result(ctx);
+	kernel_dplane_flush(&work_list, sharded, &done_list);
 
+	while ((ctx = dplane_ctx_list_pop(&done_list)) != NULL)
 		dplane_provider_enqueue_out_ctx(prov, ctx);
-	}
 
 	/* Ensure that we'll run the work loop again if there's still
 	 * more work to do.
@@ -7646,6 +8183,113 @@ void zebra_dplane_finish(void)
 			NULL, 0, &zdplane_info.dg_t_shutdown_check);
 }
 
+/*
+ * Can a route update whose kernel programming was skipped be picked up by a
+ * later update for the same destination, given the kernel has the route that
+ * the earlier one replaced? Only where the later update is a plain replace,
+ * which doesn't depend on what exactly the kernel has.
+ */
+static bool dplane_route_update_is_replace(const struct zebra_dplane_ctx *prev,
+					   const struct zebra_dplane_ctx *ctx)
+{
+#if defined(HAVE_NETLINK)
+	if (RSYSTEM_ROUTE(prev->u.rinfo.zd_old_type) ||
+	    RSYSTEM_ROUTE(ctx->u.rinfo.zd_old_type) ||
+	    RSYSTEM_ROUTE(ctx->u.rinfo.zd_type))
+		return false;
+
+	return ctx->u.rinfo.zd_dest.family == AF_INET ||
+	       zrouter.zav.v6_rr_semantics;
+#else
+	/* Updates are per-nexthop deletes and adds of the old route */
+	return false;
+#endif
+}
+
+/*
+ * Let route update 'ctx' take over the kernel programming of the earlier,
+ * still unprocessed 'prev' for the same destination. 'prev' is left in
+ * place, to be returned to zebra in order and with success once it has been
+ * through the providers, but it bypasses the kernel. Returns the number of
+ * updates that won't reach the kernel.
+ */
+static int dplane_route_coalesce(struct zebra_dplane_ctx *prev,
+				 struct zebra_dplane_ctx *ctx)
+{
+	switch (prev->zd_op) {
+	case DPLANE_OP_ROUTE_INSTALL:
+		/* The kernel doesn't have the route yet: an install followed
+		 * by a delete is nothing at all, and anything else an install
+		 * of the last version.
+		 */
+		if (ctx->zd_op == DPLANE_OP_ROUTE_DELETE) {
+			dplane_ctx_set_skip_kernel(prev);
+			dplane_ctx_set_skip_kernel(ctx);
+			return 2;
+		}
+		ctx->zd_op = DPLANE_OP_ROUTE_INSTALL;
+		break;
+	case DPLANE_OP_ROUTE_UPDATE:
+		if (ctx->zd_op != DPLANE_OP_ROUTE_UPDATE ||
+		    !dplane_route_update_is_replace(prev, ctx))
+			return 0;
+		break;
+	default:
+		return 0;
+	}
+
+	dplane_ctx_set_skip_kernel(prev);
+	SET_FLAG(ctx->zd_flags, DPLANE_CTX_FLAG_COALESCED);
+	return 1;
+}
+
+/*
+ * Coalesce the route updates in a batch of new work: when a route flaps,
+ * zebra queues an update for every change, and only the last one for each
+ * destination needs to reach the kernel. The rest still go through the
+ * providers and back to zebra, so that every one of them gets its result,
+ * in order, and the owner its notifications.
+ */
+static void dplane_routes_coalesce(struct dplane_ctx_list_head *work_list)
+{
+	struct dplane_route_pend_head pend;
+	struct zebra_dplane_ctx *ctx, *prev;
+	uint32_t coalesced = 0;
+
+	dplane_route_pend_init(&pend);
+
+	frr_each (dplane_ctx_list, work_list, ctx) {
+		if ((ctx->zd_op != DPLANE_OP_ROUTE_INSTALL &&
+		     ctx->zd_op != DPLANE_OP_ROUTE_UPDATE &&
+		     ctx->zd_op != DPLANE_OP_ROUTE_DELETE) ||
+		    ctx->zd_status != ZEBRA_DPLANE_REQUEST_SUCCESS ||
+		    dplane_ctx_is_skip_kernel(ctx))
+			continue;
+
+		prev = dplane_route_pend_find(&pend, ctx);
+		if (prev) {
+			dplane_route_pend_del(&pend, prev);
+			coalesced += dplane_route_coalesce(prev, ctx);
+		}
+
+		if (!dplane_ctx_is_skip_kernel(ctx))
+			dplane_route_pend_add(&pend, ctx);
+	}
+
+	while (dplane_route_pend_pop(&pend))
+		;
+	dplane_route_pend_fini(&pend);
+
+	if (coalesced) {
+		atomic_fetch_add_explicit(&zdplane_info.dg_routes_coalesced,
+					  coalesced, memory_order_relaxed);
+
+		if (IS_ZEBRA_DEBUG_DPLANE_DETAIL)
+			zlog_debug("dplane: %u route updates coalesced",
+				   coalesced);
+	}
+}
+
 /*
  * Main dataplane pthread event loop. The thread takes new incoming work
  * and offers it to the first provider. It then iterates through the
@@ -7738,6 +8382,9 @@ static void dplane_thread_loop(struct event *event)
 	if (IS_ZEBRA_DEBUG_DPLANE_DETAIL)
 		zlog_debug("dplane: incoming new work counter: %d", counter);
 
+	if (counter > 1)
+		dplane_routes_coalesce(&work_list);
+
 	/* Iterate through the registered providers, offering new incoming
 	 * work. If the provider has outgoing work in its queue, take that
 	 * work for the next provider
@@ -7940,6 +8587,9 @@ void zebra_dplane_shutdown(void)
 	zdplane_info.dg_pthread = NULL;
 	zdplane_info.dg_master = NULL;
 
+	/* The workers only ever run on behalf of the dplane pthread */
+	kernel_dplane_workers_stop();
+
 	/* Notify provider(s) of final shutdown.
 	 * Note that this call is in the main pthread, so providers must
 	 * be prepared for that.
@@ -8000,6 +8650,10 @@ void zebra_dplane_shutdown(void)
 
 	/* Destroy global mutex */
 	pthread_mutex_destroy(&zdplane_info.dg_mutex);
+	pthread_mutex_destroy(&zdplane_info.dg_kworker_mutex);
+	pthread_cond_destroy(&zdplane_info.dg_kworker_cond);
+
+	dplane_ctx_pools_fini();
 }
 
 /*
@@ -8013,6 +8667,10 @@ static void zebra_dplane_init_internal(void)
 
 	dplane_prov_list_init(&zdplane_info.dg_providers);
 
+	zdplane_info.dg_kernel_workers = dplane_kernel_workers;
+	pthread_mutex_init(&zdplane_info.dg_kworker_mutex, NULL);
+	pthread_cond_init(&zdplane_info.dg_kworker_cond, NULL);
+
 	frr_with_mutex (&zdplane_info.dg_mutex) {
 		dplane_ctx_list_init(&zdplane_info.dg_update_list);
 	}
@@ -8027,6 +8685,16 @@ static void zebra_dplane_init_internal(void)
 	dplane_provider_init();
 }
 
+void dplane_set_kernel_workers(uint32_t count)
+{
+	dplane_kernel_workers = MAX(1U, MIN(count, DPLANE_KERNEL_WORKERS_MAX));
+}
+
+uint32_t dplane_get_kernel_workers(void)
+{
+	return dplane_kernel_workers;
+}
+
 /*
  * Start the dataplane pthread. This step needs to be run later than the
  * 'init' step, in case zebra has fork-ed.
@@ -8077,6 +8745,8 @@ void zebra_dplane_start(void)
 		prov = dplane_prov_list_next(&zdplane_info.dg_providers, prov);
 	}
 
+	kernel_dplane_workers_start();
+
 	frr_pthread_run(zdplane_info.dg_pthread, NULL);
 }
 
@@ -298,6 +298,12 @@ PREDECL_DLIST(dplane_intf_extra_list);
 /* Allocate a context object */
 struct zebra_dplane_ctx *dplane_ctx_alloc(void);
 
+/*
+ * Allocate a smaller context object, for route updates only: it must not
+ * be reset and reused for any other kind of update.
+ */
+struct zebra_dplane_ctx *dplane_ctx_route_alloc(void);
+
 /*
  * Reset an allocated context object for re-use. All internal allocations are
  * freed.
@@ -888,6 +894,8 @@ void dplane_ctx_set_netconf_linkdown(struct zebra_dplane_ctx *ctx,
 const struct zebra_dplane_info *dplane_ctx_get_ns(
 	const struct zebra_dplane_ctx *ctx);
 int dplane_ctx_get_ns_sock(const struct zebra_dplane_ctx *ctx);
+/* Redirect a context to another programming channel of the same ns */
+void dplane_ctx_set_ns_sock(struct zebra_dplane_ctx *ctx, int sock);
 
 /* Indicates zebra shutdown/exit is in progress. Some operations may be
  * simplified or skipped during shutdown processing.
@@ -1296,6 +1304,16 @@ void dplane_enable_intf_extra_info(void);
  */
 void zebra_dplane_init(int (*)(struct dplane_ctx_list_head *));
 
+/*
+ * Number of pthreads programming route updates into the kernel. With more
+ * than one, route updates are sharded across them by prefix, each worker
+ * using its own OS channel; all other updates stay on the dplane pthread.
+ * Must be set before zebra_dplane_init().
+ */
+#define DPLANE_KERNEL_WORKERS_MAX 16
+void dplane_set_kernel_workers(uint32_t count);
+uint32_t dplane_get_kernel_workers(void);
+
 /*
  * Start the dataplane pthread. This step needs to be run later than the
  * 'init' step, in case zebra has fork-ed.
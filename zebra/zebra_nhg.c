@@ -34,6 +34,7 @@
 DEFINE_MTYPE_STATIC(ZEBRA, NHG, "Nexthop Group Entry");
 DEFINE_MTYPE_STATIC(ZEBRA, NHG_CONNECTED, "Nexthop Group Connected");
 DEFINE_MTYPE_STATIC(ZEBRA, NHG_CTX, "Nexthop Group Context");
+DEFINE_MTYPE_STATIC(ZEBRA, NHG_VEC, "Nexthop Group Vector");
 
 /* Map backup nexthop indices between two nhes */
 struct backup_nh_map_s {
@@ -45,6 +46,30 @@ struct backup_nh_map_s {
 	} map[MULTIPATH_NUM];
 };
 
+/*
+ * Interned nexthops of a group: the primary nexthops in nexthop_next()
+ * order, resolved ones included, then the backup nexthops, copied into
+ * one array.  Vectors are kept in zrouter.nhg_vecs, so nhes with the same
+ * nexthops share one and comparing them is a pointer compare.
+ */
+struct nhg_vec {
+	uint32_t refcnt;
+
+	/* nexthop_group_hash() of the primary and of the backup nexthops */
+	uint32_t primary_key;
+	uint32_t backup_key;
+
+	uint32_t num;
+	uint32_t backup_num;
+	bool has_backup;
+
+	/* Set in a lookup only, then nh[] is empty */
+	const struct nexthop_group *nhg;
+	const struct nexthop_group *backup_nhg;
+
+	struct nexthop nh[];
+};
+
 /* id counter to keep in sync with kernel */
 uint32_t id_counter;
 
@@ -67,6 +92,9 @@ static void depends_decrement_free(struct nhg_connected_tree_head *head);
 static struct nhg_backup_info *
 nhg_backup_copy(const struct nhg_backup_info *orig);
 
+static struct nhg_vec *nhg_vec_get(const struct nhg_hash_entry *nhe);
+static void nhg_vec_put(struct nhg_vec **pvec);
+
 const char *zebra_nhg_afi2str(struct nhg_hash_entry *nhe)
 {
 	if (nhe->afi == AFI_UNSPEC)
@@ -426,6 +454,11 @@ struct nhg_hash_entry *zebra_nhe_copy(const struct nhg_hash_entry *orig,
 	nhe->refcnt = 0;
 	nhe->dplane_ref = zebra_router_get_next_sequence();
 
+	/* Share the interned nexthops until the copy is looked up */
+	nhe->nhv = orig->nhv;
+	if (nhe->nhv)
+		nhe->nhv->refcnt++;
+
 	/* Copy backup info also, if present */
 	if (orig->backup_info)
 		nhe->backup_info = nhg_backup_copy(orig->backup_info);
@@ -479,18 +512,17 @@ static void *zebra_nhg_hash_alloc(void *arg)
 	return nhe;
 }
 
+/*
+ * Only interned nhes are hashed: those in zrouter.nhgs, and the lookup
+ * in zebra_nhe_find().
+ */
 uint32_t zebra_nhg_hash_key(const void *arg)
 {
 	const struct nhg_hash_entry *nhe = arg;
 	uint32_t key = 0x5a351234;
-	uint32_t primary = 0;
-	uint32_t backup = 0;
-
-	primary = nexthop_group_hash(&(nhe->nhg));
-	if (nhe->backup_info)
-		backup = nexthop_group_hash(&(nhe->backup_info->nhe->nhg));
 
-	key = jhash_3words(primary, backup, nhe->type, key);
+	key = jhash_3words(nhe->nhv->primary_key, nhe->nhv->backup_key,
+			   nhe->type, key);
 
 	key = jhash_2words(nhe->vrf_id, nhe->afi, key);
 
@@ -548,8 +580,9 @@ bool zebra_nhg_hash_equal(const void *arg1, const void *arg2)
 {
 	const struct nhg_hash_entry *nhe1 = arg1;
 	const struct nhg_hash_entry *nhe2 = arg2;
-	struct nexthop *nexthop1;
-	struct nexthop *nexthop2;
+
+	if (nhe1 == nhe2)
+		return true;
 
 	/* If both NHG's have id's then we can just know that
 	 * they are either identical or not.  This comparison
@@ -582,58 +615,150 @@ bool zebra_nhg_hash_equal(const void *arg1, const void *arg2)
 	if (nhe1->nhg.nhgr.unbalanced_timer != nhe2->nhg.nhgr.unbalanced_timer)
 		return false;
 
-	/* Nexthops should be in-order, so we simply compare them in-place */
-	for (nexthop1 = nhe1->nhg.nexthop, nexthop2 = nhe2->nhg.nexthop;
-	     nexthop1 && nexthop2;
-	     nexthop1 = nexthop_next(nexthop1), nexthop2 = nexthop_next(nexthop2)) {
-		if (!nhg_compare_nexthops(nexthop1, nexthop2))
-			return false;
-	}
+	/* Both are interned, the same nexthops are the same vector */
+	return nhe1->nhv == nhe2->nhv;
+}
 
-	/* Check for unequal list lengths */
-	if (nexthop1 || nexthop2)
-		return false;
+bool zebra_nhg_hash_id_equal(const void *arg1, const void *arg2)
+{
+	const struct nhg_hash_entry *nhe1 = arg1;
+	const struct nhg_hash_entry *nhe2 = arg2;
+
+	return nhe1->id == nhe2->id;
+}
 
-	/* If there's no backup info, comparison is done. */
-	if ((nhe1->backup_info == NULL) && (nhe2->backup_info == NULL))
+uint32_t zebra_nhg_vec_hash_key(const void *arg)
+{
+	const struct nhg_vec *vec = arg;
+
+	return jhash_3words(vec->primary_key, vec->backup_key, vec->has_backup,
+			    0x5a351234);
+}
+
+/*
+ * Stored vectors are unique, so only a lookup can match one: compare the
+ * lookup's nexthops in place against the stored array.
+ */
+bool zebra_nhg_vec_hash_equal(const void *arg1, const void *arg2)
+{
+	const struct nhg_vec *vec = arg1;
+	const struct nhg_vec *lookup = arg2;
+	struct nexthop *nh;
+	uint32_t i = 0;
+
+	if (vec == lookup)
 		return true;
 
-	/* Compare backup info also - test the easy things first */
-	if (nhe1->backup_info && (nhe2->backup_info == NULL))
+	if (vec->nhg) {
+		vec = arg2;
+		lookup = arg1;
+	}
+
+	if (vec->nhg || !lookup->nhg)
 		return false;
-	if (nhe2->backup_info && (nhe1->backup_info == NULL))
+
+	if (vec->primary_key != lookup->primary_key ||
+	    vec->backup_key != lookup->backup_key ||
+	    vec->has_backup != lookup->has_backup)
+		return false;
+
+	if (vec->num != lookup->num || vec->backup_num != lookup->backup_num)
 		return false;
 
-	/* Compare number of backups before actually comparing any */
-	for (nexthop1 = nhe1->backup_info->nhe->nhg.nexthop,
-	     nexthop2 = nhe2->backup_info->nhe->nhg.nexthop;
-	     nexthop1 && nexthop2;
-	     nexthop1 = nexthop1->next, nexthop2 = nexthop2->next) {
-		;
+	for (ALL_NEXTHOPS_PTR(lookup->nhg, nh)) {
+		if (!nhg_compare_nexthops(nh, &vec->nh[i++]))
+			return false;
 	}
 
-	/* Did we find the end of one list before the other? */
-	if (nexthop1 || nexthop2)
-		return false;
+	if (!lookup->backup_nhg)
+		return true;
 
-	/* Have to compare the backup nexthops */
-	for (nexthop1 = nhe1->backup_info->nhe->nhg.nexthop,
-	     nexthop2 = nhe2->backup_info->nhe->nhg.nexthop;
-	     nexthop1 && nexthop2;
-	     nexthop1 = nexthop_next(nexthop1), nexthop2 = nexthop_next(nexthop2)) {
-		if (!nhg_compare_nexthops(nexthop1, nexthop2))
+	for (ALL_NEXTHOPS_PTR(lookup->backup_nhg, nh)) {
+		if (!nhg_compare_nexthops(nh, &vec->nh[i++]))
 			return false;
 	}
 
 	return true;
 }
 
-bool zebra_nhg_hash_id_equal(const void *arg1, const void *arg2)
+/*
+ * Intern the nexthops of an nhe: hash them once, and copy them only if no
+ * other nhe has the same ones.  Returns a referenced vector.
+ */
+static struct nhg_vec *nhg_vec_get(const struct nhg_hash_entry *nhe)
 {
-	const struct nhg_hash_entry *nhe1 = arg1;
-	const struct nhg_hash_entry *nhe2 = arg2;
+	struct nhg_vec lookup = {};
+	struct nhg_vec *vec;
+	struct nexthop *nh;
+	uint32_t i = 0;
 
-	return nhe1->id == nhe2->id;
+	lookup.nhg = &nhe->nhg;
+	for (ALL_NEXTHOPS_PTR(lookup.nhg, nh)) {
+		lookup.primary_key = jhash_1word(nexthop_hash(nh),
+						 lookup.primary_key);
+		lookup.num++;
+	}
+
+	if (nhe->backup_info) {
+		lookup.has_backup = true;
+		lookup.backup_nhg = &nhe->backup_info->nhe->nhg;
+		for (ALL_NEXTHOPS_PTR(lookup.backup_nhg, nh)) {
+			lookup.backup_key = jhash_1word(nexthop_hash(nh),
+							lookup.backup_key);
+			lookup.backup_num++;
+		}
+	}
+
+	vec = hash_lookup(zrouter.nhg_vecs, &lookup);
+	if (!vec) {
+		vec = XCALLOC(MTYPE_NHG_VEC,
+			      sizeof(*vec) + (lookup.num + lookup.backup_num) *
+						     sizeof(struct nexthop));
+		vec->primary_key = lookup.primary_key;
+		vec->backup_key = lookup.backup_key;
+		vec->num = lookup.num;
+		vec->backup_num = lookup.backup_num;
+		vec->has_backup = lookup.has_backup;
+
+		for (ALL_NEXTHOPS_PTR(lookup.nhg, nh))
+			nexthop_copy_no_recurse(&vec->nh[i++], nh, NULL);
+		if (lookup.backup_nhg) {
+			for (ALL_NEXTHOPS_PTR(lookup.backup_nhg, nh))
+				nexthop_copy_no_recurse(&vec->nh[i++], nh,
+							NULL);
+		}
+
+		(void)hash_get(zrouter.nhg_vecs, vec, hash_alloc_intern);
+	}
+
+	vec->refcnt++;
+
+	return vec;
+}
+
+static void nhg_vec_put(struct nhg_vec **pvec)
+{
+	struct nhg_vec *vec = *pvec;
+	uint32_t i;
+
+	if (!vec)
+		return;
+
+	*pvec = NULL;
+
+	assert(vec->refcnt > 0);
+	if (--vec->refcnt > 0)
+		return;
+
+	hash_release(zrouter.nhg_vecs, vec);
+
+	for (i = 0; i < vec->num + vec->backup_num; i++) {
+		nexthop_del_labels(&vec->nh[i]);
+		nexthop_del_srv6_seg6local(&vec->nh[i]);
+		nexthop_del_srv6_seg6(&vec->nh[i]);
+	}
+
+	XFREE(MTYPE_NHG_VEC, vec);
 }
 
 static int zebra_nhg_process_grp(struct nexthop_group *nhg, struct nhg_connected_tree_head *depends,
@@ -710,7 +835,16 @@ static bool zebra_nhe_find(struct nhg_hash_entry **nhe, /* return value */
 	bool recursive = false;
 	struct nhg_hash_entry *newnhe, *backup_nhe;
 	struct nexthop *nh = NULL;
+	struct nhg_vec *nhv = lookup->nhv;
 
+	/*
+	 * Intern the nexthops once, for the lookup and for the insert.  A
+	 * copy shares the vector of the nhe it came from, but the caller may
+	 * have changed its nexthops since, so intern them again; holding the
+	 * old vector until then means an unchanged copy just finds it.
+	 */
+	lookup->nhv = nhg_vec_get(lookup);
+	nhg_vec_put(&nhv);
 
 	if (lookup->id)
 		(*nhe) = zebra_nhg_lookup_id(lookup->id);
@@ -863,6 +997,9 @@ static bool zebra_nhe_find(struct nhg_hash_entry **nhe, /* return value */
 		SET_FLAG(backup_nhe->flags, NEXTHOP_GROUP_RECURSIVE);
 
 done:
+	/* The caller may change its nhe once we are done */
+	nhg_vec_put(&lookup->nhv);
+
 	/* Reset time since last update */
 	(*nhe)->uptime = monotime(NULL);
 
@@ -1691,6 +1828,8 @@ static void zebra_nhg_free_members(struct nhg_hash_entry *nhe)
 {
 	nexthops_free(nhe->nhg.nexthop);
 
+	nhg_vec_put(&nhe->nhv);
+
 	zebra_nhg_backup_free(&nhe->backup_info);
 
 	/* Decrement to remove connection ref */
@@ -1742,6 +1881,8 @@ void zebra_nhg_hash_free(void *p)
 
 	nexthops_free(nhe->nhg.nexthop);
 
+	nhg_vec_put(&nhe->nhv);
+
 	XFREE(MTYPE_NHG, nhe);
 }
 
@@ -3180,15 +3321,189 @@ static struct nhg_hash_entry *zebra_nhg_rib_compare_old_nhe(
 		return new_nhe;
 }
 
+/*
+ * The address nexthop_active() looks up in the routing table for this
+ * nexthop, if any.
+ */
+static bool nexthop_lookup_prefix(const struct nexthop *nexthop,
+				  struct prefix *p)
+{
+	memset(p, 0, sizeof(*p));
+
+	switch (nexthop->type) {
+	case NEXTHOP_TYPE_IPV4:
+	case NEXTHOP_TYPE_IPV4_IFINDEX:
+		p->family = AF_INET;
+		p->prefixlen = IPV4_MAX_BITLEN;
+		p->u.prefix4 = nexthop->gate.ipv4;
+		return true;
+	case NEXTHOP_TYPE_IPV6:
+	case NEXTHOP_TYPE_IPV6_IFINDEX:
+		if (IS_MAPPED_IPV6(&nexthop->gate.ipv6)) {
+			p->family = AF_INET;
+			p->prefixlen = IPV4_MAX_BITLEN;
+			ipv4_mapped_ipv6_to_ipv4(&nexthop->gate.ipv6,
+						 &p->u.prefix4);
+		} else {
+			p->family = AF_INET6;
+			p->prefixlen = IPV6_MAX_BITLEN;
+			p->u.prefix6 = nexthop->gate.ipv6;
+		}
+		return true;
+	case NEXTHOP_TYPE_IFINDEX:
+	case NEXTHOP_TYPE_BLACKHOLE:
+		break;
+	}
+
+	return false;
+}
+
+/*
+ * Can the nexthops of this route entry be resolved off the main pthread?
+ * Only if resolving them reads nothing but the tables of the route's own
+ * vrf, none of them resolves over the route's own node, and no route-map
+ * has to be run.
+ */
+static bool nexthop_prepare_allowed(struct route_node *rn,
+				    struct route_entry *re, vrf_id_t vrf_id)
+{
+	const struct prefix *dst_p, *src_p;
+	const struct nexthop_group *nhg;
+	struct nexthop *nexthop;
+	struct zebra_vrf *zvrf;
+	struct prefix p;
+
+	srcdest_rnode_prefixes(rn, &dst_p, &src_p);
+
+	zvrf = zebra_vrf_lookup_by_id(re->vrf_id);
+	if (zvrf && zebra_route_map_configured(zvrf, re->type))
+		return false;
+
+	nhg = &re->nhe->nhg;
+	while (nhg) {
+		for (nexthop = nhg->nexthop; nexthop; nexthop = nexthop->next) {
+			if (nexthop->vrf_id != vrf_id)
+				return false;
+			if (nexthop_lookup_prefix(nexthop, &p) &&
+			    prefix_match(dst_p, &p))
+				return false;
+		}
+
+		if (nhg == &re->nhe->nhg && re->nhe->backup_info &&
+		    re->nhe->backup_info->nhe)
+			nhg = &re->nhe->backup_info->nhe->nhg;
+		else
+			nhg = NULL;
+	}
+
+	return true;
+}
+
+/*
+ * First half of nexthop_active_update(), for a RIB worker pthread: resolve
+ * a local copy of the route entry's nhe.  The main pthread must be waiting
+ * for the workers, and all route entries of a vrf must be handled by the
+ * same worker, as the lookups lock and unlock that vrf's route nodes.
+ *
+ * Nothing shared is written to; the entry's status and mtu changes are
+ * made to a copy and recorded in prep.
+ *
+ * Returns false if this entry has to be resolved on the main pthread.
+ */
+bool nexthop_active_prepare(struct route_node *rn, struct route_entry *re,
+			    struct nhe_prepared *prep)
+{
+	struct route_entry shadow;
+	struct nhg_hash_entry *curr_nhe;
+	vrf_id_t vrf_id;
+
+	memset(prep, 0, sizeof(*prep));
+
+	if (PROTO_OWNED(re->nhe) ||
+	    CHECK_FLAG(re->nhe->flags, NEXTHOP_GROUP_RECEIVED_FROM_EXTERNAL))
+		return false;
+
+	vrf_id = zvrf_id(rib_dest_vrf(rib_dest_from_rnode(rn)));
+	if (!nexthop_prepare_allowed(rn, re, vrf_id))
+		return false;
+
+	shadow = *re;
+	UNSET_FLAG(shadow.status, ROUTE_ENTRY_CHANGED);
+
+	curr_nhe = zebra_nhe_copy(re->nhe, re->nhe->id);
+	curr_nhe->id = 0;
+
+	prep->curr_active = nexthop_list_active_update(rn, &shadow, curr_nhe,
+						       false);
+	if (zebra_nhg_get_backup_nhg(curr_nhe))
+		nexthop_list_active_update(rn, &shadow,
+					   curr_nhe->backup_info->nhe, true);
+
+	prep->re = re;
+	prep->orig = re->nhe;
+	prep->nhe = curr_nhe;
+	prep->changed = CHECK_FLAG(shadow.status, ROUTE_ENTRY_CHANGED);
+	prep->nexthop_mtu = shadow.nexthop_mtu;
+	prep->labels_changed = CHECK_FLAG(re->status,
+					  ROUTE_ENTRY_LABELS_CHANGED);
+
+	return true;
+}
+
+/*
+ * Could the resolution in prep have come out differently, now that the
+ * route nodes in changed[] have been processed?  Only the nodes covering a
+ * nexthop's address are looked at when resolving it.
+ */
+bool nexthop_prepared_stale(const struct nhe_prepared *prep,
+			    struct route_table *const changed[AFI_MAX])
+{
+	const struct nexthop_group *nhg;
+	struct nexthop *nexthop;
+	struct route_node *rn;
+	struct prefix p;
+
+	nhg = &prep->orig->nhg;
+	while (nhg) {
+		for (nexthop = nhg->nexthop; nexthop; nexthop = nexthop->next) {
+			if (!nexthop_lookup_prefix(nexthop, &p))
+				continue;
+
+			rn = route_node_match(changed[family2afi(p.family)], &p);
+			if (rn) {
+				route_unlock_node(rn);
+				return true;
+			}
+		}
+
+		if (nhg == &prep->orig->nhg && prep->orig->backup_info &&
+		    prep->orig->backup_info->nhe)
+			nhg = &prep->orig->backup_info->nhe->nhg;
+		else
+			nhg = NULL;
+	}
+
+	return false;
+}
+
+void nexthop_prepared_free(struct nhe_prepared *prep)
+{
+	if (prep->nhe)
+		zebra_nhg_free(prep->nhe);
+	prep->nhe = NULL;
+}
+
 /*
  * Iterate over all nexthops of the given RIB entry and refresh their
  * ACTIVE flag.  If any nexthop is found to toggle the ACTIVE flag,
  * the whole re structure is flagged with ROUTE_ENTRY_CHANGED.
  *
+ * If a RIB worker already did that for this entry, prep has the result.
+ *
  * Return value is the new number of active nexthops.
  */
 int nexthop_active_update(struct route_node *rn, struct route_entry *re,
-			  struct route_entry *old_re)
+			  struct route_entry *old_re, struct nhe_prepared *prep)
 {
 	struct nhg_hash_entry *curr_nhe, *remove;
 	uint32_t curr_active = 0, backup_active = 0;
@@ -3201,6 +3516,24 @@ int nexthop_active_update(struct route_node *rn, struct route_entry *re,
 
 	UNSET_FLAG(re->status, ROUTE_ENTRY_CHANGED);
 
+	if (prep && prep->nhe && prep->re == re && prep->orig == re->nhe &&
+	    prep->labels_changed ==
+		    CHECK_FLAG(re->status, ROUTE_ENTRY_LABELS_CHANGED)) {
+		curr_nhe = prep->nhe;
+		prep->nhe = NULL;
+
+		curr_active = prep->curr_active;
+		re->nexthop_mtu = prep->nexthop_mtu;
+		if (prep->changed)
+			SET_FLAG(re->status, ROUTE_ENTRY_CHANGED);
+
+		if (IS_ZEBRA_DEBUG_NHG_DETAIL)
+			zlog_debug("%s: re %p nhe %p (%pNG), prepared curr_nhe %p curr_active %u",
+				   __func__, re, re->nhe, re->nhe, curr_nhe,
+				   curr_active);
+		goto backups_done;
+	}
+
 	/* Make a local copy of the existing nhe, so we don't work on/modify
 	 * the shared nhe.
 	 */
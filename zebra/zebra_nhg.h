@@ -27,6 +27,8 @@ struct nh_grp {
 
 PREDECL_RBTREE_UNIQ(nhg_connected_tree);
 
+struct nhg_vec;
+
 /*
  * Hashtables containing nhg entries is in `zebra_router`.
  */
@@ -61,6 +63,9 @@ struct nhg_hash_entry {
 	uint32_t refcnt;
 	uint32_t dplane_ref;
 
+	/* Interned nexthops, see struct nhg_vec in zebra_nhg.c */
+	struct nhg_vec *nhv;
+
 	uint32_t flags;
 
 	/* Dependency trees for other entries.
@@ -313,6 +318,9 @@ extern uint32_t zebra_nhg_id_key(const void *arg);
 extern bool zebra_nhg_hash_equal(const void *arg1, const void *arg2);
 extern bool zebra_nhg_hash_id_equal(const void *arg1, const void *arg2);
 
+extern uint32_t zebra_nhg_vec_hash_key(const void *arg);
+extern bool zebra_nhg_vec_hash_equal(const void *arg1, const void *arg2);
+
 /*
  * Process a context off of a queue.
  * Specifically this should be from
@@ -406,9 +414,40 @@ extern void zebra_nhg_mark_keep(void);
 
 /* Nexthop resolution processing */
 struct route_entry; /* Forward ref to avoid circular includes */
+struct route_table;
 extern void nexthop_vrf_update(struct route_node *rn, struct route_entry *re, vrf_id_t vrf_id);
+
+/*
+ * Nexthop resolution of a route entry done ahead of rib_process(), by a
+ * RIB worker pthread, into a local copy of its nhe.  The rest of
+ * nexthop_active_update() still runs on the main pthread.
+ */
+struct nhe_prepared {
+	struct route_entry *re;
+
+	/* re->nhe the copy was made from */
+	struct nhg_hash_entry *orig;
+
+	/* Resolved copy, or NULL once handed over */
+	struct nhg_hash_entry *nhe;
+
+	uint32_t curr_active;
+	uint32_t changed;
+	uint32_t nexthop_mtu;
+
+	/* ROUTE_ENTRY_LABELS_CHANGED, as the resolution saw it */
+	uint32_t labels_changed;
+};
+
+extern bool nexthop_active_prepare(struct route_node *rn,
+				   struct route_entry *re,
+				   struct nhe_prepared *prep);
+extern bool nexthop_prepared_stale(const struct nhe_prepared *prep,
+				   struct route_table *const changed[AFI_MAX]);
+extern void nexthop_prepared_free(struct nhe_prepared *prep);
 extern int nexthop_active_update(struct route_node *rn, struct route_entry *re,
-				 struct route_entry *old_re);
+				 struct route_entry *old_re,
+				 struct nhe_prepared *prep);
 
 extern const char *zebra_nhg_afi2str(struct nhg_hash_entry *nhe);
 
@@ -33,6 +33,10 @@ struct nlsock {
 
 	uint8_t *buf;
 	size_t buflen;
+
+	/* Programming channels of the kernel dplane workers, dplane out only */
+	struct nlsock *workers;
+	uint32_t n_workers;
 };
 #endif
 
@@ -59,6 +59,7 @@ DEFINE_MTYPE(ZEBRA, RE,       "Route Entry");
 DEFINE_MTYPE_STATIC(ZEBRA, RIB_DEST,       "RIB destination");
 DEFINE_MTYPE_STATIC(ZEBRA, RIB_UPDATE_CTX, "Rib update context object");
 DEFINE_MTYPE_STATIC(ZEBRA, WQ_WRAPPER, "WQ wrapper");
+DEFINE_MTYPE_STATIC(ZEBRA, RIB_WORKER, "RIB worker");
 
 /*
  * Event, list, and mutex for delivery of dataplane results
@@ -72,6 +73,56 @@ DEFINE_HOOK(rib_update, (struct route_node * rn, const char *reason),
 	    (rn, reason));
 DEFINE_HOOK(rib_shutdown, (struct route_node * rn), (rn));
 
+/*
+ * RIB workers: when there are several, the nexthops of a batch of route
+ * nodes are resolved by these pthreads before the main pthread processes
+ * the nodes one by one.  Each vrf belongs to one worker.
+ */
+static uint32_t rib_workers = 1;
+
+/* Route nodes taken off a sub-queue in one go */
+#define RIB_BATCH_MAX 256
+
+struct rib_worker {
+	uint32_t id;
+	struct frr_pthread *pthread;
+	struct event *t_work;
+
+	/* Route entries resolved */
+	_Atomic uint32_t prepared;
+};
+
+struct rib_batch_node {
+	struct route_node *rn;
+	uint32_t worker;
+
+	/* Prepared resolution of the node's changed route entries */
+	struct nhe_prepared *preps;
+	uint32_t npreps;
+};
+
+static struct rib_batch {
+	struct rib_worker *workers;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	uint32_t busy;
+
+	struct rib_batch_node nodes[RIB_BATCH_MAX];
+	uint32_t nnodes;
+
+	struct nhe_prepared *preps;
+	uint32_t preps_size;
+
+	/* Route nodes of this batch processed so far */
+	struct route_table *changed[AFI_MAX];
+
+	/* Counters */
+	_Atomic uint32_t batches;
+	_Atomic uint32_t used;
+	_Atomic uint32_t stale;
+} rib_batch;
+
 
 /*
  * Meta Q's specific names
@@ -284,10 +335,18 @@ int zebra_show_metaq_counter(struct vty *vty, bool uj)
 	char *table = NULL;
 	json_object *json = NULL;
 	json_object *json_table = NULL;
+	uint32_t batches, prepared = 0, used, stale, i;
 
 	if (!mq)
 		return CMD_WARNING;
 
+	batches = atomic_load_explicit(&rib_batch.batches, memory_order_relaxed);
+	used = atomic_load_explicit(&rib_batch.used, memory_order_relaxed);
+	stale = atomic_load_explicit(&rib_batch.stale, memory_order_relaxed);
+	for (i = 0; rib_batch.workers && i < rib_workers; i++)
+		prepared += atomic_load_explicit(&rib_batch.workers[i].prepared,
+						 memory_order_relaxed);
+
 	/* Create a table for subqueue details */
 	tt = ttable_new(&ttable_styles[TTSTYLE_ASCII]);
 	ttable_add_row(tt, "SubQ|Current|Max Size|Total");
@@ -314,12 +373,25 @@ int zebra_show_metaq_counter(struct vty *vty, bool uj)
 		/* n = name/string, u = unsigned int */
 		json_table = ttable_json(tt, "sddd");
 		json_object_object_add(json, "subqueues", json_table);
+		if (rib_batch.workers) {
+			json_object_int_add(json, "ribWorkers", rib_workers);
+			json_object_int_add(json, "ribBatches", batches);
+			json_object_int_add(json, "ribPrepared", prepared);
+			json_object_int_add(json, "ribPreparedUsed", used);
+			json_object_int_add(json, "ribPreparedStale", stale);
+		}
 		vty_json(vty, json);
 	} else {
 		vty_out(vty, "MetaQ Summary\n");
 		vty_out(vty, "Current Size\t: %u\n", mq->size);
 		vty_out(vty, "Max Size\t: %u\n", mq->max_metaq);
 		vty_out(vty, "Total\t\t: %u\n", mq->total_metaq);
+		if (rib_batch.workers) {
+			vty_out(vty, "RIB Workers\t: %u\n", rib_workers);
+			vty_out(vty, "Batches\t\t: %u\n", batches);
+			vty_out(vty, "Prepared\t: %u (used %u, stale %u)\n",
+				prepared, used, stale);
+		}
 
 		/* Dump the table */
 		table = ttable_dump(tt, "\n");
@@ -775,12 +847,78 @@ static int rib_can_delete_dest(rib_dest_t *dest)
 	return 1;
 }
 
+/*
+ * Evaluate the rnhs resolving over this dest, or only those tracking a
+ * prefix within the given one.  Evaluating a prefix evaluates all rnhs for
+ * it, which can move them to other dests, so look each next one up again.
+ */
+static void zebra_rib_evaluate_dest_nht(struct route_node *rn, rib_dest_t *dest,
+					const struct prefix *within, uint32_t seq)
+{
+	struct route_node key_rn = {};
+	struct rnh key = { .node = &key_rn };
+	struct zebra_vrf *zvrf;
+	struct prefix *p, host;
+	struct rnh *rnh;
+
+	if (within) {
+		prefix_copy(&key_rn.p, within);
+		rnh = rnh_deps_find_gteq(&dest->nht, &key);
+	} else
+		rnh = rnh_deps_first(&dest->nht);
+
+	for (; rnh; rnh = rnh_deps_find_gteq(&dest->nht, &key)) {
+		p = &rnh->node->p;
+
+		/* Carry on after all rnhs for this prefix */
+		prefix_copy(&key_rn.p, p);
+		key.safi = rnh->safi + 1;
+
+		if (within && !prefix_match(within, p)) {
+			prefix_copy(&host, p);
+			host.prefixlen = prefix_blen(p) * 8;
+			if (!prefix_match(within, &host))
+				break;
+			continue;
+		}
+
+		zvrf = zebra_vrf_lookup_by_id(rnh->vrf_id);
+		if (IS_ZEBRA_DEBUG_NHT_DETAILED)
+			zlog_debug("%s(%u):%pRN has Nexthop(%pRN) depending on it, evaluating %u:%u",
+				   zvrf_name(zvrf), zvrf_id(zvrf), rn, rnh->node,
+				   seq, rnh->seqno);
+
+		/*
+		 * If we have evaluated this node on this pass
+		 * already, due to following the tree up
+		 * then we know that we can move onto the next
+		 * rnh to process.
+		 *
+		 * Additionally we call zebra_evaluate_rnh
+		 * when we gc the dest.  In this case we know
+		 * that there must be no other re's where
+		 * we were originally as such we know that
+		 * that sequence number is ok to respect.
+		 */
+		if (rnh->seqno == seq) {
+			if (IS_ZEBRA_DEBUG_NHT_DETAILED)
+				zlog_debug("    Node processed and moved already");
+			continue;
+		}
+
+		rnh->seqno = seq;
+		zebra_evaluate_rnh(zvrf, family2afi(p->family), 0, p, rnh->safi);
+	}
+}
+
 void zebra_rib_evaluate_rn_nexthops(struct route_node *rn, uint32_t seq,
 				    bool rt_delete)
 {
 	rib_dest_t *dest = rib_dest_from_rnode(rn);
-	struct rnh *rnh;
+	struct route_node *changed_rn = rn;
+	const struct prefix *changed, *src_p;
 
+	srcdest_rnode_prefixes(rn, &changed, &src_p);
 	/*
 	 * We are storing the rnh's associated with
 	 * the tracked nexthop as a list of the rnh's
@@ -847,21 +985,22 @@ void zebra_rib_evaluate_rn_nexthops(struct route_node *rn, uint32_t seq,
 	 * and move them to a more specific node.  Also vice-versa as a
 	 * more specific node is removed.
 	 *
-	 * Long term the rnh code might be improved some as the rnh's
-	 * are stored as a list.  This might be transformed to a better
-	 * data structure.  This has not proven to be necessary yet as
-	 * that we have not seen any particular case where a rn is
-	 * storing more than a couple rnh's.  If we find a case
-	 * where this matters something might need to be done.
+	 * Only the rnh's on the changed node itself resolve over the
+	 * changed route.  Further up the tree, only the rnh's tracking a
+	 * prefix within the changed node's can be affected: nothing else
+	 * would match it on a LPM.  The rnh's on each node are sorted by
+	 * the prefix they track, so those are found without looking at
+	 * the others, which matters when thousands of them resolve over
+	 * a default or aggregate route.
 	 */
 	while (rn) {
 		if (IS_ZEBRA_DEBUG_NHT_DETAILED)
 			zlog_debug(
 				"%s: %pRN Being examined for Nexthop Tracking Count: %zd",
 				__func__, rn,
-				dest ? rnh_list_count(&dest->nht) : 0);
+				dest ? rnh_deps_count(&dest->nht) : 0);
 
-		if (rt_delete && (!dest || !rnh_list_count(&dest->nht))) {
+		if (rt_delete && (!dest || !rnh_deps_count(&dest->nht))) {
 			if (IS_ZEBRA_DEBUG_NHT_DETAILED)
 				zlog_debug("%pRN has no tracking NHTs. Bailing",
 					   rn);
@@ -879,40 +1018,11 @@ void zebra_rib_evaluate_rn_nexthops(struct route_node *rn, uint32_t seq,
 		 * nht resolution and as such we need to call the
 		 * nexthop tracking evaluation code
 		 */
-		frr_each_safe(rnh_list, &dest->nht, rnh) {
-			struct zebra_vrf *zvrf =
-				zebra_vrf_lookup_by_id(rnh->vrf_id);
-			struct prefix *p = &rnh->node->p;
-
-			if (IS_ZEBRA_DEBUG_NHT_DETAILED)
-				zlog_debug(
-					"%s(%u):%pRN has Nexthop(%pRN) depending on it, evaluating %u:%u",
-					zvrf_name(zvrf), zvrf_id(zvrf), rn,
-					rnh->node, seq, rnh->seqno);
-
-			/*
-			 * If we have evaluated this node on this pass
-			 * already, due to following the tree up
-			 * then we know that we can move onto the next
-			 * rnh to process.
-			 *
-			 * Additionally we call zebra_evaluate_rnh
-			 * when we gc the dest.  In this case we know
-			 * that there must be no other re's where
-			 * we were originally as such we know that
-			 * that sequence number is ok to respect.
-			 */
-			if (rnh->seqno == seq) {
-				if (IS_ZEBRA_DEBUG_NHT_DETAILED)
-					zlog_debug(
-						"    Node processed and moved already");
-				continue;
-			}
-
-			rnh->seqno = seq;
-			zebra_evaluate_rnh(zvrf, family2afi(p->family), 0, p,
-					   rnh->safi);
-		}
+		if (rnh_deps_count(&dest->nht))
+			zebra_rib_evaluate_dest_nht(rn, dest,
+						    rn == changed_rn ? NULL
+								     : changed,
+						    seq);
 
 		rn = rn->parent;
 		if (rn)
@@ -950,7 +1060,7 @@ int rib_gc_dest(struct route_node *rn)
 				       true);
 
 	dest->rnode = NULL;
-	rnh_list_fini(&dest->nht);
+	rnh_deps_fini(&dest->nht);
 	XFREE(MTYPE_RIB_DEST, dest);
 	rn->info = NULL;
 
@@ -981,7 +1091,7 @@ void zebra_node_info_cleanup(struct route_node *node)
 		/* Remove from update queue of FPM module */
 		hook_call(rib_shutdown, node);
 
-		rnh_list_fini(&dest->nht);
+		rnh_deps_fini(&dest->nht);
 		XFREE(MTYPE_RIB_DEST, node->info);
 	}
 }
@@ -1247,7 +1357,23 @@ static struct route_entry *rib_choose_best(struct route_entry *current,
 }
 
 /* Core function for processing routing information base. */
-static void rib_process(struct route_node *rn)
+/* The worker's resolution of this route entry, if there is one */
+static struct nhe_prepared *rib_batch_prepared(struct rib_batch_node *bn,
+					       struct route_entry *re)
+{
+	uint32_t i;
+
+	if (!bn)
+		return NULL;
+
+	for (i = 0; i < bn->npreps; i++)
+		if (bn->preps[i].re == re)
+			return &bn->preps[i];
+
+	return NULL;
+}
+
+static void rib_process(struct route_node *rn, struct rib_batch_node *bn)
 {
 	struct route_entry *re;
 	struct route_entry *next;
@@ -1334,7 +1460,8 @@ static void rib_process(struct route_node *rn)
 		 */
 		if (CHECK_FLAG(re->status, ROUTE_ENTRY_CHANGED)) {
 			proto_re_changed = re;
-			if (!nexthop_active_update(rn, re, old_fib)) {
+			if (!nexthop_active_update(rn, re, old_fib,
+						   rib_batch_prepared(bn, re))) {
 				struct rib_table_info *info;
 
 				if (re->type == ZEBRA_ROUTE_TABLE) {
@@ -2484,7 +2611,8 @@ static void process_subq_early_label(struct listnode *lnode)
 	XFREE(MTYPE_WQ_WRAPPER, w);
 }
 
-static void process_subq_route(struct listnode *lnode, uint8_t qindex)
+static void process_subq_route(struct listnode *lnode, uint8_t qindex,
+			       struct rib_batch_node *bn)
 {
 	struct route_node *rnode = NULL;
 	rib_dest_t *dest = NULL;
@@ -2496,7 +2624,7 @@ static void process_subq_route(struct listnode *lnode, uint8_t qindex)
 
 	zvrf = rib_dest_vrf(dest);
 
-	rib_process(rnode);
+	rib_process(rnode, bn);
 
 	if (IS_ZEBRA_DEBUG_RIB_DETAILED) {
 		struct route_entry *re = NULL;
@@ -3090,7 +3218,8 @@ static void process_subq_gr_run(struct listnode *lnode)
  * there is a node, return 0 otherwise.
  */
 static unsigned int process_subq(struct list *subq,
-				 enum meta_queue_indexes qindex)
+				 enum meta_queue_indexes qindex,
+				 struct rib_batch_node *bn)
 {
 	struct listnode *lnode = listhead(subq);
 
@@ -3116,7 +3245,7 @@ static unsigned int process_subq(struct list *subq,
 	case META_QUEUE_NOTBGP:
 	case META_QUEUE_BGP:
 	case META_QUEUE_OTHER:
-		process_subq_route(lnode, qindex);
+		process_subq_route(lnode, qindex, bn);
 		break;
 	case META_QUEUE_GR_RUN:
 		process_subq_gr_run(lnode);
@@ -3128,6 +3257,244 @@ static unsigned int process_subq(struct list *subq,
 	return 1;
 }
 
+static bool rib_subq_is_route(enum meta_queue_indexes qindex)
+{
+	switch (qindex) {
+	case META_QUEUE_CONNECTED:
+	case META_QUEUE_KERNEL:
+	case META_QUEUE_STATIC:
+	case META_QUEUE_NOTBGP:
+	case META_QUEUE_BGP:
+	case META_QUEUE_OTHER:
+		return true;
+	case META_QUEUE_NHG:
+	case META_QUEUE_EVPN:
+	case META_QUEUE_EARLY_ROUTE:
+	case META_QUEUE_EARLY_LABEL:
+	case META_QUEUE_GR_RUN:
+		break;
+	}
+
+	return false;
+}
+
+/* Route entries rib_process() resolves the nexthops of */
+static bool rib_batch_wants(const struct route_entry *re)
+{
+	return CHECK_FLAG(re->status, ROUTE_ENTRY_CHANGED) &&
+	       !CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED);
+}
+
+/*
+ * RIB worker pthread: resolve the nexthops of the batch's route nodes that
+ * are in this worker's vrfs, then tell the main pthread.
+ */
+static void rib_worker_run(struct event *event)
+{
+	struct rib_worker *w = EVENT_ARG(event);
+	struct rib_batch_node *bn;
+	struct route_entry *re;
+	uint32_t i, n, prepared = 0;
+
+	for (i = 0; i < rib_batch.nnodes; i++) {
+		bn = &rib_batch.nodes[i];
+		if (bn->worker != w->id || !bn->npreps)
+			continue;
+
+		n = 0;
+		RNODE_FOREACH_RE (bn->rn, re) {
+			if (!rib_batch_wants(re) || n == bn->npreps)
+				continue;
+
+			if (nexthop_active_prepare(bn->rn, re, &bn->preps[n]))
+				prepared++;
+			n++;
+		}
+	}
+
+	atomic_fetch_add_explicit(&w->prepared, prepared, memory_order_relaxed);
+
+	frr_with_mutex (&rib_batch.mutex) {
+		if (--rib_batch.busy == 0)
+			pthread_cond_signal(&rib_batch.cond);
+	}
+}
+
+/* Have the workers prepare the batch, and wait for all of them */
+static void rib_batch_prepare(void)
+{
+	bool work[RIB_WORKERS_MAX] = {};
+	struct rib_batch_node *bn;
+	struct rib_worker *w;
+	uint32_t i, total = 0, busy = 0;
+
+	for (i = 0; i < rib_batch.nnodes; i++)
+		total += rib_batch.nodes[i].npreps;
+	if (!total)
+		return;
+
+	if (total > rib_batch.preps_size) {
+		rib_batch.preps = XREALLOC(MTYPE_RIB_WORKER, rib_batch.preps,
+					   total * sizeof(*rib_batch.preps));
+		rib_batch.preps_size = total;
+	}
+
+	total = 0;
+	for (i = 0; i < rib_batch.nnodes; i++) {
+		bn = &rib_batch.nodes[i];
+		bn->preps = rib_batch.preps + total;
+		total += bn->npreps;
+
+		if (bn->npreps && !work[bn->worker]) {
+			work[bn->worker] = true;
+			busy++;
+		}
+	}
+
+	frr_with_mutex (&rib_batch.mutex)
+		rib_batch.busy = busy;
+
+	for (i = 0; i < rib_workers; i++) {
+		w = &rib_batch.workers[i];
+		if (work[i])
+			event_add_event(w->pthread->master, rib_worker_run, w, 0,
+					&w->t_work);
+	}
+
+	frr_with_mutex (&rib_batch.mutex) {
+		while (rib_batch.busy > 0)
+			pthread_cond_wait(&rib_batch.cond, &rib_batch.mutex);
+	}
+}
+
+/* Would meta_queue_process() pick this node next, too? */
+static bool rib_batch_continue(struct meta_queue *mq,
+			       enum meta_queue_indexes qindex,
+			       struct route_node *rn)
+{
+	struct listnode *lnode;
+	unsigned int i;
+
+	if (dplane_get_in_queue_len() > dplane_get_in_queue_limit())
+		return false;
+
+	for (i = 0; i < qindex; i++)
+		if (listcount(mq->subq[i]))
+			return false;
+
+	lnode = listhead(mq->subq[qindex]);
+	return lnode && listgetdata(lnode) == rn;
+}
+
+/*
+ * Take up to RIB_BATCH_MAX route nodes off the head of a route sub-queue,
+ * have the RIB workers resolve the nexthops of their changed route entries
+ * while this pthread waits, then process the nodes one by one just like
+ * process_subq() would.
+ *
+ * Everything but the resolution into a local nhe copy stays on the main
+ * pthread: the nhg hash, route selection, the dplane, redistribution and
+ * nexthop tracking.  A node's prepared resolutions are thrown away, and
+ * done again by rib_process(), if a node processed before it in the batch
+ * covers one of its nexthops.  The batch ends early if
+ * meta_queue_process() would pick something else next.
+ */
+static void meta_queue_process_batch(struct meta_queue *mq,
+				     enum meta_queue_indexes qindex)
+{
+	struct list *subq = mq->subq[qindex];
+	const struct prefix *p, *src_p;
+	struct rib_batch_node *bn;
+	struct listnode *lnode;
+	struct route_node *rn;
+	struct route_entry *re;
+	struct prefix dst;
+	uint32_t i, j;
+	afi_t afi;
+
+	rib_batch.nnodes = 0;
+	for (ALL_LIST_ELEMENTS_RO(subq, lnode, rn)) {
+		if (rib_batch.nnodes == RIB_BATCH_MAX)
+			break;
+
+		bn = &rib_batch.nodes[rib_batch.nnodes++];
+		bn->rn = rn;
+		bn->worker = 0;
+		bn->preps = NULL;
+		bn->npreps = 0;
+
+		if (!rn->info)
+			continue;
+
+		/* A node queued twice is only prepared for the first time */
+		for (j = 0; j < rib_batch.nnodes - 1; j++)
+			if (rib_batch.nodes[j].rn == rn)
+				break;
+		if (j < rib_batch.nnodes - 1)
+			continue;
+
+		bn->worker = zvrf_id(rib_dest_vrf(rib_dest_from_rnode(rn))) %
+			     rib_workers;
+		RNODE_FOREACH_RE (rn, re)
+			if (rib_batch_wants(re))
+				bn->npreps++;
+	}
+
+	rib_batch_prepare();
+	atomic_fetch_add_explicit(&rib_batch.batches, 1, memory_order_relaxed);
+
+	for (afi = AFI_IP; afi <= AFI_IP6; afi++)
+		rib_batch.changed[afi] = route_table_init();
+
+	for (i = 0; i < rib_batch.nnodes; i++) {
+		bn = &rib_batch.nodes[i];
+		rn = bn->rn;
+
+		if (i > 0 && !rib_batch_continue(mq, qindex, rn))
+			break;
+
+		for (j = 0; j < bn->npreps; j++) {
+			if (bn->preps[j].nhe &&
+			    nexthop_prepared_stale(&bn->preps[j],
+						   rib_batch.changed)) {
+				nexthop_prepared_free(&bn->preps[j]);
+				bn->preps[j].re = NULL;
+				atomic_fetch_add_explicit(&rib_batch.stale, 1,
+							  memory_order_relaxed);
+			}
+		}
+
+		/* The node may be gone once processed */
+		srcdest_rnode_prefixes(rn, &p, &src_p);
+		prefix_copy(&dst, p);
+
+		process_subq(subq, qindex, bn);
+		mq->size--;
+
+		route_node_get(rib_batch.changed[family2afi(dst.family)], &dst)
+			->info = rib_batch.changed;
+
+		for (j = 0; j < bn->npreps; j++) {
+			if (bn->preps[j].re && !bn->preps[j].nhe)
+				atomic_fetch_add_explicit(&rib_batch.used, 1,
+							  memory_order_relaxed);
+			nexthop_prepared_free(&bn->preps[j]);
+		}
+	}
+
+	/* Whatever the batch didn't get to is prepared again next time */
+	for (; i < rib_batch.nnodes; i++) {
+		bn = &rib_batch.nodes[i];
+		for (j = 0; j < bn->npreps; j++)
+			nexthop_prepared_free(&bn->preps[j]);
+	}
+
+	for (afi = AFI_IP; afi <= AFI_IP6; afi++) {
+		route_table_finish(rib_batch.changed[afi]);
+		rib_batch.changed[afi] = NULL;
+	}
+}
+
 /* Dispatch the meta queue by picking and processing the next node from
  * a non-empty sub-queue with lowest priority. wq is equal to zebra->ribq and
  * data is pointed to the meta queue structure.
@@ -3154,11 +3521,18 @@ static wq_item_status meta_queue_process(struct work_queue *dummy, void *data)
 		return WQ_QUEUE_BLOCKED;
 	}
 
-	for (i = 0; i < MQ_SIZE; i++)
-		if (process_subq(mq->subq[i], i)) {
+	for (i = 0; i < MQ_SIZE; i++) {
+		if (rib_batch.workers && rib_subq_is_route(i) &&
+		    listcount(mq->subq[i]) > 1) {
+			meta_queue_process_batch(mq, i);
+			break;
+		}
+
+		if (process_subq(mq->subq[i], i, NULL)) {
 			mq->size--;
 			break;
 		}
+	}
 	return mq->size ? WQ_REQUEUE : WQ_SUCCESS;
 }
 
@@ -3909,7 +4283,7 @@ rib_dest_t *zebra_rib_create_dest(struct route_node *rn)
 	rib_dest_t *dest;
 
 	dest = XCALLOC(MTYPE_RIB_DEST, sizeof(rib_dest_t));
-	rnh_list_init(&dest->nht);
+	rnh_deps_init(&dest->nht);
 	re_list_init(&dest->routes);
 	route_lock_node(rn); /* rn route table reference */
 	rn->info = dest;
@@ -5282,10 +5656,71 @@ void zebra_rib_init(void)
 	zebra_dplane_init(rib_dplane_results);
 }
 
+void zebra_rib_set_workers(uint32_t count)
+{
+	rib_workers = MAX(1U, MIN(count, RIB_WORKERS_MAX));
+}
+
+/* Start the RIB workers, once zebra has forked */
+void zebra_rib_start(void)
+{
+	struct frr_pthread_attr pattr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop
+	};
+	struct rib_worker *w;
+	char name[64], os_name[OS_THREAD_NAMELEN];
+	uint32_t i;
+
+	if (rib_workers <= 1)
+		return;
+
+	pthread_mutex_init(&rib_batch.mutex, NULL);
+	pthread_cond_init(&rib_batch.cond, NULL);
+
+	rib_batch.workers = XCALLOC(MTYPE_RIB_WORKER,
+				    rib_workers * sizeof(*rib_batch.workers));
+
+	for (i = 0; i < rib_workers; i++) {
+		w = &rib_batch.workers[i];
+		w->id = i;
+
+		snprintf(name, sizeof(name), "Zebra RIB worker %u", i);
+		snprintf(os_name, sizeof(os_name), "zebra_rib%u", i);
+		w->pthread = frr_pthread_new(&pattr, name, os_name);
+		frr_pthread_run(w->pthread, NULL);
+	}
+}
+
+static void rib_workers_stop(void)
+{
+	struct rib_worker *w;
+	uint32_t i;
+
+	if (!rib_batch.workers)
+		return;
+
+	for (i = 0; i < rib_workers; i++) {
+		w = &rib_batch.workers[i];
+		frr_pthread_stop(w->pthread, NULL);
+		frr_pthread_destroy(w->pthread);
+		w->pthread = NULL;
+	}
+
+	XFREE(MTYPE_RIB_WORKER, rib_batch.workers);
+	XFREE(MTYPE_RIB_WORKER, rib_batch.preps);
+	rib_batch.preps_size = 0;
+
+	pthread_cond_destroy(&rib_batch.cond);
+	pthread_mutex_destroy(&rib_batch.mutex);
+}
+
 void zebra_rib_terminate(void)
 {
 	struct zebra_dplane_ctx *ctx;
 
+	rib_workers_stop();
+
 	event_cancel(&t_dplane);
 
 	ctx = dplane_ctx_dequeue(&rib_dplane_q);
@@ -108,6 +108,24 @@ static inline struct route_table *get_rnh_table(vrf_id_t vrfid, afi_t afi,
 	return t;
 }
 
+/*
+ * The rnh is not necessarily on the dest its resolved route matches now,
+ * and deleting it from a tree it is not in would corrupt that tree.
+ */
+static void zebra_rnh_deps_del(rib_dest_t *dest, struct rnh *rnh)
+{
+	struct rnh *item;
+
+	for (item = rnh_deps_find_gteq(&dest->nht, rnh);
+	     item && !rnh_deps_cmp(item, rnh);
+	     item = rnh_deps_next(&dest->nht, item)) {
+		if (item == rnh) {
+			rnh_deps_del(&dest->nht, rnh);
+			return;
+		}
+	}
+}
+
 static void zebra_rnh_remove_from_routing_table(struct rnh *rnh)
 {
 	struct zebra_vrf *zvrf = zebra_vrf_lookup_by_id(rnh->vrf_id);
@@ -132,7 +150,7 @@ static void zebra_rnh_remove_from_routing_table(struct rnh *rnh)
 			   rnh->node, rn);
 
 	dest = rib_dest_from_rnode(rn);
-	rnh_list_del(&dest->nht, rnh);
+	zebra_rnh_deps_del(dest, rnh);
 	route_unlock_node(rn);
 }
 
@@ -160,7 +178,7 @@ static void zebra_rnh_store_in_routing_table(struct rnh *rnh)
 			   rnh->node, rn);
 
 	dest = rib_dest_from_rnode(rn);
-	rnh_list_add_tail(&dest->nht, rnh);
+	rnh_deps_add(&dest->nht, rnh);
 	route_unlock_node(rn);
 }
 
@@ -283,30 +301,10 @@ struct rnh *zebra_lookup_rnh(struct prefix *p, vrf_id_t vrfid, safi_t safi, stru
 
 void zebra_free_rnh(struct rnh *rnh)
 {
-	struct zebra_vrf *zvrf;
-	struct route_table *table;
-
 	zebra_rnh_remove_from_routing_table(rnh);
 	rnh->flags |= ZEBRA_NHT_DELETED;
 	list_delete(&rnh->zebra_pseudowire_list);
 
-	zvrf = zebra_vrf_lookup_by_id(rnh->vrf_id);
-	if (zvrf) {
-		table = zvrf->table[family2afi(rnh->resolved_route.family)][rnh->safi];
-
-		if (table) {
-			struct route_node *rern;
-
-			rern = route_node_match(table, &rnh->resolved_route);
-			if (rern) {
-				rib_dest_t *dest;
-
-				dest = rib_dest_from_rnode(rern);
-				rnh_list_del(&dest->nht, rnh);
-				route_unlock_node(rern);
-			}
-		}
-	}
 	free_state(rnh->vrf_id, rnh->state, rnh->node);
 	XFREE(MTYPE_RNH, rnh);
 }
@@ -1140,10 +1138,12 @@ static bool compare_state(struct route_entry *r1,
 	return false;
 }
 
-int zebra_send_rnh_update(struct rnh *rnh, struct zserv *client,
-			  vrf_id_t vrf_id, uint32_t srte_color)
+/*
+ * Encode the body of a ZEBRA_NEXTHOP_UPDATE for rnh.
+ */
+static int zebra_rnh_encode_update(struct stream *s, struct rnh *rnh,
+				   uint32_t srte_color)
 {
-	struct stream *s = NULL;
 	struct route_entry *re;
 	unsigned long nump;
 	uint16_t num;
@@ -1155,11 +1155,6 @@ int zebra_send_rnh_update(struct rnh *rnh, struct zserv *client,
 	rn = rnh->node;
 	re = rnh->state;
 
-	/* Get output stream. */
-	s = stream_new_expandable(ZEBRA_MAX_PACKET_SIZ);
-
-	zclient_create_header(s, ZEBRA_NEXTHOP_UPDATE, vrf_id);
-
 	/* Message flags. */
 	if (srte_color)
 		SET_FLAG(message, ZAPI_MESSAGE_SRTE);
@@ -1182,7 +1177,7 @@ int zebra_send_rnh_update(struct rnh *rnh, struct zserv *client,
 		flog_err(EC_ZEBRA_RNH_UNKNOWN_FAMILY,
 			 "%s: Unknown family (%d) notification attempted",
 			 __func__, rn->p.family);
-		goto failure;
+		return -1;
 	}
 
 	/*
@@ -1201,7 +1196,7 @@ int zebra_send_rnh_update(struct rnh *rnh, struct zserv *client,
 		flog_err(EC_ZEBRA_RNH_UNKNOWN_FAMILY,
 			 "%s: Unknown family (%d) notification attempted",
 			 __func__, rn->p.family);
-		goto failure;
+		return -1;
 	}
 
 	if (srte_color)
@@ -1225,7 +1220,7 @@ int zebra_send_rnh_update(struct rnh *rnh, struct zserv *client,
 				zapi_nexthop_from_nexthop(&znh, nh);
 				ret = zapi_nexthop_encode(s, &znh, 0, message);
 				if (ret < 0)
-					goto failure;
+					return -1;
 
 				num++;
 			}
@@ -1238,15 +1233,119 @@ int zebra_send_rnh_update(struct rnh *rnh, struct zserv *client,
 		stream_putl(s, 0); // metric
 		stream_putw(s, 0); // nexthops
 	}
+
+	return 0;
+}
+
+static struct stream *zebra_rnh_bulk_new(void)
+{
+	struct stream *s;
+
+	s = stream_new_expandable(ZEBRA_MAX_PACKET_SIZ);
+	zclient_create_header(s, ZEBRA_NEXTHOP_UPDATE_BULK, VRF_DEFAULT);
+	stream_putw(s, 0);
+
+	return s;
+}
+
+/* Send off the nexthop updates collected for a client, if any. */
+static void zebra_rnh_bulk_send(struct zserv *client)
+{
+	struct stream *s = client->nht_bulk;
+
+	if (!s)
+		return;
+
+	client->nht_bulk = NULL;
+	if (!client->nht_bulk_cnt) {
+		stream_free(s);
+		return;
+	}
+
+	stream_putw_at(s, ZEBRA_HEADER_SIZE, client->nht_bulk_cnt);
 	stream_putw_at(s, 0, stream_get_endp(s));
 
+	client->nht_bulk_cnt = 0;
+	client->nh_upd_msg_cnt++;
 	client->nh_last_upd_time = monotime(NULL);
-	return zserv_send_message(client, s);
+	zserv_send_message(client, s);
+}
 
-failure:
+static void zebra_rnh_bulk_flush(struct event *event)
+{
+	zebra_rnh_bulk_send(EVENT_ARG(event));
+}
 
-	stream_free(s);
-	return -1;
+void zebra_rnh_client_flush(struct zserv *client)
+{
+	event_cancel(&client->t_nht_bulk);
+	zebra_rnh_bulk_send(client);
+}
+
+/*
+ * Add an update to the client's pending ZEBRA_NEXTHOP_UPDATE_BULK.  Whatever
+ * piles up while the current event runs, e.g. one pass of the meta queue,
+ * goes out together once it is done.  A message is kept within
+ * ZEBRA_MAX_PACKET_SIZ unless a single update is larger than that.
+ */
+static int zebra_rnh_bulk_add(struct rnh *rnh, struct zserv *client,
+			      vrf_id_t vrf_id, uint32_t srte_color)
+{
+	struct stream *s, *next;
+	size_t start, len;
+
+	if (!client->nht_bulk)
+		client->nht_bulk = zebra_rnh_bulk_new();
+	event_add_event(zrouter.master, zebra_rnh_bulk_flush, client, 0,
+			&client->t_nht_bulk);
+
+	s = client->nht_bulk;
+	start = stream_get_endp(s);
+	stream_putl(s, vrf_id);
+	if (zebra_rnh_encode_update(s, rnh, srte_color) < 0) {
+		stream_set_endp(s, start);
+		return -1;
+	}
+
+	if (stream_get_endp(s) > ZEBRA_MAX_PACKET_SIZ && client->nht_bulk_cnt) {
+		/* Full, this update starts the next message */
+		len = stream_get_endp(s) - start;
+		next = zebra_rnh_bulk_new();
+		stream_put(next, STREAM_DATA(s) + start, len);
+		stream_set_endp(s, start);
+
+		zebra_rnh_bulk_send(client);
+		client->nht_bulk = next;
+	}
+
+	client->nht_bulk_cnt++;
+	client->nh_upd_cnt++;
+	return 0;
+}
+
+int zebra_send_rnh_update(struct rnh *rnh, struct zserv *client,
+			  vrf_id_t vrf_id, uint32_t srte_color)
+{
+	struct stream *s = NULL;
+
+	if (CHECK_FLAG(client->capabilities, ZAPI_CLIENT_CAP_NHT_BULK))
+		return zebra_rnh_bulk_add(rnh, client, vrf_id, srte_color);
+
+	/* Get output stream. */
+	s = stream_new_expandable(ZEBRA_MAX_PACKET_SIZ);
+
+	zclient_create_header(s, ZEBRA_NEXTHOP_UPDATE, vrf_id);
+
+	if (zebra_rnh_encode_update(s, rnh, srte_color) < 0) {
+		stream_free(s);
+		return -1;
+	}
+	stream_putw_at(s, 0, stream_get_endp(s));
+
+	client->nh_upd_cnt++;
+	client->nh_upd_msg_cnt++;
+	client->nh_last_upd_time = monotime(NULL);
+	return zserv_send_message(client, s);
 }
 
 
@@ -1518,6 +1617,11 @@ static int zebra_client_cleanup_rnh(struct zserv *client)
 	struct vrf *vrf;
 	struct zebra_vrf *zvrf;
 
+	/* Nobody left to send pending updates to */
+	event_cancel(&client->t_nht_bulk);
+	stream_free(client->nht_bulk);
+	client->nht_bulk = NULL;
+
 	RB_FOREACH (vrf, vrf_id_head, &vrfs_by_id) {
 		zvrf = vrf->info;
 		if (zvrf) {
@@ -1237,6 +1237,24 @@ route_map_result_t zebra_route_map_check(afi_t family, struct route_entry *re,
 	return (ret);
 }
 
+/*
+ * Would zebra_route_map_check() apply a route-map to routes of this type?
+ */
+bool zebra_route_map_configured(struct zebra_vrf *zvrf, int rtype)
+{
+	afi_t afi;
+
+	for (afi = AFI_IP; afi <= AFI_IP6; afi++) {
+		if (rtype >= 0 && rtype < ZEBRA_ROUTE_MAX &&
+		    PROTO_RM_MAP(zvrf, afi, rtype))
+			return true;
+		if (PROTO_RM_MAP(zvrf, afi, ZEBRA_ROUTE_ALL))
+			return true;
+	}
+
+	return false;
+}
+
 char *zebra_get_import_table_route_map(afi_t afi, safi_t safi, uint32_t table)
 {
 	return zebra_import_table_routemap[afi][safi][table];
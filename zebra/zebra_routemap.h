@@ -27,6 +27,7 @@ extern route_map_result_t zebra_route_map_check(afi_t family,
 						const struct prefix *p,
 						struct nexthop *nexthop,
 						struct zebra_vrf *zvrf);
+extern bool zebra_route_map_configured(struct zebra_vrf *zvrf, int rtype);
 extern route_map_result_t zebra_nht_route_map_check(afi_t afi, int client_proto,
 						    const struct prefix *p,
 						    struct zebra_vrf *zvrf,
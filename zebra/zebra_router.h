@@ -219,10 +219,12 @@ struct zebra_router {
 	struct event *t_rib_sweep;
 
 	/*
-	 * The hash of nexthop groups associated with this router
+	 * The hash of nexthop groups associated with this router,
+	 * and of the interned nexthop vectors they share
 	 */
 	struct hash *nhgs;
 	struct hash *nhgs_id;
+	struct hash *nhg_vecs;
 
 	bool all_mc_forwardingv4, default_mc_forwardingv4;
 	bool all_mc_forwardingv6, default_mc_forwardingv6;
@@ -123,9 +123,12 @@ void lua_pushzebra_dplane_ctx(lua_State *L, const struct zebra_dplane_ctx *ctx)
 				lua_pushnexthop_group(
 					L, dplane_ctx_get_nhe_ng(ctx));
 				lua_setfield(L, -2, "ng");
-				lua_pushnh_grp(L,
-					       dplane_ctx_get_nhe_nh_grp(ctx));
-				lua_setfield(L, -2, "nh_grp");
+				/* route updates carry no group array */
+				if (dplane_ctx_get_nhe_nh_grp_count(ctx)) {
+					lua_pushnh_grp(L,
+						       dplane_ctx_get_nhe_nh_grp(ctx));
+					lua_setfield(L, -2, "nh_grp");
+				}
 				lua_pushinteger(
 					L,
 					dplane_ctx_get_nhe_nh_grp_count(ctx));
@@ -158,6 +158,11 @@ static int zebra_sr_policy_notify_update_client(struct zebra_sr_policy *policy,
 	stream_putw_at(s, nump, num);
 	stream_putw_at(s, 0, stream_get_endp(s));
 
+	/* Must not overtake nexthop updates waiting to be bundled */
+	zebra_rnh_client_flush(client);
+
+	client->nh_upd_cnt++;
+	client->nh_upd_msg_cnt++;
 	client->nh_last_upd_time = monotime(NULL);
 	return zserv_send_message(client, s);
 
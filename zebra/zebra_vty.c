@@ -4191,6 +4191,20 @@ DEFUN_HIDDEN(no_zebra_kernel_netlink_batch_tx_buf,
 	return CMD_SUCCESS;
 }
 
+DEFPY_HIDDEN(zebra_kernel_netlink_batch_pipeline,
+	     zebra_kernel_netlink_batch_pipeline_cmd,
+	     "[no] zebra kernel netlink batch-pipeline ![(1-64)$depth]",
+	     NO_STR ZEBRA_STR
+	     "Zebra kernel interface\n"
+	     "Set Netlink parameters\n"
+	     "Send batches before reading back their responses\n"
+	     "Number of batches in flight\n")
+{
+	netlink_set_batch_pipeline_depth(depth, !no);
+
+	return CMD_SUCCESS;
+}
+
 DEFPY (zebra_protodown_bit,
        zebra_protodown_bit_cmd,
        "zebra protodown reason-bit (0-31)$bit",
@@ -4354,6 +4368,7 @@ void zebra_vty_init(void)
 #ifdef HAVE_NETLINK
 	install_element(CONFIG_NODE, &zebra_kernel_netlink_batch_tx_buf_cmd);
 	install_element(CONFIG_NODE, &no_zebra_kernel_netlink_batch_tx_buf_cmd);
+	install_element(CONFIG_NODE, &zebra_kernel_netlink_batch_pipeline_cmd);
 	install_element(CONFIG_NODE, &zebra_protodown_bit_cmd);
 	install_element(CONFIG_NODE, &no_zebra_protodown_bit_cmd);
 #endif /* HAVE_NETLINK */
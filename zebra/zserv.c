@@ -33,6 +33,7 @@
 #include "lib/sockopt.h"          /* for setsockopt_so_recvbuf, setsockopt... */
 #include "lib/sockunion.h"        /* for sockopt_reuseaddr, sockopt_reuseport */
 #include "lib/stream.h"           /* for STREAM_SIZE, stream (ptr only), ... */
+#include "lib/ringbuf.h"          /* for ringbuf_peek, ringbuf_space_iov, ... */
 #include "frrevent.h"                /* for thread (ptr only), EVENT_ARG, ... */
 #include "lib/vrf.h"              /* for vrf_info_lookup, VRF_DEFAULT */
 #include "lib/vty.h"              /* for vty_out, vty (ptr only) */
@@ -45,7 +46,7 @@
 
 #include "zebra/debug.h"          /* for various debugging macros */
 #include "zebra/rib.h"            /* for rib_score_proto */
-#include "zebra/zapi_msg.h"       /* for zserv_handle_commands */
+#include "zebra/zapi_msg.h"       /* for zserv_handle_command */
 #include "zebra/zebra_vrf.h"      /* for zebra_vrf_lookup_by_id, zvrf */
 #include "zebra/zserv.h"          /* for zserv */
 #include "zebra/zebra_router.h"
@@ -73,6 +74,12 @@ static struct zserv *find_client_internal(uint8_t proto,
 /* Mem type for zclients. */
 DEFINE_MTYPE_STATIC(ZEBRA, ZSERV_CLIENT, "ZClients");
 
+/*
+ * Size of a client's input ring, given the largest message: room for a good
+ * batch of messages, and for a few of the largest ones.
+ */
+#define ZSERV_IBUF_RING_SIZE(max) MAX(64 * ZEBRA_MAX_PACKET_SIZ, 4 * (max))
+
 /*
  * Client thread events.
  *
@@ -197,6 +204,7 @@ static void zserv_client_fail(struct zserv *client)
 
 	event_cancel(&client->t_read);
 	event_cancel(&client->t_write);
+	event_cancel(&client->t_shm_read);
 	zserv_event(client, ZSERV_HANDLE_CLIENT_FAIL);
 }
 
@@ -292,97 +300,32 @@ zwrite_fail:
 }
 
 /*
- * Read and process data from a client socket.
- *
- * The responsibilities here are to read raw data from the client socket,
- * validate the header, encapsulate it into a single stream object, push it
- * onto the input queue and then notify the main thread that there is new data
- * available.
- *
- * This function first looks for any data in the client structure's working
- * input buffer. If data is present, it is assumed that reading stopped in a
- * previous invocation of this task and needs to be resumed to finish a message.
- * Otherwise, the socket data stream is assumed to be at the beginning of a new
- * ZAPI message (specifically at the header). The header is read and validated.
- * If the header passed validation then the length field found in the header is
- * used to compute the total length of the message. That much data is read (but
- * not inspected), appended to the header, placed into a stream and pushed onto
- * the client's input queue. A task is then scheduled on the main thread to
- * process the client's input queue. Finally, if all of this was successful,
- * this task reschedules itself.
+ * Count the complete messages newly read into a client's input ring,
+ * validating their headers. Runs with the input buffer lock held.
  *
- * Any failure in any of these actions is handled by terminating the client.
- *
- * The client's input buffer ibuf_fifo can have a maximum items as configured
- * in the packets_to_process. This way we are not filling up the FIFO more
- * than the maximum when the zebra main is busy. If the fifo has space, we
- * reschedule ourselves to read more.
- *
- * The main thread processes the items in ibuf_fifo and always signals the
- * client IO thread.
+ * Returns false if a header is corrupt, in which case the client is to be
+ * terminated.
  */
-static void zserv_read(struct event *event)
+static bool zserv_read_parse(struct zserv *client, int sock, uint32_t *added,
+			     uint16_t *last_cmd)
 {
-	struct zserv *client = EVENT_ARG(event);
-	int sock;
-	size_t already;
-	struct stream_fifo *cache;
-	uint32_t p2p;	    /* Temp p2p used to process */
-	uint32_t p2p_orig;  /* Configured p2p (Default-1000) */
-	int p2p_avail;	    /* How much space is available for p2p */
+	struct ringbuf *ring = client->ibuf_ring;
+	size_t remain = ringbuf_remain(ring);
+	uint8_t hbuf[ZEBRA_HEADER_SIZE];
+	struct stream hs;
 	struct zmsghdr hdr;
-	size_t client_ibuf_fifo_cnt = stream_fifo_count_safe(client->ibuf_fifo);
+	char errmsg[256];
 
-	p2p_orig = atomic_load_explicit(&zrouter.packets_to_process,
-					memory_order_relaxed);
-	p2p_avail = p2p_orig - client_ibuf_fifo_cnt;
-
-    /*
-     * Do nothing if ibuf_fifo count has reached its max limit. Otherwise
-     * proceed and reschedule ourselves if there is space in the ibuf_fifo.
-     */
-	if (p2p_avail <= 0)
-		return;
-
-	p2p = p2p_avail;
-	cache = stream_fifo_new();
-	sock = EVENT_FD(event);
-
-	while (p2p) {
-		ssize_t nb;
-		bool hdrvalid;
-		char errmsg[256];
-
-		already = stream_get_endp(client->ibuf_work);
-
-		/* Read length and command (if we don't have it already). */
-		if (already < ZEBRA_HEADER_SIZE) {
-			nb = stream_read_try(client->ibuf_work, sock,
-					     ZEBRA_HEADER_SIZE - already);
-			if ((nb == 0 || nb == -1)) {
-				if (IS_ZEBRA_DEBUG_EVENT)
-					zlog_debug("connection closed socket [%d]",
-						   sock);
-				goto zread_fail;
-			}
-			if (nb != (ssize_t)(ZEBRA_HEADER_SIZE - already)) {
-				/* Try again later. */
-				break;
-			}
-			already = ZEBRA_HEADER_SIZE;
-		}
-
-		/* Reset to read from the beginning of the incoming packet. */
-		stream_set_getp(client->ibuf_work, 0);
+	while (remain - client->ibuf_msgs_size >= ZEBRA_HEADER_SIZE) {
+		ringbuf_peek(ring, client->ibuf_msgs_size, hbuf, sizeof(hbuf));
+		stream_view_init(&hs, hbuf, sizeof(hbuf));
 
 		/* Fetch header values */
-		hdrvalid = zapi_parse_header(client->ibuf_work, &hdr);
-
-		if (!hdrvalid) {
+		if (!zapi_parse_header(&hs, &hdr)) {
 			snprintf(errmsg, sizeof(errmsg),
 				 "%s: Message has corrupt header", __func__);
-			zserv_log_message(errmsg, client->ibuf_work, NULL);
-			goto zread_fail;
+			zserv_log_message(errmsg, &hs, NULL);
+			return false;
 		}
 
 		/* Validate header */
@@ -392,16 +335,16 @@ static void zserv_read(struct event *event)
 				errmsg, sizeof(errmsg),
 				"Message has corrupt header\n%s: socket %d version mismatch, marker %d, version %d",
 				__func__, sock, hdr.marker, hdr.version);
-			zserv_log_message(errmsg, client->ibuf_work, &hdr);
-			goto zread_fail;
+			zserv_log_message(errmsg, &hs, &hdr);
+			return false;
 		}
 		if (hdr.length < ZEBRA_HEADER_SIZE) {
 			snprintf(
 				errmsg, sizeof(errmsg),
 				"Message has corrupt header\n%s: socket %d message length %u is less than header size %d",
 				__func__, sock, hdr.length, ZEBRA_HEADER_SIZE);
-			zserv_log_message(errmsg, client->ibuf_work, &hdr);
-			goto zread_fail;
+			zserv_log_message(errmsg, &hs, &hdr);
+			return false;
 		}
 		if (hdr.length > STREAM_SIZE(client->ibuf_work)) {
 			snprintf(
@@ -409,26 +352,13 @@ static void zserv_read(struct event *event)
 				"Message has corrupt header\n%s: socket %d message length %u exceeds buffer size %lu",
 				__func__, sock, hdr.length,
 				(unsigned long)STREAM_SIZE(client->ibuf_work));
-			zserv_log_message(errmsg, client->ibuf_work, &hdr);
-			goto zread_fail;
+			zserv_log_message(errmsg, &hs, &hdr);
+			return false;
 		}
 
-		/* Read rest of data. */
-		if (already < hdr.length) {
-			nb = stream_read_try(client->ibuf_work, sock,
-					     hdr.length - already);
-			if ((nb == 0 || nb == -1)) {
-				if (IS_ZEBRA_DEBUG_EVENT)
-					zlog_debug(
-						   "connection closed [%d] when reading zebra data",
-						   sock);
-				goto zread_fail;
-			}
-			if (nb != (ssize_t)(hdr.length - already)) {
-				/* Try again later. */
-				break;
-			}
-		}
+		/* Rest of the message yet to come? */
+		if (remain - client->ibuf_msgs_size < hdr.length)
+			break;
 
 		/* Debug packet information. */
 		if (IS_ZEBRA_DEBUG_PACKET) {
@@ -439,31 +369,118 @@ static void zserv_read(struct event *event)
 				   VRF_LOGNAME(vrf), hdr.length, sock);
 		}
 
-		stream_set_getp(client->ibuf_work, 0);
-		struct stream *msg = stream_dup(client->ibuf_work);
+		client->ibuf_msgs_size += hdr.length;
+		client->ibuf_msgs++;
+		(*added)++;
+		*last_cmd = hdr.command;
+
+		/* Everything after this marker comes through the ring */
+		if (hdr.command == ZEBRA_ZAPI_SHM) {
+			if (!client->shm || client->shm_active ||
+			    remain != client->ibuf_msgs_size) {
+				snprintf(errmsg, sizeof(errmsg),
+					 "%s: socket %d unexpected switch to shared memory",
+					 __func__, sock);
+				zserv_log_message(errmsg, &hs, &hdr);
+				return false;
+			}
+			atomic_store_explicit(&client->shm_active, true,
+					      memory_order_release);
+		}
+	}
+
+	if (client->ibuf_msgs > client->ibuf_msgs_max)
+		client->ibuf_msgs_max = client->ibuf_msgs;
 
-		stream_fifo_push(cache, msg);
-		stream_reset(client->ibuf_work);
-		p2p--;
+	return true;
+}
+
+/*
+ * Read data from a client socket.
+ *
+ * The responsibilities here are to read raw data from the client socket,
+ * validate the headers of the messages in it and notify the main thread that
+ * there are new messages available.
+ *
+ * Data is read in bulk, as much as there is room for, into the client's input
+ * ring buffer; any partial message at its end is completed by later reads.
+ * The headers of the complete messages are validated, and the messages are
+ * made available to the main thread, which handles them right out of the
+ * ring. Finally, if all of this was successful, this task reschedules itself.
+ *
+ * Any failure in any of these actions is handled by terminating the client.
+ *
+ * The client's input ring can hold a maximum number of messages as configured
+ * in the packets_to_process. This way we are not filling it up more than the
+ * maximum when the zebra main is busy. If the ring has space, we reschedule
+ * ourselves to read more.
+ *
+ * The main thread processes the messages in the ring and always signals the
+ * client IO thread.
+ */
+static void zserv_read_shm(struct event *event);
+
+/*
+ * Find room in a client's input ring for zserv_read() and zserv_read_shm().
+ *
+ * Returns the number of iovecs set up, 0 if the ring has reached its max
+ * limit of messages, or is full; the main thread reschedules us once it made
+ * room. The main thread only ever consumes from the ring: the space found
+ * can only grow until we're done writing into it.
+ */
+static int zserv_read_space(struct zserv *client, uint32_t p2p_orig,
+			    struct iovec iov[2])
+{
+	uint32_t msgs;
+	int iovcnt;
+
+	frr_with_mutex (&client->ibuf_mtx) {
+		msgs = client->ibuf_msgs;
+
+		/* Start over at the beginning when the ring is empty, so that
+		 * fewer messages wrap around its end.
+		 */
+		if (!ringbuf_remain(client->ibuf_ring))
+			ringbuf_reset(client->ibuf_ring);
+		iovcnt = ringbuf_space_iov(client->ibuf_ring, iov);
+	}
+
+	if (msgs >= p2p_orig)
+		return 0;
+	return iovcnt;
+}
+
+/*
+ * Make nb bytes just read into a client's input ring available to the main
+ * thread, up to the last complete message.
+ *
+ * Returns false if the data is corrupt, in which case the client is to be
+ * terminated; otherwise msgs is set to the number of messages in the ring.
+ */
+static bool zserv_read_commit(struct zserv *client, size_t nb,
+			      uint32_t p2p_orig, uint32_t *msgs)
+{
+	uint32_t added = 0;
+	uint16_t last_cmd = 0;
+	bool hdrvalid;
+
+	frr_with_mutex (&client->ibuf_mtx) {
+		ringbuf_commit(client->ibuf_ring, nb);
+		hdrvalid = zserv_read_parse(client, client->sock, &added,
+					    &last_cmd);
+		*msgs = client->ibuf_msgs;
 	}
 
-	if (p2p < (uint32_t)p2p_avail) {
+	if (!hdrvalid)
+		return false;
+
+	if (added) {
 		uint64_t time_now = monotime(NULL);
 
 		/* update session statistics */
 		frr_with_mutex (&client->stats_mtx) {
 			client->last_read_time = time_now;
-			client->last_read_cmd = hdr.command;
-		}
-
-		/* publish read packets on client's input queue */
-		frr_with_mutex (&client->ibuf_mtx) {
-			while (cache->head)
-				stream_fifo_push(client->ibuf_fifo,
-						 stream_fifo_pop(cache));
-			/* Need to update count as main event could have processed few */
-			client_ibuf_fifo_cnt =
-				stream_fifo_count_safe(client->ibuf_fifo);
+			client->last_read_cmd = last_cmd;
 		}
 
 		/* Schedule job to process those packets */
@@ -471,20 +488,172 @@ static void zserv_read(struct event *event)
 	}
 
 	if (IS_ZEBRA_DEBUG_PACKET)
-		zlog_debug("Read %d packets from client: %s(%d). Current ibuf fifo count: %zu. Conf P2p %d",
-			   p2p_avail - p2p, zebra_route_string(client->proto), client->sock,
-			   client_ibuf_fifo_cnt, p2p_orig);
+		zlog_debug("Read %u packets (%zu bytes) from client: %s(%d). Current ibuf count: %u. Conf P2p %d",
+			   added, nb, zebra_route_string(client->proto),
+			   client->sock, *msgs, p2p_orig);
+
+	return true;
+}
+
+/*
+ * Keep the descriptors for a shared memory ring that came in on a client's
+ * socket, for zread_hello() to pick up. Only the latest ones are kept.
+ */
+static void zserv_read_fds(struct zserv *client, int *fds, int nfds)
+{
+	int old_fds[ZAPI_SHM_FD_MAX];
+	int old_nfds, i;
+
+	frr_with_mutex (&client->ibuf_mtx) {
+		old_nfds = client->shm_nfds;
+		memcpy(old_fds, client->shm_fds, sizeof(old_fds));
+		memcpy(client->shm_fds, fds, nfds * sizeof(int));
+		client->shm_nfds = nfds;
+	}
+
+	for (i = 0; i < old_nfds; i++)
+		close(old_fds[i]);
+}
+
+/*
+ * Read data from a client socket.
+ *
+ * The responsibilities here are to read raw data from the client socket,
+ * validate the headers of the messages in it and notify the main thread that
+ * there are new messages available.
+ *
+ * Data is read in bulk, as much as there is room for, into the client's input
+ * ring buffer; any partial message at its end is completed by later reads.
+ * The headers of the complete messages are validated, and the messages are
+ * made available to the main thread, which handles them right out of the
+ * ring. Finally, if all of this was successful, this task reschedules itself.
+ *
+ * Any failure in any of these actions is handled by terminating the client.
+ *
+ * The client's input ring can hold a maximum number of messages as configured
+ * in the packets_to_process. This way we are not filling it up more than the
+ * maximum when the zebra main is busy. If the ring has space, we reschedule
+ * ourselves to read more.
+ *
+ * The main thread processes the messages in the ring and always signals the
+ * client IO thread.
+ *
+ * Once the client switched over to a shared memory ring, zserv_read_shm()
+ * takes over, and the socket is only watched for the client going away.
+ */
+static void zserv_read(struct event *event)
+{
+	struct zserv *client = EVENT_ARG(event);
+	int sock;
+	uint32_t p2p_orig;  /* Configured p2p (Default-1000) */
+	uint32_t msgs;
+	struct iovec iov[2];
+	int iovcnt;
+	int fds[ZAPI_SHM_FD_MAX];
+	int nfds;
+	ssize_t nb;
 
-	/* Reschedule ourselves since we have space in ibuf_fifo */
-	if (client_ibuf_fifo_cnt < p2p_orig)
+	p2p_orig = atomic_load_explicit(&zrouter.packets_to_process,
+					memory_order_relaxed);
+
+	iovcnt = zserv_read_space(client, p2p_orig, iov);
+	if (iovcnt == 0)
+		return;
+
+	sock = EVENT_FD(event);
+
+	nb = zapi_shm_recvmsg(sock, iov, iovcnt, fds, &nfds);
+	if (nfds)
+		zserv_read_fds(client, fds, nfds);
+	if (nb == 0 || (nb < 0 && !ERRNO_IO_RETRY(errno))) {
+		if (IS_ZEBRA_DEBUG_EVENT)
+			zlog_debug("connection closed socket [%d]", sock);
+		goto zread_fail;
+	}
+	if (nb < 0) {
+		/* Try again later. */
 		zserv_client_event(client, ZSERV_CLIENT_READ);
+		return;
+	}
 
-	stream_fifo_free(cache);
+	if (atomic_load_explicit(&client->shm_active, memory_order_relaxed)) {
+		flog_warn(EC_ZEBRA_CLIENT_IO_ERROR,
+			  "%s: client %d sent data on its socket after switching to shared memory",
+			  __func__, sock);
+		goto zread_fail;
+	}
+
+	if (!zserv_read_commit(client, nb, p2p_orig, &msgs))
+		goto zread_fail;
+
+	/* Reschedule ourselves since we have space in the input ring */
+	if (msgs < p2p_orig)
+		zserv_client_event(client, ZSERV_CLIENT_READ);
+
+	return;
+
+zread_fail:
+	zserv_client_fail(client);
+}
+
+/*
+ * Read data from a client's shared memory ring.
+ *
+ * Works like zserv_read(), except that the data is copied out of the shared
+ * ring into the client's input ring, where it can't change anymore while we
+ * look at it. When the shared ring is empty, the client is asked to signal
+ * its eventfd once it puts more data in.
+ */
+static void zserv_read_shm(struct event *event)
+{
+	struct zserv *client = EVENT_ARG(event);
+	uint32_t p2p_orig;
+	uint32_t msgs;
+	struct iovec iov[2];
+	int iovcnt;
+	ssize_t nb;
+
+	p2p_orig = atomic_load_explicit(&zrouter.packets_to_process,
+					memory_order_relaxed);
+
+	iovcnt = zserv_read_space(client, p2p_orig, iov);
+	if (iovcnt == 0)
+		return;
+
+	zapi_shm_event_clear(client->shm->fds[ZAPI_SHM_FD_DATA]);
+
+	nb = zapi_shm_read(client->shm, iov, iovcnt);
+	if (nb < 0) {
+		flog_warn(EC_ZEBRA_CLIENT_IO_ERROR,
+			  "%s: client %d corrupted its shared memory ring",
+			  __func__, client->sock);
+		goto zread_fail;
+	}
+
+	if (nb == 0) {
+		if (zapi_shm_data_wait(client->shm))
+			event_add_read(client->pthread->master, zserv_read_shm,
+				       client,
+				       client->shm->fds[ZAPI_SHM_FD_DATA],
+				       &client->t_shm_read);
+		else
+			event_add_event(client->pthread->master,
+					zserv_read_shm, client, 0,
+					&client->t_shm_read);
+		return;
+	}
+
+	if (!zserv_read_commit(client, nb, p2p_orig, &msgs))
+		goto zread_fail;
+
+	/* Reschedule ourselves since we have space in the input ring */
+	if (msgs < p2p_orig)
+		event_add_event(client->pthread->master, zserv_read_shm, client,
+				0, &client->t_shm_read);
 
 	return;
 
 zread_fail:
-	stream_fifo_free(cache);
 	zserv_client_fail(client);
 }
 
@@ -499,6 +668,11 @@ static void zserv_client_event(struct zserv *client,
 	case ZSERV_CLIENT_READ:
 		event_add_read(client->pthread->master, zserv_read, client,
 			       client->sock, &client->t_read);
+		if (atomic_load_explicit(&client->shm_active,
+					 memory_order_acquire))
+			event_add_event(client->pthread->master,
+					zserv_read_shm, client, 0,
+					&client->t_shm_read);
 		break;
 	case ZSERV_CLIENT_WRITE:
 		event_add_write(client->pthread->master, zserv_write, client,
@@ -513,59 +687,94 @@ static void zserv_client_event(struct zserv *client,
  * Read and process messages from a client.
  *
  * This task runs on the main pthread. It is scheduled by client pthreads when
- * they have new messages available on their input queues. The client is passed
+ * they have new messages available in their input rings. The client is passed
  * as the task argument.
  *
- * Each message is popped off the client's input queue and the action associated
- * with the message is executed. This proceeds until an error occurs, or the
- * processing limit is reached.
+ * Each message is handled in place, as a view of the client's input ring,
+ * and the action associated with the message is executed; only a message
+ * that wraps around the end of the ring is copied, into the client's work
+ * buffer. This proceeds until an error occurs, or the processing limit is
+ * reached. The space taken by the messages is then handed back to the
+ * client pthread.
  *
- * The client's I/O thread can push at most zrouter.packets_to_process messages
- * onto the input buffer before notifying us there are packets to read. As long
+ * The client's I/O thread can make at most zrouter.packets_to_process messages
+ * available before notifying us there are packets to read. As long
  * as we always process zrouter.packets_to_process messages here, then we can
  * rely on the read thread to handle queuing this task enough times to process
- * everything on the input queue.
+ * everything in the input ring.
  *
  * If the client ibuf always schedules a wakeup to the client IO to read more
  * items from the socked buffer. This way we ensure
  *  - Client IO thread always tries to read the socket buffer and add more
- *    items to the ibuf_fifo (until max limit)
+ *    items to the input ring (until max limit)
  *  - the hidden config change (zebra zapi-packets <>) is taken into account.
  */
 static void zserv_process_messages(struct event *event)
 {
 	struct zserv *client = EVENT_ARG(event);
-	struct stream *msg;
-	struct stream_fifo *cache = stream_fifo_new();
+	struct stream view, *msg;
+	struct stream_fifo deferred;
+	struct ringbuf ring;
 	uint32_t p2p = zrouter.packets_to_process;
+	uint32_t msgs, i;
+	uint16_t length;
+	size_t offset = 0;
 	bool need_resched = false;
 	uint32_t meta_queue_size = zebra_rib_meta_queue_size();
+	void *data;
 
 	if (meta_queue_size < p2p)
 		p2p = p2p - meta_queue_size;
 	else
 		p2p = 0;
 
+	/*
+	 * The client pthread only ever appends to the ring: a snapshot of it
+	 * is good for the messages already counted, which stay put until we
+	 * consume them.
+	 */
 	frr_with_mutex (&client->ibuf_mtx) {
-		uint32_t i;
-		for (i = 0; i < p2p && stream_fifo_head(client->ibuf_fifo);
-		     ++i) {
-			msg = stream_fifo_pop(client->ibuf_fifo);
-			stream_fifo_push(cache, msg);
-		}
+		msgs = MIN(p2p, client->ibuf_msgs);
+		ring = *client->ibuf_ring;
 
 		/* Need to reschedule processing work if there are still
-		 * packets in the fifo.
+		 * packets in the ring.
 		 */
-		if (stream_fifo_head(client->ibuf_fifo))
+		if (client->ibuf_msgs > msgs)
 			need_resched = true;
 	}
 
+	stream_fifo_init(&deferred);
+
 	/* Process the batch of messages */
-	if (stream_fifo_head(cache))
-		zserv_handle_commands(client, cache);
+	for (i = 0; i < msgs; i++) {
+		ringbuf_peek(&ring, offset, &length, sizeof(length));
+		length = ntohs(length);
+
+		data = ringbuf_peek_ptr(&ring, offset, length);
+		if (data) {
+			stream_view_init(&view, data, length);
+			msg = &view;
+		} else {
+			msg = client->ibuf_work;
+			stream_reset(msg);
+			ringbuf_peek(&ring, offset, STREAM_DATA(msg), length);
+			stream_set_endp(msg, length);
+		}
 
-	stream_fifo_free(cache);
+		zserv_handle_command(client, msg, &deferred);
+		offset += length;
+	}
+
+	zserv_handle_deferred(&deferred);
+	stream_fifo_deinit(&deferred);
+
+	/* Hand the space back to the client pthread */
+	frr_with_mutex (&client->ibuf_mtx) {
+		ringbuf_skip(client->ibuf_ring, offset);
+		client->ibuf_msgs -= msgs;
+		client->ibuf_msgs_size -= offset;
+	}
 
 	/* Reschedule ourselves if necessary */
 	if (need_resched)
@@ -621,6 +830,43 @@ int zserv_send_batch(struct zserv *client, struct stream_fifo *fifo)
 	return 0;
 }
 
+bool zserv_shm_attach(struct zserv *client)
+{
+	int fds[ZAPI_SHM_FD_MAX];
+	int nfds, i;
+	struct zapi_shm *shm = NULL;
+
+	frr_with_mutex (&client->ibuf_mtx) {
+		nfds = client->shm_nfds;
+		memcpy(fds, client->shm_fds, sizeof(fds));
+		client->shm_nfds = 0;
+	}
+
+	if (nfds == ZAPI_SHM_FD_MAX)
+		shm = zapi_shm_attach(fds);
+	else
+		for (i = 0; i < nfds; i++)
+			close(fds[i]);
+
+	if (!shm) {
+		flog_warn(EC_ZEBRA_CLIENT_IO_ERROR,
+			  "client %d '%s' offered an unusable shared memory ring",
+			  client->sock, zebra_route_string(client->proto));
+		return false;
+	}
+
+	frr_with_mutex (&client->ibuf_mtx) {
+		zapi_shm_free(&client->shm);
+		client->shm = shm;
+	}
+
+	if (IS_ZEBRA_DEBUG_EVENT)
+		zlog_debug("client %d '%s' uses a %" PRIu64 " byte shared memory ring",
+			   client->sock, zebra_route_string(client->proto),
+			   shm->size);
+	return true;
+}
+
 /* Hooks for client connect / disconnect */
 DEFINE_HOOK(zserv_client_connect, (struct zserv *client), (client));
 DEFINE_KOOH(zserv_client_close, (struct zserv *client), (client));
@@ -680,13 +926,19 @@ static void zserv_client_free(struct zserv *client)
 		stream_free(client->ibuf_work);
 	if (client->obuf_work)
 		stream_free(client->obuf_work);
-	if (client->ibuf_fifo)
-		stream_fifo_free(client->ibuf_fifo);
+	if (client->ibuf_ring)
+		ringbuf_del(client->ibuf_ring);
 	if (client->obuf_fifo)
 		stream_fifo_free(client->obuf_fifo);
 	if (client->wb)
 		buffer_free(client->wb);
 
+	/* Unmap the shared memory ring, if any */
+	zapi_shm_free(&client->shm);
+	for (int i = 0; i < client->shm_nfds; i++)
+		close(client->shm_fds[i]);
+	client->shm_nfds = 0;
+
 	/* Free buffer mutexes */
 	pthread_mutex_destroy(&client->stats_mtx);
 	pthread_mutex_destroy(&client->obuf_mtx);
@@ -808,7 +1060,7 @@ static struct zserv *zserv_client_create(int sock)
 
 	/* Make client input/output buffer. */
 	client->sock = sock;
-	client->ibuf_fifo = stream_fifo_new();
+	client->ibuf_ring = ringbuf_new(ZSERV_IBUF_RING_SIZE(stream_size));
 	client->obuf_fifo = stream_fifo_new();
 	client->ibuf_work = stream_new(stream_size);
 	client->obuf_work = stream_new(stream_size);
@@ -1128,6 +1380,9 @@ static void zebra_show_client_detail(struct vty *vty, struct zserv *client, json
 		json_object_int_add(json_client, "sessionId", client->session_id);
 		json_object_int_add(json_client, "fileDescriptor", client->sock);
 		json_object_boolean_add(json_client, "asynchronous", !client->synchronous);
+		json_object_boolean_add(json_client, "sharedMemory",
+					atomic_load_explicit(&client->shm_active,
+							     memory_order_relaxed));
 
 		/* Time information */
 		json_object_string_add(json_client, "connectTime",
@@ -1155,6 +1410,14 @@ static void zebra_show_client_detail(struct vty *vty, struct zserv *client, json
 						       zserv_time_buf(&client->nh_last_upd_time,
 								      mbuf, ZEBRA_TIME_BUF));
 			json_object_boolean_true_add(json_client, "nexthopRegistered");
+			json_object_boolean_add(json_client, "nexthopBulkUpdates",
+						CHECK_FLAG(client->capabilities,
+							   ZAPI_CLIENT_CAP_NHT_BULK));
+			json_object_int_add(json_client, "nexthopUpdates", client->nh_upd_cnt);
+			json_object_int_add(json_client, "nexthopUpdateMessages",
+					    client->nh_upd_msg_cnt);
+			json_object_int_add(json_client, "nexthopUpdatesCoalesced",
+					    client->nh_upd_cnt - client->nh_upd_msg_cnt);
 		} else {
 			json_object_boolean_false_add(json_client, "nexthopRegistered");
 		}
@@ -1340,8 +1603,8 @@ static void zebra_show_client_detail(struct vty *vty, struct zserv *client, json
 
 		/* FIFO queues */
 		json_fifo = json_object_new_object();
-		json_object_int_add(json_fifo, "inputCount", client->ibuf_fifo->count);
-		json_object_int_add(json_fifo, "inputMaxCount", client->ibuf_fifo->max_count);
+		json_object_int_add(json_fifo, "inputCount", client->ibuf_msgs);
+		json_object_int_add(json_fifo, "inputMaxCount", client->ibuf_msgs_max);
 		json_object_int_add(json_fifo, "outputCount", client->obuf_fifo->count);
 		json_object_int_add(json_fifo, "outputMaxCount", client->obuf_fifo->max_count);
 		json_object_object_add(json_client, "fifo", json_fifo);
@@ -1359,6 +1622,8 @@ static void zebra_show_client_detail(struct vty *vty, struct zserv *client, json
 
 		vty_out(vty, "------------------------ \n");
 		vty_out(vty, "FD: %d \n", client->sock);
+		if (atomic_load_explicit(&client->shm_active, memory_order_relaxed))
+			vty_out(vty, "Input: shared memory ring\n");
 
 		vty_out(vty, "Connect Time: %s \n",
 			zserv_time_buf(&connect_time, cbuf, ZEBRA_TIME_BUF));
@@ -1371,6 +1636,12 @@ static void zebra_show_client_detail(struct vty *vty, struct zserv *client, json
 						       ZEBRA_TIME_BUF));
 			else
 				vty_out(vty, "No Nexthop Update sent\n");
+			vty_out(vty, "Nexthop Updates: %u in %u messages, %u coalesced%s\n",
+				client->nh_upd_cnt, client->nh_upd_msg_cnt,
+				client->nh_upd_cnt - client->nh_upd_msg_cnt,
+				CHECK_FLAG(client->capabilities, ZAPI_CLIENT_CAP_NHT_BULK)
+					? " (bulk)"
+					: "");
 		} else
 			vty_out(vty, "Not registered for Nexthop Updates\n");
 
@@ -1464,8 +1735,8 @@ static void zebra_show_client_detail(struct vty *vty, struct zserv *client, json
 			}
 		}
 
-		vty_out(vty, "Input Fifo: %zu:%zu Output Fifo: %zu:%zu\n",
-			client->ibuf_fifo->count, client->ibuf_fifo->max_count,
+		vty_out(vty, "Input Fifo: %u:%u Output Fifo: %zu:%zu\n",
+			client->ibuf_msgs, client->ibuf_msgs_max,
 			client->obuf_fifo->count, client->obuf_fifo->max_count);
 
 		vty_out(vty, "\n");
@@ -19,6 +19,8 @@
 #include "lib/vrf.h"          /* for vrf_bitmap_t */
 #include "lib/zclient.h"      /* for redist_proto */
 #include "lib/stream.h"       /* for stream, stream_fifo */
+#include "lib/ringbuf.h"      /* for ringbuf */
+#include "lib/zapi_shm.h"     /* for zapi_shm */
 #include "frrevent.h"            /* for thread, thread_master */
 #include "lib/linklist.h"     /* for list */
 #include "lib/workqueue.h"    /* for work_queue */
@@ -96,13 +98,21 @@ struct zserv {
 	/* For managing this node in the stale client list */
 	struct zserv_stale_client_list_item stale_client_list_entry;
 
-	/* Input/output buffer to the client. */
+	/* Input/output buffer to the client. The input ring is filled by the
+	 * client pthread; the complete messages at its start, ibuf_msgs of
+	 * them, ibuf_msgs_size bytes, are handled by the main pthread in place.
+	 */
 	pthread_mutex_t ibuf_mtx;
-	struct stream_fifo *ibuf_fifo;
+	struct ringbuf *ibuf_ring;
+	uint32_t ibuf_msgs;
+	uint32_t ibuf_msgs_max;
+	size_t ibuf_msgs_size;
 	pthread_mutex_t obuf_mtx;
 	struct stream_fifo *obuf_fifo;
 
-	/* Private I/O buffers */
+	/* Private I/O buffers; ibuf_work holds a copy of the messages that
+	 * wrap around the end of the input ring.
+	 */
 	struct stream *ibuf_work;
 	struct stream *obuf_work;
 
@@ -113,6 +123,17 @@ struct zserv {
 	struct event *t_read;
 	struct event *t_write;
 
+	/* Shared memory ring offered by the client at hello, and the
+	 * descriptors for it as they were received, under ibuf_mtx. Once the
+	 * client sent the ZEBRA_ZAPI_SHM marker on the socket, its messages
+	 * are read from the ring instead.
+	 */
+	struct zapi_shm *shm;
+	int shm_fds[ZAPI_SHM_FD_MAX];
+	int shm_nfds;
+	atomic_bool shm_active;
+	struct event *t_shm_read;
+
 	/* Event for message processing, for the main pthread */
 	struct event *t_process;
 
@@ -137,6 +158,9 @@ struct zserv {
 	/* Indicates if client is synchronous. */
 	bool synchronous;
 
+	/* ZAPI_CLIENT_CAP_* sent with the hello */
+	uint32_t capabilities;
+
 	/* client's protocol and session info */
 	uint8_t proto;
 	uint16_t instance;
@@ -197,11 +221,21 @@ struct zserv {
 	uint32_t nhg_add_cnt;
 	uint32_t nhg_upd8_cnt;
 	uint32_t nhg_del_cnt;
+	uint32_t nh_upd_cnt;
+	uint32_t nh_upd_msg_cnt;
 
 	time_t nh_reg_time;
 	time_t nh_dereg_time;
 	time_t nh_last_upd_time;
 
+	/*
+	 * Nexthop updates waiting to go out in one ZEBRA_NEXTHOP_UPDATE_BULK
+	 * when t_nht_bulk runs (main pthread only).
+	 */
+	struct stream *nht_bulk;
+	uint16_t nht_bulk_cnt;
+	struct event *t_nht_bulk;
+
 	/*
 	 * Session information.
 	 *
@@ -314,6 +348,18 @@ extern int zserv_send_message(struct zserv *client, struct stream *msg);
  */
 extern int zserv_send_batch(struct zserv *client, struct stream_fifo *fifo);
 
+/*
+ * Map the shared memory ring whose descriptors the client passed along with
+ * its hello. Runs on the main pthread.
+ *
+ * client
+ *    the client that asked for it
+ *
+ * Returns:
+ *    true if the ring is usable, the client then switches over to it
+ */
+extern bool zserv_shm_attach(struct zserv *client);
+
 /*
  * Retrieve a client by its protocol and instance number.
  *